@@ -0,0 +1,11 @@
+# Toolchain file for bare-metal Cortex-M builds (arm-none-eabi-gcc)
+#   cmake -S bench -B build/bench -DCMAKE_TOOLCHAIN_FILE=bench/arm-none-eabi.cmake
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(CMAKE_C_COMPILER arm-none-eabi-gcc)
+set(CMAKE_ASM_COMPILER arm-none-eabi-gcc)
+
+# Nothing can be executed while probing the compiler
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
@@ -0,0 +1,535 @@
+// kbench.c - Kernel microbenchmarks
+//
+// Measures cycles per kernel operation with port_cycle_count() and prints
+// one CSV line per result:
+//
+//   kbench,<name>,<param>,<iterations>,<min>,<avg>,<max>
+//
+// The cost of reading the counter is measured first and subtracted from
+// every sample. Lines starting with '#' are comments. Save two runs and
+// compare them with tools/bench_compare.py.
+
+#include "circular_buffer.h"
+#include "critical.h"
+#include "kernel.h"
+#include "klog.h"
+#include "memory.h"
+#include "mutex.h"
+#include "port.h"
+#include "profile.h"
+#include "queue.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "trace.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef KBENCH_ITERATIONS
+#define KBENCH_ITERATIONS 1000
+#endif
+
+#define KBENCH_WAIT 0x7FFFFFFFu // "Forever" for APIs without a constant
+
+#define DRIVER_PRIORITY 1
+#define PARTNER_PRIORITY 2
+#define FILLER_PRIORITY (MAX_PRIORITY - 1)
+
+// Keeps the compiler from moving work across the timestamps
+#define BENCH_BARRIER() __asm volatile("" ::: "memory")
+
+// Times op, but only counts it if cond holds afterwards (e.g. an
+// allocation that succeeded)
+#define BENCH_TIME_IF(stat, op, cond)                                          \
+  do {                                                                         \
+    BENCH_BARRIER();                                                           \
+    uint32_t _t0 = port_cycle_count();                                         \
+    BENCH_BARRIER();                                                           \
+    op;                                                                        \
+    BENCH_BARRIER();                                                           \
+    uint32_t _t1 = port_cycle_count();                                         \
+    BENCH_BARRIER();                                                           \
+    if (cond) stat_add(&(stat), _t1 - _t0);                                    \
+  } while (0)
+
+#define BENCH_TIME(stat, op) BENCH_TIME_IF(stat, op, 1)
+
+typedef struct bench_stat {
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t count;
+} bench_stat_t;
+
+static uint32_t timer_overhead;
+
+static semaphore_handle_t partner_done;
+
+// ============================== HELPER FUNCTIONS =============================
+
+static void stat_reset(bench_stat_t *stat) {
+  stat->min = UINT32_MAX;
+  stat->max = 0;
+  stat->sum = 0;
+  stat->count = 0;
+}
+
+static void stat_add(bench_stat_t *stat, uint32_t cycles) {
+  cycles = cycles > timer_overhead ? cycles - timer_overhead : 0;
+  if (cycles < stat->min) stat->min = cycles;
+  if (cycles > stat->max) stat->max = cycles;
+  stat->sum += cycles;
+  stat->count++;
+}
+
+static void report(const char *name, const char *param,
+                   const bench_stat_t *stat) {
+  if (stat->count == 0) {
+    printf("kbench,%s,%s,0,0,0,0\n", name, param);
+    return;
+  }
+  printf("kbench,%s,%s,%lu,%lu,%lu,%lu\n", name, param,
+         (unsigned long)stat->count, (unsigned long)stat->min,
+         (unsigned long)(stat->sum / stat->count), (unsigned long)stat->max);
+}
+
+static void calibrate(void) {
+  bench_stat_t stat;
+  stat_reset(&stat);
+  timer_overhead = 0;
+
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(stat, (void)0);
+  }
+  timer_overhead = stat.min;
+  printf("# timer overhead %lu cycles (subtracted)\n",
+         (unsigned long)timer_overhead);
+}
+
+// Partners end by parking in a long delay, the one state
+// task_delete() can take a task out of cleanly.
+static void partner_finish(void) {
+  sem_post(partner_done);
+  task_delay(KBENCH_WAIT);
+}
+
+static task_handle_t start_partner(task_function_t fn, void *param,
+                                   task_priority_t priority) {
+  return task_create(fn, "partner", DEFAULT_STACK_SIZE, param, priority);
+}
+
+static void stop_partner(task_handle_t partner) {
+  sem_wait(partner_done, SEM_WAIT_FOREVER);
+  task_delete(partner);
+}
+
+// ============================== BENCHMARKS ===================================
+
+static void bench_circular_buffer(void) {
+  static const size_t sizes[] = {1, 4, 16, 64};
+  static uint8_t storage[16 * 64];
+  static uint8_t item[64];
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    circular_buffer_t cb;
+    bench_stat_t put, get;
+    char param[8];
+
+    if (cb_init(&cb, storage, 16, sizes[s]) != CB_SUCCESS) continue;
+    stat_reset(&put);
+    stat_reset(&get);
+
+    for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+      BENCH_TIME(put, cb_put(&cb, item));
+      BENCH_TIME(get, cb_get(&cb, item));
+    }
+
+    snprintf(param, sizeof(param), "%uB", (unsigned)sizes[s]);
+    report("cb_put", param, &put);
+    report("cb_get", param, &get);
+  }
+}
+
+static void bench_pools(void) {
+  static const char *names[POOL_COUNT] = {
+      "tcb", "stack_small", "stack_default", "stack_large", "qcb",
+      "buffer_small", "buffer_medium", "buffer_large", "scb", "mcb", "tmcb"};
+
+  for (int p = 0; p < POOL_COUNT; p++) {
+    bench_stat_t alloc, release;
+    void *obj = NULL;
+
+    stat_reset(&alloc);
+    stat_reset(&release);
+
+    for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+      BENCH_TIME_IF(alloc, obj = pool_alloc((pool_type_t)p), obj != NULL);
+      if (!obj) break; // Pool exhausted by live kernel objects
+      BENCH_TIME(release, pool_free((pool_type_t)p, obj));
+    }
+
+    // Compiled out (e.g. tmcb without SWTIMER_ENABLED) or never free
+    if (alloc.count == 0) continue;
+    report("pool_alloc", names[p], &alloc);
+    report("pool_free", names[p], &release);
+  }
+}
+
+static void bench_queue_uncontended(void) {
+  queue_handle_t q = queue_create(8, sizeof(uint32_t));
+  bench_stat_t send, receive;
+  uint32_t value = 0;
+
+  stat_reset(&send);
+  stat_reset(&receive);
+
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(send, queue_send(q, &value, 0));
+    BENCH_TIME(receive, queue_receive(q, &value, 0));
+  }
+
+  report("queue_send", "uncontended", &send);
+  report("queue_receive", "uncontended", &receive);
+  queue_delete(q);
+}
+
+typedef struct pingpong {
+  queue_handle_t to_partner;
+  queue_handle_t to_driver;
+  semaphore_handle_t sem_to_partner;
+  semaphore_handle_t sem_to_driver;
+} pingpong_t;
+
+static void queue_echo_task(void *param) {
+  pingpong_t *pp = param;
+  uint32_t value;
+
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    queue_receive(pp->to_partner, &value, KBENCH_WAIT);
+    queue_send(pp->to_driver, &value, KBENCH_WAIT);
+  }
+  partner_finish();
+}
+
+static void sem_echo_task(void *param) {
+  pingpong_t *pp = param;
+
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    sem_wait(pp->sem_to_partner, SEM_WAIT_FOREVER);
+    sem_post(pp->sem_to_driver);
+  }
+  partner_finish();
+}
+
+// Round trip: send/post, switch to the partner, its reply, switch back
+static void bench_pingpong(void) {
+  pingpong_t pp;
+  bench_stat_t rtt;
+  uint32_t value = 0;
+
+  pp.to_partner = queue_create(1, sizeof(uint32_t));
+  pp.to_driver = queue_create(1, sizeof(uint32_t));
+  task_handle_t partner = start_partner(queue_echo_task, &pp, PARTNER_PRIORITY);
+
+  stat_reset(&rtt);
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(rtt, {
+      queue_send(pp.to_partner, &value, KBENCH_WAIT);
+      queue_receive(pp.to_driver, &value, KBENCH_WAIT);
+    });
+  }
+  report("queue_pingpong", "round_trip", &rtt);
+  stop_partner(partner);
+  queue_delete(pp.to_partner);
+  queue_delete(pp.to_driver);
+
+  pp.sem_to_partner = sem_create(0, 1, "ping");
+  pp.sem_to_driver = sem_create(0, 1, "pong");
+  partner = start_partner(sem_echo_task, &pp, PARTNER_PRIORITY);
+
+  stat_reset(&rtt);
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(rtt, {
+      sem_post(pp.sem_to_partner);
+      sem_wait(pp.sem_to_driver, SEM_WAIT_FOREVER);
+    });
+  }
+  report("sem_pingpong", "round_trip", &rtt);
+  stop_partner(partner);
+  sem_delete(pp.sem_to_partner);
+  sem_delete(pp.sem_to_driver);
+}
+
+typedef struct pi_bench {
+  mutex_handle_t mutex;
+  semaphore_handle_t holding; // Low task owns the mutex
+  semaphore_handle_t go;      // Driver is ready for the next round
+} pi_bench_t;
+
+// Lower-priority owner: takes the mutex, lets the driver contend for it,
+// then releases it while boosted.
+static void pi_owner_task(void *param) {
+  pi_bench_t *pb = param;
+
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    sem_wait(pb->go, SEM_WAIT_FOREVER);
+    mutex_lock(pb->mutex, MUTEX_WAIT_FOREVER);
+    sem_post(pb->holding);
+    task_yield(); // Driver now blocks on the mutex and boosts us
+    mutex_unlock(pb->mutex);
+    task_yield();
+  }
+  partner_finish();
+}
+
+static void bench_mutex(void) {
+  mutex_handle_t m = mutex_create("bench");
+  bench_stat_t lock, unlock;
+
+  stat_reset(&lock);
+  stat_reset(&unlock);
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(lock, mutex_lock(m, MUTEX_NO_WAIT));
+    BENCH_TIME(unlock, mutex_unlock(m));
+  }
+  report("mutex_lock", "uncontended", &lock);
+  report("mutex_unlock", "uncontended", &unlock);
+
+  // Contended lock with priority inheritance: from the driver's lock call
+  // until it owns the mutex (boost, two switches, owner's unlock/restore).
+  pi_bench_t pb = {m, sem_create(0, 1, "hold"), sem_create(0, 1, "go")};
+  task_handle_t owner = start_partner(pi_owner_task, &pb, PARTNER_PRIORITY);
+
+  stat_reset(&lock);
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    sem_post(pb.go);
+    sem_wait(pb.holding, SEM_WAIT_FOREVER);
+    BENCH_TIME(lock, mutex_lock(m, MUTEX_WAIT_FOREVER));
+    mutex_unlock(m);
+  }
+  report("mutex_lock", "pi_handoff", &lock);
+
+  stop_partner(owner);
+  sem_delete(pb.holding);
+  sem_delete(pb.go);
+  mutex_delete(m);
+}
+
+static void filler_task(void *param) {
+  (void)param;
+  while (1) {
+    task_delay(KBENCH_WAIT);
+  }
+}
+
+// Scheduler pick with `n` ready tasks one level above idle. The driver
+// steps out of its ready queue for the measurement so the scan has to
+// walk down to them.
+static void bench_scheduler_pick(void) {
+  static const int counts[] = {1, 2, 4, 6};
+  task_handle_t fillers[6];
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    int created = 0;
+    char param[8];
+    bench_stat_t pick;
+
+    for (int i = 0; i < counts[c]; i++) {
+      fillers[i] = task_create(filler_task, "filler", DEFAULT_STACK_SIZE,
+                               NULL, FILLER_PRIORITY);
+      if (!fillers[i]) break;
+      created++;
+    }
+
+    stat_reset(&pick);
+    task_handle_t self = task_get_current();
+    for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+      KERNEL_CRITICAL_BEGIN();
+      list_remove(&self->ready_link);
+      BENCH_TIME(pick, (void)scheduler_get_next_task());
+      list_insert_tail(&ready_queues[self->effective_priority],
+                       &self->ready_link);
+      KERNEL_CRITICAL_END();
+    }
+
+    snprintf(param, sizeof(param), "%d", created);
+    report("scheduler_get_next_task", param, &pick);
+
+    for (int i = 0; i < created; i++) {
+      task_delete(fillers[i]);
+    }
+  }
+}
+
+static volatile bool yield_running;
+static bench_stat_t yield_rtt;
+
+static void yield_timer_task(void *param) {
+  (void)param;
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(yield_rtt, task_yield());
+  }
+  yield_running = false;
+  partner_finish();
+}
+
+static void yield_echo_task(void *param) {
+  (void)param;
+  while (yield_running) {
+    task_yield();
+  }
+  partner_finish();
+}
+
+// Two equal-priority tasks yield to each other: one round trip is two
+// full switches (yield, PendSV save/restore) and the partner's yield call.
+static void bench_context_switch(void) {
+  stat_reset(&yield_rtt);
+  yield_running = true;
+
+  task_handle_t a = start_partner(yield_timer_task, NULL, PARTNER_PRIORITY);
+  task_handle_t b = start_partner(yield_echo_task, NULL, PARTNER_PRIORITY);
+
+  stop_partner(a);
+  stop_partner(b);
+
+  report("context_switch", "yield_round_trip", &yield_rtt);
+
+  bench_stat_t per_switch = yield_rtt;
+  per_switch.min /= 2;
+  per_switch.max /= 2;
+  per_switch.sum /= 2;
+  report("context_switch", "per_switch", &per_switch);
+}
+
+#if KLOG_ENABLED
+// Inlined, so the sample is the macro alone; its expansion has bare commas
+// that would split BENCH_TIME's arguments
+static inline __attribute__((always_inline)) void klog_one(uint32_t arg) {
+  KLOG("kbench %u\n", arg);
+}
+
+// One record with one argument. The ring is drained between samples, so
+// every sample takes the store path rather than the cheaper drop.
+static void bench_klog(void) {
+  bench_stat_t log;
+  stat_reset(&log);
+
+  klog_drain(NULL, SIZE_MAX);
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(log, klog_one((uint32_t)i));
+    klog_drain(NULL, SIZE_MAX);
+  }
+
+  report("klog", "1arg", &log);
+}
+#endif
+
+#if TRACE_ENABLED
+// The recording hot path with tracing started and no sink: flag test, slot
+// claim, timestamp and four stores
+static void bench_trace_record(void) {
+  bench_stat_t record;
+  stat_reset(&record);
+
+  trace_clear();
+  trace_start();
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    BENCH_TIME(record, trace_record(TRACE_EVENT_USER, (uintptr_t)&record,
+                                    (uint32_t)i));
+  }
+  trace_stop();
+
+  report("trace_record", "-", &record);
+}
+#endif
+
+#if PROFILE_ENABLED
+// One tick's sample: a hash, the probes and an increment. Sixteen PCs in
+// one task, so after the first round every sample hits a counted entry.
+// The tick samples too and the table has no lock, so mask it as the tick
+// would be.
+static void bench_profile_sample(void) {
+  bench_stat_t sample;
+  stat_reset(&sample);
+
+  uintptr_t base = (uintptr_t)&bench_profile_sample;
+  task_handle_t self = task_get_current();
+
+  profile_reset();
+  for (int i = 0; i < KBENCH_ITERATIONS; i++) {
+    uintptr_t pc = base + (uintptr_t)(i % 16) * 4;
+
+    KERNEL_CRITICAL_BEGIN();
+    BENCH_TIME(sample, profile_sample(pc, self));
+    KERNEL_CRITICAL_END();
+  }
+  profile_reset();
+
+  report("profile_sample", "16pc", &sample);
+}
+#endif
+
+// ============================== DRIVER =======================================
+
+static void kbench_exit(int status) {
+#if defined(__ARM_ARCH) && !defined(KBENCH_SEMIHOSTING)
+  (void)status;
+  while (1) {
+  }
+#else
+  exit(status);
+#endif
+}
+
+static void bench_driver(void *param) {
+  (void)param;
+
+  partner_done = sem_create(0, 4, "done");
+
+  calibrate();
+  bench_circular_buffer();
+  bench_pools();
+  bench_queue_uncontended();
+  bench_mutex();
+  bench_pingpong();
+  bench_scheduler_pick();
+  bench_context_switch();
+#if KLOG_ENABLED
+  bench_klog();
+#endif
+#if TRACE_ENABLED
+  bench_trace_record();
+#endif
+#if PROFILE_ENABLED
+  bench_profile_sample();
+#endif
+
+  printf("# kbench done\n");
+  kbench_exit(0);
+}
+
+#ifdef KBENCH_SEMIHOSTING
+extern void initialise_monitor_handles(void);
+#endif
+
+int main(void) {
+#ifdef KBENCH_SEMIHOSTING
+  initialise_monitor_handles();
+#endif
+  // Unbuffered, so printf never needs the heap from inside a task
+  setvbuf(stdout, NULL, _IONBF, 0);
+
+  printf("# kbench format=1 hz=%lu iterations=%d\n",
+         (unsigned long)PORT_CYCLE_COUNTER_HZ, KBENCH_ITERATIONS);
+
+  kernel_init();
+  if (!task_create(bench_driver, "kbench", LARGE_STACK_SIZE, NULL,
+                   DRIVER_PRIORITY)) {
+    printf("# kbench: cannot create driver task\n");
+    kbench_exit(1);
+  }
+  kernel_start();
+  return 0;
+}
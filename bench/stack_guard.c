@@ -0,0 +1,106 @@
+// stack_guard.c - Checks that the MPU stack guard catches an overflow
+//
+// A bystander task starts first and sleeps, so PendSV has to move the
+// guard region onto the victim's stack before the victim recurses past
+// its bottom. MemManage_Handler fills in port_last_fault and calls
+// port_fault_halt(), overridden here to print one CSV line and exit:
+//
+//   stack_guard,<pass|fail>,<task>,<cfsr>,<address>
+//
+// Exit status 0 means the fault was taken in the victim, as a data access
+// or stacking violation inside its guard region.
+
+#include "kernel.h"
+#include "port.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !MPU_STACK_GUARD_ENABLED
+#error "stack_guard needs MPU_STACK_GUARD_ENABLED"
+#endif
+
+#define BYSTANDER_PRIORITY 1
+#define VICTIM_PRIORITY 2
+
+#define CFSR_DACCVIOL (1u << 1)
+#define CFSR_MSTKERR (1u << 4)
+#define CFSR_MMARVALID (1u << 7)
+
+static task_handle_t victim;
+static volatile uint32_t depth;
+
+// Not a tail call, so every level keeps its frame
+static __attribute__((noinline)) uint32_t recurse(uint32_t level) {
+  volatile uint32_t frame[8];
+
+  frame[0] = level;
+  depth = level;
+  return recurse(level + 1) + frame[0];
+}
+
+static void victim_task(void *param) {
+  (void)param;
+  recurse(0);
+
+  // Only reached if the guard did not trap
+  printf("stack_guard,fail,%s,0x00000000,0x00000000\n", victim->name);
+  exit(1);
+}
+
+static void bystander_task(void *param) {
+  (void)param;
+
+  while (1) {
+    task_delay(100);
+  }
+}
+
+void port_fault_halt(void) {
+  task_handle_t task = port_last_fault.task;
+  uint32_t cfsr = port_last_fault.cfsr;
+  uint32_t address = port_last_fault.address;
+
+  uintptr_t base = (uintptr_t)victim->stack_base;
+  uintptr_t guard = (base + MPU_STACK_GUARD_SIZE - 1) &
+                    ~(uintptr_t)(MPU_STACK_GUARD_SIZE - 1);
+  bool in_guard = address >= guard && address < guard + MPU_STACK_GUARD_SIZE;
+
+  bool pass = task == victim;
+  if (cfsr & CFSR_DACCVIOL) {
+    pass = pass && (cfsr & CFSR_MMARVALID) && in_guard;
+  } else {
+    // Exception entry ran into the guard; MMFAR is not valid then
+    pass = pass && (cfsr & CFSR_MSTKERR);
+  }
+
+  printf("stack_guard,%s,%s,0x%08lx,0x%08lx\n", pass ? "pass" : "fail",
+         task ? task->name : "none", (unsigned long)cfsr,
+         (unsigned long)address);
+  printf("# %lu levels deep\n", (unsigned long)depth);
+  exit(pass ? 0 : 1);
+}
+
+#ifdef STACK_GUARD_SEMIHOSTING
+extern void initialise_monitor_handles(void);
+#endif
+
+int main(void) {
+#ifdef STACK_GUARD_SEMIHOSTING
+  initialise_monitor_handles();
+#endif
+  // Unbuffered, so printf never needs the heap from the fault handler
+  setvbuf(stdout, NULL, _IONBF, 0);
+
+  kernel_init();
+  victim = task_create(victim_task, "victim", SMALL_STACK_SIZE, NULL,
+                       VICTIM_PRIORITY);
+  if (!victim || !task_create(bystander_task, "bystander", SMALL_STACK_SIZE,
+                              NULL, BYSTANDER_PRIORITY)) {
+    printf("# stack_guard: cannot create tasks\n");
+    exit(1);
+  }
+  kernel_start();
+  return 0;
+}
@@ -0,0 +1,73 @@
+// tm_api.h - Thread-Metric RTOS porting interface
+//
+// The Thread-Metric tests only talk to the RTOS through these functions.
+// tm_porting_layer.c implements them on top of the public Morph-RT API.
+// IDs are small integers chosen by the test; priorities follow the
+// Thread-Metric convention (1 = most urgent, 31 = least).
+
+#ifndef TM_API_H
+#define TM_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TM_SUCCESS 0
+#define TM_ERROR 1
+
+// Length of each reporting interval, in seconds
+#ifndef TM_TEST_DURATION
+#define TM_TEST_DURATION 30
+#endif
+
+// Number of intervals to report before exiting (0 = run forever)
+#ifndef TM_TEST_CYCLES
+#define TM_TEST_CYCLES 0
+#endif
+
+// Thread-Metric messages are four unsigned longs (16 bytes on 32-bit)
+#define TM_MESSAGE_WORDS 4
+
+// Block size used by the memory allocation test
+#define TM_MEMORY_BLOCK_SIZE 128
+
+// Every test defines tm_main(); the porting layer's main() calls it
+void tm_main(void);
+
+// Creates the kernel objects, runs test_initialization_function and starts
+// the scheduler. Does not return on success.
+int tm_initialize(void (*test_initialization_function)(void));
+
+// Threads are created suspended and start on their first tm_thread_resume()
+int tm_thread_create(int thread_id, int priority, void (*entry_function)(void));
+int tm_thread_resume(int thread_id);
+int tm_thread_suspend(int thread_id);
+void tm_thread_relinquish(void);
+void tm_thread_sleep(int seconds);
+
+int tm_queue_create(int queue_id);
+int tm_queue_send(int queue_id, unsigned long *message_ptr);
+int tm_queue_receive(int queue_id, unsigned long *message_ptr);
+
+int tm_semaphore_create(int semaphore_id);
+int tm_semaphore_get(int semaphore_id);
+int tm_semaphore_put(int semaphore_id);
+
+int tm_memory_pool_create(int pool_id);
+int tm_memory_pool_allocate(int pool_id, unsigned char **memory_ptr);
+int tm_memory_pool_deallocate(int pool_id, unsigned char *memory_ptr);
+
+// Raises the test interrupt, which runs tm_interrupt_handler() in ISR
+// context. Tests that use it define the handler.
+void tm_cause_interrupt(void);
+void tm_interrupt_handler(void);
+
+// Called by each reporter after printing an interval. Exits once
+// TM_TEST_CYCLES intervals have been reported.
+void tm_report_done(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TM_API_H
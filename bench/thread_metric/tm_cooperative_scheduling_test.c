@@ -0,0 +1,89 @@
+// tm_cooperative_scheduling_test.c - Thread-Metric cooperative scheduling
+//
+// Five threads at the same priority each bump a counter and relinquish.
+// The score is the number of relinquish round trips per interval. With
+// strict round-robin no counter may drift more than one from the average.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+#define TM_COOP_THREADS 5
+
+static volatile unsigned long tm_cooperative_counter[TM_COOP_THREADS];
+
+static void tm_cooperative_thread_entry(int index) {
+  while (1) {
+    tm_thread_relinquish();
+    tm_cooperative_counter[index]++;
+  }
+}
+
+static void tm_cooperative_thread_0_entry(void) {
+  tm_cooperative_thread_entry(0);
+}
+
+static void tm_cooperative_thread_1_entry(void) {
+  tm_cooperative_thread_entry(1);
+}
+
+static void tm_cooperative_thread_2_entry(void) {
+  tm_cooperative_thread_entry(2);
+}
+
+static void tm_cooperative_thread_3_entry(void) {
+  tm_cooperative_thread_entry(3);
+}
+
+static void tm_cooperative_thread_4_entry(void) {
+  tm_cooperative_thread_entry(4);
+}
+
+static void tm_cooperative_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Cooperative Scheduling Test **** Relative Time: "
+           "%lu\n",
+           relative_time);
+
+    unsigned long total = 0;
+    for (int i = 0; i < TM_COOP_THREADS; i++) {
+      total += tm_cooperative_counter[i];
+    }
+
+    unsigned long average = total / TM_COOP_THREADS;
+    for (int i = 0; i < TM_COOP_THREADS; i++) {
+      if (tm_cooperative_counter[i] + 1 < average ||
+          tm_cooperative_counter[i] > average + 1) {
+        printf("ERROR: Invalid counter value(s). Cooperative counters should "
+               "not be more that 1 different than the average!\n");
+        break;
+      }
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_cooperative_scheduling_initialize(void) {
+  tm_thread_create(0, 3, tm_cooperative_thread_0_entry);
+  tm_thread_create(1, 3, tm_cooperative_thread_1_entry);
+  tm_thread_create(2, 3, tm_cooperative_thread_2_entry);
+  tm_thread_create(3, 3, tm_cooperative_thread_3_entry);
+  tm_thread_create(4, 3, tm_cooperative_thread_4_entry);
+  tm_thread_create(5, 2, tm_cooperative_thread_report);
+
+  for (int i = 0; i <= TM_COOP_THREADS; i++) {
+    tm_thread_resume(i);
+  }
+}
+
+void tm_main(void) { tm_initialize(tm_cooperative_scheduling_initialize); }
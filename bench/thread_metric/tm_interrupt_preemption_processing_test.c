@@ -0,0 +1,76 @@
+// tm_interrupt_preemption_processing_test.c - Thread-Metric interrupt
+// preemption processing
+//
+// A low-priority thread raises the test interrupt, whose handler resumes a
+// more urgent thread. That thread runs as soon as the ISR returns, bumps
+// its counter and suspends, handing the CPU back. Each loop is one
+// interrupt plus two context switches.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+static volatile unsigned long tm_interrupt_preemption_thread_0_counter;
+static volatile unsigned long tm_interrupt_preemption_thread_1_counter;
+static volatile unsigned long tm_interrupt_preemption_handler_counter;
+
+static void tm_interrupt_preemption_thread_0_entry(void) {
+  while (1) {
+    tm_cause_interrupt();
+    tm_interrupt_preemption_thread_0_counter++;
+  }
+}
+
+static void tm_interrupt_preemption_thread_1_entry(void) {
+  while (1) {
+    tm_interrupt_preemption_thread_1_counter++;
+    tm_thread_suspend(1);
+  }
+}
+
+void tm_interrupt_handler(void) {
+  tm_interrupt_preemption_handler_counter++;
+  tm_thread_resume(1);
+}
+
+static void tm_interrupt_preemption_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Interrupt Preemption Processing Test **** "
+           "Relative Time: %lu\n",
+           relative_time);
+
+    unsigned long total = tm_interrupt_preemption_thread_1_counter;
+    unsigned long handled = tm_interrupt_preemption_handler_counter;
+    unsigned long raised = tm_interrupt_preemption_thread_0_counter;
+    if (total + 1 < handled || total > handled + 1 || raised + 1 < total ||
+        raised > total + 1) {
+      printf("ERROR: Invalid counter value(s). Interrupt preemption test has "
+             "failed!\n");
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_interrupt_preemption_processing_initialize(void) {
+  tm_thread_create(0, 10, tm_interrupt_preemption_thread_0_entry);
+  tm_thread_create(1, 9, tm_interrupt_preemption_thread_1_entry);
+  tm_thread_create(5, 2, tm_interrupt_preemption_thread_report);
+
+  // Thread 1 starts suspended and is only resumed by the handler
+  tm_thread_resume(0);
+  tm_thread_resume(5);
+}
+
+void tm_main(void) {
+  tm_initialize(tm_interrupt_preemption_processing_initialize);
+}
@@ -0,0 +1,70 @@
+// tm_interrupt_processing_test.c - Thread-Metric interrupt processing
+//
+// A thread raises the test interrupt, whose handler puts a semaphore; the
+// thread then gets it. Each loop is one interrupt entry/exit plus a
+// semaphore put from ISR context, without a context switch.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+static volatile unsigned long tm_interrupt_thread_0_counter;
+static volatile unsigned long tm_interrupt_handler_counter;
+
+static void tm_interrupt_thread_0_entry(void) {
+  while (1) {
+    tm_cause_interrupt();
+
+    // The handler has run and put the semaphore
+    if (tm_semaphore_get(0) != TM_SUCCESS) {
+      break;
+    }
+
+    tm_interrupt_thread_0_counter++;
+  }
+}
+
+void tm_interrupt_handler(void) {
+  tm_interrupt_handler_counter++;
+  tm_semaphore_put(0);
+}
+
+static void tm_interrupt_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Interrupt Processing Test **** Relative Time: "
+           "%lu\n",
+           relative_time);
+
+    unsigned long total = tm_interrupt_thread_0_counter;
+    unsigned long handled = tm_interrupt_handler_counter;
+    if (total + 1 < handled || total > handled + 1) {
+      printf("ERROR: Invalid counter value(s). Interrupt processing test has "
+             "failed!\n");
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_interrupt_processing_initialize(void) {
+  tm_thread_create(0, 10, tm_interrupt_thread_0_entry);
+  tm_thread_create(5, 2, tm_interrupt_thread_report);
+
+  // Created available; take it so only the handler's put satisfies a get
+  tm_semaphore_create(0);
+  tm_semaphore_get(0);
+
+  tm_thread_resume(0);
+  tm_thread_resume(5);
+}
+
+void tm_main(void) { tm_initialize(tm_interrupt_processing_initialize); }
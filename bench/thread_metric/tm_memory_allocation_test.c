@@ -0,0 +1,63 @@
+// tm_memory_allocation_test.c - Thread-Metric memory allocation
+//
+// One thread allocates a 128-byte block from a fixed-size pool and frees
+// it again in a loop.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+static volatile unsigned long tm_memory_allocation_counter;
+
+static void tm_memory_allocation_thread_0_entry(void) {
+  unsigned char *memory_ptr;
+
+  while (1) {
+    if (tm_memory_pool_allocate(0, &memory_ptr) != TM_SUCCESS) {
+      break;
+    }
+
+    if (tm_memory_pool_deallocate(0, memory_ptr) != TM_SUCCESS) {
+      break;
+    }
+
+    tm_memory_allocation_counter++;
+  }
+}
+
+static void tm_memory_allocation_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Memory Allocation Test **** Relative Time: "
+           "%lu\n",
+           relative_time);
+
+    unsigned long total = tm_memory_allocation_counter;
+    if (total == last_total) {
+      printf("ERROR: Invalid counter value(s). Error allocating/deallocating "
+             "memory!\n");
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_memory_allocation_initialize(void) {
+  tm_thread_create(0, 10, tm_memory_allocation_thread_0_entry);
+  tm_thread_create(5, 2, tm_memory_allocation_thread_report);
+
+  tm_memory_pool_create(0);
+
+  tm_thread_resume(0);
+  tm_thread_resume(5);
+}
+
+void tm_main(void) { tm_initialize(tm_memory_allocation_initialize); }
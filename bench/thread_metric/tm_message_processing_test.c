@@ -0,0 +1,69 @@
+// tm_message_processing_test.c - Thread-Metric message processing
+//
+// One thread sends a 16-byte message to a queue and receives it straight
+// back, checking the contents. Each loop is one send and one receive that
+// never block.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+static volatile unsigned long tm_message_processing_counter;
+static unsigned long tm_message_sent[TM_MESSAGE_WORDS];
+static unsigned long tm_message_received[TM_MESSAGE_WORDS];
+
+static void tm_message_processing_thread_0_entry(void) {
+  tm_message_sent[0] = 0x11112222;
+  tm_message_sent[1] = 0x33334444;
+  tm_message_sent[2] = 0x55556666;
+  tm_message_sent[3] = 0;
+
+  while (1) {
+    tm_queue_send(0, tm_message_sent);
+    tm_queue_receive(0, tm_message_received);
+
+    if (tm_message_received[3] != tm_message_sent[3]) {
+      break;
+    }
+
+    tm_message_sent[3]++;
+    tm_message_processing_counter++;
+  }
+}
+
+static void tm_message_processing_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Message Processing Test **** Relative Time: "
+           "%lu\n",
+           relative_time);
+
+    unsigned long total = tm_message_processing_counter;
+    if (total == last_total) {
+      printf("ERROR: Invalid counter value(s). Error sending/receiving "
+             "messages!\n");
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_message_processing_initialize(void) {
+  tm_thread_create(0, 10, tm_message_processing_thread_0_entry);
+  tm_thread_create(5, 2, tm_message_processing_thread_report);
+
+  tm_queue_create(0);
+
+  tm_thread_resume(0);
+  tm_thread_resume(5);
+}
+
+void tm_main(void) { tm_initialize(tm_message_processing_initialize); }
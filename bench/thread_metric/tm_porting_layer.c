@@ -0,0 +1,326 @@
+// tm_porting_layer.c - Thread-Metric on Morph-RT
+//
+// Maps the Thread-Metric porting interface (tm_api.h) onto kernel.h,
+// queue.h, semaphore.h and memory.h.
+//
+// Morph-RT has no suspend/resume, so every thread owns a binary "gate"
+// semaphore: resume posts it, suspend waits on it. Thread-Metric only ever
+// suspends the calling thread, which is all this supports. The kernel does
+// not preempt when a post readies a more urgent task, so resume follows
+// the post with scheduler_yield(), the same pick-and-pend the tick uses.
+// That also works from the test ISR: PendSV runs once the ISR returns.
+//
+// The test interrupt is IRQ 0, pended in software through the NVIC. Its
+// priority is just below KERNEL_MAX_SYSCALL_PRIORITY so it may call the
+// kernel. On the POSIX port it is the port's simulated IRQ (SIGUSR2).
+
+#include "tm_api.h"
+
+#include "kernel.h"
+#include "memory.h"
+#include "port.h"
+#include "queue.h"
+#include "scheduler.h"
+#include "semaphore.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TM_MAX_THREADS 6 // Five test threads plus the reporter
+#define TM_MAX_QUEUES 1
+#define TM_MAX_SEMAPHORES 1
+#define TM_MAX_POOLS 1
+
+#define TM_QUEUE_LENGTH 4 // Power of two, like every queue buffer
+
+#ifndef TM_TICKS_PER_SECOND
+#define TM_TICKS_PER_SECOND 1000 // scheduler_start() programs a 1 ms tick
+#endif
+
+#define TM_WAIT_FOREVER 0x7FFFFFFFu // For APIs without a constant
+
+#ifdef __ARM_ARCH
+#define NVIC_ISER0 (*(volatile uint32_t *)0xE000E100)
+#define NVIC_ISPR0 (*(volatile uint32_t *)0xE000E200)
+#define NVIC_IPR0 ((volatile uint8_t *)0xE000E400)
+
+#define TM_IRQ 0
+#define TM_IRQ_PRIORITY                                                        \
+  ((KERNEL_MAX_SYSCALL_PRIORITY + 1) << (8 - PORT_NVIC_PRIO_BITS))
+#endif
+
+#if defined(__ARM_ARCH) || PORT_POSIX
+void IRQ0_Handler(void);
+#endif
+
+static task_handle_t tm_threads[TM_MAX_THREADS];
+static semaphore_handle_t tm_thread_gates[TM_MAX_THREADS];
+static void (*tm_thread_entries[TM_MAX_THREADS])(void);
+
+static queue_handle_t tm_queues[TM_MAX_QUEUES];
+static semaphore_handle_t tm_semaphores[TM_MAX_SEMAPHORES];
+static pool_type_t tm_pools[TM_MAX_POOLS];
+
+#if TM_TEST_CYCLES > 0
+static unsigned tm_reports;
+#endif
+
+// ============================== HELPER FUNCTIONS =============================
+
+// Thread-Metric uses 1..31 and the tests only need a handful of levels:
+// 1-2 (reporter) map to 0, 6-10 (preemptive test) to 1-5, and anything in
+// between to 1. The idle priority is never handed out.
+static task_priority_t tm_map_priority(int priority) {
+  if (priority <= 2) {
+    return 0;
+  }
+
+  int mapped = priority - 5;
+  if (mapped < 1) {
+    mapped = 1;
+  }
+  if (mapped > MAX_PRIORITY - 1) {
+    mapped = MAX_PRIORITY - 1;
+  }
+
+  return (task_priority_t)mapped;
+}
+
+static void tm_thread_trampoline(void *param) {
+  int id = (int)(intptr_t)param;
+
+  // Created suspended
+  sem_wait(tm_thread_gates[id], SEM_WAIT_FOREVER);
+
+  tm_thread_entries[id]();
+
+  // Thread-Metric entries never return
+  while (1) {
+    tm_thread_suspend(id);
+  }
+}
+
+static void tm_exit(int status) {
+#if defined(__ARM_ARCH) && !defined(TM_SEMIHOSTING)
+  (void)status;
+  while (1) {
+  }
+#else
+  exit(status);
+#endif
+}
+
+// ================================ PUBLIC API =================================
+
+int tm_initialize(void (*test_initialization_function)(void)) {
+  kernel_init();
+
+#ifdef __ARM_ARCH
+  NVIC_IPR0[TM_IRQ] = TM_IRQ_PRIORITY;
+  NVIC_ISER0 = 1u << TM_IRQ;
+#elif PORT_POSIX
+  port_posix_set_irq_handler(IRQ0_Handler);
+#endif
+
+  test_initialization_function();
+
+  kernel_start();
+  return TM_ERROR;
+}
+
+int tm_thread_create(int thread_id, int priority,
+                     void (*entry_function)(void)) {
+  if (thread_id < 0 || thread_id >= TM_MAX_THREADS || !entry_function) {
+    return TM_ERROR;
+  }
+
+  tm_thread_gates[thread_id] = sem_create(0, 1, "tm_gate");
+  if (!tm_thread_gates[thread_id]) {
+    return TM_ERROR;
+  }
+
+  tm_thread_entries[thread_id] = entry_function;
+  tm_threads[thread_id] =
+      task_create(tm_thread_trampoline, "tm_thread", DEFAULT_STACK_SIZE,
+                  (void *)(intptr_t)thread_id, tm_map_priority(priority));
+
+  return tm_threads[thread_id] ? TM_SUCCESS : TM_ERROR;
+}
+
+int tm_thread_resume(int thread_id) {
+  if (thread_id < 0 || thread_id >= TM_MAX_THREADS ||
+      !tm_thread_gates[thread_id]) {
+    return TM_ERROR;
+  }
+
+  if (sem_post(tm_thread_gates[thread_id]) != SEM_OK) {
+    return TM_ERROR; // Not suspended
+  }
+
+  // Switch now if the resumed thread is more urgent than the caller. Before
+  // kernel_start() there is nothing to switch away from.
+  if (task_get_current()) {
+    scheduler_yield();
+  }
+  return TM_SUCCESS;
+}
+
+int tm_thread_suspend(int thread_id) {
+  if (thread_id < 0 || thread_id >= TM_MAX_THREADS ||
+      tm_threads[thread_id] != task_get_current()) {
+    return TM_ERROR;
+  }
+
+  return sem_wait(tm_thread_gates[thread_id], SEM_WAIT_FOREVER) == SEM_OK
+             ? TM_SUCCESS
+             : TM_ERROR;
+}
+
+void tm_thread_relinquish(void) { task_yield(); }
+
+void tm_thread_sleep(int seconds) {
+  task_delay((uint32_t)seconds * TM_TICKS_PER_SECOND);
+}
+
+int tm_queue_create(int queue_id) {
+  if (queue_id < 0 || queue_id >= TM_MAX_QUEUES) {
+    return TM_ERROR;
+  }
+
+  tm_queues[queue_id] = queue_create(
+      TM_QUEUE_LENGTH, TM_MESSAGE_WORDS * sizeof(unsigned long));
+
+  return tm_queues[queue_id] ? TM_SUCCESS : TM_ERROR;
+}
+
+int tm_queue_send(int queue_id, unsigned long *message_ptr) {
+  if (queue_id < 0 || queue_id >= TM_MAX_QUEUES) {
+    return TM_ERROR;
+  }
+
+  return queue_send(tm_queues[queue_id], message_ptr, TM_WAIT_FOREVER) ==
+                 QUEUE_SUCCESS
+             ? TM_SUCCESS
+             : TM_ERROR;
+}
+
+int tm_queue_receive(int queue_id, unsigned long *message_ptr) {
+  if (queue_id < 0 || queue_id >= TM_MAX_QUEUES) {
+    return TM_ERROR;
+  }
+
+  return queue_receive(tm_queues[queue_id], message_ptr, TM_WAIT_FOREVER) ==
+                 QUEUE_SUCCESS
+             ? TM_SUCCESS
+             : TM_ERROR;
+}
+
+int tm_semaphore_create(int semaphore_id) {
+  if (semaphore_id < 0 || semaphore_id >= TM_MAX_SEMAPHORES) {
+    return TM_ERROR;
+  }
+
+  tm_semaphores[semaphore_id] = sem_create(1, 1, "tm_sem");
+
+  return tm_semaphores[semaphore_id] ? TM_SUCCESS : TM_ERROR;
+}
+
+int tm_semaphore_get(int semaphore_id) {
+  if (semaphore_id < 0 || semaphore_id >= TM_MAX_SEMAPHORES) {
+    return TM_ERROR;
+  }
+
+  // Thread-Metric "get" never blocks
+  return sem_try_wait(tm_semaphores[semaphore_id]) == SEM_OK ? TM_SUCCESS
+                                                             : TM_ERROR;
+}
+
+int tm_semaphore_put(int semaphore_id) {
+  if (semaphore_id < 0 || semaphore_id >= TM_MAX_SEMAPHORES) {
+    return TM_ERROR;
+  }
+
+  return sem_post(tm_semaphores[semaphore_id]) == SEM_OK ? TM_SUCCESS
+                                                         : TM_ERROR;
+}
+
+int tm_memory_pool_create(int pool_id) {
+  if (pool_id < 0 || pool_id >= TM_MAX_POOLS) {
+    return TM_ERROR;
+  }
+
+  // The kernel pools are static; pick the smallest that fits a block
+  tm_pools[pool_id] = TM_MEMORY_BLOCK_SIZE <= SMALL_BUFFER_SIZE
+                          ? POOL_BUFFER_SMALL
+                          : POOL_BUFFER_MEDIUM;
+  return TM_SUCCESS;
+}
+
+int tm_memory_pool_allocate(int pool_id, unsigned char **memory_ptr) {
+  if (pool_id < 0 || pool_id >= TM_MAX_POOLS || !memory_ptr) {
+    return TM_ERROR;
+  }
+
+  *memory_ptr = pool_alloc(tm_pools[pool_id]);
+  return *memory_ptr ? TM_SUCCESS : TM_ERROR;
+}
+
+int tm_memory_pool_deallocate(int pool_id, unsigned char *memory_ptr) {
+  if (pool_id < 0 || pool_id >= TM_MAX_POOLS) {
+    return TM_ERROR;
+  }
+
+  return pool_free(tm_pools[pool_id], memory_ptr) ? TM_SUCCESS : TM_ERROR;
+}
+
+void tm_cause_interrupt(void) {
+#ifdef __ARM_ARCH
+  NVIC_ISPR0 = 1u << TM_IRQ;
+  // Taken before the next instruction, like a real device interrupt
+  __asm volatile("dsb\n\tisb" ::: "memory");
+#elif PORT_POSIX
+  port_posix_trigger_irq(); // Delivered before this returns
+#else
+  kernel_isr_enter();
+  tm_interrupt_handler();
+  kernel_isr_exit();
+#endif
+}
+
+// Tests without an interrupt leave this in place
+__attribute__((weak)) void tm_interrupt_handler(void) {}
+
+#if defined(__ARM_ARCH) || PORT_POSIX
+void IRQ0_Handler(void) {
+  kernel_isr_enter();
+  tm_interrupt_handler();
+  kernel_isr_exit();
+}
+#endif
+
+void tm_report_done(void) {
+#if TM_TEST_CYCLES > 0
+  if (++tm_reports >= TM_TEST_CYCLES) {
+    tm_exit(0);
+  }
+#endif
+}
+
+#ifdef TM_SEMIHOSTING
+extern void initialise_monitor_handles(void);
+#endif
+
+int main(void) {
+#ifdef TM_SEMIHOSTING
+  initialise_monitor_handles();
+#endif
+  // Unbuffered, so printf never needs the heap from inside a task
+  setvbuf(stdout, NULL, _IONBF, 0);
+
+  tm_main();
+
+  printf("tm: initialization failed\n");
+  tm_exit(1);
+  return 1;
+}
@@ -0,0 +1,101 @@
+// tm_preemptive_scheduling_test.c - Thread-Metric preemptive scheduling
+//
+// Five threads at five priorities. Each resumes the next more urgent one,
+// which preempts it at once; the most urgent bumps its counter and
+// suspends, and the chain unwinds. One pass through thread 0's loop is
+// five preemptions in each direction. All counters must stay in lockstep.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+#define TM_PREEMPT_THREADS 5
+
+static volatile unsigned long tm_preemptive_counter[TM_PREEMPT_THREADS];
+
+static void tm_preemptive_thread_0_entry(void) {
+  while (1) {
+    tm_thread_resume(1);
+    tm_preemptive_counter[0]++;
+  }
+}
+
+static void tm_preemptive_thread_1_entry(void) {
+  while (1) {
+    tm_thread_resume(2);
+    tm_preemptive_counter[1]++;
+    tm_thread_suspend(1);
+  }
+}
+
+static void tm_preemptive_thread_2_entry(void) {
+  while (1) {
+    tm_thread_resume(3);
+    tm_preemptive_counter[2]++;
+    tm_thread_suspend(2);
+  }
+}
+
+static void tm_preemptive_thread_3_entry(void) {
+  while (1) {
+    tm_thread_resume(4);
+    tm_preemptive_counter[3]++;
+    tm_thread_suspend(3);
+  }
+}
+
+static void tm_preemptive_thread_4_entry(void) {
+  while (1) {
+    tm_preemptive_counter[4]++;
+    tm_thread_suspend(4);
+  }
+}
+
+static void tm_preemptive_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Preemptive Scheduling Test **** Relative Time: "
+           "%lu\n",
+           relative_time);
+
+    unsigned long total = 0;
+    for (int i = 0; i < TM_PREEMPT_THREADS; i++) {
+      total += tm_preemptive_counter[i];
+    }
+
+    unsigned long average = total / TM_PREEMPT_THREADS;
+    for (int i = 0; i < TM_PREEMPT_THREADS; i++) {
+      if (tm_preemptive_counter[i] + 1 < average ||
+          tm_preemptive_counter[i] > average + 1) {
+        printf("ERROR: Invalid counter value(s). Preemptive counters should "
+               "not be more that 1 different than the average!\n");
+        break;
+      }
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_preemptive_scheduling_initialize(void) {
+  tm_thread_create(0, 10, tm_preemptive_thread_0_entry);
+  tm_thread_create(1, 9, tm_preemptive_thread_1_entry);
+  tm_thread_create(2, 8, tm_preemptive_thread_2_entry);
+  tm_thread_create(3, 7, tm_preemptive_thread_3_entry);
+  tm_thread_create(4, 6, tm_preemptive_thread_4_entry);
+  tm_thread_create(5, 2, tm_preemptive_thread_report);
+
+  // Threads 1-4 are only ever resumed by the chain
+  tm_thread_resume(0);
+  tm_thread_resume(5);
+}
+
+void tm_main(void) { tm_initialize(tm_preemptive_scheduling_initialize); }
@@ -0,0 +1,62 @@
+// tm_synchronization_processing_test.c - Thread-Metric synchronization
+// processing
+//
+// One thread gets and puts a semaphore in a loop. Neither call ever blocks,
+// so this is the raw cost of an uncontended semaphore pair.
+
+#include "tm_api.h"
+
+#include <stdio.h>
+
+static volatile unsigned long tm_synchronization_processing_counter;
+
+static void tm_synchronization_processing_thread_0_entry(void) {
+  while (1) {
+    if (tm_semaphore_get(0) != TM_SUCCESS) {
+      break;
+    }
+
+    if (tm_semaphore_put(0) != TM_SUCCESS) {
+      break;
+    }
+
+    tm_synchronization_processing_counter++;
+  }
+}
+
+static void tm_synchronization_processing_thread_report(void) {
+  unsigned long last_total = 0;
+  unsigned long relative_time = 0;
+
+  while (1) {
+    tm_thread_sleep(TM_TEST_DURATION);
+    relative_time += TM_TEST_DURATION;
+
+    printf("**** Thread-Metric Synchronization Processing Test **** Relative "
+           "Time: %lu\n",
+           relative_time);
+
+    unsigned long total = tm_synchronization_processing_counter;
+    if (total == last_total) {
+      printf("ERROR: Invalid counter value(s). Error getting/putting "
+             "semaphore!\n");
+    }
+
+    printf("Time Period Total:  %lu\n\n", total - last_total);
+    last_total = total;
+
+    tm_report_done();
+  }
+}
+
+static void tm_synchronization_processing_initialize(void) {
+  tm_thread_create(0, 10, tm_synchronization_processing_thread_0_entry);
+  tm_thread_create(5, 2, tm_synchronization_processing_thread_report);
+
+  tm_semaphore_create(0);
+
+  tm_thread_resume(0);
+  tm_thread_resume(5);
+}
+
+void tm_main(void) { tm_initialize(tm_synchronization_processing_initialize); }
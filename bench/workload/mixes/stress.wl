@@ -0,0 +1,23 @@
+# Stress mix: 25 tasks at roughly half load
+#
+# Twenty sensor pollers share a bus mutex with a slow logger, a three-stage
+# chain runs acquire -> filter -> publish over queues, and publish wakes an
+# alarm handler through a semaphore. filter has a long-tailed execution
+# time; publish and alarm report the chain's end-to-end latency.
+
+seed 1
+duration 5
+
+queue raw 8
+queue filtered 8
+sem   alarm_sem
+mutex bus
+
+task acquire  prio=2 period=2 exec=100 send=raw
+task filter   prio=3 wait=raw exec=exp:150 send=filtered deadline=2
+task publish  prio=5 wait=filtered exec=80 post=alarm_sem deadline=4
+task alarm    prio=1 wait=alarm_sem exec=20 deadline=4
+
+task sensor   prio=4 period=10 offset=1 exec=50..150 lock=bus:5..20 count=20
+
+task logger   prio=6 period=100 exec=5000..15000 lock=bus:200
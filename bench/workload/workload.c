@@ -0,0 +1,660 @@
+// workload.c - Synthetic task-set generator (format in workload.h)
+//
+// Reads a workload file (argv[1] on the host, WORKLOAD_FILE over
+// semihosting under QEMU), creates its objects and tasks through the
+// public API and runs them on the real kernel. Results are CSV lines:
+//
+//   wl,<name>,<prio>,<jobs>,<misses>,<p50_us>,<p90_us>,<p99_us>,<max_us>,
+//      <cpu_permille>
+//   wl_total,<workload_cpu_permille>,<cpu_load_permille>
+//
+// Execution time is a calibrated spin loop, so a preempted job still does
+// all of its work after it resumes.
+
+#include "workload.h"
+
+#include "critical.h"
+#include "mutex.h"
+#include "port.h"
+#include "queue.h"
+#include "runtime_stats.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "task.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !LATENCY_STATS_ENABLED || !RUNTIME_STATS_ENABLED
+#error "workload needs LATENCY_STATS_ENABLED and RUNTIME_STATS_ENABLED"
+#endif
+
+#ifndef WORKLOAD_FILE
+#define WORKLOAD_FILE "workload.wl"
+#endif
+
+#define WL_TEXT_MAX 16384
+#define WL_LINE_MAX 256
+#define WL_MAX_TOKENS 16
+
+#define WL_WAIT 0x7FFFFFFFu // "Forever" for queues
+#define WL_SEM_MAX 255
+#define WL_QUEUE_LENGTH 8
+#define WL_RUNNER_PRIORITY 0
+#define WL_CYCLES_PER_TICK (PORT_CYCLE_COUNTER_HZ / KERNEL_TICK_HZ)
+
+#define WL_CALIBRATE_LOOPS 200000u
+
+typedef struct wl_message {
+  uint32_t release; // Cycle count the chain's first job was released at
+  uint32_t seq;
+} wl_message_t;
+
+static semaphore_handle_t wl_go;
+static uint32_t wl_epoch_cycles; // Common start, on a tick edge
+static uint32_t wl_epoch_tick;
+static uint32_t wl_loops_per_kcycle; // Spin iterations per 1000 cycles
+
+// ============================== HELPER FUNCTIONS =============================
+
+static uint32_t wl_us_to_cycles(uint32_t us) {
+  return (uint32_t)((uint64_t)us * PORT_CYCLE_COUNTER_HZ / 1000000u);
+}
+
+static uint32_t wl_cycles_to_us(uint32_t cycles) {
+  return (uint32_t)((uint64_t)cycles * 1000000u / PORT_CYCLE_COUNTER_HZ);
+}
+
+static void wl_spin(uint32_t loops) {
+  for (volatile uint32_t i = 0; i < loops; i++) {
+  }
+}
+
+static void wl_burn(uint32_t us) {
+  wl_spin((uint32_t)((uint64_t)wl_us_to_cycles(us) * wl_loops_per_kcycle /
+                     1000u));
+}
+
+static uint32_t wl_random(wl_task_t *task) {
+  uint32_t x = task->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  task->rng = x;
+  return x;
+}
+
+static uint32_t wl_draw(wl_task_t *task, const wl_dist_t *dist) {
+  switch (dist->type) {
+  case WL_DIST_UNIFORM:
+    return dist->a_us + wl_random(task) % (dist->b_us - dist->a_us + 1);
+  case WL_DIST_EXP: {
+    // u in (0, 1]
+    double u = ((wl_random(task) >> 8) + 1) / (double)(1u << 24);
+    double us = -(double)dist->a_us * log(u);
+    double cap = 10.0 * dist->a_us;
+    return (uint32_t)(us < cap ? us : cap);
+  }
+  default:
+    return dist->a_us;
+  }
+}
+
+// Exact below 2^WL_HIST_SUB_BITS, then WL_HIST_SUB_BITS bits of mantissa
+static uint32_t wl_bucket(uint32_t cycles) {
+  if (cycles < (1u << WL_HIST_SUB_BITS)) {
+    return cycles;
+  }
+  uint32_t msb = 31u - (uint32_t)__builtin_clz(cycles);
+  uint32_t sub =
+      (cycles >> (msb - WL_HIST_SUB_BITS)) & ((1u << WL_HIST_SUB_BITS) - 1);
+  return ((msb - WL_HIST_SUB_BITS + 1) << WL_HIST_SUB_BITS) + sub;
+}
+
+static uint32_t wl_bucket_upper(uint32_t bucket) {
+  if (bucket < (1u << WL_HIST_SUB_BITS)) {
+    return bucket;
+  }
+  uint32_t shift = (bucket >> WL_HIST_SUB_BITS) - 1;
+  uint32_t sub = bucket & ((1u << WL_HIST_SUB_BITS) - 1);
+  uint64_t lower = (uint64_t)((1u << WL_HIST_SUB_BITS) + sub) << shift;
+  uint64_t upper = lower + (1ull << shift) - 1;
+  return upper > UINT32_MAX ? UINT32_MAX : (uint32_t)upper;
+}
+
+static void wl_record(wl_task_t *task, uint32_t release) {
+  // Signed, so an estimated release that lands past now counts as no wait
+  // instead of wrapping to a huge response
+  int32_t elapsed = (int32_t)(port_cycle_count() - release);
+  uint32_t response = elapsed > 0 ? (uint32_t)elapsed : 0;
+
+  task->jobs++;
+  task->hist[wl_bucket(response)]++;
+  if (response > task->max_cycles) {
+    task->max_cycles = response;
+  }
+  if (task->deadline_ms &&
+      response > task->deadline_ms * (PORT_CYCLE_COUNTER_HZ / 1000u)) {
+    task->misses++;
+  }
+}
+
+// The semaphore carries the poster's release time alongside the count
+static void wl_sem_push(wl_object_t *sem, uint32_t release) {
+  KERNEL_CRITICAL_BEGIN();
+  if (sem->release_count < WL_SEM_BACKLOG) {
+    uint32_t slot = (sem->release_head + sem->release_count) % WL_SEM_BACKLOG;
+    sem->releases[slot] = release;
+    sem->release_count++;
+  }
+  KERNEL_CRITICAL_END();
+}
+
+static uint32_t wl_sem_pop(wl_object_t *sem) {
+  uint32_t release = port_cycle_count(); // Backlog overflowed
+  KERNEL_CRITICAL_BEGIN();
+  if (sem->release_count > 0) {
+    release = sem->releases[sem->release_head];
+    sem->release_head = (sem->release_head + 1) % WL_SEM_BACKLOG;
+    sem->release_count--;
+  }
+  KERNEL_CRITICAL_END();
+  return release;
+}
+
+static uint32_t wl_wait_release(wl_task_t *task) {
+  if (task->period_ms) {
+    uint32_t release;
+    int32_t ahead = (int32_t)(task->next_tick - tick_now);
+    if (ahead > 0) {
+      task_delay((uint32_t)ahead);
+      // Stamped by the tick that readied us
+      release = task->handle->ready_since;
+      task->anchor_tick = task->next_tick;
+      task->anchor_cycles = release;
+    } else {
+      // An overrun job's successor was released on a tick we were busy
+      // through, so it is estimated from the last one seen. Ticks that
+      // arrive late and then bunch up (host signals) can put that past
+      // now; the release is never later than the job starting.
+      release = task->anchor_cycles +
+                (task->next_tick - task->anchor_tick) * WL_CYCLES_PER_TICK;
+      uint32_t now = port_cycle_count();
+      if ((int32_t)(release - now) > 0) {
+        release = now;
+      }
+    }
+    task->next_tick += TIME_MS_TO_TICKS(task->period_ms);
+    return release;
+  }
+
+  if (task->wait->type == WL_OBJ_QUEUE) {
+    wl_message_t msg;
+    queue_receive(task->wait->handle, &msg, WL_WAIT);
+    return msg.release;
+  }
+
+  sem_wait(task->wait->handle, SEM_WAIT_FOREVER);
+  return wl_sem_pop(task->wait);
+}
+
+static void wl_task_body(void *param) {
+  wl_task_t *task = param;
+
+  sem_wait(wl_go, SEM_WAIT_FOREVER);
+  task->anchor_tick = wl_epoch_tick;
+  task->anchor_cycles = wl_epoch_cycles;
+  task->next_tick =
+      wl_epoch_tick + TIME_MS_TO_TICKS(task->offset_ms);
+
+  while (1) {
+    uint32_t release = wl_wait_release(task);
+
+    wl_burn(wl_draw(task, &task->exec));
+
+    if (task->lock) {
+      mutex_lock(task->lock->handle, MUTEX_WAIT_FOREVER);
+      wl_burn(wl_draw(task, &task->lock_exec));
+      mutex_unlock(task->lock->handle);
+    }
+
+    if (task->send) {
+      wl_message_t msg = {release, task->jobs};
+      queue_send(task->send->handle, &msg, WL_WAIT);
+    }
+
+    if (task->post) {
+      wl_sem_push(task->post, release);
+      sem_post(task->post->handle);
+    }
+
+    wl_record(task, release);
+  }
+}
+
+static void wl_exit(int status) {
+#if defined(__ARM_ARCH) && !defined(WORKLOAD_SEMIHOSTING)
+  (void)status;
+  while (1) {
+  }
+#else
+  exit(status);
+#endif
+}
+
+static void wl_report(const workload_t *wl) {
+  uint32_t total_permille = 0;
+
+  printf("# workload tasks=%lu duration=%lus seed=%lu\n",
+         (unsigned long)wl->task_count, (unsigned long)wl->duration_s,
+         (unsigned long)wl->seed);
+
+  for (size_t i = 0; i < wl->task_count; i++) {
+    const wl_task_t *task = &wl->tasks[i];
+    task_runtime_stats_t stats = {0};
+    task_get_runtime_stats(task->handle, &stats);
+    total_permille += stats.share_permille;
+
+    printf("wl,%s,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", task->name,
+           (unsigned)task->priority, (unsigned long)task->jobs,
+           (unsigned long)task->misses,
+           (unsigned long)wl_cycles_to_us(workload_percentile(task, 500)),
+           (unsigned long)wl_cycles_to_us(workload_percentile(task, 900)),
+           (unsigned long)wl_cycles_to_us(workload_percentile(task, 990)),
+           (unsigned long)wl_cycles_to_us(task->max_cycles),
+           (unsigned long)stats.share_permille);
+  }
+
+  printf("wl_total,%lu,%lu\n", (unsigned long)total_permille,
+         (unsigned long)kernel_get_cpu_load());
+}
+
+// Highest priority: calibrates, starts everyone on one tick edge, reports
+static void wl_runner(void *param) {
+  workload_t *wl = param;
+
+  uint32_t start = port_cycle_count();
+  wl_spin(WL_CALIBRATE_LOOPS);
+  uint32_t elapsed = port_cycle_count() - start;
+  wl_loops_per_kcycle =
+      (uint32_t)((uint64_t)WL_CALIBRATE_LOOPS * 1000u / (elapsed ? elapsed : 1));
+
+  task_delay(1);
+  wl_epoch_cycles = task_get_current()->ready_since;
+  wl_epoch_tick = tick_now;
+  for (size_t i = 0; i < wl->task_count; i++) {
+    sem_post(wl_go);
+  }
+
+  task_delay(wl->duration_s * KERNEL_TICK_HZ);
+
+  wl_report(wl);
+  wl_exit(0);
+}
+
+// ================================ PARSER =====================================
+
+static bool wl_parse_uint(const char *text, uint32_t *out) {
+  char *end;
+  if (!isdigit((unsigned char)*text)) {
+    return false;
+  }
+  unsigned long value = strtoul(text, &end, 10);
+  if (*end != '\0' || value > UINT32_MAX) {
+    return false;
+  }
+  *out = (uint32_t)value;
+  return true;
+}
+
+static bool wl_parse_dist(const char *text, wl_dist_t *dist) {
+  char buf[32];
+  const char *range = strstr(text, "..");
+
+  if (strncmp(text, "exp:", 4) == 0) {
+    dist->type = WL_DIST_EXP;
+    return wl_parse_uint(text + 4, &dist->a_us) && dist->a_us > 0;
+  }
+
+  if (range) {
+    size_t len = (size_t)(range - text);
+    if (len >= sizeof(buf)) {
+      return false;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+    dist->type = WL_DIST_UNIFORM;
+    return wl_parse_uint(buf, &dist->a_us) &&
+           wl_parse_uint(range + 2, &dist->b_us) && dist->b_us >= dist->a_us;
+  }
+
+  dist->type = WL_DIST_CONST;
+  return wl_parse_uint(text, &dist->a_us);
+}
+
+static wl_object_t *wl_find(workload_t *wl, const char *name) {
+  for (size_t i = 0; i < wl->object_count; i++) {
+    if (strcmp(wl->objects[i].name, name) == 0) {
+      return &wl->objects[i];
+    }
+  }
+  return NULL;
+}
+
+static bool wl_name_taken(workload_t *wl, const char *name) {
+  if (wl_find(wl, name)) {
+    return true;
+  }
+  for (size_t i = 0; i < wl->task_count; i++) {
+    if (strcmp(wl->tasks[i].name, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char *wl_parse_object(workload_t *wl, char **tok, int ntok) {
+  wl_obj_type_t type = strcmp(tok[0], "queue") == 0 ? WL_OBJ_QUEUE
+                       : strcmp(tok[0], "sem") == 0 ? WL_OBJ_SEM
+                                                    : WL_OBJ_MUTEX;
+
+  if (ntok < 2 || ntok > (type == WL_OBJ_QUEUE ? 3 : 2)) {
+    return "expected: queue <name> [length] | sem <name> | mutex <name>";
+  }
+  if (strlen(tok[1]) >= WL_MAX_NAME || wl_name_taken(wl, tok[1])) {
+    return "name too long or already used";
+  }
+  if (wl->object_count >= sizeof(wl->objects) / sizeof(wl->objects[0])) {
+    return "too many objects";
+  }
+
+  wl_object_t *obj = &wl->objects[wl->object_count++];
+  memset(obj, 0, sizeof(*obj));
+  strcpy(obj->name, tok[1]);
+  obj->type = type;
+  obj->length = WL_QUEUE_LENGTH;
+
+  if (ntok == 3 && (!wl_parse_uint(tok[2], &obj->length) ||
+                    obj->length == 0 || (obj->length & (obj->length - 1)))) {
+    return "queue length must be a power of two";
+  }
+  return NULL;
+}
+
+static const char *wl_parse_object_ref(workload_t *wl, const char *name,
+                                       wl_obj_type_t a, wl_obj_type_t b,
+                                       wl_object_t **out) {
+  wl_object_t *obj = wl_find(wl, name);
+  if (!obj || (obj->type != a && obj->type != b)) {
+    return "unknown object, or the wrong kind";
+  }
+  *out = obj;
+  return NULL;
+}
+
+static const char *wl_parse_task(workload_t *wl, char **tok, int ntok) {
+  wl_task_t proto;
+  uint32_t count = 1;
+  uint32_t priority = 0;
+  bool has_deadline = false;
+  const char *err = NULL;
+
+  if (ntok < 2 || strlen(tok[1]) >= WL_MAX_NAME - 2) {
+    return "expected: task <name> key=value...";
+  }
+
+  memset(&proto, 0, sizeof(proto));
+  strcpy(proto.name, tok[1]);
+
+  for (int i = 2; i < ntok && !err; i++) {
+    char *key = tok[i];
+    char *value = strchr(key, '=');
+    if (!value) {
+      return "expected key=value";
+    }
+    *value++ = '\0';
+
+    if (strcmp(key, "prio") == 0) {
+      if (!wl_parse_uint(value, &priority)) err = "bad prio";
+    } else if (strcmp(key, "period") == 0) {
+      if (!wl_parse_uint(value, &proto.period_ms) || !proto.period_ms)
+        err = "bad period";
+    } else if (strcmp(key, "offset") == 0) {
+      if (!wl_parse_uint(value, &proto.offset_ms)) err = "bad offset";
+    } else if (strcmp(key, "deadline") == 0) {
+      has_deadline = true;
+      if (!wl_parse_uint(value, &proto.deadline_ms)) err = "bad deadline";
+    } else if (strcmp(key, "count") == 0) {
+      if (!wl_parse_uint(value, &count) || count == 0 || count > 99)
+        err = "count must be 1..99";
+    } else if (strcmp(key, "exec") == 0) {
+      if (!wl_parse_dist(value, &proto.exec)) err = "bad exec distribution";
+    } else if (strcmp(key, "wait") == 0) {
+      err = wl_parse_object_ref(wl, value, WL_OBJ_QUEUE, WL_OBJ_SEM,
+                                &proto.wait);
+    } else if (strcmp(key, "send") == 0) {
+      err = wl_parse_object_ref(wl, value, WL_OBJ_QUEUE, WL_OBJ_QUEUE,
+                                &proto.send);
+    } else if (strcmp(key, "post") == 0) {
+      err = wl_parse_object_ref(wl, value, WL_OBJ_SEM, WL_OBJ_SEM,
+                                &proto.post);
+    } else if (strcmp(key, "lock") == 0) {
+      char *dist = strchr(value, ':');
+      if (!dist) {
+        return "expected lock=<mutex>:<dist>";
+      }
+      *dist++ = '\0';
+      err = wl_parse_object_ref(wl, value, WL_OBJ_MUTEX, WL_OBJ_MUTEX,
+                                &proto.lock);
+      if (!err && !wl_parse_dist(dist, &proto.lock_exec))
+        err = "bad lock distribution";
+    } else {
+      err = "unknown key";
+    }
+  }
+  if (err) {
+    return err;
+  }
+
+  if (priority < 1 || priority >= MAX_PRIORITY) {
+    return "prio must be 1..MAX_PRIORITY-1";
+  }
+  if (!proto.period_ms == !proto.wait) {
+    return "give exactly one of period= and wait=";
+  }
+  if (wl->task_count + count > WL_MAX_TASKS) {
+    return "too many tasks (raise MAX_TASKS)";
+  }
+  if (wl_name_taken(wl, proto.name)) {
+    return "name already used";
+  }
+
+  proto.priority = (task_priority_t)priority;
+  if (!has_deadline) {
+    proto.deadline_ms = proto.period_ms;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    wl_task_t *task = &wl->tasks[wl->task_count++];
+    *task = proto;
+    if (count > 1) {
+      snprintf(task->name, sizeof(task->name), "%s%lu", proto.name,
+               (unsigned long)i);
+    }
+  }
+  return NULL;
+}
+
+// ================================ PUBLIC API =================================
+
+bool workload_parse(workload_t *wl, const char *text) {
+  unsigned line_no = 0;
+
+  memset(wl, 0, sizeof(*wl));
+  wl->seed = 1;
+  wl->duration_s = 10;
+
+  while (*text) {
+    char line[WL_LINE_MAX];
+    char *tok[WL_MAX_TOKENS];
+    int ntok = 0;
+    size_t len = strcspn(text, "\n");
+    const char *err = NULL;
+
+    line_no++;
+    if (len >= sizeof(line)) {
+      printf("workload: line %u: line too long\n", line_no);
+      return false;
+    }
+    memcpy(line, text, len);
+    line[len] = '\0';
+    text += len + (text[len] == '\n');
+
+    char *hash = strchr(line, '#');
+    if (hash) {
+      *hash = '\0';
+    }
+    for (char *t = strtok(line, " \t\r"); t; t = strtok(NULL, " \t\r")) {
+      if (ntok == WL_MAX_TOKENS) {
+        err = "too many fields";
+        break;
+      }
+      tok[ntok++] = t;
+    }
+    if (ntok == 0 && !err) {
+      continue;
+    }
+
+    if (err) {
+      // Reported below
+    } else if (strcmp(tok[0], "seed") == 0) {
+      if (ntok != 2 || !wl_parse_uint(tok[1], &wl->seed)) err = "bad seed";
+    } else if (strcmp(tok[0], "duration") == 0) {
+      if (ntok != 2 || !wl_parse_uint(tok[1], &wl->duration_s) ||
+          !wl->duration_s)
+        err = "bad duration";
+    } else if (strcmp(tok[0], "queue") == 0 || strcmp(tok[0], "sem") == 0 ||
+               strcmp(tok[0], "mutex") == 0) {
+      err = wl_parse_object(wl, tok, ntok);
+    } else if (strcmp(tok[0], "task") == 0) {
+      err = wl_parse_task(wl, tok, ntok);
+    } else {
+      err = "unknown directive";
+    }
+
+    if (err) {
+      printf("workload: line %u: %s\n", line_no, err);
+      return false;
+    }
+  }
+
+  if (wl->task_count == 0) {
+    printf("workload: no tasks\n");
+    return false;
+  }
+  return true;
+}
+
+bool workload_create(workload_t *wl) {
+  wl_go = sem_create(0, WL_MAX_TASKS, "wl_go");
+  if (!wl_go) {
+    return false;
+  }
+
+  for (size_t i = 0; i < wl->object_count; i++) {
+    wl_object_t *obj = &wl->objects[i];
+    switch (obj->type) {
+    case WL_OBJ_QUEUE:
+      obj->handle = queue_create(obj->length, sizeof(wl_message_t));
+      break;
+    case WL_OBJ_SEM:
+      obj->handle = sem_create(0, WL_SEM_MAX, obj->name);
+      break;
+    default:
+      obj->handle = mutex_create(obj->name);
+      break;
+    }
+    if (!obj->handle) {
+      printf("workload: cannot create %s (raise its pool)\n", obj->name);
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < wl->task_count; i++) {
+    wl_task_t *task = &wl->tasks[i];
+    task->rng = (wl->seed ^ (uint32_t)((i + 1) * 0x9E3779B9u)) | 1u;
+    task->handle = task_create(wl_task_body, task->name, DEFAULT_STACK_SIZE,
+                               task, task->priority);
+    if (!task->handle) {
+      printf("workload: cannot create task %s (raise MAX_TASKS and "
+             "MAX_DEFAULT_STACKS)\n",
+             task->name);
+      return false;
+    }
+  }
+
+  return task_create(wl_runner, "wl_runner", LARGE_STACK_SIZE, wl,
+                     WL_RUNNER_PRIORITY) != NULL;
+}
+
+uint32_t workload_percentile(const wl_task_t *task, uint32_t permille) {
+  if (task->jobs == 0) {
+    return 0;
+  }
+
+  uint64_t target = ((uint64_t)task->jobs * permille + 999) / 1000;
+  uint64_t seen = 0;
+  if (target == 0) {
+    target = 1;
+  }
+
+  for (uint32_t b = 0; b < WL_HIST_BUCKETS; b++) {
+    seen += task->hist[b];
+    if (seen >= target) {
+      uint32_t upper = wl_bucket_upper(b);
+      return upper < task->max_cycles ? upper : task->max_cycles;
+    }
+  }
+  return task->max_cycles;
+}
+
+// ================================== MAIN =====================================
+
+#ifdef WORKLOAD_SEMIHOSTING
+extern void initialise_monitor_handles(void);
+#endif
+
+int main(int argc, char **argv) {
+  static char text[WL_TEXT_MAX];
+  static workload_t wl;
+
+#ifdef WORKLOAD_SEMIHOSTING
+  initialise_monitor_handles();
+#endif
+  // Unbuffered, so printf never needs the heap from inside a task
+  setvbuf(stdout, NULL, _IONBF, 0);
+
+  const char *path = argc > 1 ? argv[1] : WORKLOAD_FILE;
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    printf("workload: cannot open %s\n", path);
+    wl_exit(1);
+  }
+  size_t len = fread(text, 1, sizeof(text) - 1, file);
+  fclose(file);
+  text[len] = '\0';
+
+  if (!workload_parse(&wl, text)) {
+    wl_exit(1);
+  }
+
+  kernel_init();
+  if (!workload_create(&wl)) {
+    wl_exit(1);
+  }
+  kernel_start();
+  return 0;
+}
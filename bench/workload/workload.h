@@ -0,0 +1,132 @@
+// workload.h - Synthetic task-set generator
+//
+// Builds a task set from a plain-text description, runs it on the real
+// kernel (QEMU image or POSIX host port) and reports per-task response
+// time percentiles, deadline misses and CPU share. One line per object,
+// '#' starts a comment, times are in milliseconds (periods) and
+// microseconds (execution):
+//
+//   seed 42                  # PRNG seed for the execution-time draws
+//   duration 10              # Seconds to run before reporting
+//   queue  <name> [length]   # uint32 pairs, length a power of two (8)
+//   sem    <name>            # Counting, starts empty
+//   mutex  <name>
+//   task   <name> prio=<1..MAX_PRIORITY-1> key=value...
+//
+// Task keys:
+//
+//   period=<ms>       Periodic release, from the common start tick
+//   offset=<ms>       First release after the start tick (0)
+//   wait=<queue|sem>  Released by a message or post instead of a period
+//   exec=<dist>       CPU work per job
+//   lock=<mutex>:<dist>  Work done holding the mutex, after exec
+//   send=<queue>      Message to the queue at the end of each job
+//   post=<sem>        Post to the semaphore at the end of each job
+//   deadline=<ms>     Relative deadline (period; none for wait= tasks)
+//   count=<n>         Create n copies, named <name>0 .. <name>n-1
+//
+// A <dist> in microseconds is a constant ("300"), uniform ("100..400") or
+// exponential with the given mean, capped at 10x ("exp:200").
+//
+// A job's response time runs from its release to the end of the job.
+// Periodic releases sit on tick edges and are timed from the tick that
+// made the task ready, so late ticks on the host port do not skew them. A queue message carries the
+// release time of the job that started the chain, so the last stage of
+// a producer/consumer chain reports end-to-end latency. A semaphore post
+// passes on the poster's release time in the same way.
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "kernel.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WL_MAX_TASKS (MAX_TASKS - 2) // Idle and the runner
+#define WL_MAX_NAME 16
+#define WL_SEM_BACKLOG 8    // Release times a semaphore carries
+#define WL_HIST_SUB_BITS 3 // 8 buckets per power of two, ~12% resolution
+#define WL_HIST_BUCKETS (32 << WL_HIST_SUB_BITS)
+
+typedef enum {
+  WL_DIST_CONST,
+  WL_DIST_UNIFORM,
+  WL_DIST_EXP,
+} wl_dist_type_t;
+
+typedef struct wl_dist {
+  wl_dist_type_t type;
+  uint32_t a_us; // Constant, lower bound or mean
+  uint32_t b_us; // Upper bound (uniform)
+} wl_dist_t;
+
+typedef enum {
+  WL_OBJ_NONE,
+  WL_OBJ_QUEUE,
+  WL_OBJ_SEM,
+  WL_OBJ_MUTEX,
+} wl_obj_type_t;
+
+typedef struct wl_object {
+  char name[WL_MAX_NAME];
+  wl_obj_type_t type;
+  uint32_t length; // Queues only
+  void *handle;
+
+  // Semaphores only: release times of posts not yet taken, oldest first
+  uint32_t releases[WL_SEM_BACKLOG];
+  uint32_t release_head;
+  uint32_t release_count;
+} wl_object_t;
+
+typedef struct wl_task {
+  char name[WL_MAX_NAME];
+  task_priority_t priority;
+  uint32_t period_ms; // 0 for event-driven tasks
+  uint32_t offset_ms;
+  uint32_t deadline_ms; // 0 = none
+  wl_dist_t exec;
+  wl_dist_t lock_exec;
+  wl_object_t *wait;
+  wl_object_t *lock;
+  wl_object_t *send;
+  wl_object_t *post;
+  uint32_t rng; // xorshift32 state
+
+  task_handle_t handle;
+
+  // Periodic release state: the last tick seen to wake us, and when
+  uint32_t next_tick;
+  uint32_t anchor_tick;
+  uint32_t anchor_cycles;
+
+  // Results
+  uint32_t jobs;
+  uint32_t misses;
+  uint32_t max_cycles;
+  uint32_t hist[WL_HIST_BUCKETS];
+} wl_task_t;
+
+typedef struct workload {
+  uint32_t seed;
+  uint32_t duration_s;
+  size_t task_count;
+  size_t object_count;
+  wl_task_t tasks[WL_MAX_TASKS];
+  wl_object_t objects[MAX_QUEUES + MAX_SEMAPHORES + MAX_MUTEXES];
+} workload_t;
+
+// Parses a description into wl. Prints "workload: line N: ..." and
+// returns false on the first error.
+bool workload_parse(workload_t *wl, const char *text);
+
+// Creates the objects and tasks on an initialised kernel. The runner task
+// calibrates, releases everything on a common tick, waits duration_s and
+// prints the report. Call kernel_start() afterwards.
+bool workload_create(workload_t *wl);
+
+// Upper bound of the bucket holding the permille-th sample, in cycles
+uint32_t workload_percentile(const wl_task_t *task, uint32_t permille);
+
+#endif // WORKLOAD_H
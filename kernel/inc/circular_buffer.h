@@ -1,10 +1,10 @@
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
+#include "klog.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 
 
@@ -148,12 +148,12 @@ static inline cb_result_t cb_peek(const circular_buffer_t *self, void *data_out)
 
 static inline void cb_print_stats(const circular_buffer_t *self) {
   if (!self) return;
-  printf("circular buffer stats:\n");
-  printf("\t capacity: %zu\n", self->capacity);
-  printf("\t size: %zu\n", self->size);
-  printf("\t head index: %zu\n", self->head);
-  printf("\t tail index: %zu\n", self->tail);
-  printf("\t bit mask value: %zu\n\n", self->mask);
+  KLOG("circular buffer stats:\n");
+  KLOG("\t capacity: %u\n", self->capacity);
+  KLOG("\t size: %u\n", self->size);
+  KLOG("\t head index: %u\n", self->head);
+  KLOG("\t tail index: %u\n", self->tail);
+  KLOG("\t bit mask value: %u\n\n", self->mask);
 }
 
 
@@ -1,31 +1,248 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// NOTE: included by context_switch.S as well, so keep this file to plain
+// preprocessor definitions only.
+
 // RTOS Configuration
 #define MAX_PRIORITY 7
 
+// Round-robin between equal-priority tasks on every tick. With 0 they only
+// switch when the running one yields or blocks.
+#ifndef SCHEDULER_TIME_SLICING
+#define SCHEDULER_TIME_SLICING 1
+#endif
+
+// Tick rate at boot. Kernel timeouts and delays are in ticks; time_utils.h
+// converts from milliseconds and microseconds. kernel_set_clock() changes
+// the rate at runtime.
+#ifndef KERNEL_TICK_HZ
+#define KERNEL_TICK_HZ 1000
+#endif
+
+// Core clock at boot (Cortex-M and the simulator). SysTick counts it, so
+// PORT_CORE_CLOCK_HZ / KERNEL_TICK_HZ must fit SysTick's 24-bit reload.
+#ifndef PORT_CORE_CLOCK_HZ
+#define PORT_CORE_CLOCK_HZ 168000000u
+#endif
+
+// Interrupt priorities (Cortex-M)
+// Kernel critical sections raise BASEPRI to KERNEL_MAX_SYSCALL_PRIORITY
+// instead of setting PRIMASK. Interrupts with a numerically lower (more
+// urgent) priority are never masked by the kernel and must not call it.
+#ifndef PORT_NVIC_PRIO_BITS
+#define PORT_NVIC_PRIO_BITS 4 // STM32F4 implements 4 priority bits
+#endif
+#ifndef KERNEL_MAX_SYSCALL_PRIORITY
+#define KERNEL_MAX_SYSCALL_PRIORITY 5
+#endif
+#define KERNEL_MAX_SYSCALL_BASEPRI                                             \
+  (KERNEL_MAX_SYSCALL_PRIORITY << (8 - PORT_NVIC_PRIO_BITS))
+
+// Debug checks (KERNEL_ASSERT). Includes trapping kernel calls made from
+// interrupts above KERNEL_MAX_SYSCALL_PRIORITY.
+#ifndef KERNEL_ASSERT_ENABLED
+#define KERNEL_ASSERT_ENABLED 0
+#endif
+
+// Time every outermost critical section and keep the worst call sites
+#ifndef CRITICAL_PROFILE_ENABLED
+#define CRITICAL_PROFILE_ENABLED 0
+#endif
+#define CRITICAL_PROFILE_SLOTS 8
+
 // Pool config
+// Each pool tracks its free objects in a 32-bit bitmap, so no count below
+// may exceed 32. Stress builds (bench/workload) raise them.
+#ifndef MAX_TASKS
 #define MAX_TASKS 8
+#endif
+#ifndef MAX_QUEUES
 #define MAX_QUEUES 4
+#endif
+#ifndef MAX_SEMAPHORES
 #define MAX_SEMAPHORES 8
+#endif
+#ifndef MAX_MUTEXES
 #define MAX_MUTEXES 4
+#endif
+#ifndef MAX_SWTIMERS
+#define MAX_SWTIMERS 8
+#endif
 
 // Stack sizes
 #define SMALL_STACK_SIZE 512
 #define DEFAULT_STACK_SIZE 1024
 #define LARGE_STACK_SIZE 2048
 
+// Stack painting
+// Stacks are filled with STACK_PAINT_PATTERN at creation so the deepest word
+// ever touched can be found later. The idle task re-measures every task once
+// per STACK_SWEEP_PERIOD_MS and keeps the lowest headroom seen.
+#ifndef STACK_PAINT_ENABLED
+#define STACK_PAINT_ENABLED 1
+#endif
+#define STACK_PAINT_PATTERN 0xA5A5A5A5u
+#ifndef STACK_SWEEP_PERIOD_MS
+#define STACK_SWEEP_PERIOD_MS 100
+#endif
+
+// MPU stack guard (Cortex-M only)
+// PendSV moves one no-access MPU region onto the lowest MPU_STACK_GUARD_SIZE
+// bytes of the incoming task's stack, so an overflow faults in MemManage
+// instead of silently corrupting the neighbouring stack. The guard bytes are
+// unusable, so each stack effectively loses up to 2 * MPU_STACK_GUARD_SIZE.
+#ifndef MPU_STACK_GUARD_ENABLED
+#if defined(__ARM_ARCH)
+#define MPU_STACK_GUARD_ENABLED 1
+#else
+#define MPU_STACK_GUARD_ENABLED 0
+#endif
+#endif
+#define MPU_STACK_GUARD_SIZE 32  // Power of two, >= 32
+#define MPU_STACK_GUARD_REGION 7 // Highest region number wins on overlap
+
+// Cycle counter source (Cortex-M only). 0: DWT CYCCNT. 1: derived from
+// SysTick, for cores or emulators without CYCCNT (QEMU mps2-an386).
+#ifndef PORT_CYCLE_COUNTER_SYSTICK
+#define PORT_CYCLE_COUNTER_SYSTICK 0
+#endif
+
+// Host builds only. 1: run the real kernel on Linux/POSIX (port/posix), with
+// ucontext tasks and signals for SysTick and PendSV. 0: no-op port stubs,
+// which is what the unit tests link against.
+#ifndef PORT_POSIX
+#define PORT_POSIX 0
+#endif
+
+// Host builds only. 1: run the real kernel in the discrete-event simulator
+// (port/sim) against a virtual cycle clock. Mutually exclusive with
+// PORT_POSIX.
+#ifndef PORT_SIM
+#define PORT_SIM 0
+#endif
+
+// Both host ports give each task a host context instead of running it on
+// its pool stack
+#define PORT_HOST_CONTEXTS (PORT_POSIX || PORT_SIM)
+
+// FPU context switching (Cortex-M4F)
+// Follows the compiler: building with -mfloat-abi=hard/softfp and an FPU
+// turns it on. Relies on lazy stacking (FPCCR.ASPEN/LSPEN, set at reset).
+#ifndef PORT_FPU_ENABLED
+#if defined(__ARM_FP)
+#define PORT_FPU_ENABLED 1
+#else
+#define PORT_FPU_ENABLED 0
+#endif
+#endif
+
+#ifndef MAX_SMALL_STACKS
 #define MAX_SMALL_STACKS 4
+#endif
+#ifndef MAX_DEFAULT_STACKS
 #define MAX_DEFAULT_STACKS 6
+#endif
+#ifndef MAX_LARGE_STACKS
 #define MAX_LARGE_STACKS 2
+#endif
 
 // Buffer sizes for queues
 #define SMALL_BUFFER_SIZE 64
 #define DEFAULT_BUFFER_SIZE 256
 #define LARGE_BUFFER_SIZE 1024 // 1KB
 
+#ifndef MAX_SMALL_BUFFERS
 #define MAX_SMALL_BUFFERS 8
+#endif
+#ifndef MAX_MEDIUM_BUFFERS
 #define MAX_MEDIUM_BUFFERS 4
+#endif
+#ifndef MAX_LARGE_BUFFERS
 #define MAX_LARGE_BUFFERS 2
+#endif
+
+// Pool integrity checking
+// Guard words sit between pool objects and are verified on pool_free() and by
+// the idle task's incremental scan. Poisoning fills freed objects so stale
+// pointers read garbage instead of plausible data.
+#ifndef POOL_GUARD_ENABLED
+#define POOL_GUARD_ENABLED 1
+#endif
+#define POOL_GUARD_PATTERN 0xCAFEF00Du
+
+#ifndef POOL_POISON_ENABLED
+#define POOL_POISON_ENABLED 0
+#endif
+#define POOL_POISON_BYTE 0xDD
+
+#define POOL_SCAN_SLOTS_PER_STEP 4 // Guard blocks checked per idle iteration
+
+// Runtime accounting
+// Charges cycles (DWT CYCCNT, or a monotonic clock off-target) to the task
+// that used them at every context switch and tick. CPU load is reported over
+// a sliding window of RUNTIME_LOAD_SLOTS * RUNTIME_LOAD_SLOT_TICKS ticks.
+#ifndef RUNTIME_STATS_ENABLED
+#define RUNTIME_STATS_ENABLED 1
+#endif
+#define RUNTIME_LOAD_SLOTS 10
+#define RUNTIME_LOAD_SLOT_TICKS 100
+
+// Wakeup-to-run latency and blocked time per task. Bucket b of a histogram
+// counts delays of [2^b, 2^(b+1)) cycles; the last bucket takes the rest.
+#ifndef LATENCY_STATS_ENABLED
+#define LATENCY_STATS_ENABLED 1
+#endif
+#define LATENCY_HIST_BUCKETS 24
+
+// Event trace recorder
+// Fixed-size binary records in a RAM ring; see trace.h and tools/trace_decode.py
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+#define TRACE_BUFFER_RECORDS 512 // Power of two
+
+// Record/replay of ticks and interrupt posts; see replay.h
+#ifndef REPLAY_ENABLED
+#define REPLAY_ENABLED 0
+#endif
+#ifndef REPLAY_BUFFER_BYTES
+#define REPLAY_BUFFER_BYTES 8192
+#endif
+
+// Deferred binary logging; see klog.h and tools/klog_decode.py
+#ifndef KLOG_ENABLED
+#define KLOG_ENABLED 1
+#endif
+#ifndef KLOG_BUFFER_WORDS
+#define KLOG_BUFFER_WORDS 512 // Power of two
+#endif
+
+// Statistical PC sampling on every tick; see profile.h and
+// tools/profile_report.py
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 0
+#endif
+#ifndef PROFILE_HASH_SLOTS
+#define PROFILE_HASH_SLOTS 256 // Power of two
+#endif
+#define PROFILE_MAX_PROBES 8
+
+// Software timers; see swtimer.h. kernel_init() creates the timer task,
+// which takes a TCB, a stack and a queue from the pools.
+#ifndef SWTIMER_ENABLED
+#define SWTIMER_ENABLED 0
+#endif
+#ifndef SWTIMER_TASK_PRIORITY
+#define SWTIMER_TASK_PRIORITY 1
+#endif
+#define SWTIMER_TASK_STACK_SIZE DEFAULT_STACK_SIZE
+#define SWTIMER_COMMAND_QUEUE_LENGTH 8 // Commands posted from interrupts
+#define SWTIMER_WHEEL_SLOTS 64         // Power of two
+
+// Derived: PendSV calls scheduler_switch_hook() when something needs it
+#define KERNEL_SWITCH_HOOK_ENABLED                                             \
+  (RUNTIME_STATS_ENABLED || TRACE_ENABLED || LATENCY_STATS_ENABLED ||          \
+   REPLAY_ENABLED)
 
 #endif // CONFIG_H
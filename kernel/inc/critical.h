@@ -1,28 +1,115 @@
 #ifndef CRITICAL_H
 #define CRITICAL_H
 
+#include "config.h"
+#include <stddef.h>
 #include <stdint.h>
 
+#if KERNEL_ASSERT_ENABLED
+// Halt on the spot so the debugger shows the failing check
+#define KERNEL_ASSERT(cond)                                                    \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      while (1) {                                                              \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+#else
+#define KERNEL_ASSERT(cond) ((void)0)
+#endif
+
 #ifdef __ARM_ARCH
+#if KERNEL_ASSERT_ENABLED
+// Kernel APIs may only be called from Thread mode or from exceptions whose
+// priority is at or below KERNEL_MAX_SYSCALL_PRIORITY.
+static inline void kernel_assert_syscall_priority(void) {
+  uint32_t ipsr;
+  __asm volatile("mrs %0, ipsr" : "=r"(ipsr));
+  uint32_t exception = ipsr & 0x1FF;
+
+  if (exception >= 16) { // External interrupt: NVIC_IPR
+    uint8_t priority = ((volatile uint8_t *)0xE000E400)[exception - 16];
+    KERNEL_ASSERT(priority >= KERNEL_MAX_SYSCALL_BASEPRI);
+  } else if (exception >= 4) { // Configurable system exception: SHPR1-3
+    uint8_t priority = ((volatile uint8_t *)0xE000ED18)[exception - 4];
+    KERNEL_ASSERT(priority >= KERNEL_MAX_SYSCALL_BASEPRI);
+  }
+}
+#endif
+
+// Masks only interrupts that are allowed to use the kernel. BASEPRI_MAX never
+// lowers the mask, so nested sections just restore the level they found.
 static inline uint32_t kernel_critical_enter(void) {
-  uint32_t primask;
-  __asm volatile("mrs %0, primask" : "=r"(primask));
-  __asm volatile("cpsid i" ::: "memory");
-  return primask;
+  uint32_t basepri;
+#if KERNEL_ASSERT_ENABLED
+  kernel_assert_syscall_priority();
+#endif
+  __asm volatile("mrs %0, basepri" : "=r"(basepri));
+  __asm volatile("msr basepri_max, %0\n\tisb" ::"r"(KERNEL_MAX_SYSCALL_BASEPRI)
+                 : "memory");
+  return basepri;
 }
 
-static inline void kernel_critical_exit(uint32_t primask) {
-  __asm volatile("msr primask, %0" ::"r"(primask) : "memory");
+static inline void kernel_critical_exit(uint32_t basepri) {
+  __asm volatile("msr basepri, %0" ::"r"(basepri) : "memory");
 }
+#elif PORT_HOST_CONTEXTS
+// Masks the port's simulated kernel-aware interrupts (signals on the POSIX
+// port, queued events in the simulator). Returns whether they were already
+// masked, so nested sections unmask only once.
+uint32_t kernel_critical_enter(void);
+void kernel_critical_exit(uint32_t was_masked);
 #else
 // Generic fallback for testing
 static inline uint32_t kernel_critical_enter(void) { return 0; }
-static inline void kernel_critical_exit(uint32_t primask) { (void)primask; }
+static inline void kernel_critical_exit(uint32_t basepri) { (void)basepri; }
 #endif
 
+#if REPLAY_ENABLED
+// Record/replay keeps its logical clock on outermost sections (replay.h)
+uint32_t replay_critical_enter(void);
+void replay_critical_exit(uint32_t state);
+#define KERNEL_CRITICAL_ENTER() replay_critical_enter()
+#define KERNEL_CRITICAL_EXIT(state) replay_critical_exit(state)
+#else
+#define KERNEL_CRITICAL_ENTER() kernel_critical_enter()
+#define KERNEL_CRITICAL_EXIT(state) kernel_critical_exit(state)
+#endif
+
+#if CRITICAL_PROFILE_ENABLED
+// Masked-time profiler. Outermost sections are timed with the cycle counter
+// from just after masking to just before unmasking, and grouped by call site
+// (the return address of critical_profile_enter). The
+// CRITICAL_PROFILE_SLOTS sites with the longest single section are kept.
+typedef struct critical_profile_entry {
+  uintptr_t site;        // Code address inside the function that masked
+  uint32_t max_cycles;   // Longest single section
+  uint32_t count;        // Sections timed at this site
+  uint64_t total_cycles; // Sum of all sections, for the average
+} critical_profile_entry_t;
+
+void critical_profile_enter(void);
+void critical_profile_exit(void);
+
+// Copies the table sorted by max_cycles, longest first. Returns the count.
+size_t critical_profile_get(critical_profile_entry_t *out, size_t max_entries);
+uint32_t critical_profile_worst_cycles(void);
+void critical_profile_reset(void);
+void critical_profile_print(void);
+
+#define KERNEL_CRITICAL_BEGIN()                                                \
+  uint32_t _critical_state = KERNEL_CRITICAL_ENTER();                          \
+  critical_profile_enter()
+#define KERNEL_CRITICAL_END()                                                  \
+  do {                                                                         \
+    critical_profile_exit();                                                   \
+    KERNEL_CRITICAL_EXIT(_critical_state);                                     \
+  } while (0)
+#else
 // Simplified macros - single line each to avoid parsing issues
 #define KERNEL_CRITICAL_BEGIN()                                                \
-  uint32_t _critical_state = kernel_critical_enter()
-#define KERNEL_CRITICAL_END() kernel_critical_exit(_critical_state)
+  uint32_t _critical_state = KERNEL_CRITICAL_ENTER()
+#define KERNEL_CRITICAL_END() KERNEL_CRITICAL_EXIT(_critical_state)
+#endif
 
 #endif /* ifndef CRITICAL_H */
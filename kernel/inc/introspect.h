@@ -0,0 +1,91 @@
+#ifndef INTROSPECT_H
+#define INTROSPECT_H
+
+#include "mutex.h"
+#include "queue.h"
+#include "semaphore.h"
+#include "task.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Kernel object enumeration
+//
+// Each *_next() call finds the next allocated object in its pool bitmap at
+// or after *cursor, copies it into an info structure under one short
+// critical section and moves the cursor past it. Start with a cursor of 0
+// and stop when it returns false:
+//
+//   size_t cursor = 0;
+//   task_info_t info;
+//   while (introspect_task_next(&cursor, &info)) { ... }
+//
+// No lock is held between calls, so each info is consistent in itself but
+// a walk is not a snapshot: an object created or deleted during the walk
+// may or may not be seen. Handles are for display and comparison; the
+// object may be gone by the time the caller looks at it.
+
+typedef enum {
+  KERNEL_OBJECT_NONE,
+  KERNEL_OBJECT_QUEUE,
+  KERNEL_OBJECT_SEMAPHORE,
+  KERNEL_OBJECT_MUTEX,
+  KERNEL_OBJECT_UNKNOWN,
+} kernel_object_type_t;
+
+typedef struct task_info {
+  task_handle_t handle;
+  size_t slot; // Index in the TCB pool
+  char name[16];
+  task_state_t state; // The current task reads TASK_RUNNING
+  task_priority_t base_priority;
+  task_priority_t effective_priority; // Raised by mutex inheritance
+  uint32_t stack_size;     // In bytes
+  uint32_t stack_used;     // At the last switch-out
+  uint32_t stack_headroom; // Least free stack seen by the idle sweep
+  const void *waiting_on;  // Object a blocked task waits for, or NULL
+  kernel_object_type_t waiting_on_type;
+  wake_reason_t wake_reason; // Why it last left BLOCKED
+  uint32_t wake_tick;        // Timeout of a delay or timed wait
+  uint32_t run_count;
+  uint64_t runtime_cycles;
+} task_info_t;
+
+typedef struct queue_info {
+  queue_handle_t handle;
+  size_t slot;
+  size_t messages;
+  size_t capacity;
+  size_t item_size;
+  uint8_t waiting_senders;
+  uint8_t waiting_receivers;
+} queue_info_t;
+
+typedef struct sem_info {
+  semaphore_handle_t handle;
+  size_t slot;
+  char name[16];
+  uint32_t count;
+  uint32_t max_count;
+  uint8_t waiting_tasks;
+} sem_info_t;
+
+typedef struct mutex_info {
+  mutex_handle_t handle;
+  size_t slot;
+  char name[16];
+  task_handle_t owner; // NULL when free
+  int owner_slot;      // -1 when free
+  uint8_t waiting_tasks;
+} mutex_info_t;
+
+// Public API
+bool introspect_task_next(size_t *cursor, task_info_t *info);
+bool introspect_queue_next(size_t *cursor, queue_info_t *info);
+bool introspect_sem_next(size_t *cursor, sem_info_t *info);
+bool introspect_mutex_next(size_t *cursor, mutex_info_t *info);
+
+// Which kind of kernel object ptr is, by pool membership
+kernel_object_type_t introspect_object_type(const void *ptr);
+
+#endif // !INTROSPECT_H
@@ -37,5 +37,35 @@ void task_delete(task_handle_t task);
 void task_delay(uint32_t ticks);
 void task_yield(void);
 task_handle_t task_get_current(void);
+task_handle_t kernel_get_idle_task(void);
+
+// Monotonic 64-bit time, never wrapping. Ticks count at the tick rate;
+// cycles at PORT_TIME_HZ, which on target is the core clock read from
+// SysTick between ticks. Pass kernel_ticks_until(deadline) as the timeout
+// of any blocking call to wait until an absolute deadline.
+uint64_t kernel_get_ticks64(void);
+uint64_t kernel_get_time_cycles(void);
+uint64_t kernel_get_time_us(void);
+uint32_t kernel_ticks_until(uint64_t deadline);
+
+// Clock changes. Call after reprogramming the core clock to core_hz, or to
+// switch to a tick rate of tick_hz (or both): SysTick is reprogrammed and
+// armed timeouts are converted so they expire at the same time (rounded
+// up to the new tick). Microsecond time stays continuous and cycle time
+// goes on at the new clock. Returns false, changing nothing, if SysTick
+// cannot divide core_hz down to tick_hz. Off-target core_hz is only
+// reported back. Tick deadlines held by the application (absolute tick
+// values) are not converted; time_ms_to_ticks() follows the new rate. The
+// cycle counter follows the core clock on target (port_cycle_counter_hz());
+// the change is recorded in the trace and klog streams.
+bool kernel_set_clock(uint32_t core_hz, uint32_t tick_hz);
+uint32_t kernel_get_tick_hz(void);
+uint32_t kernel_get_core_clock_hz(void);
+
+// Interrupt bookkeeping
+// Kernel-aware ISRs call these first and last so their time is not charged
+// to the task they interrupted. Nesting is allowed.
+void kernel_isr_enter(void);
+void kernel_isr_exit(void);
 
 #endif // !KERNEL_H
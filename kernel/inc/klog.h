@@ -0,0 +1,126 @@
+#ifndef KLOG_H
+#define KLOG_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Deferred binary logging
+//
+// KLOG("fmt", args...) formats nothing. It stores the offset of its format
+// string in the klog_fmt section, a timestamp and the arguments as raw
+// 32-bit words in klog_ram, a lock-free ring: a producer claims its words
+// with one compare-and-swap and publishes them with a tag word, so tasks
+// and interrupts can log without a critical section. kbench times a call
+// (klog,1arg); when the ring is full the record is dropped and counted.
+//
+// Formatting happens elsewhere. klog_drain() hands completed records to a
+// sink, typically from a low-priority task that forwards them over UART or
+// semihosting; off-target, klog_format() and klog_print_pending() render
+// them in place. On the target the klog_fmt section is linked at address 0
+// and not loaded (see port/arm-cortex-m4/mps2_an386.ld), so the strings
+// cost no flash and printf is not linked; tools/klog_decode.py reads them
+// from the ELF into a dictionary:
+//
+//   (gdb) dump binary memory klog.bin &klog_ram (char *)&klog_ram + sizeof(klog_ram)
+//   $ tools/klog_decode.py --elf app.elf klog.bin
+//
+// A sink that ships records off the chip should write a header with
+// capacity 0, then per record format | count << 16, timestamp and the
+// arguments; the decoder reads that as a stream.
+//
+// Formats take flags, a width and a precision but no length modifier. Each
+// %d %i %u %x %X %o %c consumes one argument, converted to uint32_t; %s
+// consumes KLOG_STR_ARGS words filled by KLOG_STR() with the first
+// KLOG_STR_MAX characters of a string; %% prints a percent sign. Format
+// offsets are 16 bits, so all formats together must stay under 64 KB.
+
+#define KLOG_MAGIC 0x474C524Du // "MRLG"
+#define KLOG_VERSION 1
+
+#define KLOG_MAX_ARGS 12
+#define KLOG_STR_ARGS 4
+#define KLOG_STR_MAX (4 * KLOG_STR_ARGS)
+
+// A record in the ring is KLOG_RECORD_WORDS words, then its arguments.
+// The tag is ~(position of the record) once it is complete.
+#define KLOG_RECORD_WORDS 3 // tag, format | count << 16, timestamp
+
+typedef struct klog_header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t capacity;     // Words in the ring, 0 for a stream
+  uint32_t head;         // Words ever claimed; word = position % capacity
+  uint32_t tail;         // Words ever consumed by klog_drain()
+  uint32_t timestamp_hz; // Rate of the timestamp counter
+  uint32_t dropped;      // Records that did not fit
+} klog_header_t;
+
+typedef struct klog_buffer {
+  klog_header_t header;
+  uint32_t words[KLOG_BUFFER_WORDS];
+} klog_buffer_t;
+
+// A record as klog_drain() hands it out
+typedef struct klog_record {
+  uint16_t format; // Offset in the klog_fmt section
+  uint16_t count;  // Arguments used
+  uint32_t timestamp;
+  uint32_t args[KLOG_MAX_ARGS];
+} klog_record_t;
+
+typedef void (*klog_sink_t)(const klog_record_t *record);
+
+#if KLOG_ENABLED
+extern klog_buffer_t klog_ram;
+extern const char __start_klog_fmt[]; // Set by the linker
+
+void klog_init(void);
+void klog_write(uint32_t format, uint32_t count, const uint32_t *args);
+size_t klog_drain(klog_sink_t sink, size_t max_records);
+uint32_t klog_dropped(void);
+
+#ifndef __ARM_ARCH
+size_t klog_format(const klog_record_t *record, char *out, size_t size);
+size_t klog_print_pending(void); // Drains to stdout
+#endif
+
+// Characters 4 * part to 4 * part + 3 of s, zero-padded
+static inline uint32_t klog_str_part(const char *s, size_t part) {
+  uint32_t word = 0;
+  for (size_t i = 0; i < 4 * part + 4 && s[i]; i++) {
+    if (i >= 4 * part) {
+      word |= (uint32_t)(uint8_t)s[i] << (8 * (i - 4 * part));
+    }
+  }
+  return word;
+}
+
+#define KLOG_STR(s)                                                            \
+  klog_str_part((s), 0), klog_str_part((s), 1), klog_str_part((s), 2),         \
+      klog_str_part((s), 3)
+
+#define KLOG(fmt, ...)                                                         \
+  do {                                                                         \
+    static const char klog_fmt_[]                                              \
+        __attribute__((section("klog_fmt"), used)) = fmt;                      \
+    const uint32_t klog_args_[] = {0, ##__VA_ARGS__};                          \
+    _Static_assert(sizeof(klog_args_) <= 4 * (KLOG_MAX_ARGS + 1),              \
+                   "too many KLOG arguments");                                 \
+    klog_write((uint32_t)(klog_fmt_ - __start_klog_fmt),                       \
+               sizeof(klog_args_) / 4 - 1, klog_args_ + 1);                    \
+  } while (0)
+#else
+#define KLOG_STR(s) ((void)(s), 0u)
+#define KLOG(fmt, ...)                                                         \
+  do {                                                                         \
+    if (0) {                                                                   \
+      const uint32_t klog_args_[] = {0, ##__VA_ARGS__};                        \
+      (void)klog_args_;                                                        \
+    }                                                                          \
+  } while (0)
+#endif
+
+#endif // !KLOG_H
@@ -0,0 +1,22 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include "task.h"
+
+// Public API
+bool task_get_latency_stats(task_handle_t task, task_latency_stats_t *stats);
+void task_reset_latency_stats(task_handle_t task);
+
+// Upper bound, in cycles, of the bucket holding the given fraction (in
+// tenths of a percent) of samples, e.g. 990 for p99. 0 if empty.
+uint32_t latency_histogram_percentile(const latency_histogram_t *hist,
+                                      uint32_t permille);
+
+void latency_print_stats(void);
+
+// Kernel hooks
+void latency_stats_blocked(task_handle_t task);
+void latency_stats_ready(task_handle_t task);
+void latency_stats_switch(task_handle_t to);
+
+#endif // !LATENCY_STATS_H
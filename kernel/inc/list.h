@@ -62,4 +62,17 @@ static inline void list_move_to_head(list_head_t *h, list_head_t *n) {
   list_insert_head(h, n);
 }
 
+// Moves every node of src to the tail of dst, leaving src empty
+static inline void list_splice_tail(list_head_t *dst, list_head_t *src) {
+  if (list_is_empty(src)) {
+    return;
+  }
+
+  src->next->prev = dst->prev;
+  dst->prev->next = src->next;
+  src->prev->next = dst;
+  dst->prev = src->prev;
+  list_init(src);
+}
+
 #endif // !LIST_H
@@ -6,6 +6,7 @@
 #include "semaphore.h"
 #include "task.h"
 #include "mutex.h"
+#include "swtimer.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -15,6 +16,7 @@
 typedef struct memory_pool {
   void *pool_start;     // Starting position in memory of pool
   size_t object_size;   // Object size
+  size_t object_stride; // Object size plus trailing guard, 8-byte aligned
   size_t pool_size;     // Math can be done to extract end address of pool
   uint32_t free_bitmap; // Bitmap for free objects (up to 32 objects)
   size_t free_count;    // Number of free objects
@@ -31,6 +33,7 @@ typedef enum {
   POOL_BUFFER_LARGE,
   POOL_SCB,
   POOL_MCB,
+  POOL_TMCB, // Empty unless SWTIMER_ENABLED
   POOL_COUNT,
 } pool_type_t;
 
@@ -39,6 +42,13 @@ void memory_pools_init(void);
 void *pool_alloc(pool_type_t pool_type);
 bool pool_free(pool_type_t pool_type, void *ptr);
 
+// Returns the index-th object of a pool if it is allocated, NULL otherwise.
+void *pool_object_at(pool_type_t pool_type, size_t index);
+
+// Slot of an object within its pool (the inverse of pool_object_at()), or -1
+// if ptr is not the start of an object in that pool.
+int pool_index_of(pool_type_t pool_type, const void *ptr);
+
 // Helper functions for specific types
 void *task_pool_alloc_tcb(void);
 void *task_pool_alloc_stack(size_t requested_size);
@@ -57,14 +67,31 @@ bool sem_pool_free_scb(semaphore_control_block *sem);
 mutex_control_block *mutex_pool_alloc_mcb(void);
 bool mutex_pool_free_mcb(mutex_control_block *mutex);
 
+#if SWTIMER_ENABLED
+swtimer_control_block *swtimer_pool_alloc_tmcb(void);
+bool swtimer_pool_free_tmcb(swtimer_control_block *timer);
+#endif
+
 typedef struct pool_stats {
   size_t total_objects;
   size_t free_objects;
   size_t used_objects;
   size_t peak_usage;
+  size_t corruptions; // Guard/poison violations detected so far
 } pool_stats_t;
 
 pool_stats_t pool_get_stats(pool_type_t pool_type);
 void pool_print_stats(void);
 
+// Integrity checking
+// Called with the pool and the object whose guard (or poison) was found
+// damaged. Runs in the context that detected it (pool_free() or idle task).
+typedef void (*pool_corruption_handler_t)(pool_type_t pool_type, void *object);
+
+void pool_set_corruption_handler(pool_corruption_handler_t handler);
+
+// Checks the next POOL_SCAN_SLOTS_PER_STEP guard blocks, resuming where the
+// previous call stopped. Returns false if this step found corruption.
+bool pool_integrity_scan_step(void);
+
 #endif // !MEMORY_H
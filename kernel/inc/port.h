@@ -3,6 +3,8 @@
 #ifndef PORT_H
 #define PORT_H
 
+#include "config.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -18,9 +20,78 @@ extern void trigger_context_switch(void);
 extern void systick_init(uint32_t ticks_per_second);
 extern void set_pendsv_priority(void);
 
+// Enables the MPU with the stack guard region over the first task's stack.
+// PendSV retargets the region on every switch afterwards.
+void port_stack_guard_init(const uint32_t *stack_base);
+
+// Filled in by MemManage_Handler before it halts
+typedef struct port_fault_info {
+  struct task_control_block *task; // Task running when the fault hit
+  uint32_t cfsr;                   // Configurable Fault Status Register
+  uint32_t address;                // MMFAR, valid if cfsr bit 7 (MMARVALID)
+} port_fault_info_t;
+
+extern volatile port_fault_info_t port_last_fault;
+
+// Called by MemManage_Handler once port_last_fault is filled in. The
+// default spins forever; bench/stack_guard.c overrides it.
+void port_fault_halt(void);
+
+// Cycle counter (DWT CYCCNT), enabled by port_cycle_counter_init()
+#define PORT_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+// Rate of the cycle counter at boot, for constant expressions
+#ifndef PORT_CYCLE_COUNTER_HZ
+#define PORT_CYCLE_COUNTER_HZ PORT_CORE_CLOCK_HZ
+#endif
+
+// The core clock SysTick divides, PORT_CORE_CLOCK_HZ until
+// kernel_set_clock() changes it. systick_init() may be called again to
+// reprogram the tick; the 64-bit time base carries over.
+extern uint32_t port_core_clock_hz;
+
+// Rate of port_cycle_count() now. CYCCNT and the SysTick fallback both
+// count core clocks, so the rate follows kernel_set_clock().
+static inline uint32_t port_cycle_counter_hz(void) {
+  return port_core_clock_hz;
+}
+
+#define PORT_SYSTICK_MAX_RELOAD 0x1000000u // 24-bit counter
+#define PORT_TIME_HZ port_core_clock_hz    // Rate of port_time_cycles()
+
+static inline bool port_tick_rate_valid(uint32_t core_hz, uint32_t tick_hz) {
+  return tick_hz && core_hz / tick_hz >= 2 &&
+         core_hz / tick_hz <= PORT_SYSTICK_MAX_RELOAD;
+}
+
+void port_cycle_counter_init(void);
+
+#if PORT_CYCLE_COUNTER_SYSTICK
+// Cores without CYCCNT (QEMU does not model the DWT) count SysTick clocks
+// instead: ticks * reload + elapsed part of the current tick.
+uint32_t port_cycle_count(void);
+#else
+static inline uint32_t port_cycle_count(void) { return PORT_DWT_CYCCNT; }
+#endif
+
+// Core clocks since the scheduler started, from the SysTick wrap count and
+// SysTick VAL; monotonic and never wraps
+uint64_t port_time_cycles(void);
+
+// Called by SysTick_Handler before scheduler_tick()
+void port_systick_count(void);
+
+// Active exception number (IPSR), 0 in Thread mode
+static inline uint32_t port_current_exception(void) {
+  uint32_t ipsr;
+  __asm volatile("mrs %0, ipsr" : "=r"(ipsr));
+  return ipsr & 0x1FF;
+}
+
 // Interrupt handlers (these need to be in your vector table)
 extern void PendSV_Handler(void);
 extern void SysTick_Handler(void);
+void MemManage_Handler(void);
 
 static inline void port_wait_for_interrupt(void) {
   __asm volatile("wfi" ::: "memory");
@@ -40,6 +111,88 @@ static inline void port_enable_interrupts(void) {
 #define __enable_irq() port_enable_interrupts()
 
 #else
+#if PORT_SIM
+// The simulator's virtual clock (port/sim), at the simulated core clock
+#ifndef PORT_CYCLE_COUNTER_HZ
+#define PORT_CYCLE_COUNTER_HZ PORT_CORE_CLOCK_HZ
+#endif
+
+static inline void port_cycle_counter_init(void) {}
+uint32_t port_cycle_count(void);
+uint64_t port_time_cycles(void);
+#else
+#include <time.h>
+
+// Nanoseconds from a monotonic clock stand in for cycles off-target
+#define PORT_CYCLE_COUNTER_HZ 1000000000u
+
+static inline void port_cycle_counter_init(void) {}
+
+static inline uint32_t port_cycle_count(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+static inline uint64_t port_time_cycles(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif // PORT_SIM
+
+// Host time bases do not follow a core clock
+#define PORT_TIME_HZ PORT_CYCLE_COUNTER_HZ
+
+static inline uint32_t port_cycle_counter_hz(void) {
+  return PORT_CYCLE_COUNTER_HZ;
+}
+
+static inline bool port_tick_rate_valid(uint32_t core_hz, uint32_t tick_hz) {
+  (void)core_hz;
+  return tick_hz && tick_hz <= 1000000u;
+}
+
+static inline void set_pendsv_priority(void) {}
+
+static inline void port_stack_guard_init(const uint32_t *stack_base) {
+  (void)stack_base;
+}
+
+#if PORT_HOST_CONTEXTS
+// Host ports. Tasks are ucontexts on host stacks. On Linux/POSIX
+// (port/posix/port_posix.c) SysTick is a SIGALRM interval timer, PendSV is
+// SIGUSR1, and "masking interrupts" blocks those signals. The simulator
+// (port/sim/sim.c) delivers the same exceptions from an event list as its
+// virtual clock advances.
+struct task_control_block;
+
+void start_first_task(uint32_t *first_task_sp);
+void trigger_context_switch(void);
+void systick_init(uint32_t ticks_per_second); // Also changes a running tick
+
+// Exception number of the handler running (as on Cortex-M: 14 PendSV,
+// 15 SysTick, 16 and up simulated IRQs), 0 in a task
+uint32_t port_current_exception(void);
+
+void port_disable_interrupts(void);
+void port_enable_interrupts(void);
+void port_wait_for_interrupt(void);
+
+// Called by task_init_stack(): gives the task a host context that starts
+// function(param). port_task_free() releases it again.
+void port_task_init(struct task_control_block *task,
+                    void (*function)(void *), void *param);
+void port_task_free(struct task_control_block *task);
+#endif // PORT_HOST_CONTEXTS
+
+#if PORT_POSIX
+// One simulated peripheral interrupt (SIGUSR2). The handler runs in
+// interrupt context and is masked by critical sections like a kernel-aware
+// IRQ, so it may call kernel_isr_enter() and post semaphores/queues.
+void port_posix_set_irq_handler(void (*handler)(void));
+void port_posix_trigger_irq(void);
+#elif !PORT_SIM
 // Stub implementations for non-ARM platforms
 static inline void start_first_task(uint32_t *first_task_sp) {
   (void)first_task_sp;
@@ -48,7 +201,9 @@ static inline void trigger_context_switch(void) {}
 static inline void systick_init(uint32_t ticks_per_second) {
   (void)ticks_per_second;
 }
-static inline void set_pendsv_priority(void) {}
+
+static inline uint32_t port_current_exception(void) { return 0; }
+
 static inline void port_disable_interrupts(void) {}
 static inline void port_enable_interrupts(void) {}
 
@@ -56,6 +211,7 @@ static inline void port_enable_interrupts(void) {}
 static inline void port_wait_for_interrupt(void) {
   // No-op for non-ARM platforms
 }
+#endif // PORT_POSIX / !PORT_SIM
 
 #define __WFI() port_wait_for_interrupt()
 #define __disable_irq() port_disable_interrupts()
@@ -0,0 +1,76 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "config.h"
+#include "task.h"
+#include <stdint.h>
+
+// Statistical PC-sampling profiler
+//
+// With PROFILE_ENABLED, every tick samples the program counter of the
+// context the tick interrupted: SysTick_Handler passes the exception frame
+// it was entered with to profile_sample_frame(), which reads the stacked PC
+// (the POSIX port takes it from the signal context instead). The sample is
+// counted in profile_ram, an open-addressed hash table keyed by PC and TCB
+// slot, so a sample costs a hash, a few probes and an increment, cheap
+// enough to leave on under production load (kbench_diag times it as
+// profile_sample). A port with a spare timer can call
+// profile_sample_frame() from its handler the same way to sample faster
+// than the tick; call it from one interrupt priority only.
+//
+// Samples taken in a nested handler, or before the scheduler starts, are
+// charged to PROFILE_NO_TASK. When a PC misses every probed entry the
+// sample is dropped and counted; a profile with many drops wants more
+// PROFILE_HASH_SLOTS. tools/profile_report.py symbolizes a dump against
+// the ELF into per-task function tables or folded stacks for a flame
+// graph:
+//
+//   (gdb) dump binary memory prof.bin &profile_ram (char *)&profile_ram + sizeof(profile_ram)
+//   $ tools/profile_report.py --elf app.elf prof.bin
+//
+// The names table holds the name of the last task sampled in each TCB
+// slot; reset between runs if tasks come and go.
+
+#define PROFILE_MAGIC 0x4650524Du // "MRPF"
+#define PROFILE_VERSION 1
+
+#define PROFILE_NO_TASK 0xFF
+
+typedef struct profile_header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  uint16_t slots;     // Histogram entries
+  uint8_t pc_bytes;   // sizeof(uintptr_t)
+  uint8_t task_slots; // Entries in the names table
+  uint32_t samples;   // Taken, dropped ones included
+  uint32_t dropped;   // No free entry along the probe run
+} profile_header_t;
+
+// Free while count is 0
+typedef struct profile_entry {
+  uintptr_t pc;
+  uint32_t count;
+  uint8_t task; // TCB slot, or PROFILE_NO_TASK
+} profile_entry_t;
+
+typedef struct profile_buffer {
+  profile_header_t header;
+  char names[MAX_TASKS][16];
+  profile_entry_t entries[PROFILE_HASH_SLOTS];
+} profile_buffer_t;
+
+#if PROFILE_ENABLED
+extern profile_buffer_t profile_ram;
+
+// Public API
+void profile_reset(void);
+void profile_sample(uintptr_t pc, task_handle_t task);
+
+#if defined(__ARM_ARCH) && !PORT_HOST_CONTEXTS
+// frame: the hardware-stacked registers, exc_return: LR on handler entry
+void profile_sample_frame(const uint32_t *frame, uint32_t exc_return);
+#endif
+#endif
+
+#endif // !PROFILE_H
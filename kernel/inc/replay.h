@@ -0,0 +1,120 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "config.h"
+#include "queue.h"
+#include "semaphore.h"
+#include "task.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Record and replay of external stimuli
+//
+// Recording logs everything that reaches the kernel from outside the task
+// code: ticks, and semaphore posts and queue sends made from interrupts,
+// with their payloads. Replay feeds that log back in while the live ticks
+// and interrupt posts are dropped, so the tasks see the same inputs in the
+// same order and the scheduler makes the same decisions.
+//
+// Stimuli are placed on a logical clock, not on cycle counts: the number
+// of outermost kernel critical sections task code had completed when the
+// stimulus arrived, plus the switch digest below. Interrupts cannot land
+// inside a section, and between two sections a task only runs its own
+// code, so replay delivers a stimulus at the next section boundary with
+// the same count and digest, or from the live tick once as many cycles
+// have passed since the last section as in the recording (tasks that spin
+// without calling the kernel). The order of kernel events is exact; only
+// cycle timings differ. That holds on every port whose
+// kernel_critical_enter() reports nesting, including QEMU with or without
+// -icount.
+//
+// Both runs must start from the same state: call replay_record_start() or
+// replay_play() after creating the tasks and before kernel_start(), and
+// create tasks, semaphores and queues in the same order (objects are
+// identified by pool slot). State shared with interrupts outside kernel
+// objects is not captured, and a task that reads tick_now (or anything an
+// interrupt writes) directly sees the recorded value only if it reads
+// inside a KERNEL_CRITICAL_BEGIN/END pair.
+//
+// Replay skips idle time. If a changed build leaves only the idle task
+// waiting for something the trace expects from the others, replay goes on
+// at one recorded tick per live tick.
+//
+// Each stimulus carries 16 bits of a digest of every context switch so
+// far. Replay checks it on delivery and reports the first record where the
+// schedule went a different way (REPLAY_DIVERGED), so a fix can be checked
+// against the trace of the incident.
+//
+// The log is a byte stream in replay_ram, and a dump of that one symbol
+// can be passed straight to replay_play() on the bench:
+//
+//   (gdb) dump binary memory incident.rpl &replay_ram (char *)&replay_ram + sizeof(replay_ram)
+//
+// Record: type byte, varint section-count delta, varint cycles since the
+// last section, 16-bit digest, then for posts the object slot and for
+// sends the item size and item. A tick is 5-7 bytes.
+
+#define REPLAY_MAGIC 0x5052524Du // "MRRP"
+#define REPLAY_VERSION 1
+
+typedef enum {
+  REPLAY_RECORD_TICK = 1,
+  REPLAY_RECORD_SEM_POST = 2,   // + semaphore slot
+  REPLAY_RECORD_QUEUE_SEND = 3, // + queue slot, item size, item
+  REPLAY_RECORD_STOP = 4,       // Where recording stopped
+} replay_record_type_t;
+
+typedef enum {
+  REPLAY_OFF,
+  REPLAY_RECORDING,
+  REPLAY_PLAYING,
+  REPLAY_DONE,     // Every record delivered, live stimuli are back
+  REPLAY_DIVERGED, // Still delivering, but the schedule differs
+} replay_state_t;
+
+typedef struct replay_header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t bytes;        // Record bytes following the header
+  uint32_t records;
+  uint32_t timestamp_hz; // Rate of the cycle offsets
+  uint32_t digest;       // Switch digest when recording stopped
+  uint32_t truncated;    // The buffer filled and recording stopped early
+} replay_header_t;
+
+typedef struct replay_buffer {
+  replay_header_t header;
+  uint8_t data[REPLAY_BUFFER_BYTES];
+} replay_buffer_t;
+
+typedef struct replay_status {
+  replay_state_t state;
+  uint32_t records;     // Recorded, or in the trace being played
+  uint32_t delivered;   // Replayed so far
+  uint32_t diverged_at; // First record whose digest did not match
+  uint32_t digest;      // Switch digest up to the end of the trace
+} replay_status_t;
+
+#if REPLAY_ENABLED
+extern replay_buffer_t replay_ram;
+
+// Public API
+void replay_record_start(void);
+void replay_record_stop(void);
+
+// Plays a header plus records, as left in replay_ram by a recording. The
+// trace is read in place and must stay valid until replay is done.
+bool replay_play(const void *trace, size_t size);
+
+void replay_get_status(replay_status_t *status);
+
+// Kernel hooks (replay_critical_enter/exit are declared in critical.h)
+bool replay_tick(void); // True: replay owns time, drop this live tick
+bool replay_isr_sem_post(semaphore_handle_t sem);
+bool replay_isr_queue_send(queue_handle_t queue, const void *item);
+void replay_switch(task_handle_t from, task_handle_t to);
+#endif
+
+#endif // !REPLAY_H
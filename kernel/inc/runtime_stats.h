@@ -0,0 +1,29 @@
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include "task.h"
+
+typedef struct task_runtime_stats {
+  uint32_t run_count;      // Times switched in
+  uint64_t runtime_cycles; // Cycles spent running, interrupts excluded
+  uint32_t share_permille; // Share of all cycles since the kernel started
+} task_runtime_stats_t;
+
+// Public API
+bool task_get_runtime_stats(task_handle_t task, task_runtime_stats_t *stats);
+
+// Non-idle share of the last RUNTIME_LOAD_SLOTS windows, in tenths of a
+// percent (0-1000).
+uint32_t kernel_get_cpu_load(void);
+
+// Total cycles spent in kernel-aware interrupts
+uint64_t kernel_get_isr_cycles(void);
+
+// Kernel hooks
+void runtime_stats_init(void);
+void runtime_stats_switch(task_handle_t from, task_handle_t to);
+void runtime_stats_tick(void);
+void runtime_stats_isr_enter(void);
+void runtime_stats_isr_exit(void);
+
+#endif // !RUNTIME_STATS_H
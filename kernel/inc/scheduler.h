@@ -28,8 +28,20 @@ void scheduler_unblock_task(task_handle_t task);
 void scheduler_yield(void);
 void scheduler_delay_current_task(uint32_t ticks);
 
-// Timer tick processing
-void scheduler_tick(void); // Called from timer interrupt
+// Called from PendSV between saving `from` and restoring `to`, with kernel
+// interrupts masked. Must not use the FPU.
+void scheduler_switch_hook(task_handle_t from, task_handle_t to);
+
+// Timer tick processing, called from the timer interrupt. The handler then
+// picks the next task, unless this returns false (replay owns the ticks).
+bool scheduler_tick(void);
+
+// tick_now extended to 64 bits, so it never wraps
+uint64_t scheduler_get_ticks64(void);
+
+// Sets tick_hz and converts the armed timeouts to it. The caller
+// reprograms the timer.
+void scheduler_set_tick_hz(uint32_t hz);
 
 // Arms timeout for a given task at absolute wake_tick
 void scheduler_set_timeout(task_handle_t t, uint32_t wake_tick);
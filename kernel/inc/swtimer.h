@@ -0,0 +1,94 @@
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+#include "kernel.h"
+#include "list.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Software timers
+//
+// One-shot and periodic timers that call a function when they expire, in
+// place of a task that loops on task_delay(). Armed timers hang in a hashed
+// timing wheel of SWTIMER_WHEEL_SLOTS lists indexed by expiry tick, so
+// starting and stopping are O(1) and each tick only looks at the timers
+// that hash to it. A periodic timer is re-armed from its expiry tick, not
+// from when its callback ran, so it does not drift.
+//
+// Callbacks run in the timer task (SWTIMER_TASK_PRIORITY), one at a time
+// and in expiry order, and may block briefly. With SWTIMER_IN_TICK they run
+// in the tick interrupt instead, for a few instructions of work such as
+// posting a semaphore. A periodic callback that has not run by its next
+// expiry runs once for both.
+//
+// Interrupts use the *_from_isr calls, which only post a command to the
+// timer task and return; the command counts from the tick it was posted
+// at. Periods are in ticks and are not converted by kernel_set_clock().
+
+#define SWTIMER_ONE_SHOT 0x00
+#define SWTIMER_PERIODIC 0x01
+#define SWTIMER_IN_TICK 0x02 // Callback in the tick interrupt
+
+typedef struct swtimer_control_block *swtimer_handle_t;
+
+typedef void (*swtimer_callback_t)(swtimer_handle_t timer, void *arg);
+
+typedef enum {
+  SWTIMER_OK = 0,
+  SWTIMER_ERROR_NULL = -1,
+  SWTIMER_ERROR_QUEUE_FULL = -2, // *_from_isr: command not posted
+  SWTIMER_ERROR_PERIOD = -3,     // Period of 0
+} swtimer_result_t;
+
+typedef struct swtimer_control_block {
+  list_head_t wheel_link; // Wheel slot while armed, self-linked otherwise
+  list_head_t fire_link;  // Expired, callback not yet run
+  uint32_t expiry;        // Tick of the next expiry
+  uint32_t period;        // In ticks
+  swtimer_callback_t callback;
+  void *arg;
+  uint8_t flags;
+  uint8_t queued; // *_from_isr commands not yet taken by the timer task
+  char name[16];
+} swtimer_control_block;
+
+#define swtimer_from_wheel_link(ptr)                                           \
+  container_of(ptr, swtimer_control_block, wheel_link)
+#define swtimer_from_fire_link(ptr)                                            \
+  container_of(ptr, swtimer_control_block, fire_link)
+
+// =========================== PUBLIC API ============================
+// Created stopped. NULL if period is 0, callback is NULL or the pool is
+// empty. Delete a timer only from a task. *_from_isr commands already
+// posted for it are dropped, and its control block goes back to the pool
+// once the timer task has taken the last of them. The handle must not be
+// used after the delete.
+swtimer_handle_t swtimer_create(const char *name, uint32_t period,
+                                uint8_t flags, swtimer_callback_t callback,
+                                void *arg);
+void swtimer_delete(swtimer_handle_t timer);
+
+// Start arms a stopped timer period ticks from now and leaves a running
+// one alone. Reset re-arms it period ticks from now either way. Stop
+// disarms it and drops a callback that is still waiting to run.
+swtimer_result_t swtimer_start(swtimer_handle_t timer);
+swtimer_result_t swtimer_stop(swtimer_handle_t timer);
+swtimer_result_t swtimer_reset(swtimer_handle_t timer);
+
+// Takes effect from the next arming
+swtimer_result_t swtimer_set_period(swtimer_handle_t timer, uint32_t period);
+
+bool swtimer_is_active(swtimer_handle_t timer);
+
+swtimer_result_t swtimer_start_from_isr(swtimer_handle_t timer);
+swtimer_result_t swtimer_stop_from_isr(swtimer_handle_t timer);
+swtimer_result_t swtimer_reset_from_isr(swtimer_handle_t timer);
+
+task_handle_t swtimer_get_task(void);
+
+// Kernel internal: kernel_init() creates the timer task and queue, and
+// scheduler_tick() expires timers after counting tick `now`
+void swtimer_service_init(void);
+void swtimer_tick(uint32_t now);
+
+#endif // !SWTIMER_H
@@ -14,14 +14,39 @@ typedef enum {
   WAKE_REASON_DATA_AVAILABLE,
   WAKE_REASON_TIMEOUT,
   WAKE_REASON_SIGNAL,
-  WAKE_REASON_NONE
+  WAKE_REASON_NONE,
+  WAKE_REASON_COUNT,
 } wake_reason_t;
 
+typedef struct latency_histogram {
+  uint32_t count;
+  uint32_t max_cycles;
+  uint32_t buckets[LATENCY_HIST_BUCKETS]; // See LATENCY_HIST_BUCKETS
+} latency_histogram_t;
+
+typedef struct blocked_time {
+  uint32_t count;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+} blocked_time_t;
+
+typedef struct task_latency_stats {
+  latency_histogram_t wakeup;                // Made ready -> running
+  blocked_time_t blocked[WAKE_REASON_COUNT]; // Indexed by wake_reason_t
+} task_latency_stats_t;
+
+// Thread mode, PSP, no FP frame: what every task starts with
+#define TASK_INITIAL_EXC_RETURN 0xFFFFFFFDu
+
+// context_switch.S reads the TCB by offset: stack_pointer must stay at 0,
+// stack_base at 4 and exc_return at 8. Add new fields after them.
 typedef struct task_control_block {
   // CPU context (stack pointer, registers)
   uint32_t *stack_pointer;
   uint32_t *stack_base;
-  uint32_t stack_size; // In bytes
+  uint32_t exc_return; // EXC_RETURN of the last switch-out (FP frame or not)
+  uint32_t stack_size;         // In bytes
+  uint32_t stack_min_headroom; // Least free stack seen by the idle sweep
 
   // Task information
   char name[16];
@@ -35,7 +60,14 @@ typedef struct task_control_block {
   wake_reason_t wake_reason;
 
   uint32_t run_count;     // Number of times scheduled
-  uint32_t total_runtime; // Total CPU time
+  uint64_t total_runtime; // Total CPU time in cycles, excluding interrupts
+
+#if LATENCY_STATS_ENABLED
+  uint32_t blocked_since; // Cycle count at the last block
+  uint32_t ready_since;   // Cycle count at the last wakeup
+  bool wakeup_pending;    // Woken but not yet switched in
+  task_latency_stats_t latency;
+#endif
 
   list_head_t ready_link; // Per-priority ready queue
   list_head_t delay_link; // Delayed list
@@ -54,4 +86,12 @@ void task_init_stack(task_handle_t task, task_function_t function, void *param);
 bool task_stack_check(task_handle_t task);
 uint32_t task_stack_used_bytes(task_handle_t task);
 
+// Deepest stack usage ever reached, in bytes, found by scanning up from
+// stack_base for the first word that lost its paint.
+uint32_t task_stack_high_water(task_handle_t task);
+
+// Re-measures every live task and updates stack_min_headroom.
+// Called periodically from the idle task.
+void task_stack_sweep(void);
+
 #endif // !TASK_H
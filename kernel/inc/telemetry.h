@@ -0,0 +1,67 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "config.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary telemetry snapshot
+//
+// telemetry_snapshot() writes the kernel's statistics into a caller buffer
+// as one compact frame for a low-bandwidth link: a header, then one TLV
+// entry (type byte, length byte, value) per pool, task, queue, semaphore
+// and mutex. Every value is little-endian and packed. Objects are copied
+// one per critical section, so masked time is bounded by the largest
+// object, not by how many there are; each entry is consistent in itself,
+// and the header carries the ticks at which copying started and ended.
+// Unknown entry types are skipped by length, so new ones can be added
+// without bumping the version; changing an existing entry bumps it.
+//
+//   $ tools/telemetry_decode.py frame.bin
+//
+// Entries (slot = index in the object's pool, name = up to 15 bytes, not
+// terminated, running to the end of the entry):
+//
+//   KERNEL 1  cpu load (permille) u16, ISR cycles u64, timestamp hz u32,
+//             task count u8
+//   POOL   2  pool u8, total u16, used u16, peak u16, corruptions u16
+//   TASK   3  slot u8, state u8, base priority u8, effective priority u8,
+//             stack size u16, stack headroom u16, run count u32,
+//             runtime cycles u64, name
+//   QUEUE  4  slot u8, messages u16, capacity u16, item size u16,
+//             flags u8 (bit 0: senders blocked, bit 1: receivers blocked)
+//   SEM    5  slot u8, count u32, max count u32, waiting tasks u8, name
+//   MUTEX  6  slot u8, owner task slot u8 (0xFF: free), waiting tasks u8,
+//             name
+
+#define TELEMETRY_MAGIC 0x4D54524Du // "MRTM"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_SIZE 20
+
+#define TELEMETRY_FLAG_TRUNCATED 0x01 // Buffer full, entries left out
+
+#define TELEMETRY_NO_TASK 0xFF
+
+typedef enum {
+  TELEMETRY_ENTRY_KERNEL = 1,
+  TELEMETRY_ENTRY_POOL = 2,
+  TELEMETRY_ENTRY_TASK = 3,
+  TELEMETRY_ENTRY_QUEUE = 4,
+  TELEMETRY_ENTRY_SEM = 5,
+  TELEMETRY_ENTRY_MUTEX = 6,
+} telemetry_entry_t;
+
+typedef enum {
+  TELEMETRY_OK = 0,
+  TELEMETRY_ERROR_NULL = -1,
+  TELEMETRY_ERROR_TOO_SMALL = -2, // Not even the header fits
+} telemetry_result_t;
+
+// Header: magic u32, version u8, flags u8, frame length u16 (header
+// included), sequence u32, tick at start u32, tick at end u32
+
+// Public API
+telemetry_result_t telemetry_snapshot(uint8_t *buffer, size_t size,
+                                      size_t *length);
+
+#endif // !TELEMETRY_H
@@ -1,5 +1,6 @@
 #ifndef TIME_UTILS_H
 #define TIME_UTILS_H
+#include "config.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -24,4 +25,65 @@ static inline uint32_t ticks_until(uint32_t deadline, uint32_t now) {
   return dt <= 0 ? 0u : (uint32_t)dt;
 }
 
+// Current tick rate: KERNEL_TICK_HZ until kernel_set_clock() changes it
+extern volatile uint32_t tick_hz;
+
+// 64-bit tick count to a timeout, saturating one below the WAIT_FOREVER
+// value so a long finite duration never turns into an infinite one
+#define TIME_SATURATE_TICKS(ticks)                                             \
+  ((ticks) >= 0xFFFFFFFFu ? 0xFFFFFFFEu : (uint32_t)(ticks))
+
+// Conversions at a given tick rate. Durations round up into ticks, so a
+// timeout never expires early, and down out of them. The macros are for
+// constants and assume the rate stays at KERNEL_TICK_HZ; the functions
+// follow tick_hz.
+#define TIME_MS_TO_TICKS_AT(ms, hz)                                            \
+  TIME_SATURATE_TICKS(((uint64_t)(ms) * (hz) + 999u) / 1000u)
+#define TIME_US_TO_TICKS_AT(us, hz)                                            \
+  TIME_SATURATE_TICKS(((uint64_t)(us) * (hz) + 999999u) / 1000000u)
+#define TIME_TICKS_TO_MS_AT(ticks, hz)                                         \
+  ((uint64_t)(ticks) / (hz) * 1000u + (uint64_t)(ticks) % (hz) * 1000u / (hz))
+#define TIME_TICKS_TO_US_AT(ticks, hz)                                         \
+  ((uint64_t)(ticks) / (hz) * 1000000u +                                       \
+   (uint64_t)(ticks) % (hz) * 1000000u / (hz))
+
+#define TIME_MS_TO_TICKS(ms) TIME_MS_TO_TICKS_AT(ms, KERNEL_TICK_HZ)
+#define TIME_US_TO_TICKS(us) TIME_US_TO_TICKS_AT(us, KERNEL_TICK_HZ)
+#define TIME_TICKS_TO_MS(ticks) TIME_TICKS_TO_MS_AT(ticks, KERNEL_TICK_HZ)
+#define TIME_TICKS_TO_US(ticks) TIME_TICKS_TO_US_AT(ticks, KERNEL_TICK_HZ)
+
+static inline uint32_t time_ms_to_ticks(uint32_t ms) {
+  uint32_t hz = tick_hz;
+  return TIME_MS_TO_TICKS_AT(ms, hz);
+}
+
+static inline uint32_t time_us_to_ticks(uint32_t us) {
+  uint32_t hz = tick_hz;
+  return TIME_US_TO_TICKS_AT(us, hz);
+}
+
+static inline uint64_t time_ticks_to_ms(uint64_t ticks) {
+  uint32_t hz = tick_hz;
+  return TIME_TICKS_TO_MS_AT(ticks, hz);
+}
+
+static inline uint64_t time_ticks_to_us(uint64_t ticks) {
+  uint32_t hz = tick_hz;
+  return TIME_TICKS_TO_US_AT(ticks, hz);
+}
+
+// Counter cycles at hz (e.g. PORT_TIME_HZ) to microseconds, split
+// so a 64-bit cycle count cannot overflow the multiply
+static inline uint64_t time_cycles_to_us(uint64_t cycles, uint32_t hz) {
+  return cycles / hz * 1000000u + cycles % hz * 1000000u / hz;
+}
+
+// Timeout in ticks for a blocking call that must return by an absolute
+// 64-bit tick deadline: 0 once it has passed, and never the WAIT_FOREVER
+// value however far away it is
+static inline uint32_t ticks_until64(uint64_t deadline, uint64_t now) {
+  if (deadline <= now) return 0u;
+  return TIME_SATURATE_TICKS(deadline - now);
+}
+
 #endif // !TIME_UTILS_H
@@ -0,0 +1,120 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Kernel event trace recorder
+//
+// Every event is one fixed-size record in a RAM ring. Producers claim a slot
+// with a single atomic increment, so tasks and interrupts can record without
+// a critical section. The ring is wrapped in trace_ram together with a header
+// so a debugger dump of that one symbol is self-describing:
+//
+//   (gdb) dump binary memory trace.bin &trace_ram (char *)&trace_ram + sizeof(trace_ram)
+//   $ tools/trace_decode.py trace.bin
+//
+// A sink installed with trace_set_sink() additionally sees each record as it
+// is written (semihosting, UART, host-side encoders). A stream is a header
+// with capacity 0 followed by records; off-target, trace_stream_open() writes
+// one to a file with a write(2) per record, which is safe from signal
+// handlers. tools/trace_to_perfetto.py turns either form into a Chrome
+// Trace Event / Perfetto timeline.
+
+#define TRACE_MAGIC 0x5454524Du // "MRTT"
+#define TRACE_VERSION 1
+
+typedef enum {
+  TRACE_EVENT_NONE = 0,
+
+  // Scheduler (object = task)
+  TRACE_EVENT_TASK_SWITCH = 1, // arg = outgoing task
+  TRACE_EVENT_TASK_READY = 2,  // arg = effective priority
+  TRACE_EVENT_TASK_BLOCK = 3,  // arg = object waited on (0 for a delay)
+  TRACE_EVENT_TASK_CREATE = 4, // arg = base priority
+  TRACE_EVENT_TASK_DELETE = 5,
+  TRACE_EVENT_TASK_NAME = 6, // arg = 4 name bytes, 4 records per name
+
+  // Queues (object = queue, arg = messages waiting afterwards)
+  TRACE_EVENT_QUEUE_SEND = 16,
+  TRACE_EVENT_QUEUE_RECEIVE = 17,
+  TRACE_EVENT_QUEUE_SEND_BLOCK = 18,
+  TRACE_EVENT_QUEUE_RECEIVE_BLOCK = 19,
+
+  // Semaphores (object = semaphore, arg = count afterwards)
+  TRACE_EVENT_SEM_POST = 24,
+  TRACE_EVENT_SEM_TAKE = 25,
+  TRACE_EVENT_SEM_BLOCK = 26,
+
+  // Mutexes (object = mutex unless noted)
+  TRACE_EVENT_MUTEX_LOCK = 32,  // arg = new owner
+  TRACE_EVENT_MUTEX_UNLOCK = 33,
+  TRACE_EVENT_MUTEX_BLOCK = 34, // arg = current owner
+  TRACE_EVENT_MUTEX_PI_BOOST = 35,   // object = owner, arg = new priority
+  TRACE_EVENT_MUTEX_PI_RESTORE = 36, // object = owner, arg = new priority
+
+  // Memory pools (object = pointer, arg = pool | used objects << 16)
+  TRACE_EVENT_POOL_ALLOC = 40,
+  TRACE_EVENT_POOL_FREE = 41,
+
+  // Interrupts (arg = exception number)
+  TRACE_EVENT_ISR_ENTER = 48,
+  TRACE_EVENT_ISR_EXIT = 49,
+
+  // Clock (object = old cycle counter rate, arg = new rate, both in Hz).
+  // Timestamps after it count at the new rate.
+  TRACE_EVENT_CLOCK_CHANGE = 56,
+
+  TRACE_EVENT_USER = 64, // First id free for applications
+} trace_event_t;
+
+typedef struct trace_record {
+  uint32_t timestamp; // port_cycle_count()
+  uint16_t event;     // trace_event_t
+  uint16_t sequence;  // Low bits of the slot number, exposes lost records
+  uint32_t object;    // Handle or address (low 32 bits off-target)
+  uint32_t arg;
+} trace_record_t;
+
+typedef struct trace_header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t capacity;     // Records in the ring, 0 for a stream
+  uint32_t head;         // Records ever written; slot = head % capacity
+  uint32_t timestamp_hz; // Rate of the timestamp counter
+  uint32_t enabled;
+} trace_header_t;
+
+typedef struct trace_buffer {
+  trace_header_t header;
+  trace_record_t records[TRACE_BUFFER_RECORDS];
+} trace_buffer_t;
+
+typedef void (*trace_sink_t)(const trace_record_t *record);
+
+#if TRACE_ENABLED
+extern trace_buffer_t trace_ram;
+
+void trace_init(void);
+void trace_start(void); // Also records the names of all live tasks
+void trace_stop(void);
+void trace_clear(void);
+void trace_set_sink(trace_sink_t sink);
+void trace_record(uint16_t event, uintptr_t object, uint32_t arg);
+void trace_task_name(const void *task); // TASK_NAME records for one task
+void trace_stream_header(trace_header_t *header);
+
+#ifndef __ARM_ARCH
+bool trace_stream_open(const char *path); // Installs a file sink
+void trace_stream_close(void);
+#endif
+
+#define TRACE(event, object, arg)                                              \
+  trace_record((event), (uintptr_t)(object), (uint32_t)(arg))
+#else
+#define TRACE(event, object, arg) ((void)0)
+#endif
+
+#endif // !TRACE_H
@@ -0,0 +1,75 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "kernel.h"
+#include "list.h"
+#include "semaphore.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Deferred work queues (bottom halves)
+//
+// An interrupt that has more to do than acknowledge its device submits a
+// work item and returns; the queue's worker task runs the item's function
+// later, at the queue's priority, with interrupts enabled. Create one
+// queue per priority the work needs. Items are owned by the caller and
+// linked in intrusively, so submitting never allocates. An immediate
+// submit is O(1): one list insert and a semaphore post, safe from any
+// kernel-aware ISR.
+//
+// An item is in at most one queue at a time. Submitting an item that is
+// still waiting to run (immediately or delayed) does nothing and returns
+// false, so a burst of interrupts coalesces into one run. Once its
+// function has started the item is free again and may be resubmitted,
+// including by the function itself.
+//
+// Delayed items wait on a separate list sorted by due tick. A delayed
+// submit walks it from the tail to find its place, which is O(1) when
+// delays are submitted in deadline order; the worker takes due items off
+// the head one critical section at a time. Delays are in ticks and are not
+// converted by kernel_set_clock().
+
+struct work_item;
+struct work_queue;
+
+typedef void (*work_function_t)(struct work_item *work, void *arg);
+
+typedef struct work_item {
+  list_head_t link; // Pending or delayed list, self-linked when idle
+  work_function_t function;
+  void *arg;
+  uint32_t due;             // Tick a delayed item becomes pending
+  struct work_queue *queue; // Set while queued
+} work_item_t;
+
+typedef struct work_queue {
+  list_head_t pending; // Run in submission order
+  list_head_t delayed; // Sorted by due, see above
+  semaphore_handle_t wake;
+  task_handle_t worker;
+  uint32_t runs;      // Items run so far
+  uint32_t coalesced; // Submits that found their item already queued
+} work_queue_t;
+
+#define WORK_ITEM_INIT(item, fn, a)                                            \
+  { {&(item).link, &(item).link}, (fn), (a), 0, NULL }
+
+// =========================== PUBLIC API ============================
+// Starts the worker task; stack_size 0 picks the default. False if the
+// kernel is not initialised or the task or its semaphore cannot be had.
+bool work_queue_init(work_queue_t *wq, const char *name,
+                     task_priority_t priority, uint16_t stack_size);
+
+void work_init(work_item_t *work, work_function_t function, void *arg);
+
+// True if queued, false if already queued (coalesced) or NULL
+bool work_submit(work_queue_t *wq, work_item_t *work);
+bool work_submit_delayed(work_queue_t *wq, work_item_t *work, uint32_t ticks);
+
+// Takes a queued item back out. True if it was queued; an item whose
+// function is already running is not waited for.
+bool work_cancel(work_item_t *work);
+
+bool work_is_queued(const work_item_t *work);
+
+#endif // !WORKQUEUE_H
@@ -0,0 +1,124 @@
+#include "critical.h"
+
+#if CRITICAL_PROFILE_ENABLED
+
+#include "klog.h"
+#include "port.h"
+
+#include <string.h>
+
+// Only the outermost section is timed: inner ones don't change how long
+// interrupts stay masked. All state is touched with interrupts masked, and
+// kernel-aware ISRs can't run inside a section, so a plain depth counter is
+// enough to tell outermost from nested.
+
+static uint32_t depth;
+static uint32_t enter_cycles;
+static uintptr_t enter_site;
+
+static critical_profile_entry_t entries[CRITICAL_PROFILE_SLOTS];
+
+// ============================== HELPER FUNCTIONS =============================
+
+static void record(uintptr_t site, uint32_t cycles) {
+  critical_profile_entry_t *shortest = &entries[0];
+
+  for (size_t i = 0; i < CRITICAL_PROFILE_SLOTS; i++) {
+    critical_profile_entry_t *e = &entries[i];
+
+    if (e->site == site) {
+      if (cycles > e->max_cycles) e->max_cycles = cycles;
+      e->count++;
+      e->total_cycles += cycles;
+      return;
+    }
+    if (e->max_cycles < shortest->max_cycles) {
+      shortest = e;
+    }
+  }
+
+  // New site: evict the least offending one if this section beats it
+  if (shortest->count == 0 || cycles > shortest->max_cycles) {
+    shortest->site = site;
+    shortest->max_cycles = cycles;
+    shortest->count = 1;
+    shortest->total_cycles = cycles;
+  }
+}
+
+// ============================== PUBLIC API ===================================
+
+__attribute__((noinline)) void critical_profile_enter(void) {
+  if (depth++ == 0) {
+    enter_site = (uintptr_t)__builtin_return_address(0);
+#ifdef __ARM_ARCH
+    enter_site &= ~(uintptr_t)1; // Drop the Thumb bit for addr2line
+#endif
+    enter_cycles = port_cycle_count();
+  }
+}
+
+__attribute__((noinline)) void critical_profile_exit(void) {
+  uint32_t now = port_cycle_count();
+
+  if (depth == 0) return; // Unbalanced END
+  if (--depth == 0) {
+    record(enter_site, now - enter_cycles);
+  }
+}
+
+size_t critical_profile_get(critical_profile_entry_t *out, size_t max_entries) {
+  critical_profile_entry_t copy[CRITICAL_PROFILE_SLOTS];
+  size_t count = 0;
+
+  uint32_t state = kernel_critical_enter();
+  for (size_t i = 0; i < CRITICAL_PROFILE_SLOTS; i++) {
+    if (entries[i].count > 0) copy[count++] = entries[i];
+  }
+  kernel_critical_exit(state);
+
+  // Insertion sort by max_cycles, longest first
+  for (size_t i = 1; i < count; i++) {
+    critical_profile_entry_t e = copy[i];
+    size_t j = i;
+    while (j > 0 && copy[j - 1].max_cycles < e.max_cycles) {
+      copy[j] = copy[j - 1];
+      j--;
+    }
+    copy[j] = e;
+  }
+
+  if (count > max_entries) count = max_entries;
+  memcpy(out, copy, count * sizeof(*out));
+  return count;
+}
+
+uint32_t critical_profile_worst_cycles(void) {
+  critical_profile_entry_t worst;
+  return critical_profile_get(&worst, 1) ? worst.max_cycles : 0;
+}
+
+void critical_profile_reset(void) {
+  uint32_t state = kernel_critical_enter();
+  memset(entries, 0, sizeof(entries));
+  kernel_critical_exit(state);
+}
+
+void critical_profile_print(void) {
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  size_t count = critical_profile_get(top, CRITICAL_PROFILE_SLOTS);
+
+  KLOG("\n=== Critical Section Profile ===\n");
+  KLOG("Site       |   Max cyc |  Max us |    Count |   Avg cyc\n");
+  KLOG("-----------|-----------|---------|----------|----------\n");
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t max_us = (uint32_t)((uint64_t)top[i].max_cycles * 1000000u /
+                                 port_cycle_counter_hz());
+    KLOG("0x%08x | %9u | %7u | %8u | %9u\n", top[i].site, top[i].max_cycles,
+         max_us, top[i].count, (uint32_t)(top[i].total_cycles / top[i].count));
+  }
+  KLOG("\n");
+}
+
+#endif // CRITICAL_PROFILE_ENABLED
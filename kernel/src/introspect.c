@@ -0,0 +1,155 @@
+#include "introspect.h"
+#include "critical.h"
+#include "memory.h"
+#include "scheduler.h"
+
+#include <string.h>
+
+// Empty slots cost a section each too, so a walk masks interrupts for at
+// most one object copy at a time, however many objects there are.
+
+// ============================== HELPER FUNCTIONS =============================
+
+static uint8_t count_waiters(const list_head_t *head) {
+  uint32_t count = 0;
+  const list_head_t *pos;
+
+  list_iter(pos, head) {
+    count++;
+  }
+  return count > UINT8_MAX ? UINT8_MAX : (uint8_t)count;
+}
+
+static size_t pool_slots(pool_type_t pool) {
+  return pool_get_stats(pool).total_objects;
+}
+
+// ============================== PUBLIC API ===================================
+
+kernel_object_type_t introspect_object_type(const void *ptr) {
+  if (!ptr) return KERNEL_OBJECT_NONE;
+  if (pool_index_of(POOL_QCB, ptr) >= 0) return KERNEL_OBJECT_QUEUE;
+  if (pool_index_of(POOL_SCB, ptr) >= 0) return KERNEL_OBJECT_SEMAPHORE;
+  if (pool_index_of(POOL_MCB, ptr) >= 0) return KERNEL_OBJECT_MUTEX;
+  return KERNEL_OBJECT_UNKNOWN;
+}
+
+bool introspect_task_next(size_t *cursor, task_info_t *info) {
+  if (!cursor || !info) return false;
+
+  for (size_t slots = pool_slots(POOL_TCB); *cursor < slots; (*cursor)++) {
+    bool found = false;
+
+    KERNEL_CRITICAL_BEGIN();
+    task_handle_t task = pool_object_at(POOL_TCB, *cursor);
+    if (task && task->state != TASK_DELETED) {
+      info->handle = task;
+      info->slot = *cursor;
+      memcpy(info->name, task->name, sizeof(info->name));
+      // The scheduler only marks the first task it starts as running
+      info->state = task == current_task ? TASK_RUNNING : task->state;
+      info->base_priority = task->base_priority;
+      info->effective_priority = task->effective_priority;
+      info->stack_size = task->stack_size;
+      info->stack_used = task_stack_used_bytes(task);
+      info->stack_headroom = task->stack_min_headroom;
+      info->waiting_on = task->waiting_on;
+      info->waiting_on_type = introspect_object_type(task->waiting_on);
+      info->wake_reason = task->wake_reason;
+      info->wake_tick = task->wake_tick;
+      info->run_count = task->run_count;
+      info->runtime_cycles = task->total_runtime;
+      found = true;
+    }
+    KERNEL_CRITICAL_END();
+
+    if (found) {
+      (*cursor)++;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool introspect_queue_next(size_t *cursor, queue_info_t *info) {
+  if (!cursor || !info) return false;
+
+  for (size_t slots = pool_slots(POOL_QCB); *cursor < slots; (*cursor)++) {
+    bool found = false;
+
+    KERNEL_CRITICAL_BEGIN();
+    queue_handle_t queue = pool_object_at(POOL_QCB, *cursor);
+    if (queue) {
+      info->handle = queue;
+      info->slot = *cursor;
+      info->messages = queue->buffer.size;
+      info->capacity = queue->buffer.capacity;
+      info->item_size = queue->buffer.element_size;
+      info->waiting_senders = count_waiters(&queue->waiting_senders);
+      info->waiting_receivers = count_waiters(&queue->waiting_receivers);
+      found = true;
+    }
+    KERNEL_CRITICAL_END();
+
+    if (found) {
+      (*cursor)++;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool introspect_sem_next(size_t *cursor, sem_info_t *info) {
+  if (!cursor || !info) return false;
+
+  for (size_t slots = pool_slots(POOL_SCB); *cursor < slots; (*cursor)++) {
+    bool found = false;
+
+    KERNEL_CRITICAL_BEGIN();
+    semaphore_handle_t sem = pool_object_at(POOL_SCB, *cursor);
+    if (sem) {
+      info->handle = sem;
+      info->slot = *cursor;
+      memcpy(info->name, sem->name, sizeof(info->name));
+      info->count = sem->count;
+      info->max_count = sem->max_count;
+      info->waiting_tasks = count_waiters(&sem->waiting_tasks);
+      found = true;
+    }
+    KERNEL_CRITICAL_END();
+
+    if (found) {
+      (*cursor)++;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool introspect_mutex_next(size_t *cursor, mutex_info_t *info) {
+  if (!cursor || !info) return false;
+
+  for (size_t slots = pool_slots(POOL_MCB); *cursor < slots; (*cursor)++) {
+    bool found = false;
+
+    KERNEL_CRITICAL_BEGIN();
+    mutex_handle_t mutex = pool_object_at(POOL_MCB, *cursor);
+    if (mutex) {
+      info->handle = mutex;
+      info->slot = *cursor;
+      memcpy(info->name, mutex->name, sizeof(info->name));
+      info->owner = mutex->owner;
+      info->owner_slot = mutex->owner ? pool_index_of(POOL_TCB, mutex->owner)
+                                      : -1;
+      info->waiting_tasks = count_waiters(&mutex->waiting_tasks);
+      found = true;
+    }
+    KERNEL_CRITICAL_END();
+
+    if (found) {
+      (*cursor)++;
+      return true;
+    }
+  }
+  return false;
+}
@@ -1,13 +1,20 @@
 #include "kernel.h"
+#include "critical.h"
+#include "klog.h"
 #include "scheduler.h"
 #include "task.h"
+#include "time_utils.h"
 #include "memory.h"
 #include "port.h"
+#include "runtime_stats.h"
+#include "swtimer.h"
+#include "trace.h"
 #include <stddef.h>
 
 // Kernel state - private to this module
 static bool kernel_initialized = false;
 static bool kernel_running = false;
+static uint32_t core_clock_hz = PORT_CORE_CLOCK_HZ;
 
 static bool _is_valid_task_context(void) {
   return kernel_running && current_task != NULL;
@@ -19,7 +26,23 @@ static bool _is_kernel_ready(void) { return kernel_initialized; }
 
 static void idle_task_function(void *param) {
   (void)param;
+  uint32_t last_stack_sweep = tick_now;
+
   while (1) {
+#if POOL_GUARD_ENABLED
+    // Incremental, bounded guard check of the memory pools
+    pool_integrity_scan_step();
+#endif
+
+    // Converted each pass, so the period holds across kernel_set_clock()
+    if (tick_now - last_stack_sweep >=
+        time_ms_to_ticks(STACK_SWEEP_PERIOD_MS)) {
+      last_stack_sweep = tick_now;
+      task_stack_sweep();
+    }
+
+    // PRIMASK rather than BASEPRI on purpose: WFI must still wake for any
+    // interrupt, and the window is only a few list checks long.
     __disable_irq();
 
     bool can_sleep = true;
@@ -51,6 +74,13 @@ void kernel_init(void) {
     return;
   }
 
+#if TRACE_ENABLED
+  trace_init();
+#endif
+#if KLOG_ENABLED
+  klog_init();
+#endif
+
   memory_pools_init();
 
   scheduler_init();
@@ -70,6 +100,10 @@ void kernel_init(void) {
 
   scheduler_add_task(idle_task_handle);
 
+#if SWTIMER_ENABLED
+  swtimer_service_init();
+#endif
+
   kernel_initialized = true;
   kernel_running = false;
 }
@@ -161,9 +195,11 @@ void task_yield(void) {
   // For public API, use the clean interface
   task_handle_t current = task_get_current();
 
-  if (current->state == TASK_RUNNING) {
-    current->state = TASK_READY;
+  // Go behind the other ready tasks of the same priority (round-robin)
+  if (current->state == TASK_RUNNING || current->state == TASK_READY) {
+    KERNEL_CRITICAL_BEGIN();
     scheduler_add_task(current);
+    KERNEL_CRITICAL_END();
   }
 
   scheduler_yield();
@@ -173,3 +209,70 @@ void task_yield(void) {
 }
 
 task_handle_t task_get_current(void) { return current_task; }
+
+task_handle_t kernel_get_idle_task(void) { return idle_task_handle; }
+
+uint64_t kernel_get_ticks64(void) { return scheduler_get_ticks64(); }
+
+uint64_t kernel_get_time_cycles(void) { return port_time_cycles(); }
+
+uint64_t kernel_get_time_us(void) {
+  KERNEL_CRITICAL_BEGIN();
+  uint64_t us = time_cycles_to_us(port_time_cycles(), PORT_TIME_HZ);
+  KERNEL_CRITICAL_END();
+  return us;
+}
+
+uint32_t kernel_ticks_until(uint64_t deadline) {
+  return ticks_until64(deadline, scheduler_get_ticks64());
+}
+
+bool kernel_set_clock(uint32_t core_hz, uint32_t tick_hz) {
+  if (!port_tick_rate_valid(core_hz, tick_hz)) {
+    return false;
+  }
+
+  KERNEL_CRITICAL_BEGIN();
+  uint32_t old_counter_hz = port_cycle_counter_hz();
+  core_clock_hz = core_hz;
+#ifdef __ARM_ARCH
+  port_core_clock_hz = core_hz;
+#endif
+  scheduler_set_tick_hz(tick_hz);
+  if (kernel_running) {
+    systick_init(tick_hz);
+  }
+
+  // Timestamped streams mark where their counter changes rate; headers
+  // give the current rate to a dump taken from here on
+  uint32_t counter_hz = port_cycle_counter_hz();
+  TRACE(TRACE_EVENT_CLOCK_CHANGE, old_counter_hz, counter_hz);
+#if TRACE_ENABLED
+  trace_ram.header.timestamp_hz = counter_hz;
+#endif
+#if KLOG_ENABLED
+  klog_ram.header.timestamp_hz = counter_hz;
+#endif
+  KLOG("clock: cycle counter %u -> %u Hz, tick %u Hz\n", old_counter_hz,
+       counter_hz, tick_hz);
+  KERNEL_CRITICAL_END();
+  return true;
+}
+
+uint32_t kernel_get_tick_hz(void) { return tick_hz; }
+
+uint32_t kernel_get_core_clock_hz(void) { return core_clock_hz; }
+
+void kernel_isr_enter(void) {
+#if RUNTIME_STATS_ENABLED
+  runtime_stats_isr_enter();
+#endif
+  TRACE(TRACE_EVENT_ISR_ENTER, 0, port_current_exception());
+}
+
+void kernel_isr_exit(void) {
+  TRACE(TRACE_EVENT_ISR_EXIT, 0, port_current_exception());
+#if RUNTIME_STATS_ENABLED
+  runtime_stats_isr_exit();
+#endif
+}
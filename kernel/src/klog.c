@@ -0,0 +1,181 @@
+#include "klog.h"
+
+#if KLOG_ENABLED
+
+#include "port.h"
+
+#include <string.h>
+
+#ifndef __ARM_ARCH
+#include <stdio.h>
+#endif
+
+#if (KLOG_BUFFER_WORDS & (KLOG_BUFFER_WORDS - 1)) != 0
+#error "KLOG_BUFFER_WORDS must be a power of two"
+#endif
+
+#define KLOG_MASK (KLOG_BUFFER_WORDS - 1)
+
+// The header is valid before klog_init(), so logging works from the start
+klog_buffer_t klog_ram = {
+    .header =
+        {
+            .magic = KLOG_MAGIC,
+            .version = KLOG_VERSION,
+            .header_size = sizeof(klog_header_t),
+            .capacity = KLOG_BUFFER_WORDS,
+            .timestamp_hz = PORT_CYCLE_COUNTER_HZ,
+        },
+};
+
+// Makes sure the section (and so __start_klog_fmt) exists in every image
+static const char klog_fmt_empty[] __attribute__((section("klog_fmt"), used)) =
+    "";
+
+// ============================== PUBLIC API ===================================
+
+void klog_init(void) {
+  port_cycle_counter_init();
+
+  memset(klog_ram.words, 0, sizeof(klog_ram.words));
+  klog_ram.header.head = 0;
+  klog_ram.header.tail = 0;
+  klog_ram.header.dropped = 0;
+}
+
+// Hot path. The CAS claims the words only if the consumer has freed them,
+// so a full ring drops the new record instead of tearing an old one. An
+// interrupt that preempts a producer between claim and tag claims the
+// words after it and may complete first; the consumer then waits at the
+// untagged record, so records come out in claim order.
+void klog_write(uint32_t format, uint32_t count, const uint32_t *args) {
+  uint32_t words = KLOG_RECORD_WORDS + count;
+  uint32_t pos = __atomic_load_n(&klog_ram.header.head, __ATOMIC_RELAXED);
+
+  do {
+    uint32_t tail = __atomic_load_n(&klog_ram.header.tail, __ATOMIC_ACQUIRE);
+    if (pos - tail + words > KLOG_BUFFER_WORDS) {
+      __atomic_fetch_add(&klog_ram.header.dropped, 1, __ATOMIC_RELAXED);
+      return;
+    }
+  } while (!__atomic_compare_exchange_n(&klog_ram.header.head, &pos,
+                                        pos + words, true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+
+  uint32_t *ring = klog_ram.words;
+  ring[(pos + 1) & KLOG_MASK] = (format & 0xFFFFu) | count << 16;
+  ring[(pos + 2) & KLOG_MASK] = port_cycle_count();
+  for (uint32_t i = 0; i < count; i++) {
+    ring[(pos + KLOG_RECORD_WORDS + i) & KLOG_MASK] = args[i];
+  }
+  __atomic_store_n(&ring[pos & KLOG_MASK], ~pos, __ATOMIC_RELEASE);
+}
+
+// Single consumer. Words are zeroed before they are handed back, so a
+// stale tag can never look complete to the next lap.
+size_t klog_drain(klog_sink_t sink, size_t max_records) {
+  uint32_t *ring = klog_ram.words;
+  uint32_t tail = klog_ram.header.tail;
+  size_t drained = 0;
+
+  while (drained < max_records) {
+    if (__atomic_load_n(&ring[tail & KLOG_MASK], __ATOMIC_ACQUIRE) != ~tail) {
+      break; // Empty, or the oldest producer is still writing
+    }
+
+    klog_record_t record;
+    uint32_t info = ring[(tail + 1) & KLOG_MASK];
+    record.format = (uint16_t)info;
+    record.count = (uint16_t)(info >> 16);
+    record.timestamp = ring[(tail + 2) & KLOG_MASK];
+    if (record.count > KLOG_MAX_ARGS) {
+      record.count = KLOG_MAX_ARGS; // Corrupted; keep the copy in bounds
+    }
+    for (uint32_t i = 0; i < record.count; i++) {
+      record.args[i] = ring[(tail + KLOG_RECORD_WORDS + i) & KLOG_MASK];
+    }
+
+    uint32_t words = KLOG_RECORD_WORDS + record.count;
+    for (uint32_t i = 0; i < words; i++) {
+      ring[(tail + i) & KLOG_MASK] = 0;
+    }
+    tail += words;
+    __atomic_store_n(&klog_ram.header.tail, tail, __ATOMIC_RELEASE);
+
+    if (sink) {
+      sink(&record);
+    }
+    drained++;
+  }
+  return drained;
+}
+
+uint32_t klog_dropped(void) {
+  return __atomic_load_n(&klog_ram.header.dropped, __ATOMIC_RELAXED);
+}
+
+#ifndef __ARM_ARCH
+// Off-target the section is loaded, so the format is at its offset
+size_t klog_format(const klog_record_t *record, char *out, size_t size) {
+  const char *fmt = __start_klog_fmt + record->format;
+  size_t len = 0;
+  uint32_t arg = 0;
+
+  if (size == 0) return 0;
+  out[0] = '\0';
+
+  while (*fmt) {
+    if (*fmt != '%' || fmt[1] == '%') {
+      if (len + 1 < size) {
+        out[len] = *fmt;
+        out[len + 1] = '\0';
+      }
+      len++;
+      fmt += *fmt == '%' ? 2 : 1;
+      continue;
+    }
+
+    char spec[16];
+    size_t n = strspn(fmt + 1, "-+ #0123456789.") + 2;
+    if (n >= sizeof(spec) || !fmt[n - 1] || !strchr("diouxXcs", fmt[n - 1])) {
+      break; // Not a format KLOG() accepts
+    }
+    memcpy(spec, fmt, n);
+    spec[n] = '\0';
+    fmt += n;
+
+    char *dst = len < size ? out + len : NULL;
+    size_t room = len < size ? size - len : 0;
+    int written;
+    if (spec[n - 1] == 's') {
+      char str[KLOG_STR_MAX + 1] = {0};
+      for (uint32_t i = 0; i < KLOG_STR_ARGS && arg < record->count; i++) {
+        uint32_t word = record->args[arg++];
+        memcpy(&str[4 * i], &word, 4); // Little-endian, as packed
+      }
+      written = snprintf(dst, room, spec, str);
+    } else {
+      uint32_t value = arg < record->count ? record->args[arg++] : 0;
+      if (spec[n - 1] == 'd' || spec[n - 1] == 'i' || spec[n - 1] == 'c') {
+        written = snprintf(dst, room, spec, (int)(int32_t)value);
+      } else {
+        written = snprintf(dst, room, spec, (unsigned)value);
+      }
+    }
+    len += written > 0 ? (size_t)written : 0;
+  }
+  return len;
+}
+
+static void klog_print_record(const klog_record_t *record) {
+  char line[256];
+  klog_format(record, line, sizeof(line));
+  fputs(line, stdout);
+}
+
+size_t klog_print_pending(void) {
+  return klog_drain(klog_print_record, (size_t)-1);
+}
+#endif
+
+#endif // KLOG_ENABLED
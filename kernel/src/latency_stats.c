@@ -0,0 +1,134 @@
+#include "latency_stats.h"
+
+#if LATENCY_STATS_ENABLED
+
+#include "critical.h"
+#include "klog.h"
+#include "memory.h"
+#include "port.h"
+
+#include <string.h>
+
+// Every hook runs with interrupts masked (waker's critical section, tick or
+// PendSV), so each costs a cycle-counter read, a subtract and a CLZ.
+
+// ============================== HELPER FUNCTIONS =============================
+
+static uint32_t bucket_of(uint32_t cycles) {
+  uint32_t bucket = cycles ? 31u - (uint32_t)__builtin_clz(cycles) : 0;
+  return bucket < LATENCY_HIST_BUCKETS ? bucket : LATENCY_HIST_BUCKETS - 1;
+}
+
+static uint32_t cycles_to_us(uint32_t cycles) {
+  return (uint32_t)((uint64_t)cycles * 1000000u / port_cycle_counter_hz());
+}
+
+// ============================== KERNEL HOOKS =================================
+
+void latency_stats_blocked(task_handle_t task) {
+  task->blocked_since = port_cycle_count();
+}
+
+// Called by scheduler_add_task() before the state changes to READY
+void latency_stats_ready(task_handle_t task) {
+  if (task->state != TASK_BLOCKED) return;
+
+  uint32_t now = port_cycle_count();
+  uint32_t blocked = now - task->blocked_since;
+
+  wake_reason_t reason = task->wake_reason < WAKE_REASON_COUNT
+                             ? task->wake_reason
+                             : WAKE_REASON_NONE;
+  blocked_time_t *bt = &task->latency.blocked[reason];
+  bt->count++;
+  bt->total_cycles += blocked;
+  if (blocked > bt->max_cycles) bt->max_cycles = blocked;
+
+  task->ready_since = now;
+  task->wakeup_pending = true;
+}
+
+void latency_stats_switch(task_handle_t to) {
+  if (!to || !to->wakeup_pending) return;
+
+  uint32_t latency = port_cycle_count() - to->ready_since;
+  latency_histogram_t *hist = &to->latency.wakeup;
+
+  hist->buckets[bucket_of(latency)]++;
+  hist->count++;
+  if (latency > hist->max_cycles) hist->max_cycles = latency;
+
+  to->wakeup_pending = false;
+}
+
+// ============================== PUBLIC API ===================================
+
+bool task_get_latency_stats(task_handle_t task, task_latency_stats_t *stats) {
+  if (!task || !stats) return false;
+
+  KERNEL_CRITICAL_BEGIN();
+  *stats = task->latency;
+  KERNEL_CRITICAL_END();
+
+  return true;
+}
+
+void task_reset_latency_stats(task_handle_t task) {
+  if (!task) return;
+
+  KERNEL_CRITICAL_BEGIN();
+  memset(&task->latency, 0, sizeof(task->latency));
+  KERNEL_CRITICAL_END();
+}
+
+uint32_t latency_histogram_percentile(const latency_histogram_t *hist,
+                                      uint32_t permille) {
+  if (!hist || hist->count == 0) return 0;
+
+  uint64_t target = ((uint64_t)hist->count * permille + 999) / 1000;
+  uint64_t seen = 0;
+
+  for (uint32_t b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+    seen += hist->buckets[b];
+    if (seen >= target && seen > 0) {
+      // The open-ended last bucket is bounded by the observed maximum
+      if (b == LATENCY_HIST_BUCKETS - 1) return hist->max_cycles;
+      return (2u << b) - 1;
+    }
+  }
+  return hist->max_cycles;
+}
+
+void latency_print_stats(void) {
+  static const char *reason_names[WAKE_REASON_COUNT] = {"Data", "Timeout",
+                                                        "Signal", "Other"};
+  size_t count = pool_get_stats(POOL_TCB).total_objects;
+
+  KLOG("\n=== Wakeup Latency (us) ===\n");
+  KLOG("Task             | Wakeups |    p50 |    p99 |    Max\n");
+  KLOG("-----------------|---------|--------|--------|-------\n");
+
+  for (size_t i = 0; i < count; i++) {
+    task_handle_t task = pool_object_at(POOL_TCB, i);
+    task_latency_stats_t stats;
+    if (!task || !task_get_latency_stats(task, &stats)) continue;
+
+    const latency_histogram_t *h = &stats.wakeup;
+    KLOG("%-16s | %7u | %6u | %6u | %6u\n", KLOG_STR(task->name), h->count,
+         cycles_to_us(latency_histogram_percentile(h, 500)),
+         cycles_to_us(latency_histogram_percentile(h, 990)),
+         cycles_to_us(h->max_cycles));
+
+    for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+      const blocked_time_t *bt = &stats.blocked[r];
+      if (bt->count == 0) continue;
+      KLOG("  blocked %-7s | %7u | avg %u us | max %u us\n",
+           KLOG_STR(reason_names[r]), bt->count,
+           cycles_to_us((uint32_t)(bt->total_cycles / bt->count)),
+           cycles_to_us(bt->max_cycles));
+    }
+  }
+  KLOG("\n");
+}
+
+#endif // LATENCY_STATS_ENABLED
@@ -1,61 +1,136 @@
 #include "critical.h"
+#include "klog.h"
 #include "memory.h"
-#include <stdio.h>
+#include "trace.h"
 #include <string.h>
 
+// Every pool is laid out as [guard][obj 0][guard][obj 1] ... [obj N-1][guard].
+// A guard block holds POOL_GUARD_PATTERN from the end of one object up to the
+// start of the next, so overruns and stack underruns both land in a guard.
+#if POOL_GUARD_ENABLED
+#define POOL_GUARD_SIZE 8
+#else
+#define POOL_GUARD_SIZE 0
+#endif
+
+#define POOL_ALIGN(size) (((size) + 7u) & ~(size_t)7u)
+#define POOL_STRIDE(size) POOL_ALIGN((size) + POOL_GUARD_SIZE)
+
+// uint64_t backing keeps every object (and thus every stack top) 8-byte aligned
+#define POOL_STORAGE(name, size, count)                                        \
+  static uint64_t name[(POOL_GUARD_SIZE + (count) * POOL_STRIDE(size)) /       \
+                       sizeof(uint64_t)]
+
+#define POOL_POISON_WORD ((uint32_t)POOL_POISON_BYTE * 0x01010101u)
+
 // Task Control Blocks
-static task_control_block tcb_pool[MAX_TASKS];
+POOL_STORAGE(tcb_pool, sizeof(task_control_block), MAX_TASKS);
 static memory_pool_t tcb_pool_mgr;
 
 // Task Stacks
-static uint8_t small_stacks[MAX_SMALL_STACKS][SMALL_STACK_SIZE];
-static uint8_t default_stacks[MAX_DEFAULT_STACKS][DEFAULT_STACK_SIZE];
-static uint8_t large_stacks[MAX_LARGE_STACKS][LARGE_STACK_SIZE];
+POOL_STORAGE(small_stacks, SMALL_STACK_SIZE, MAX_SMALL_STACKS);
+POOL_STORAGE(default_stacks, DEFAULT_STACK_SIZE, MAX_DEFAULT_STACKS);
+POOL_STORAGE(large_stacks, LARGE_STACK_SIZE, MAX_LARGE_STACKS);
 
 static memory_pool_t stack_small_pool_mgr;
 static memory_pool_t stack_default_pool_mgr;
 static memory_pool_t stack_large_pool_mgr;
 
 // Queue Control Blocks
-static queue_control_block queue_pool[MAX_QUEUES];
+POOL_STORAGE(queue_pool, sizeof(queue_control_block), MAX_QUEUES);
 static memory_pool_t queue_pool_mgr;
 
 // Queue Buffers
-static uint8_t small_buffers[MAX_SMALL_BUFFERS][SMALL_BUFFER_SIZE];
-static uint8_t medium_buffers[MAX_MEDIUM_BUFFERS][DEFAULT_BUFFER_SIZE];
-static uint8_t large_buffers[MAX_LARGE_BUFFERS][LARGE_BUFFER_SIZE];
+POOL_STORAGE(small_buffers, SMALL_BUFFER_SIZE, MAX_SMALL_BUFFERS);
+POOL_STORAGE(medium_buffers, DEFAULT_BUFFER_SIZE, MAX_MEDIUM_BUFFERS);
+POOL_STORAGE(large_buffers, LARGE_BUFFER_SIZE, MAX_LARGE_BUFFERS);
 
 static memory_pool_t buffer_small_pool_mgr;
 static memory_pool_t buffer_medium_pool_mgr;
 static memory_pool_t buffer_large_pool_mgr;
 
-static semaphore_control_block semaphore_pool[MAX_SEMAPHORES];
-static mutex_control_block mutex_pool[MAX_MUTEXES];
+POOL_STORAGE(semaphore_pool, sizeof(semaphore_control_block), MAX_SEMAPHORES);
+POOL_STORAGE(mutex_pool, sizeof(mutex_control_block), MAX_MUTEXES);
 
 static memory_pool_t semaphore_pool_mgr;
 static memory_pool_t mutex_pool_mgr;
 
-// Array of all pool managers for easy access
+#if SWTIMER_ENABLED
+POOL_STORAGE(swtimer_pool, sizeof(swtimer_control_block), MAX_SWTIMERS);
+static memory_pool_t swtimer_pool_mgr;
+#endif
+
+// Array of all pool managers for easy access. A pool that is compiled out
+// keeps its pool_type_t value but has no manager (NULL).
 
 static memory_pool_t *pools[POOL_COUNT] = {
-    &tcb_pool_mgr,           &stack_small_pool_mgr,  &stack_default_pool_mgr,
-    &stack_large_pool_mgr,   &queue_pool_mgr,        &buffer_small_pool_mgr,
-    &buffer_medium_pool_mgr, &buffer_large_pool_mgr, &semaphore_pool_mgr,
-    &mutex_pool_mgr};
+    [POOL_TCB] = &tcb_pool_mgr,
+    [POOL_STACK_SMALL] = &stack_small_pool_mgr,
+    [POOL_STACK_DEFAULT] = &stack_default_pool_mgr,
+    [POOL_STACK_LARGE] = &stack_large_pool_mgr,
+    [POOL_QCB] = &queue_pool_mgr,
+    [POOL_BUFFER_SMALL] = &buffer_small_pool_mgr,
+    [POOL_BUFFER_MEDIUM] = &buffer_medium_pool_mgr,
+    [POOL_BUFFER_LARGE] = &buffer_large_pool_mgr,
+    [POOL_SCB] = &semaphore_pool_mgr,
+    [POOL_MCB] = &mutex_pool_mgr,
+#if SWTIMER_ENABLED
+    [POOL_TMCB] = &swtimer_pool_mgr,
+#endif
+};
 
 // Peak usage tracking
 static size_t peak_usage[POOL_COUNT] = {0};
 
+// Integrity checking state
+static size_t corruption_count[POOL_COUNT] = {0};
+static pool_corruption_handler_t corruption_handler = NULL;
+static pool_type_t scan_pool = POOL_TCB;
+static size_t scan_slot = 0;
+
 // ============================== HELPER FUNCTIONS =============================
 
-static void pool_init(memory_pool_t *pool, void *pool_start, size_t object_size,
+#if POOL_GUARD_ENABLED || POOL_POISON_ENABLED
+static void fill_words(void *start, size_t bytes, uint32_t pattern) {
+  uint32_t *word = (uint32_t *)start;
+  for (size_t i = 0; i < bytes / sizeof(uint32_t); i++) {
+    word[i] = pattern;
+  }
+}
+#endif
+
+static void pool_init(memory_pool_t *pool, void *storage, size_t object_size,
                       size_t max_objects) {
-  pool->pool_start = pool_start;
+  pool->pool_start = (uint8_t *)storage + POOL_GUARD_SIZE;
   pool->object_size = object_size;
-  pool->pool_size = object_size * max_objects;
+  pool->object_stride = POOL_STRIDE(object_size);
+  pool->pool_size = pool->object_stride * max_objects;
   pool->free_bitmap =
       (1ULL << max_objects) - 1; // All objects are free upon initialization
   pool->free_count = max_objects;
+
+#if POOL_GUARD_ENABLED
+  // Leading guard, then the gap after every object up to the next one
+  fill_words(storage, POOL_GUARD_SIZE, POOL_GUARD_PATTERN);
+#endif
+
+#if POOL_GUARD_ENABLED || POOL_POISON_ENABLED
+  for (size_t i = 0; i < max_objects; i++) {
+    uint8_t *obj = (uint8_t *)pool->pool_start + i * pool->object_stride;
+#if POOL_GUARD_ENABLED
+    fill_words(obj + object_size, pool->object_stride - object_size,
+               POOL_GUARD_PATTERN);
+#endif
+#if POOL_POISON_ENABLED
+    fill_words(obj, object_size, POOL_POISON_WORD);
+#endif
+  }
+#endif
+}
+
+// NULL for an out-of-range type or a pool that is compiled out
+static memory_pool_t *pool_lookup(pool_type_t pool_type) {
+  return pool_type < POOL_COUNT ? pools[pool_type] : NULL;
 }
 
 static int find_free_bit(uint32_t bitmap) {
@@ -72,7 +147,7 @@ static int find_free_bit(uint32_t bitmap) {
 }
 
 static void *get_object_ptr(memory_pool_t *pool, int index) {
-  return (uint8_t *)pool->pool_start + (index * pool->object_size);
+  return (uint8_t *)pool->pool_start + (index * pool->object_stride);
 }
 
 static int get_object_index(memory_pool_t *pool, void *ptr) {
@@ -85,9 +160,74 @@ static int get_object_index(memory_pool_t *pool, void *ptr) {
     return -1;
   }
 
-  return offset / pool->object_size;
+  // Only object starts are valid, never guards or interior pointers
+  if ((size_t)offset % pool->object_stride != 0) {
+    return -1;
+  }
+
+  return offset / pool->object_stride;
+}
+
+static size_t pool_total_objects(const memory_pool_t *pool) {
+  return pool->pool_size / pool->object_stride;
+}
+
+#if POOL_GUARD_ENABLED
+// Word just below the object: catches underruns (stack overflow) of this
+// object and overruns of its lower neighbour.
+static inline uint32_t *guard_below(uint8_t *obj) {
+  return (uint32_t *)obj - 1;
+}
+
+// Word just past the object: catches overruns of this object.
+static inline uint32_t *guard_above(memory_pool_t *pool, uint8_t *obj) {
+  return (uint32_t *)(obj + pool->object_size);
 }
 
+static inline bool guards_intact(memory_pool_t *pool, uint8_t *obj) {
+  return *guard_below(obj) == POOL_GUARD_PATTERN &&
+         *guard_above(pool, obj) == POOL_GUARD_PATTERN;
+}
+
+// Records the violation and re-arms the guards so each event is reported once
+static void report_corruption(pool_type_t pool_type, uint8_t *obj) {
+  memory_pool_t *pool = pools[pool_type];
+
+  KERNEL_CRITICAL_BEGIN();
+  corruption_count[pool_type]++;
+  *guard_below(obj) = POOL_GUARD_PATTERN;
+  *guard_above(pool, obj) = POOL_GUARD_PATTERN;
+  KERNEL_CRITICAL_END();
+
+  if (corruption_handler) {
+    corruption_handler(pool_type, obj);
+  }
+}
+
+static bool check_slot(pool_type_t pool_type, int index) {
+  memory_pool_t *pool = pools[pool_type];
+  uint8_t *obj = get_object_ptr(pool, index);
+  bool intact = guards_intact(pool, obj);
+
+#if POOL_POISON_ENABLED
+  // A free object whose first word lost its poison was written after free
+  KERNEL_CRITICAL_BEGIN();
+  if ((pool->free_bitmap & (1U << index)) &&
+      *(uint32_t *)obj != POOL_POISON_WORD) {
+    *(uint32_t *)obj = POOL_POISON_WORD;
+    intact = false;
+  }
+  KERNEL_CRITICAL_END();
+#endif
+
+  if (!intact) {
+    report_corruption(pool_type, obj);
+  }
+
+  return intact;
+}
+#endif
+
 // ============================== PUBLIC API =============================
 
 void memory_pools_init(void) {
@@ -122,17 +262,25 @@ void memory_pools_init(void) {
   // Placeholder mutex pools
   pool_init(&mutex_pool_mgr, mutex_pool, sizeof(mutex_control_block), MAX_MUTEXES);
 
+#if SWTIMER_ENABLED
+  pool_init(&swtimer_pool_mgr, swtimer_pool, sizeof(swtimer_control_block),
+            MAX_SWTIMERS);
+#endif
+
   // Clear peak usage counters
   memset(peak_usage, 0, sizeof(peak_usage));
+
+  memset(corruption_count, 0, sizeof(corruption_count));
+  scan_pool = POOL_TCB;
+  scan_slot = 0;
 }
 
 void *pool_alloc(pool_type_t pool_type) {
-  if (pool_type >= POOL_COUNT) {
+  memory_pool_t *pool = pool_lookup(pool_type);
+  if (!pool) {
     return NULL;
   }
 
-  memory_pool_t *pool = pools[pool_type];
-
   KERNEL_CRITICAL_BEGIN();
 
   if (pool->free_count == 0) {
@@ -150,14 +298,15 @@ void *pool_alloc(pool_type_t pool_type) {
   pool->free_bitmap &= ~(1U << free_index);
   pool->free_count--;
 
-  size_t used = (pool->pool_size / pool->object_size) - pool->free_count;
+  size_t used = pool_total_objects(pool) - pool->free_count;
   if (used > peak_usage[pool_type]) {
     peak_usage[pool_type] = used;
   }
 
-  KERNEL_CRITICAL_END();
-
   void *ptr = get_object_ptr(pool, free_index);
+  TRACE(TRACE_EVENT_POOL_ALLOC, ptr, pool_type | (used << 16));
+
+  KERNEL_CRITICAL_END();
 
   // Zero out allocated memory
   memset(ptr, 0, pool->object_size);
@@ -166,17 +315,24 @@ void *pool_alloc(pool_type_t pool_type) {
 }
 
 bool pool_free(pool_type_t pool_type, void *ptr) {
-  if (pool_type >= POOL_COUNT || !ptr) {
+  memory_pool_t *pool = pool_lookup(pool_type);
+  if (!pool || !ptr) {
     return false;
   }
 
-  memory_pool_t *pool = pools[pool_type];
   int index = get_object_index(pool, ptr);
 
   if (index < 0) {
     return false; // Invalid pointer
   }
 
+#if POOL_POISON_ENABLED
+  // Poison while still marked allocated so a concurrent alloc can't get it
+  if (!(pool->free_bitmap & (1U << index))) {
+    memset(ptr, POOL_POISON_BYTE, pool->object_size);
+  }
+#endif
+
   KERNEL_CRITICAL_BEGIN();
 
   // Check if already free
@@ -187,12 +343,43 @@ bool pool_free(pool_type_t pool_type, void *ptr) {
 
   pool->free_bitmap |= (1U << index);
   pool->free_count++;
+  TRACE(TRACE_EVENT_POOL_FREE, ptr,
+        pool_type | ((pool_total_objects(pool) - pool->free_count) << 16));
 
   KERNEL_CRITICAL_END();
 
+#if POOL_GUARD_ENABLED
+  // Damage is reported, not fatal: the object is still returned to the pool
+  if (!guards_intact(pool, ptr)) {
+    report_corruption(pool_type, ptr);
+  }
+#endif
+
   return true;
 }
 
+void *pool_object_at(pool_type_t pool_type, size_t index) {
+  memory_pool_t *pool = pool_lookup(pool_type);
+  if (!pool || index >= pool_total_objects(pool)) {
+    return NULL;
+  }
+
+  KERNEL_CRITICAL_BEGIN();
+  bool allocated = !(pool->free_bitmap & (1U << index));
+  KERNEL_CRITICAL_END();
+
+  return allocated ? get_object_ptr(pool, (int)index) : NULL;
+}
+
+int pool_index_of(pool_type_t pool_type, const void *ptr) {
+  memory_pool_t *pool = pool_lookup(pool_type);
+  if (!pool) {
+    return -1;
+  }
+
+  return get_object_index(pool, (void *)ptr);
+}
+
 // ========================== TASK-SPECIFIC HELPERS ===========================
 void *task_pool_alloc_tcb(void) { return pool_alloc(POOL_TCB); }
 
@@ -271,23 +458,34 @@ bool mutex_pool_free_mcb(mutex_control_block *mutex) {
   return pool_free(POOL_MCB, mutex);
 }
 
+// ==================== SWTIMER-SPECIFIC HELPERS ============================
+#if SWTIMER_ENABLED
+swtimer_control_block *swtimer_pool_alloc_tmcb(void) {
+  return (swtimer_control_block *)pool_alloc(POOL_TMCB);
+}
+
+bool swtimer_pool_free_tmcb(swtimer_control_block *timer) {
+  return pool_free(POOL_TMCB, timer);
+}
+#endif
+
 // ======================= STATISTICS AND DEBUG ================================
 
 pool_stats_t pool_get_stats(pool_type_t pool_type) {
-  pool_stats_t stats = {0, 0, 0, 0};
+  pool_stats_t stats = {0, 0, 0, 0, 0};
 
-  if (pool_type >= POOL_COUNT) {
-    return stats;
+  memory_pool_t *pool = pool_lookup(pool_type);
+  if (!pool) {
+    return stats; // All zero for a pool that is compiled out
   }
-
-  memory_pool_t *pool = pools[pool_type];
-  size_t total_objects = pool->pool_size / pool->object_size;
+  size_t total_objects = pool_total_objects(pool);
 
   KERNEL_CRITICAL_BEGIN();
   stats.total_objects = total_objects;
   stats.free_objects = pool->free_count;
   stats.used_objects = total_objects - pool->free_count;
   stats.peak_usage = peak_usage[pool_type];
+  stats.corruptions = corruption_count[pool_type];
   KERNEL_CRITICAL_END();
 
   return stats;
@@ -296,22 +494,51 @@ pool_stats_t pool_get_stats(pool_type_t pool_type) {
 void pool_print_stats(void) {
   const char *pool_names[POOL_COUNT] = {
       "TCB",          "Stack Small",   "Stack Default", "Stack Large", "QCB",
-      "Buffer Small", "Buffer Medium", "Buffer Large",  "SCB",         "MCB"};
+      "Buffer Small", "Buffer Medium", "Buffer Large",  "SCB",         "MCB",
+      "TMCB"};
 
-  printf("\n=== Memory Pool Statistics ===\n");
-  printf("Pool Name        | Total | Used | Free | Peak | Utilization\n");
-  printf("-----------------|-------|------|------|------|------------\n");
+  KLOG("\n=== Memory Pool Statistics ===\n");
+  KLOG("Pool Name        | Total | Used | Free | Peak | Utilization | Corrupt\n");
+  KLOG("-----------------|-------|------|------|------|-------------|--------\n");
 
   for (int i = 0; i < POOL_COUNT; i++) {
     pool_stats_t stats = pool_get_stats((pool_type_t)i);
-    float utilization =
+    uint32_t permille =
         stats.total_objects > 0
-            ? (float)stats.used_objects / stats.total_objects * 100.0f
-            : 0.0f;
+            ? (uint32_t)(stats.used_objects * 1000 / stats.total_objects)
+            : 0;
 
-    printf("%-16s | %5zu | %4zu | %4zu | %4zu | %6.1f%%\n", pool_names[i],
-           stats.total_objects, stats.used_objects, stats.free_objects,
-           stats.peak_usage, utilization);
+    KLOG("%-16s | %5u | %4u | %4u | %4u | %8u.%u%% | %7u\n",
+         KLOG_STR(pool_names[i]), stats.total_objects, stats.used_objects,
+         stats.free_objects, stats.peak_usage, permille / 10, permille % 10,
+         stats.corruptions);
   }
-  printf("\n");
+  KLOG("\n");
+}
+
+// ========================= INTEGRITY CHECKING ================================
+
+void pool_set_corruption_handler(pool_corruption_handler_t handler) {
+  corruption_handler = handler;
+}
+
+bool pool_integrity_scan_step(void) {
+  bool clean = true;
+
+#if POOL_GUARD_ENABLED
+  for (int n = 0; n < POOL_SCAN_SLOTS_PER_STEP; n++) {
+    memory_pool_t *pool = pools[scan_pool];
+
+    if (pool && !check_slot(scan_pool, (int)scan_slot)) {
+      clean = false;
+    }
+
+    if (!pool || ++scan_slot >= pool_total_objects(pool)) {
+      scan_slot = 0;
+      scan_pool = (pool_type_t)((scan_pool + 1) % POOL_COUNT);
+    }
+  }
+#endif
+
+  return clean;
 }
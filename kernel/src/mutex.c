@@ -4,6 +4,7 @@
 #include "scheduler.h"
 #include "task.h"
 #include "time_utils.h"
+#include "trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -52,6 +53,7 @@ static void mutex_apply_priority_inheritance(mutex_handle_t mutex) {
       mutex->original_priority = mutex->owner->base_priority;
     }
 
+    TRACE(TRACE_EVENT_MUTEX_PI_BOOST, mutex->owner, highest_priority);
     scheduler_boost_priority(mutex->owner, highest_priority);
   }
 }
@@ -60,7 +62,9 @@ static void mutex_apply_priority_inheritance(mutex_handle_t mutex) {
 static void mutex_restore_priority(mutex_handle_t mutex) {
   if (!mutex->owner || mutex->original_priority == MAX_PRIORITY) return;
 
-  scheduler_boost_priority(mutex->owner, mutex->original_priority);
+  TRACE(TRACE_EVENT_MUTEX_PI_RESTORE, mutex->owner, mutex->original_priority);
+  // Boosting never lowers a priority; restore goes back to base_priority
+  scheduler_restore_priority(mutex->owner);
   mutex->original_priority = MAX_PRIORITY;
 }
 
@@ -122,6 +126,7 @@ mutex_result_t mutex_lock(mutex_handle_t mutex, uint32_t timeout) {
     // If mutex is not owned, aqcuire it
     if (!mutex->owner) {
       mutex->owner = current_task;
+      TRACE(TRACE_EVENT_MUTEX_LOCK, mutex, (uintptr_t)current_task);
       KERNEL_CRITICAL_END();
       return MUTEX_OK;
     }
@@ -140,25 +145,27 @@ mutex_result_t mutex_lock(mutex_handle_t mutex, uint32_t timeout) {
     uint32_t now = tick_now;
     uint32_t remaining = ticks_until(deadline, now);
 
-    if (remaining == 0) {
+    // The forever deadline is start - 1, so only finite waits expire
+    if (timeout != MUTEX_WAIT_FOREVER && remaining == 0) {
       KERNEL_CRITICAL_END();
       return MUTEX_ERROR_TIMEOUT;
     }
 
     // Block current task
+    TRACE(TRACE_EVENT_MUTEX_BLOCK, mutex, (uintptr_t)mutex->owner);
     current_task->waiting_on = mutex;
     mutex_waitlist_push(&mutex->waiting_tasks, current_task);
 
     // Apply priority inheritance
     mutex_apply_priority_inheritance(mutex);
 
+    task_set_state(current_task, TASK_BLOCKED);
+
     // Set timeout if not waiting forever
     if (timeout != MUTEX_WAIT_FOREVER) {
       uint32_t wake_time = now + remaining;
       scheduler_set_timeout(current_task, wake_time);
     }
-
-    task_set_state(current_task, TASK_BLOCKED);
     KERNEL_CRITICAL_END();
 
     scheduler_yield();
@@ -168,7 +175,9 @@ mutex_result_t mutex_lock(mutex_handle_t mutex, uint32_t timeout) {
 
     if (current_task->wake_reason == WAKE_REASON_SIGNAL) return MUTEX_ERROR_NULL;
 
+    // The armed wake tick, converted if the tick rate changed meanwhile
     if (timeout != MUTEX_WAIT_FOREVER) {
+      deadline = current_task->wake_tick;
       uint32_t now_updated = tick_now;
       timeout = ticks_until(deadline, now_updated);
       if (timeout == 0) return MUTEX_ERROR_TIMEOUT;
@@ -189,6 +198,7 @@ mutex_result_t mutex_unlock(mutex_handle_t mutex) {
   mutex_restore_priority(mutex);
 
   // Release mutex
+  TRACE(TRACE_EVENT_MUTEX_UNLOCK, mutex, 0);
   mutex->owner = NULL;
 
   // Wake up one waiting task if any
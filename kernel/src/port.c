@@ -0,0 +1,181 @@
+// port.c - C side of the ARM Cortex-M4 port (the rest is in
+// port/arm-cortex-m4/context_switch.S)
+
+#include "config.h"
+#include "critical.h"
+#include "port.h"
+#include "scheduler.h"
+
+#ifdef __ARM_ARCH
+
+// System Control Block
+#define SCB_ICSR (*(volatile uint32_t *)0xE000ED04)
+#define SCB_SHCSR (*(volatile uint32_t *)0xE000ED24)
+#define SCB_CFSR (*(volatile uint32_t *)0xE000ED28)
+#define SCB_MMFAR (*(volatile uint32_t *)0xE000ED34)
+
+#define SHCSR_MEMFAULTENA (1U << 16)
+
+// SysTick
+#define SYST_CSR (*(volatile uint32_t *)0xE000E010)
+#define SYST_LOAD (*(volatile uint32_t *)0xE000E014)
+#define SYST_VAL (*(volatile uint32_t *)0xE000E018)
+
+#define SYST_CSR_ENABLE (1U << 0)
+#define SYST_CSR_TICKINT (1U << 1)
+#define SYST_CSR_CLKSOURCE (1U << 2) // Processor clock
+#define SYST_CSR_COUNTFLAG (1U << 16) // Wrapped since last read; read clears
+
+// Debug / trace
+#define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA (1U << 24)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define DWT_CTRL_CYCCNTENA (1U << 0)
+
+// Memory Protection Unit
+#define MPU_CTRL (*(volatile uint32_t *)0xE000ED94)
+#define MPU_RNR (*(volatile uint32_t *)0xE000ED98)
+#define MPU_RBAR (*(volatile uint32_t *)0xE000ED9C)
+#define MPU_RASR (*(volatile uint32_t *)0xE000EDA0)
+
+#define MPU_CTRL_ENABLE (1U << 0)
+#define MPU_CTRL_PRIVDEFENA (1U << 2) // Default map for everything else
+
+#define MPU_RASR_ENABLE (1U << 0)
+#define MPU_RASR_SIZE(bytes) ((uint32_t)(__builtin_ctz(bytes) - 1) << 1)
+#define MPU_RASR_AP_NONE (0U << 24) // No access, privileged or not
+#define MPU_RASR_XN (1U << 28)
+
+#if PORT_CORE_CLOCK_HZ / KERNEL_TICK_HZ > PORT_SYSTICK_MAX_RELOAD
+#error "KERNEL_TICK_HZ is too slow for SysTick at PORT_CORE_CLOCK_HZ"
+#endif
+
+volatile port_fault_info_t port_last_fault;
+
+uint32_t port_core_clock_hz = PORT_CORE_CLOCK_HZ;
+
+// The time base counts at time_clock_hz from time_base_cycles, reached at
+// SysTick wrap time_base_wraps. systick_init() moves the base up to the
+// present.
+static uint32_t time_clock_hz = PORT_CORE_CLOCK_HZ;
+static uint64_t time_base_cycles;
+static uint64_t time_base_wraps;
+static bool systick_running;
+
+// SysTick wraps, counted here rather than taken from the tick count, which
+// scheduler_tick() only bumps partway through SysTick_Handler. Whoever
+// reads COUNTFLAG first after a wrap counts it: the handler, or a clock
+// read that got there before it.
+static uint64_t systick_wraps;
+
+// Cycles at from_hz to cycles at to_hz, without overflowing 64 bits
+static uint64_t rescale_cycles(uint64_t cycles, uint32_t from_hz,
+                               uint32_t to_hz) {
+  return cycles / from_hz * to_hz + cycles % from_hz * to_hz / from_hz;
+}
+
+// SysTick counts down from LOAD and systick_wraps counts the wraps. VAL is
+// read first: if the counter wraps before COUNTFLAG is checked, the wrap is
+// counted and VAL read again, so the two always agree.
+//
+// A period starts where COUNTFLAG sets, on the step from 1 to 0, so VAL
+// reads 0, LOAD, ..., 1 through it. Counting from LOAD instead would put
+// the 0 at the end of the period just counted, a whole period ahead.
+uint64_t port_time_cycles(void) {
+  uint32_t state = kernel_critical_enter();
+  uint32_t reload = SYST_LOAD + 1;
+  uint32_t val = SYST_VAL;
+
+  if (SYST_CSR & SYST_CSR_COUNTFLAG) {
+    systick_wraps++;
+    val = SYST_VAL;
+  }
+  uint32_t elapsed = val ? reload - val : 0;
+  uint64_t cycles = time_base_cycles +
+                    (systick_wraps - time_base_wraps) * reload + elapsed;
+  kernel_critical_exit(state);
+
+  return cycles;
+}
+
+// Called by SysTick_Handler ahead of scheduler_tick(), so the wrap that
+// raised it is counted before the tick code reads the clock
+void port_systick_count(void) {
+  uint32_t state = kernel_critical_enter();
+  if (SYST_CSR & SYST_CSR_COUNTFLAG) {
+    systick_wraps++;
+  }
+  kernel_critical_exit(state);
+}
+
+#if PORT_CYCLE_COUNTER_SYSTICK
+void port_cycle_counter_init(void) {}
+
+uint32_t port_cycle_count(void) { return (uint32_t)port_time_cycles(); }
+#else
+void port_cycle_counter_init(void) {
+  DEMCR |= DEMCR_TRCENA;
+  PORT_DWT_CYCCNT = 0;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+#endif
+
+// Called by scheduler_start() and again by kernel_set_clock(). The time so
+// far is carried over into cycles of the new core clock, and the current
+// tick period restarts.
+void systick_init(uint32_t ticks_per_second) {
+  uint32_t state = kernel_critical_enter();
+
+  if (systick_running) {
+    time_base_cycles = rescale_cycles(port_time_cycles(), time_clock_hz,
+                                      port_core_clock_hz);
+  }
+  time_base_wraps = systick_wraps;
+  time_clock_hz = port_core_clock_hz;
+
+  SYST_CSR = 0;
+  SYST_LOAD = port_core_clock_hz / ticks_per_second - 1;
+  SYST_VAL = 0;
+  SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT | SYST_CSR_ENABLE;
+  systick_running = true;
+
+  kernel_critical_exit(state);
+}
+
+void port_stack_guard_init(const uint32_t *stack_base) {
+  uintptr_t guard = ((uintptr_t)stack_base + MPU_STACK_GUARD_SIZE - 1) &
+                    ~(uintptr_t)(MPU_STACK_GUARD_SIZE - 1);
+
+  MPU_CTRL = 0;
+
+  MPU_RNR = MPU_STACK_GUARD_REGION;
+  MPU_RBAR = (uint32_t)guard;
+  MPU_RASR = MPU_RASR_XN | MPU_RASR_AP_NONE |
+             MPU_RASR_SIZE(MPU_STACK_GUARD_SIZE) | MPU_RASR_ENABLE;
+
+  MPU_CTRL = MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE;
+
+  // Take overflows as MemManage rather than escalating to HardFault
+  SCB_SHCSR |= SHCSR_MEMFAULTENA;
+
+  __asm volatile("dsb\n\tisb" ::: "memory");
+}
+
+// Weak, like the startup vectors, so a test image can report the fault
+// instead of halting
+__attribute__((weak)) void port_fault_halt(void) {
+  while (1) {
+  }
+}
+
+// A task ran into its stack guard (or another MPU violation).
+// Record who and where, then halt for the debugger.
+void MemManage_Handler(void) {
+  port_last_fault.task = current_task;
+  port_last_fault.cfsr = SCB_CFSR;
+  port_last_fault.address = SCB_MMFAR;
+
+  port_fault_halt();
+}
+
+#endif // __ARM_ARCH
@@ -0,0 +1,99 @@
+#include "profile.h"
+
+#if PROFILE_ENABLED
+
+#include "critical.h"
+#include "memory.h"
+#include "scheduler.h"
+
+#include <string.h>
+
+#if (PROFILE_HASH_SLOTS & (PROFILE_HASH_SLOTS - 1)) != 0
+#error "PROFILE_HASH_SLOTS must be a power of two"
+#endif
+
+#define PROFILE_MASK (PROFILE_HASH_SLOTS - 1)
+
+// Exception frame layout (ARMv7-M): r0-r3, r12, lr, pc, xPSR
+#define FRAME_PC 6
+#define EXC_RETURN_THREAD (1u << 3)
+
+profile_buffer_t profile_ram = {
+    .header =
+        {
+            .magic = PROFILE_MAGIC,
+            .version = PROFILE_VERSION,
+            .header_size = sizeof(profile_header_t),
+            .slots = PROFILE_HASH_SLOTS,
+            .pc_bytes = sizeof(uintptr_t),
+            .task_slots = MAX_TASKS,
+        },
+};
+
+// Task whose name is in each names[] entry
+static task_handle_t profile_named[MAX_TASKS];
+
+// ============================== HELPER FUNCTIONS =============================
+
+// Fibonacci hashing: the top bits of the product mix in every PC bit
+static uint32_t profile_hash(uintptr_t pc, uint32_t task) {
+  uint32_t key = (uint32_t)pc ^ (uint32_t)((uint64_t)pc >> 32) ^ task << 24;
+  return (key * 2654435769u) >> 16;
+}
+
+// ============================== PUBLIC API ===================================
+
+void profile_reset(void) {
+  KERNEL_CRITICAL_BEGIN();
+  memset(profile_ram.names, 0, sizeof(profile_ram.names));
+  memset(profile_ram.entries, 0, sizeof(profile_ram.entries));
+  memset(profile_named, 0, sizeof(profile_named));
+  profile_ram.header.samples = 0;
+  profile_ram.header.dropped = 0;
+  KERNEL_CRITICAL_END();
+}
+
+// Called from one interrupt priority, so the table needs no lock
+void profile_sample(uintptr_t pc, task_handle_t task) {
+  uint32_t slot = PROFILE_NO_TASK;
+
+  if (task) {
+    int index = pool_index_of(POOL_TCB, task);
+    if (index >= 0) {
+      slot = (uint32_t)index;
+      if (profile_named[slot] != task) {
+        profile_named[slot] = task;
+        memcpy(profile_ram.names[slot], task->name, sizeof(task->name));
+      }
+    }
+  }
+
+  profile_ram.header.samples++;
+
+  uint32_t h = profile_hash(pc, slot);
+  for (uint32_t probe = 0; probe < PROFILE_MAX_PROBES; probe++) {
+    profile_entry_t *e = &profile_ram.entries[(h + probe) & PROFILE_MASK];
+
+    if (e->count == 0) {
+      e->pc = pc;
+      e->task = (uint8_t)slot;
+      e->count = 1;
+      return;
+    }
+    if (e->pc == pc && e->task == slot) {
+      e->count++;
+      return;
+    }
+  }
+  profile_ram.header.dropped++;
+}
+
+#if defined(__ARM_ARCH) && !PORT_HOST_CONTEXTS
+void profile_sample_frame(const uint32_t *frame, uint32_t exc_return) {
+  // Interrupting another handler: that time belongs to no task
+  task_handle_t task = (exc_return & EXC_RETURN_THREAD) ? current_task : NULL;
+  profile_sample(frame[FRAME_PC], task);
+}
+#endif
+
+#endif // PROFILE_ENABLED
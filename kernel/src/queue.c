@@ -1,8 +1,10 @@
 #include "critical.h"
 #include "memory.h"
 #include "queue.h"
+#include "replay.h"
 #include "scheduler.h"
 #include "task.h"
+#include "trace.h"
 
 #include <string.h>
 
@@ -88,6 +90,11 @@ queue_result_t queue_send(queue_handle_t queue, const void *item,
                           uint32_t timeout) {
   if (!queue || !item) return QUEUE_ERROR_NULL_POINTER;
 
+#if REPLAY_ENABLED
+  // Replay brings the recorded interrupt sends instead of the live ones
+  if (replay_isr_queue_send(queue, item)) return QUEUE_SUCCESS;
+#endif
+
   uint32_t start = tick_now;
   uint32_t deadline = start + timeout;
 
@@ -101,6 +108,8 @@ queue_result_t queue_send(queue_handle_t queue, const void *item,
         return QUEUE_ERROR_FULL;
       }
 
+      TRACE(TRACE_EVENT_QUEUE_SEND, queue, cb_size(&queue->buffer));
+
       if (!list_is_empty(&queue->waiting_receivers)) {
         wake_one(&queue->waiting_receivers);
       }
@@ -121,11 +130,12 @@ queue_result_t queue_send(queue_handle_t queue, const void *item,
     }
 
     // Block current task as a SENDER with timeout
+    TRACE(TRACE_EVENT_QUEUE_SEND_BLOCK, queue, cb_size(&queue->buffer));
     current_task->waiting_on = queue;
     waitlist_push_tail(&queue->waiting_senders, current_task);
+    task_set_state(current_task, TASK_BLOCKED);
     uint32_t wake = now + remain;
     scheduler_set_timeout(current_task, wake);
-    task_set_state(current_task, TASK_BLOCKED);
     KERNEL_CRITICAL_END();
     scheduler_yield(); // switch out
 
@@ -133,6 +143,8 @@ queue_result_t queue_send(queue_handle_t queue, const void *item,
       return QUEUE_ERROR_TIMEOUT;
     }
 
+    // The armed wake tick, converted if the tick rate changed meanwhile
+    deadline = current_task->wake_tick;
     timeout = ticks_until(deadline, tick_now);
     if (timeout == 0) {
       return QUEUE_ERROR_TIMEOUT;
@@ -157,6 +169,8 @@ queue_result_t queue_receive(queue_handle_t queue, void *item,
         return QUEUE_ERROR_EMPTY;
       }
 
+      TRACE(TRACE_EVENT_QUEUE_RECEIVE, queue, cb_size(&queue->buffer));
+
       // Sender might be waiting; wake one
       if (!list_is_empty(&queue->waiting_senders)) {
         wake_one(&queue->waiting_senders);
@@ -178,11 +192,12 @@ queue_result_t queue_receive(queue_handle_t queue, void *item,
     }
 
     // Block current task as a RECEIVER with timeout
+    TRACE(TRACE_EVENT_QUEUE_RECEIVE_BLOCK, queue, 0);
     current_task->waiting_on = queue;
     waitlist_push_tail(&queue->waiting_receivers, current_task);
+    task_set_state(current_task, TASK_BLOCKED);
     uint32_t wake = now + remain;
     scheduler_set_timeout(current_task, wake);
-    task_set_state(current_task, TASK_BLOCKED);
     KERNEL_CRITICAL_END();
 
     scheduler_yield(); // switch out
@@ -191,6 +206,8 @@ queue_result_t queue_receive(queue_handle_t queue, void *item,
       return QUEUE_ERROR_TIMEOUT;
     }
 
+    // The armed wake tick, converted if the tick rate changed meanwhile
+    deadline = current_task->wake_tick;
     timeout = ticks_until(deadline, tick_now);
     if (timeout == 0) {
       return QUEUE_ERROR_TIMEOUT;
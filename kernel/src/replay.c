@@ -0,0 +1,472 @@
+#include "replay.h"
+
+#if REPLAY_ENABLED
+
+#include "critical.h"
+#include "kernel.h"
+#include "memory.h"
+#include "port.h"
+#include "scheduler.h"
+
+#include <string.h>
+
+// Worst-case record: type, two 5-byte varints, digest, slot, size, item
+#define REPLAY_RECORD_OVERHEAD 15
+
+// Live ticks the idle task may spend with the next record still waiting
+// for sections or a switch before replay calls the run diverged. One is
+// not enough: on target SysTick can come in while a PendSV is pending.
+#define REPLAY_STALL_TICKS 2
+
+typedef struct replay_event {
+  uint8_t type;
+  uint32_t section; // Kernel sections completed before it
+  uint32_t offset;  // Cycles after the last of them
+  uint16_t digest;
+  uint8_t slot;
+  uint8_t size;
+  const uint8_t *item;
+  uint32_t end; // Offset of the following record
+} replay_event_t;
+
+replay_buffer_t replay_ram;
+
+static replay_state_t replay_state;
+static uint32_t replay_sections;       // Outermost task kernel sections
+static uint32_t replay_section_cycles; // Cycle count at the end of the last
+static uint32_t replay_digest;      // FNV-1a over the TCB slots switched to
+static bool replay_injecting;       // A replayed stimulus is being applied
+
+// Recording
+static uint32_t record_last_section;
+
+// Playing
+static const uint8_t *play_data;
+static uint32_t play_size;
+static uint32_t play_records;
+static uint32_t play_delivered;
+static uint32_t play_diverged_at;
+static bool play_active;
+static uint32_t play_stalled_ticks;
+static replay_event_t play_next;
+
+// ============================== HELPER FUNCTIONS =============================
+
+static size_t put_varint(uint8_t *out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static bool get_varint(const uint8_t *data, uint32_t size, uint32_t *pos,
+                       uint32_t *value) {
+  uint32_t result = 0;
+  for (uint32_t shift = 0; shift < 35; shift += 7) {
+    if (*pos >= size) {
+      return false;
+    }
+    uint8_t byte = data[(*pos)++];
+    result |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decodes the record at pos. prev_section is that of the record before.
+static bool decode_event(const uint8_t *data, uint32_t size, uint32_t pos,
+                         uint32_t prev_section, replay_event_t *event) {
+  uint32_t delta;
+
+  if (pos >= size) {
+    return false;
+  }
+  event->type = data[pos++];
+  if (!get_varint(data, size, &pos, &delta) ||
+      !get_varint(data, size, &pos, &event->offset) || pos + 2 > size) {
+    return false;
+  }
+  event->section = prev_section + delta;
+  event->digest = (uint16_t)(data[pos] | (data[pos + 1] << 8));
+  pos += 2;
+  event->slot = 0;
+  event->size = 0;
+  event->item = NULL;
+
+  switch (event->type) {
+  case REPLAY_RECORD_TICK:
+  case REPLAY_RECORD_STOP:
+    break;
+  case REPLAY_RECORD_SEM_POST:
+    if (pos + 1 > size) return false;
+    event->slot = data[pos++];
+    break;
+  case REPLAY_RECORD_QUEUE_SEND:
+    if (pos + 2 > size) return false;
+    event->slot = data[pos++];
+    event->size = data[pos++];
+    if (pos + event->size > size) return false;
+    event->item = &data[pos];
+    pos += event->size;
+    break;
+  default:
+    return false;
+  }
+
+  event->end = pos;
+  return true;
+}
+
+// Objects must exist, with the recorded item size, before replay starts
+static bool event_target_valid(const replay_event_t *event) {
+  if (event->type == REPLAY_RECORD_SEM_POST) {
+    return pool_object_at(POOL_SCB, event->slot) != NULL;
+  }
+  if (event->type == REPLAY_RECORD_QUEUE_SEND) {
+    queue_handle_t queue = pool_object_at(POOL_QCB, event->slot);
+    return queue && queue->buffer.element_size == event->size;
+  }
+  return true;
+}
+
+// Appends a record; the caller has checked that it fits
+static void record_put(uint8_t type, const void *object, pool_type_t pool,
+                       const void *item, size_t size) {
+  replay_header_t *header = &replay_ram.header;
+  uint8_t *out = &replay_ram.data[header->bytes];
+  size_t n = 0;
+
+  out[n++] = type;
+  n += put_varint(&out[n], replay_sections - record_last_section);
+  n += put_varint(&out[n], port_cycle_count() - replay_section_cycles);
+  out[n++] = (uint8_t)replay_digest;
+  out[n++] = (uint8_t)(replay_digest >> 8);
+  if (object) {
+    out[n++] = (uint8_t)pool_index_of(pool, object);
+  }
+  if (item) {
+    out[n++] = (uint8_t)size;
+    memcpy(&out[n], item, size);
+    n += size;
+  }
+
+  header->bytes += n;
+  header->records++;
+  record_last_section = replay_sections;
+}
+
+// Ends the trace with a stop record. Replay delivers it where recording
+// stopped and keeps the live ticks out until then.
+static void record_finish(void) {
+  record_put(REPLAY_RECORD_STOP, NULL, POOL_COUNT, NULL, 0);
+  replay_ram.header.digest = replay_digest;
+  replay_state = REPLAY_OFF;
+}
+
+static void record_event(uint8_t type, const void *object, pool_type_t pool,
+                         const void *item, size_t size) {
+  uint32_t state = kernel_critical_enter();
+
+  if (replay_state == REPLAY_RECORDING) {
+    // Full, or an item too big for the size byte: the trace ends here.
+    // There is always room left for the stop record.
+    uint32_t room = REPLAY_BUFFER_BYTES - replay_ram.header.bytes;
+    if (size > UINT8_MAX || 2 * REPLAY_RECORD_OVERHEAD + size > room) {
+      replay_ram.header.truncated = 1;
+      record_finish();
+    } else {
+      record_put(type, object, pool, item, size);
+    }
+  }
+
+  kernel_critical_exit(state);
+}
+
+// The record belongs here: stamped with this section count and made after
+// the same switches. One stamped earlier can only mean the run diverged;
+// it goes in at once rather than hold up the rest of the trace.
+static bool play_in_order(void) {
+  return play_next.section < replay_sections ||
+         (play_next.section == replay_sections &&
+          play_next.digest == (uint16_t)replay_digest);
+}
+
+static bool play_due(const replay_event_t *event) {
+  return event->section == replay_sections &&
+         port_cycle_count() - replay_section_cycles >= event->offset;
+}
+
+// A recorded tick that is already due, at or after the next record. Posts
+// are held back until one is: the live tick handler picks a task on
+// return, and in the recording the post alone did not make it switch.
+static bool play_tick_due(void) {
+  replay_event_t event = play_next;
+
+  while (play_due(&event)) {
+    if (event.type == REPLAY_RECORD_TICK) {
+      return true;
+    }
+    if (!decode_event(play_data, play_size, event.end, event.section, &event)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Applies play_next and moves on. Returns true for a tick.
+static bool play_deliver(void) {
+  replay_event_t event = play_next;
+
+  if ((event.section != replay_sections ||
+       event.digest != (uint16_t)replay_digest) &&
+      replay_state != REPLAY_DIVERGED) {
+    replay_state = REPLAY_DIVERGED;
+    play_diverged_at = play_delivered;
+  }
+
+  replay_injecting = true;
+  switch (event.type) {
+  case REPLAY_RECORD_TICK:
+    scheduler_tick();
+    break;
+  case REPLAY_RECORD_SEM_POST:
+    sem_post(pool_object_at(POOL_SCB, event.slot));
+    break;
+  case REPLAY_RECORD_QUEUE_SEND:
+    queue_send(pool_object_at(POOL_QCB, event.slot), event.item, 0);
+    break;
+  default: // REPLAY_RECORD_STOP
+    break;
+  }
+  replay_injecting = false;
+
+  play_delivered++;
+  if (!decode_event(play_data, play_size, event.end, event.section,
+                    &play_next)) {
+    play_active = false;
+    if (replay_state == REPLAY_PLAYING) {
+      replay_state = REPLAY_DONE;
+    }
+  }
+  return event.type == REPLAY_RECORD_TICK;
+}
+
+// What the SysTick handler does after scheduler_tick()
+static bool play_preempt(void) {
+  task_handle_t next = scheduler_get_next_task();
+  if (next == current_task) {
+    return false;
+  }
+  next_task = next;
+  trigger_context_switch();
+  return true;
+}
+
+// Delivers what came before the caller's next step. Returns true if a
+// replayed tick left a switch pending.
+static bool play_deliver_in_order(void) {
+  bool switching = false;
+  while (play_active && play_in_order()) {
+    if (play_deliver()) {
+      switching |= play_preempt();
+    }
+  }
+  return switching;
+}
+
+static bool in_thread_code(void) {
+  return !replay_injecting && port_current_exception() == 0 && current_task;
+}
+
+// ============================== PUBLIC API ===================================
+
+void replay_record_start(void) {
+  uint32_t state = kernel_critical_enter();
+  memset(&replay_ram.header, 0, sizeof(replay_ram.header));
+  replay_ram.header.magic = REPLAY_MAGIC;
+  replay_ram.header.version = REPLAY_VERSION;
+  replay_ram.header.header_size = sizeof(replay_header_t);
+  replay_ram.header.timestamp_hz = port_cycle_counter_hz();
+
+  replay_sections = 0;
+  replay_section_cycles = port_cycle_count();
+  replay_digest = 2166136261u;
+  record_last_section = 0;
+  play_active = false;
+  replay_state = REPLAY_RECORDING;
+  kernel_critical_exit(state);
+}
+
+void replay_record_stop(void) {
+  uint32_t state = kernel_critical_enter();
+  if (replay_state == REPLAY_RECORDING) {
+    record_finish();
+  }
+  kernel_critical_exit(state);
+}
+
+bool replay_play(const void *trace, size_t size) {
+  const replay_header_t *header = trace;
+  replay_event_t event;
+
+  if (!trace || size < sizeof(*header) || header->magic != REPLAY_MAGIC ||
+      header->version != REPLAY_VERSION ||
+      header->header_size != sizeof(*header) ||
+      size - sizeof(*header) < header->bytes) {
+    return false;
+  }
+
+  // Check every record up front rather than stopping halfway
+  const uint8_t *data = (const uint8_t *)trace + sizeof(*header);
+  uint32_t pos = 0;
+  uint32_t section = 0;
+  for (uint32_t i = 0; i < header->records; i++) {
+    if (!decode_event(data, header->bytes, pos, section, &event) ||
+        !event_target_valid(&event)) {
+      return false;
+    }
+    pos = event.end;
+    section = event.section;
+  }
+
+  uint32_t state = kernel_critical_enter();
+  play_data = data;
+  play_size = pos;
+  play_records = header->records;
+  play_delivered = 0;
+  play_diverged_at = 0;
+  play_stalled_ticks = 0;
+  play_active = decode_event(play_data, play_size, 0, 0, &play_next);
+
+  replay_sections = 0;
+  replay_section_cycles = port_cycle_count();
+  replay_digest = 2166136261u;
+  replay_state = play_active ? REPLAY_PLAYING : REPLAY_DONE;
+  kernel_critical_exit(state);
+  return true;
+}
+
+void replay_get_status(replay_status_t *status) {
+  if (!status) return;
+
+  uint32_t state = kernel_critical_enter();
+  status->state = replay_state;
+  status->records = replay_state == REPLAY_RECORDING || !play_data
+                        ? replay_ram.header.records
+                        : play_records;
+  status->delivered = play_delivered;
+  status->diverged_at = play_diverged_at;
+  status->digest = replay_digest;
+  kernel_critical_exit(state);
+}
+
+// ============================== KERNEL HOOKS =================================
+
+// Outermost section entry from a task. Stimuli only arrive between
+// sections, so whatever came before this one in the recording goes in
+// first; if a tick among it preempts the caller, the switch happens
+// before the section starts and the check repeats once the caller is back.
+// The idle task delivers here too, without waiting out the recorded
+// offsets, so idle time is skipped.
+uint32_t replay_critical_enter(void) {
+  uint32_t state = kernel_critical_enter();
+
+  while (state == 0 && play_active && in_thread_code() &&
+         play_deliver_in_order()) {
+    kernel_critical_exit(state); // Switched out here
+    state = kernel_critical_enter();
+  }
+  return state;
+}
+
+// Outermost section exit from a task other than idle: one logical clock
+// step. Stimuli stamped with the new count and the current digest arrived
+// before any switch this section left pending, so they go in before it.
+void replay_critical_exit(uint32_t state) {
+  if (state == 0 && in_thread_code() &&
+      current_task != kernel_get_idle_task() &&
+      (replay_state == REPLAY_RECORDING || play_active)) {
+    replay_sections++;
+    replay_section_cycles = port_cycle_count();
+    play_deliver_in_order();
+  }
+  kernel_critical_exit(state);
+}
+
+bool replay_tick(void) {
+  if (replay_injecting) return false;
+
+  if (replay_state == REPLAY_RECORDING) {
+    record_event(REPLAY_RECORD_TICK, NULL, POOL_COUNT, NULL, 0);
+    return false;
+  }
+
+  if (!play_active) return false;
+
+  uint32_t state = kernel_critical_enter();
+  bool idle = current_task == kernel_get_idle_task();
+  // Only the idle task is left, and what it waits for is made by tasks:
+  // the run has diverged. Go on at one recorded tick per live tick.
+  if (idle && play_active && !play_in_order()) {
+    if (++play_stalled_ticks >= REPLAY_STALL_TICKS) {
+      while (play_active && !play_deliver()) {
+      }
+      play_preempt();
+    }
+  } else {
+    play_stalled_ticks = 0;
+  }
+
+  while (play_active && play_in_order()) {
+    if (!play_due(&play_next)) break;
+    if (!idle && play_next.type != REPLAY_RECORD_TICK && !play_tick_due()) {
+      break;
+    }
+    if (play_deliver()) {
+      play_preempt(); // The handler itself skips this for live ticks
+    }
+  }
+  kernel_critical_exit(state);
+  return true;
+}
+
+bool replay_isr_sem_post(semaphore_handle_t sem) {
+  if (replay_injecting || port_current_exception() == 0) return false;
+
+  if (replay_state == REPLAY_RECORDING) {
+    record_event(REPLAY_RECORD_SEM_POST, sem, POOL_SCB, NULL, 0);
+    return false;
+  }
+  return play_active; // The trace has this post already
+}
+
+bool replay_isr_queue_send(queue_handle_t queue, const void *item) {
+  if (replay_injecting || port_current_exception() == 0) return false;
+
+  if (replay_state == REPLAY_RECORDING) {
+    record_event(REPLAY_RECORD_QUEUE_SEND, queue, POOL_QCB, item,
+                 queue->buffer.element_size);
+    return false;
+  }
+  return play_active;
+}
+
+void replay_switch(task_handle_t from, task_handle_t to) {
+  if (!from) {
+    // First task: offsets count from here, not from replay_*_start()
+    replay_section_cycles = port_cycle_count();
+  }
+  // Only switches inside the traced span, so both runs end on the same
+  if (to && (replay_state == REPLAY_RECORDING || play_active)) {
+    replay_digest =
+        (replay_digest ^ (uint32_t)pool_index_of(POOL_TCB, to)) * 16777619u;
+  }
+}
+
+#endif // REPLAY_ENABLED
@@ -0,0 +1,162 @@
+#include "critical.h"
+#include "kernel.h"
+#include "port.h"
+#include "runtime_stats.h"
+#include "scheduler.h"
+
+#include <string.h>
+
+// Cycles are read as 32 bits and accumulated as 64, so only the time between
+// two charges (at most one tick) has to fit in the counter.
+
+typedef struct load_slot {
+  uint64_t total_cycles;
+  uint64_t idle_cycles;
+} load_slot_t;
+
+static uint32_t start_cycles;     // When accounting started
+static uint64_t elapsed_cycles;   // Everything charged so far
+static uint32_t slice_start;      // Last time the running task was charged
+static uint32_t slice_isr_cycles; // Interrupt time inside the current slice
+
+static uint32_t isr_nesting;
+static uint32_t isr_start;
+static uint64_t isr_total_cycles;
+
+static load_slot_t load_slots[RUNTIME_LOAD_SLOTS];
+static uint32_t load_slot_index;
+static uint32_t load_slot_ticks;
+
+// ============================== HELPER FUNCTIONS =============================
+
+// Charges the slice since the last charge to task. Must be called with
+// interrupts masked.
+static void charge(task_handle_t task, uint32_t now) {
+  uint32_t elapsed = now - slice_start;
+
+  // An interrupt in progress owns the time since it started
+  if (isr_nesting > 0) {
+    slice_isr_cycles += now - isr_start;
+    isr_total_cycles += now - isr_start;
+    isr_start = now;
+  }
+
+  uint32_t isr = slice_isr_cycles < elapsed ? slice_isr_cycles : elapsed;
+  uint32_t used = elapsed - isr;
+
+  if (task) {
+    task->total_runtime += used;
+  }
+
+  load_slot_t *slot = &load_slots[load_slot_index];
+  slot->total_cycles += elapsed;
+  if (task && task == kernel_get_idle_task()) {
+    slot->idle_cycles += used;
+  }
+
+  elapsed_cycles += elapsed;
+  slice_start = now;
+  slice_isr_cycles = 0;
+}
+
+// =============================================================================
+
+void runtime_stats_init(void) {
+  port_cycle_counter_init();
+
+  start_cycles = port_cycle_count();
+  elapsed_cycles = 0;
+  slice_start = start_cycles;
+  slice_isr_cycles = 0;
+
+  isr_nesting = 0;
+  isr_total_cycles = 0;
+
+  memset(load_slots, 0, sizeof(load_slots));
+  load_slot_index = 0;
+  load_slot_ticks = 0;
+}
+
+// Called from PendSV with the outgoing context saved
+void runtime_stats_switch(task_handle_t from, task_handle_t to) {
+  charge(from, port_cycle_count());
+
+  if (to) {
+    to->run_count++;
+  }
+}
+
+void runtime_stats_tick(void) {
+  KERNEL_CRITICAL_BEGIN();
+  charge(current_task, port_cycle_count());
+
+  if (++load_slot_ticks >= RUNTIME_LOAD_SLOT_TICKS) {
+    load_slot_ticks = 0;
+    load_slot_index = (load_slot_index + 1) % RUNTIME_LOAD_SLOTS;
+    load_slots[load_slot_index].total_cycles = 0;
+    load_slots[load_slot_index].idle_cycles = 0;
+  }
+  KERNEL_CRITICAL_END();
+}
+
+void runtime_stats_isr_enter(void) {
+  KERNEL_CRITICAL_BEGIN();
+  if (isr_nesting++ == 0) {
+    isr_start = port_cycle_count();
+  }
+  KERNEL_CRITICAL_END();
+}
+
+void runtime_stats_isr_exit(void) {
+  KERNEL_CRITICAL_BEGIN();
+  if (isr_nesting > 0 && --isr_nesting == 0) {
+    uint32_t spent = port_cycle_count() - isr_start;
+    slice_isr_cycles += spent;
+    isr_total_cycles += spent;
+  }
+  KERNEL_CRITICAL_END();
+}
+
+// ============================== PUBLIC API ===================================
+
+bool task_get_runtime_stats(task_handle_t task, task_runtime_stats_t *stats) {
+  if (!task || !stats) return false;
+
+  KERNEL_CRITICAL_BEGIN();
+  // Bring the running task up to date first
+  charge(current_task, port_cycle_count());
+
+  stats->run_count = task->run_count;
+  stats->runtime_cycles = task->total_runtime;
+  uint64_t total = elapsed_cycles;
+  KERNEL_CRITICAL_END();
+
+  stats->share_permille =
+      total ? (uint32_t)((stats->runtime_cycles * 1000) / total) : 0;
+
+  return true;
+}
+
+uint32_t kernel_get_cpu_load(void) {
+  uint64_t total = 0;
+  uint64_t idle = 0;
+
+  KERNEL_CRITICAL_BEGIN();
+  for (int i = 0; i < RUNTIME_LOAD_SLOTS; i++) {
+    total += load_slots[i].total_cycles;
+    idle += load_slots[i].idle_cycles;
+  }
+  KERNEL_CRITICAL_END();
+
+  if (total == 0) return 0;
+
+  return (uint32_t)(((total - idle) * 1000) / total);
+}
+
+uint64_t kernel_get_isr_cycles(void) {
+  KERNEL_CRITICAL_BEGIN();
+  uint64_t cycles = isr_total_cycles;
+  KERNEL_CRITICAL_END();
+
+  return cycles;
+}
@@ -1,5 +1,10 @@
+#include "latency_stats.h"
 #include "port.h"
+#include "replay.h"
+#include "runtime_stats.h"
 #include "scheduler.h"
+#include "swtimer.h"
+#include "trace.h"
 #include <stddef.h>
 #include "critical.h"
 
@@ -8,6 +13,13 @@ list_head_t ready_queues[MAX_PRIORITY + 1];
 task_handle_t current_task = NULL;
 task_handle_t next_task = NULL;
 
+// Delayed task lists and the tick counter
+list_head_t delayed_cur;
+list_head_t delayed_ovf;
+volatile uint32_t tick_now = 0;
+volatile uint32_t tick_hz = KERNEL_TICK_HZ;
+static uint32_t tick_epoch; // tick_now wraps, the high word of the 64-bit count
+
 
 static void delayed_insert_sorted(list_head_t *list, task_handle_t t) {
   list_head_t *pos;
@@ -30,6 +42,7 @@ void scheduler_init(void) {
   list_init(&delayed_cur);
   list_init(&delayed_ovf);
   tick_now = 0;
+  tick_epoch = 0;
 
   current_task = NULL;
   next_task = NULL;
@@ -39,8 +52,7 @@ void scheduler_start(void) {
   // Set PendSV to lowest priority
   set_pendsv_priority();
 
-  // Initialize SysTick 1ms (1000Hz)
-  systick_init(1000);
+  systick_init(tick_hz);
 
   current_task = scheduler_get_next_task();
 
@@ -53,6 +65,19 @@ void scheduler_start(void) {
 
   current_task->state = TASK_RUNNING;
 
+#if MPU_STACK_GUARD_ENABLED
+  port_stack_guard_init(current_task->stack_base);
+#endif
+
+#if RUNTIME_STATS_ENABLED
+  runtime_stats_init();
+#endif
+
+#if KERNEL_SWITCH_HOOK_ENABLED
+  // The first task is entered through SVC, not PendSV
+  scheduler_switch_hook(NULL, current_task);
+#endif
+
   start_first_task(current_task->stack_pointer);
 
   // This function should never return
@@ -64,14 +89,10 @@ task_handle_t scheduler_get_next_task(void) {
   // Find highest priority (lowest number) that has tasks
   for (task_priority_t priority = 0; priority <= MAX_PRIORITY; priority++) {
     if (!list_is_empty(&ready_queues[priority])) {
-      // Get first task from this priority
-      list_head_t *first = ready_queues[priority].next;
-      task_handle_t task = tcb_from_ready_link(first);
-
-      // Remove from head and add to tail (round-robin)
-      list_move_to_tail(&ready_queues[priority], first);
-
-      return task;
+      // The head runs. Round-robin moves it to the tail on a yield or at the
+      // end of its time slice, not here: a task preempted by a more urgent
+      // one must get the CPU back first when that one blocks.
+      return tcb_from_ready_link(ready_queues[priority].next);
     }
   }
   // No ready tasks found
@@ -80,8 +101,16 @@ task_handle_t scheduler_get_next_task(void) {
 void scheduler_add_task(task_handle_t task) {
   if (!task) return;
 
+#if LATENCY_STATS_ENABLED
+  latency_stats_ready(task);
+#endif
   task->state = TASK_READY;
+  TRACE(TRACE_EVENT_TASK_READY, task, task->effective_priority);
 
+  // The running task is still queued: re-adding it just moves it to the tail
+  if (!list_is_empty(&task->ready_link)) {
+    list_remove(&task->ready_link);
+  }
   list_insert_tail(&ready_queues[task->effective_priority], &task->ready_link);
 }
 
@@ -103,6 +132,9 @@ void scheduler_remove_task(task_handle_t task) {
 // Task state transitions
 void scheduler_block_current_task(void) {
   if (current_task) {
+#if LATENCY_STATS_ENABLED
+    latency_stats_blocked(current_task);
+#endif
     current_task->state = TASK_BLOCKED;
     scheduler_remove_task(current_task);
   }
@@ -115,26 +147,34 @@ void scheduler_unblock_task(task_handle_t task) {
 }
 
 void scheduler_yield(void) {
+  // The tick handler rotates the same ready queues
+  KERNEL_CRITICAL_BEGIN();
   next_task = scheduler_get_next_task();
 
   // Only switch if there is a different task to run
   if (next_task && next_task != current_task) {
     trigger_context_switch();
   }
+  KERNEL_CRITICAL_END();
 }
 
 // Helper function for task_delay() implementation
 void scheduler_delay_current_task(uint32_t ticks) {
   if (!current_task || ticks == 0) return;
 
+  KERNEL_CRITICAL_BEGIN();
+
   // Remove from ready queue
   if (!list_is_empty(&current_task->ready_link)) {
     list_remove(&current_task->ready_link);
   }
 
+#if LATENCY_STATS_ENABLED
+  latency_stats_blocked(current_task);
+#endif
   current_task->state = TASK_BLOCKED;
+  TRACE(TRACE_EVENT_TASK_BLOCK, current_task, 0);
 
-  KERNEL_CRITICAL_BEGIN();
   uint32_t now = tick_now;     // read once
   uint32_t wake = now + ticks; // automatically wraps
   current_task->wake_tick = wake;
@@ -147,10 +187,47 @@ void scheduler_delay_current_task(uint32_t ticks) {
   scheduler_yield();
 }
 
+void scheduler_switch_hook(task_handle_t from, task_handle_t to) {
+#if RUNTIME_STATS_ENABLED
+  runtime_stats_switch(from, to);
+#endif
+#if LATENCY_STATS_ENABLED
+  latency_stats_switch(to);
+#endif
+  TRACE(TRACE_EVENT_TASK_SWITCH, to, (uintptr_t)from);
+#if REPLAY_ENABLED
+  replay_switch(from, to);
+#endif
+  (void)from;
+  (void)to;
+}
+
 // Timer tick handler - processes delayed tasks
-void scheduler_tick(void) {
+bool scheduler_tick(void) {
+#if REPLAY_ENABLED
+  // While replaying, live ticks only pace delivery of the recorded ones
+  if (replay_tick()) return false;
+#endif
+
+#if RUNTIME_STATS_ENABLED
+  runtime_stats_tick();
+#endif
+
   KERNEL_CRITICAL_BEGIN();
-  uint32_t now = tick_now++;
+  // A delay of n ticks wakes on the n-th tick from now, not the one after
+  uint32_t now = ++tick_now;
+  if (now == 0) {
+    tick_epoch++;
+  }
+
+#if SCHEDULER_TIME_SLICING
+  // One-tick time slice: the running task goes behind its equal-priority
+  // peers. The caller picks the next task after this returns.
+  if (current_task && !list_is_empty(&current_task->ready_link)) {
+    list_move_to_tail(&ready_queues[current_task->effective_priority],
+                      &current_task->ready_link);
+  }
+#endif
   KERNEL_CRITICAL_END();
 
   // Release all tasks whose wake_tick <= now from current list
@@ -162,11 +239,12 @@ void scheduler_tick(void) {
     scheduler_expire_timeout(t);
   }
 
-  // On wrap to 0, swap lists so former overflow becomes current
+  // On wrap to 0, tasks parked for the next epoch become current. Splice
+  // them over rather than swapping the lists: the current list is only
+  // drained at this point after a real wrap. At boot it still holds every
+  // delay armed before the first tick.
   if (now == 0) {
-    list_head_t tmp = delayed_cur;
-    delayed_cur = delayed_ovf;
-    delayed_ovf = tmp;
+    list_splice_tail(&delayed_cur, &delayed_ovf);
 
     // drain again so tasks with wake_tick == 0 don't wait one extra tick
     while (!list_is_empty(&delayed_cur)) {
@@ -176,6 +254,46 @@ void scheduler_tick(void) {
       scheduler_expire_timeout(t);
     }
   }
+
+#if SWTIMER_ENABLED
+  swtimer_tick(now);
+#endif
+  return true;
+}
+
+uint64_t scheduler_get_ticks64(void) {
+  KERNEL_CRITICAL_BEGIN();
+  uint64_t ticks = (uint64_t)tick_epoch << 32 | tick_now;
+  KERNEL_CRITICAL_END();
+  return ticks;
+}
+
+// Armed timeouts are counted in ticks, so they are converted to the new
+// rate, rounding up so none expires early. The lists are rebuilt because a
+// converted wake tick can move across the wrap.
+void scheduler_set_tick_hz(uint32_t hz) {
+  list_head_t pending;
+  list_init(&pending);
+
+  KERNEL_CRITICAL_BEGIN();
+  uint32_t old_hz = tick_hz;
+  uint32_t now = tick_now;
+
+  list_splice_tail(&pending, &delayed_cur);
+  list_splice_tail(&pending, &delayed_ovf);
+  while (!list_is_empty(&pending)) {
+    task_handle_t t = tcb_from_delay_link(pending.next);
+    list_remove(&t->delay_link);
+
+    uint64_t left = (uint64_t)ticks_until(t->wake_tick, now) * hz;
+    uint64_t scaled = (left + old_hz - 1) / old_hz;
+    t->wake_tick = now + (uint32_t)(scaled > INT32_MAX ? INT32_MAX : scaled);
+
+    list_head_t *L = time_lt(t->wake_tick, now) ? &delayed_ovf : &delayed_cur;
+    delayed_insert_sorted(L, t);
+  }
+  tick_hz = hz;
+  KERNEL_CRITICAL_END();
 }
 
 void scheduler_set_timeout(task_handle_t t, uint32_t wake_tick) {
@@ -192,9 +310,10 @@ void scheduler_expire_timeout(task_handle_t t) {
     if (t->wait_link.next != &t->wait_link) {
       list_remove(&t->wait_link);
     }
-    t->wake_reason = WAKE_REASON_TIMEOUT;
     t->waiting_on = NULL;
   }
+  // Also for plain delays, so wake_reason never carries a stale value
+  t->wake_reason = WAKE_REASON_TIMEOUT;
   scheduler_add_task(t);
 }
 
@@ -232,14 +351,15 @@ void scheduler_boost_priority(task_handle_t task, task_priority_t new_priority)
 
   KERNEL_CRITICAL_BEGIN();
 
-  // Remove from current priority queue
-  if (task->state == TASK_READY && !list_is_empty(&task->ready_link)) {
+  // Move it between ready queues if it is queued (ready or running)
+  bool queued = !list_is_empty(&task->ready_link);
+  if (queued) {
     list_remove(&task->ready_link);
   }
 
   task->effective_priority = new_priority;
 
-  if (task->state == TASK_READY) {
+  if (queued) {
     list_insert_tail(&ready_queues[new_priority], &task->ready_link);
   }
 
@@ -250,13 +370,14 @@ void scheduler_restore_priority(task_handle_t task) {
   if (!task || task->effective_priority == task->base_priority) return;
 
   KERNEL_CRITICAL_BEGIN();
-  if (task->state == TASK_READY && !list_is_empty(&task->ready_link)) {
+  bool queued = !list_is_empty(&task->ready_link);
+  if (queued) {
     list_remove(&task->ready_link);
   }
 
   task->effective_priority = task->base_priority;
 
-  if (task->state == TASK_READY) {
+  if (queued) {
     list_insert_tail(&ready_queues[task->base_priority], &task->ready_link);
   }
 
@@ -1,9 +1,11 @@
 #include "critical.h"
 #include "memory.h"
+#include "replay.h"
 #include "scheduler.h"
 #include "semaphore.h"
 #include "task.h"
 #include "time_utils.h"
+#include "trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -99,6 +101,7 @@ sem_result_t sem_wait(semaphore_handle_t sem, uint32_t timeout) {
 
     if (sem->count > 0) {
       sem->count--;
+      TRACE(TRACE_EVENT_SEM_TAKE, sem, sem->count);
       KERNEL_CRITICAL_END();
       return SEM_OK;
     }
@@ -108,17 +111,19 @@ sem_result_t sem_wait(semaphore_handle_t sem, uint32_t timeout) {
       return SEM_ERROR_TIMEOUT;
     }
 
-    // Check if timeout has expired
+    // Check if timeout has expired (the forever deadline is start - 1)
     uint32_t now = tick_now;
     uint32_t remaining = ticks_until(deadline, now);
-    if (remaining == 0) {
+    if (timeout != SEM_WAIT_FOREVER && remaining == 0) {
       KERNEL_CRITICAL_END();
       return SEM_ERROR_TIMEOUT;
     }
 
     // Block current task
+    TRACE(TRACE_EVENT_SEM_BLOCK, sem, 0);
     current_task->waiting_on = sem;
     sem_waitlist_push(&sem->waiting_tasks, current_task);
+    task_set_state(current_task, TASK_BLOCKED);
 
     // Set timeout if not waiting forever
     if (timeout != SEM_WAIT_FOREVER) {
@@ -126,14 +131,17 @@ sem_result_t sem_wait(semaphore_handle_t sem, uint32_t timeout) {
       scheduler_set_timeout(current_task, wake_time);
     }
 
-    task_set_state(current_task, TASK_BLOCKED);
-
     KERNEL_CRITICAL_END();
 
     // Task will resume here when unblocked
     scheduler_yield();
 
-    // Check why we woke up
+    // Check why we woke up. sem_post() hands its unit straight to the
+    // waiter it wakes instead of incrementing count.
+    if (current_task->wake_reason == WAKE_REASON_DATA_AVAILABLE) {
+      return SEM_OK;
+    }
+
     if (current_task->wake_reason == WAKE_REASON_TIMEOUT) {
       return SEM_ERROR_TIMEOUT;
     }
@@ -143,8 +151,10 @@ sem_result_t sem_wait(semaphore_handle_t sem, uint32_t timeout) {
       return SEM_ERROR_NULL;
     }
 
-    // Update timeout for next iteration
+    // Update timeout for next iteration, from the armed wake tick, which
+    // kernel_set_clock() converts if the tick rate changed meanwhile
     if (timeout != SEM_WAIT_FOREVER) {
+      deadline = current_task->wake_tick;
       timeout = ticks_until(deadline, now);
       if (timeout == 0) {
         return SEM_ERROR_TIMEOUT;
@@ -156,9 +166,15 @@ sem_result_t sem_wait(semaphore_handle_t sem, uint32_t timeout) {
 sem_result_t sem_post(semaphore_handle_t sem) {
   if (!sem) return SEM_ERROR_NULL;
 
+#if REPLAY_ENABLED
+  // Replay brings the recorded interrupt posts instead of the live ones
+  if (replay_isr_sem_post(sem)) return SEM_OK;
+#endif
+
   KERNEL_CRITICAL_BEGIN();
 
   if (!list_is_empty(&sem->waiting_tasks)) {
+    TRACE(TRACE_EVENT_SEM_POST, sem, 0);
     sem_wait_one_waiter(sem);
     KERNEL_CRITICAL_END();
     return SEM_OK;
@@ -166,6 +182,7 @@ sem_result_t sem_post(semaphore_handle_t sem) {
 
   if (sem->count < sem->max_count) {
     sem->count++;
+    TRACE(TRACE_EVENT_SEM_POST, sem, sem->count);
     KERNEL_CRITICAL_END();
     return SEM_OK;
   }
@@ -0,0 +1,315 @@
+#include "swtimer.h"
+
+#if SWTIMER_ENABLED
+
+#include "critical.h"
+#include "memory.h"
+#include "queue.h"
+#include "scheduler.h"
+#include "task.h"
+#include "time_utils.h"
+
+#include <string.h>
+
+#define SWTIMER_TASK_WAIT 0x7FFFFFFFu // queue_receive() has no "forever"
+
+// Internal flag: deleted while commands for it were still queued. The timer
+// task drops those commands and frees the control block after the last one.
+#define SWTIMER_DELETED 0x80
+
+typedef enum {
+  SWTIMER_COMMAND_RUN, // Expired timers are waiting on the fired list
+  SWTIMER_COMMAND_START,
+  SWTIMER_COMMAND_STOP,
+  SWTIMER_COMMAND_RESET,
+} swtimer_command_op_t;
+
+typedef struct swtimer_command {
+  swtimer_handle_t timer;
+  uint32_t tick; // tick_now when posted
+  uint8_t op;
+} swtimer_command_t;
+
+static list_head_t wheel[SWTIMER_WHEEL_SLOTS];
+static list_head_t fired; // For the timer task, in expiry order
+static bool run_posted;   // A RUN command is in the queue
+
+static queue_handle_t swtimer_commands;
+static task_handle_t swtimer_task_handle;
+
+// ============================== HELPER FUNCTIONS =============================
+
+// Called with kernel interrupts masked. A timer armed late, such as from a
+// command the timer task took a while to get to, expires on the next tick.
+static void swtimer_arm(swtimer_handle_t timer, uint32_t from) {
+  uint32_t expiry = from + timer->period;
+  if (time_lte(expiry, tick_now)) {
+    expiry = tick_now + 1;
+  }
+  timer->expiry = expiry;
+  list_remove(&timer->wheel_link);
+  list_insert_tail(&wheel[expiry & (SWTIMER_WHEEL_SLOTS - 1)],
+                   &timer->wheel_link);
+}
+
+static void swtimer_disarm(swtimer_handle_t timer) {
+  list_remove(&timer->wheel_link);
+  list_remove(&timer->fire_link);
+}
+
+static void swtimer_apply(swtimer_handle_t timer, uint8_t op, uint32_t from) {
+  switch (op) {
+  case SWTIMER_COMMAND_START:
+    if (list_is_empty(&timer->wheel_link)) {
+      swtimer_arm(timer, from);
+    }
+    break;
+  case SWTIMER_COMMAND_RESET:
+    swtimer_arm(timer, from);
+    break;
+  case SWTIMER_COMMAND_STOP:
+    swtimer_disarm(timer);
+    break;
+  default:
+    break;
+  }
+}
+
+static swtimer_result_t swtimer_command(swtimer_handle_t timer, uint8_t op) {
+  if (!timer) return SWTIMER_ERROR_NULL;
+
+  KERNEL_CRITICAL_BEGIN();
+  swtimer_apply(timer, op, tick_now);
+  KERNEL_CRITICAL_END();
+  return SWTIMER_OK;
+}
+
+static swtimer_result_t swtimer_post(swtimer_handle_t timer, uint8_t op) {
+  if (!timer) return SWTIMER_ERROR_NULL;
+
+  // Counted before it is sent, so a delete in between cannot free the
+  // timer under a command the timer task is about to read
+  KERNEL_CRITICAL_BEGIN();
+  timer->queued++;
+  KERNEL_CRITICAL_END();
+
+  swtimer_command_t command = {timer, tick_now, op};
+  if (queue_send_immediate(swtimer_commands, &command) != QUEUE_SUCCESS) {
+    KERNEL_CRITICAL_BEGIN();
+    timer->queued--;
+    KERNEL_CRITICAL_END();
+    return SWTIMER_ERROR_QUEUE_FULL;
+  }
+  return SWTIMER_OK;
+}
+
+// Takes the first timer off an expired list, with what its callback needs,
+// so the callback itself runs unmasked
+static swtimer_handle_t swtimer_pop(list_head_t *list,
+                                    swtimer_callback_t *callback, void **arg) {
+  swtimer_handle_t timer = NULL;
+
+  KERNEL_CRITICAL_BEGIN();
+  if (!list_is_empty(list)) {
+    timer = swtimer_from_fire_link(list->next);
+    list_remove(&timer->fire_link);
+    *callback = timer->callback;
+    *arg = timer->arg;
+  }
+  KERNEL_CRITICAL_END();
+  return timer;
+}
+
+static void swtimer_run_list(list_head_t *list) {
+  swtimer_callback_t callback;
+  void *arg;
+  swtimer_handle_t timer;
+
+  while ((timer = swtimer_pop(list, &callback, &arg))) {
+    callback(timer, arg);
+  }
+}
+
+static void swtimer_task_function(void *param) {
+  (void)param;
+
+  while (1) {
+    swtimer_command_t command;
+    if (queue_receive(swtimer_commands, &command, SWTIMER_TASK_WAIT) ==
+        QUEUE_SUCCESS) {
+      swtimer_handle_t release = NULL;
+
+      KERNEL_CRITICAL_BEGIN();
+      if (command.op == SWTIMER_COMMAND_RUN) {
+        run_posted = false;
+      } else {
+        swtimer_handle_t timer = command.timer;
+        timer->queued--;
+        if (!(timer->flags & SWTIMER_DELETED)) {
+          swtimer_apply(timer, command.op, command.tick);
+        } else if (timer->queued == 0) {
+          release = timer;
+        }
+      }
+      KERNEL_CRITICAL_END();
+
+      if (release) {
+        swtimer_pool_free_tmcb(release);
+      }
+    }
+
+    swtimer_run_list(&fired);
+  }
+}
+
+// ============================== PUBLIC API ===================================
+
+void swtimer_service_init(void) {
+  for (size_t i = 0; i < SWTIMER_WHEEL_SLOTS; i++) {
+    list_init(&wheel[i]);
+  }
+  list_init(&fired);
+  run_posted = false;
+
+  swtimer_commands =
+      queue_create(SWTIMER_COMMAND_QUEUE_LENGTH, sizeof(swtimer_command_t));
+  swtimer_task_handle = task_create_internal(swtimer_task_function, "TIMER",
+                                             SWTIMER_TASK_STACK_SIZE, NULL,
+                                             SWTIMER_TASK_PRIORITY);
+  if (!swtimer_commands || !swtimer_task_handle) {
+    // Critical failure
+    while (1) {
+    }
+  }
+
+  scheduler_add_task(swtimer_task_handle);
+}
+
+void swtimer_tick(uint32_t now) {
+  list_head_t in_tick;
+  list_head_t *slot = &wheel[now & (SWTIMER_WHEEL_SLOTS - 1)];
+  list_head_t *pos, *n;
+  bool post_run = false;
+
+  list_init(&in_tick);
+
+  KERNEL_CRITICAL_BEGIN();
+  list_iter_mut(pos, n, slot) {
+    swtimer_handle_t timer = swtimer_from_wheel_link(pos);
+    if (timer->expiry != now) continue; // Due on a later turn of the wheel
+
+    list_remove(&timer->wheel_link);
+    if (timer->flags & SWTIMER_PERIODIC) {
+      swtimer_arm(timer, timer->expiry);
+    }
+    // Still queued from its last expiry: that callback covers this one too
+    if (list_is_empty(&timer->fire_link)) {
+      list_insert_tail((timer->flags & SWTIMER_IN_TICK) ? &in_tick : &fired,
+                       &timer->fire_link);
+    }
+  }
+
+  if (!list_is_empty(&fired) && !run_posted) {
+    run_posted = true;
+    post_run = true;
+  }
+  KERNEL_CRITICAL_END();
+
+  swtimer_run_list(&in_tick);
+
+  if (post_run) {
+    swtimer_command_t command = {NULL, now, SWTIMER_COMMAND_RUN};
+    if (queue_send_immediate(swtimer_commands, &command) != QUEUE_SUCCESS) {
+      run_posted = false; // Queue full: the next tick tries again
+    }
+  }
+}
+
+swtimer_handle_t swtimer_create(const char *name, uint32_t period,
+                                uint8_t flags, swtimer_callback_t callback,
+                                void *arg) {
+  if (period == 0 || !callback) return NULL;
+
+  swtimer_control_block *timer = swtimer_pool_alloc_tmcb();
+  if (!timer) return NULL;
+
+  list_init(&timer->wheel_link);
+  list_init(&timer->fire_link);
+  timer->expiry = 0;
+  timer->period = period;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->flags = flags & ~SWTIMER_DELETED;
+  timer->queued = 0;
+
+  if (name) {
+    strncpy(timer->name, name, sizeof(timer->name) - 1);
+    timer->name[sizeof(timer->name) - 1] = '\0';
+  } else {
+    timer->name[0] = '\0';
+  }
+
+  return (swtimer_handle_t)timer;
+}
+
+void swtimer_delete(swtimer_handle_t timer) {
+  if (!timer) return;
+
+  KERNEL_CRITICAL_BEGIN();
+  swtimer_disarm(timer);
+  timer->flags |= SWTIMER_DELETED;
+  bool release = timer->queued == 0;
+  KERNEL_CRITICAL_END();
+
+  // Otherwise the timer task frees it once its commands are drained
+  if (release) {
+    swtimer_pool_free_tmcb(timer);
+  }
+}
+
+swtimer_result_t swtimer_start(swtimer_handle_t timer) {
+  return swtimer_command(timer, SWTIMER_COMMAND_START);
+}
+
+swtimer_result_t swtimer_stop(swtimer_handle_t timer) {
+  return swtimer_command(timer, SWTIMER_COMMAND_STOP);
+}
+
+swtimer_result_t swtimer_reset(swtimer_handle_t timer) {
+  return swtimer_command(timer, SWTIMER_COMMAND_RESET);
+}
+
+swtimer_result_t swtimer_set_period(swtimer_handle_t timer, uint32_t period) {
+  if (!timer) return SWTIMER_ERROR_NULL;
+  if (period == 0) return SWTIMER_ERROR_PERIOD;
+
+  KERNEL_CRITICAL_BEGIN();
+  timer->period = period;
+  KERNEL_CRITICAL_END();
+  return SWTIMER_OK;
+}
+
+bool swtimer_is_active(swtimer_handle_t timer) {
+  if (!timer) return false;
+
+  KERNEL_CRITICAL_BEGIN();
+  bool active = !list_is_empty(&timer->wheel_link);
+  KERNEL_CRITICAL_END();
+  return active;
+}
+
+swtimer_result_t swtimer_start_from_isr(swtimer_handle_t timer) {
+  return swtimer_post(timer, SWTIMER_COMMAND_START);
+}
+
+swtimer_result_t swtimer_stop_from_isr(swtimer_handle_t timer) {
+  return swtimer_post(timer, SWTIMER_COMMAND_STOP);
+}
+
+swtimer_result_t swtimer_reset_from_isr(swtimer_handle_t timer) {
+  return swtimer_post(timer, SWTIMER_COMMAND_RESET);
+}
+
+task_handle_t swtimer_get_task(void) { return swtimer_task_handle; }
+
+#endif // SWTIMER_ENABLED
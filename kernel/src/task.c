@@ -1,13 +1,34 @@
 #include "critical.h"
+#include "latency_stats.h"
 #include "memory.h"
+#include "port.h"
 #include "scheduler.h"
 #include "task.h"
+#include "trace.h"
 
 // Task Control Block
 
 #include <stdlib.h>
 #include <string.h>
 
+// Lowest word a task may use. With the MPU guard enabled, the bottom of the
+// stack up to the end of the (aligned) guard region is no-access.
+static uint32_t *stack_usable_base(task_handle_t task) {
+#if MPU_STACK_GUARD_ENABLED
+  uintptr_t guard = ((uintptr_t)task->stack_base + MPU_STACK_GUARD_SIZE - 1) &
+                    ~(uintptr_t)(MPU_STACK_GUARD_SIZE - 1);
+  return (uint32_t *)(guard + MPU_STACK_GUARD_SIZE);
+#else
+  return task->stack_base;
+#endif
+}
+
+static uint32_t stack_usable_bytes(task_handle_t task) {
+  uint32_t *stack_top =
+      task->stack_base + (task->stack_size / sizeof(uint32_t));
+  return (uint32_t)(stack_top - stack_usable_base(task)) * sizeof(uint32_t);
+}
+
 // Task management functions
 task_handle_t task_create_internal(task_function_t function, const char *name,
                                    uint16_t stack_size, void *param,
@@ -50,12 +71,23 @@ task_handle_t task_create_internal(task_function_t function, const char *name,
   tcb->waiting_on = NULL;
   tcb->run_count = 0;
   tcb->total_runtime = 0;
+#if LATENCY_STATS_ENABLED
+  tcb->wakeup_pending = false;
+  memset(&tcb->latency, 0, sizeof(tcb->latency));
+#endif
 
   list_init(&tcb->ready_link);
   list_init(&tcb->delay_link);
   list_init(&tcb->wait_link);
 
   task_init_stack(tcb, function, param);
+  tcb->stack_min_headroom =
+      stack_usable_bytes(tcb) - task_stack_high_water(tcb);
+
+  TRACE(TRACE_EVENT_TASK_CREATE, tcb, priority);
+#if TRACE_ENABLED
+  trace_task_name(tcb);
+#endif
 
   return (task_handle_t)tcb;
 }
@@ -65,11 +97,17 @@ void task_delete_internal(task_handle_t task) {
     return;
   }
 
+  TRACE(TRACE_EVENT_TASK_DELETE, task, 0);
+
   KERNEL_CRITICAL_BEGIN();
   task->state = TASK_DELETED;
   scheduler_remove_task(task);
   KERNEL_CRITICAL_END();
 
+#if PORT_HOST_CONTEXTS
+  port_task_free(task);
+#endif
+
   if (task->stack_base) {
     task_pool_free_stack(task->stack_base);
     task->stack_base = NULL;
@@ -83,6 +121,17 @@ void task_set_state(task_handle_t task, task_state_t state) {
     return;
   }
 
+  if (state == TASK_BLOCKED) {
+#if LATENCY_STATS_ENABLED
+    latency_stats_blocked(task);
+#endif
+    TRACE(TRACE_EVENT_TASK_BLOCK, task, (uintptr_t)task->waiting_on);
+
+    // Off the ready queue, or the scheduler keeps picking it. This also
+    // drops any old timeout, so callers arm a new one afterwards.
+    scheduler_remove_task(task);
+  }
+
   task->state = state;
 }
 
@@ -102,6 +151,12 @@ void task_init_stack(task_handle_t task, task_function_t function,
       task->stack_base + (task->stack_size / sizeof(uint32_t));
   uint32_t *sp = stack_top;
 
+#if STACK_PAINT_ENABLED
+  for (uint32_t *word = stack_usable_base(task); word < stack_top; word++) {
+    *word = STACK_PAINT_PATTERN;
+  }
+#endif
+
   // ARM Cortex-M4 automatically pushes these registers during interrupt entry
   // We simulate this by preloading the stack
 
@@ -126,6 +181,12 @@ void task_init_stack(task_handle_t task, task_function_t function,
   *(--sp) = 0; // R4
 
   task->stack_pointer = sp;
+  task->exc_return = TASK_INITIAL_EXC_RETURN;
+
+#if PORT_HOST_CONTEXTS
+  // The host runs the task on its own context; the frame above is unused
+  port_task_init(task, function, param);
+#endif
 }
 
 bool task_stack_check(task_handle_t task) {
@@ -137,7 +198,7 @@ bool task_stack_check(task_handle_t task) {
       task->stack_base + (task->stack_size / sizeof(uint32_t));
   uint32_t used_bytes = (stack_top - task->stack_pointer) * sizeof(uint32_t);
 
-  return used_bytes < task->stack_size;
+  return used_bytes < stack_usable_bytes(task);
 }
 
 uint32_t task_stack_used_bytes(task_handle_t task) {
@@ -151,3 +212,46 @@ uint32_t task_stack_used_bytes(task_handle_t task) {
 
   return used_bytes;
 }
+
+uint32_t task_stack_high_water(task_handle_t task) {
+  if (!task || !task->stack_base) {
+    return 0;
+  }
+
+#if STACK_PAINT_ENABLED
+  const uint32_t *stack_top =
+      task->stack_base + (task->stack_size / sizeof(uint32_t));
+  const uint32_t *word = stack_usable_base(task);
+
+  // Stack grows down, so the first dirty word from the base is the deepest.
+  // Starting above the MPU guard keeps the idle task from faulting on its own.
+  while (word < stack_top && *word == STACK_PAINT_PATTERN) {
+    word++;
+  }
+
+  return (uint32_t)(stack_top - word) * sizeof(uint32_t);
+#else
+  return task_stack_used_bytes(task);
+#endif
+}
+
+void task_stack_sweep(void) {
+  for (size_t i = 0; i < MAX_TASKS; i++) {
+    task_handle_t task = (task_handle_t)pool_object_at(POOL_TCB, i);
+    if (!task || task->state == TASK_DELETED) {
+      continue;
+    }
+
+    uint32_t *stack_base = task->stack_base;
+    uint32_t usable = stack_usable_bytes(task);
+    uint32_t used = task_stack_high_water(task);
+    uint32_t headroom = used < usable ? usable - used : 0;
+
+    // The task may have been deleted while we were scanning its stack
+    KERNEL_CRITICAL_BEGIN();
+    if (task->stack_base == stack_base && headroom < task->stack_min_headroom) {
+      task->stack_min_headroom = headroom;
+    }
+    KERNEL_CRITICAL_END();
+  }
+}
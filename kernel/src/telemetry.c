@@ -0,0 +1,218 @@
+#include "telemetry.h"
+#include "critical.h"
+#include "introspect.h"
+#include "memory.h"
+#include "port.h"
+#include "runtime_stats.h"
+#include "scheduler.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Objects are copied by the introspection iterators, one per critical
+// section, and encoded after the section ends, so the masked part of a
+// snapshot is a few dozen loads per object.
+
+#define ENTRY_MAX 40 // Largest entry, header and name included
+#define NAME_MAX_BYTES 15
+
+typedef struct frame {
+  uint8_t *buffer;
+  size_t size;
+  size_t length;
+  bool truncated;
+} frame_t;
+
+typedef struct entry {
+  uint8_t bytes[ENTRY_MAX];
+  size_t length;
+} entry_t;
+
+static uint32_t snapshot_sequence;
+
+// ============================== HELPER FUNCTIONS =============================
+
+static void put_u8(entry_t *e, uint32_t value) {
+  e->bytes[e->length++] = (uint8_t)value;
+}
+
+static void put_u16(entry_t *e, uint32_t value) {
+  put_u8(e, value);
+  put_u8(e, value >> 8);
+}
+
+static void put_u32(entry_t *e, uint32_t value) {
+  put_u16(e, value);
+  put_u16(e, value >> 16);
+}
+
+static void put_u64(entry_t *e, uint64_t value) {
+  put_u32(e, (uint32_t)value);
+  put_u32(e, (uint32_t)(value >> 32));
+}
+
+static void put_name(entry_t *e, const char *name) {
+  for (size_t i = 0; i < NAME_MAX_BYTES && name[i]; i++) {
+    put_u8(e, (uint8_t)name[i]);
+  }
+}
+
+static void entry_begin(entry_t *e, telemetry_entry_t type) {
+  e->length = 0;
+  put_u8(e, type);
+  put_u8(e, 0); // Length, set by frame_add()
+}
+
+// Entries are whole: once one does not fit, the rest are left out too
+static void frame_add(frame_t *f, entry_t *e) {
+  if (f->truncated || f->length + e->length > f->size) {
+    f->truncated = true;
+    return;
+  }
+  e->bytes[1] = (uint8_t)(e->length - 2);
+  memcpy(f->buffer + f->length, e->bytes, e->length);
+  f->length += e->length;
+}
+
+static uint16_t saturate_u16(size_t value) {
+  return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+static void add_kernel(frame_t *f) {
+  entry_t e;
+  uint32_t load = 0;
+  uint64_t isr_cycles = 0;
+
+#if RUNTIME_STATS_ENABLED
+  load = kernel_get_cpu_load();
+  isr_cycles = kernel_get_isr_cycles();
+#endif
+
+  entry_begin(&e, TELEMETRY_ENTRY_KERNEL);
+  put_u16(&e, load);
+  put_u64(&e, isr_cycles);
+  put_u32(&e, port_cycle_counter_hz());
+  put_u8(&e, pool_get_stats(POOL_TCB).used_objects);
+  frame_add(f, &e);
+}
+
+static void add_pools(frame_t *f) {
+  for (int i = 0; i < POOL_COUNT; i++) {
+    pool_stats_t stats = pool_get_stats((pool_type_t)i);
+    entry_t e;
+
+    entry_begin(&e, TELEMETRY_ENTRY_POOL);
+    put_u8(&e, i);
+    put_u16(&e, saturate_u16(stats.total_objects));
+    put_u16(&e, saturate_u16(stats.used_objects));
+    put_u16(&e, saturate_u16(stats.peak_usage));
+    put_u16(&e, saturate_u16(stats.corruptions));
+    frame_add(f, &e);
+  }
+}
+
+static void add_tasks(frame_t *f) {
+  size_t cursor = 0;
+  task_info_t info;
+
+  while (introspect_task_next(&cursor, &info)) {
+    entry_t e;
+    entry_begin(&e, TELEMETRY_ENTRY_TASK);
+    put_u8(&e, info.slot);
+    put_u8(&e, info.state);
+    put_u8(&e, info.base_priority);
+    put_u8(&e, info.effective_priority);
+    put_u16(&e, saturate_u16(info.stack_size));
+    put_u16(&e, saturate_u16(info.stack_headroom));
+    put_u32(&e, info.run_count);
+    put_u64(&e, info.runtime_cycles);
+    put_name(&e, info.name);
+    frame_add(f, &e);
+  }
+}
+
+static void add_queues(frame_t *f) {
+  size_t cursor = 0;
+  queue_info_t info;
+
+  while (introspect_queue_next(&cursor, &info)) {
+    entry_t e;
+    entry_begin(&e, TELEMETRY_ENTRY_QUEUE);
+    put_u8(&e, info.slot);
+    put_u16(&e, saturate_u16(info.messages));
+    put_u16(&e, saturate_u16(info.capacity));
+    put_u16(&e, saturate_u16(info.item_size));
+    put_u8(&e, (info.waiting_senders ? 1 : 0) |
+                   (info.waiting_receivers ? 2 : 0));
+    frame_add(f, &e);
+  }
+}
+
+static void add_semaphores(frame_t *f) {
+  size_t cursor = 0;
+  sem_info_t info;
+
+  while (introspect_sem_next(&cursor, &info)) {
+    entry_t e;
+    entry_begin(&e, TELEMETRY_ENTRY_SEM);
+    put_u8(&e, info.slot);
+    put_u32(&e, info.count);
+    put_u32(&e, info.max_count);
+    put_u8(&e, info.waiting_tasks);
+    put_name(&e, info.name);
+    frame_add(f, &e);
+  }
+}
+
+static void add_mutexes(frame_t *f) {
+  size_t cursor = 0;
+  mutex_info_t info;
+
+  while (introspect_mutex_next(&cursor, &info)) {
+    entry_t e;
+    entry_begin(&e, TELEMETRY_ENTRY_MUTEX);
+    put_u8(&e, info.slot);
+    put_u8(&e, info.owner_slot < 0 ? TELEMETRY_NO_TASK
+                                   : (uint32_t)info.owner_slot);
+    put_u8(&e, info.waiting_tasks);
+    put_name(&e, info.name);
+    frame_add(f, &e);
+  }
+}
+
+// ============================== PUBLIC API ===================================
+
+telemetry_result_t telemetry_snapshot(uint8_t *buffer, size_t size,
+                                      size_t *length) {
+  if (!buffer || !length) return TELEMETRY_ERROR_NULL;
+  if (size < TELEMETRY_HEADER_SIZE) return TELEMETRY_ERROR_TOO_SMALL;
+
+  frame_t f = {buffer, size > 0xFFFF ? 0xFFFF : size, TELEMETRY_HEADER_SIZE,
+               false};
+
+  KERNEL_CRITICAL_BEGIN();
+  uint32_t sequence = ++snapshot_sequence;
+  uint32_t tick_start = tick_now;
+  KERNEL_CRITICAL_END();
+
+  add_kernel(&f);
+  add_pools(&f);
+  add_tasks(&f);
+  add_queues(&f);
+  add_semaphores(&f);
+  add_mutexes(&f);
+
+  entry_t header;
+  header.length = 0;
+  put_u32(&header, TELEMETRY_MAGIC);
+  put_u8(&header, TELEMETRY_VERSION);
+  put_u8(&header, f.truncated ? TELEMETRY_FLAG_TRUNCATED : 0);
+  put_u16(&header, f.length);
+  put_u32(&header, sequence);
+  put_u32(&header, tick_start);
+  put_u32(&header, tick_now);
+  memcpy(buffer, header.bytes, TELEMETRY_HEADER_SIZE);
+
+  *length = f.length;
+  return TELEMETRY_OK;
+}
@@ -0,0 +1,156 @@
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include "memory.h"
+#include "port.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef __ARM_ARCH
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if (TRACE_BUFFER_RECORDS & (TRACE_BUFFER_RECORDS - 1)) != 0
+#error "TRACE_BUFFER_RECORDS must be a power of two"
+#endif
+
+trace_buffer_t trace_ram;
+
+static trace_sink_t trace_sink;
+
+#ifndef __ARM_ARCH
+static int trace_stream_fd = -1;
+#endif
+
+// ============================== HELPER FUNCTIONS =============================
+
+static void trace_emit_task_names(void) {
+  size_t count = pool_get_stats(POOL_TCB).total_objects;
+
+  for (size_t i = 0; i < count; i++) {
+    task_handle_t task = pool_object_at(POOL_TCB, i);
+    if (task) {
+      trace_task_name(task);
+    }
+  }
+}
+
+#ifndef __ARM_ARCH
+// Runs wherever trace_record() does, which on the host port includes the
+// signal handlers standing in for interrupts. stdio is not safe there (an
+// fwrite() interrupted by another would corrupt or deadlock the stream), so
+// each record is one unbuffered write(2).
+static void trace_stream_sink(const trace_record_t *record) {
+  int saved_errno = errno;
+  if (trace_stream_fd >= 0) {
+    ssize_t written = write(trace_stream_fd, record, sizeof(*record));
+    (void)written; // A short or failed write just drops the record
+  }
+  errno = saved_errno;
+}
+#endif
+
+// ============================== PUBLIC API ===================================
+
+void trace_init(void) {
+  port_cycle_counter_init();
+
+  memset(&trace_ram, 0, sizeof(trace_ram));
+  trace_ram.header.magic = TRACE_MAGIC;
+  trace_ram.header.version = TRACE_VERSION;
+  trace_ram.header.record_size = sizeof(trace_record_t);
+  trace_ram.header.capacity = TRACE_BUFFER_RECORDS;
+  trace_ram.header.timestamp_hz = port_cycle_counter_hz();
+  trace_sink = NULL;
+}
+
+void trace_start(void) {
+  __atomic_store_n(&trace_ram.header.enabled, 1, __ATOMIC_RELEASE);
+  trace_emit_task_names();
+}
+
+void trace_stop(void) {
+  __atomic_store_n(&trace_ram.header.enabled, 0, __ATOMIC_RELEASE);
+}
+
+void trace_clear(void) {
+  trace_ram.header.head = 0;
+  memset(trace_ram.records, 0, sizeof(trace_ram.records));
+}
+
+void trace_set_sink(trace_sink_t sink) { trace_sink = sink; }
+
+void trace_task_name(const void *task) {
+  const task_control_block *tcb = task;
+
+  for (size_t off = 0; off < sizeof(tcb->name); off += 4) {
+    uint32_t chars;
+    memcpy(&chars, &tcb->name[off], sizeof(chars));
+    trace_record(TRACE_EVENT_TASK_NAME, (uintptr_t)tcb, chars);
+  }
+}
+
+void trace_stream_header(trace_header_t *header) {
+  *header = trace_ram.header;
+  header->capacity = 0;
+  header->head = 0;
+}
+
+#ifndef __ARM_ARCH
+bool trace_stream_open(const char *path) {
+  trace_stream_close();
+
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  trace_header_t header;
+  trace_stream_header(&header);
+  if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+    close(fd);
+    return false;
+  }
+
+  trace_stream_fd = fd;
+  trace_set_sink(trace_stream_sink);
+  return true;
+}
+
+void trace_stream_close(void) {
+  if (trace_stream_fd < 0) return;
+
+  // Unhooked first, so no record is written to a closed descriptor
+  trace_set_sink(NULL);
+  close(trace_stream_fd);
+  trace_stream_fd = -1;
+}
+#endif
+
+// Hot path: one atomic increment claims the slot, so an interrupt that
+// preempts a producer simply takes the next one. A reader can see a slot
+// half-written only if it dumps while the producer is between the claim and
+// the last store; the sequence field makes that visible.
+void trace_record(uint16_t event, uintptr_t object, uint32_t arg) {
+  if (!__atomic_load_n(&trace_ram.header.enabled, __ATOMIC_RELAXED)) return;
+
+  uint32_t seq =
+      __atomic_fetch_add(&trace_ram.header.head, 1, __ATOMIC_RELAXED);
+  trace_record_t *rec = &trace_ram.records[seq & (TRACE_BUFFER_RECORDS - 1)];
+
+  rec->timestamp = port_cycle_count();
+  rec->event = event;
+  rec->sequence = (uint16_t)seq;
+  rec->object = (uint32_t)object;
+  rec->arg = arg;
+
+  if (trace_sink) {
+    trace_sink(rec);
+  }
+}
+
+#endif // TRACE_ENABLED
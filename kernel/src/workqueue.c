@@ -0,0 +1,158 @@
+#include "workqueue.h"
+#include "critical.h"
+#include "scheduler.h"
+#include "task.h"
+#include "time_utils.h"
+
+#include <stddef.h>
+
+#define work_from_link(ptr) container_of(ptr, work_item_t, link)
+
+// ============================== HELPER FUNCTIONS =============================
+
+// Moves delayed items that are due onto the pending list, one per
+// critical section so masked time does not grow with the list. Returns the
+// ticks until the next one is due, or SEM_WAIT_FOREVER if none is left.
+static uint32_t work_promote_due(work_queue_t *wq) {
+  uint32_t left = 0;
+
+  while (left == 0) {
+    KERNEL_CRITICAL_BEGIN();
+    if (list_is_empty(&wq->delayed)) {
+      left = SEM_WAIT_FOREVER;
+    } else {
+      work_item_t *work = work_from_link(wq->delayed.next);
+      left = ticks_until(work->due, tick_now);
+      if (left == 0) {
+        list_move_to_tail(&wq->pending, &work->link);
+      }
+    }
+    KERNEL_CRITICAL_END();
+  }
+  return left;
+}
+
+// Keeps the delayed list sorted by due tick, equal ticks in submission
+// order. Scans from the tail, since later deadlines are the common case.
+static void work_insert_delayed(work_queue_t *wq, work_item_t *work) {
+  list_head_t *pos = wq->delayed.prev;
+  while (pos != &wq->delayed && time_lt(work->due, work_from_link(pos)->due)) {
+    pos = pos->prev;
+  }
+  list_insert_before(&work->link, pos->next);
+}
+
+static work_item_t *work_pop(work_queue_t *wq) {
+  work_item_t *work = NULL;
+
+  KERNEL_CRITICAL_BEGIN();
+  if (!list_is_empty(&wq->pending)) {
+    work = work_from_link(wq->pending.next);
+    list_remove(&work->link);
+    work->queue = NULL; // Free to be resubmitted from here on
+    wq->runs++;
+  }
+  KERNEL_CRITICAL_END();
+  return work;
+}
+
+static void work_queue_worker(void *param) {
+  work_queue_t *wq = param;
+
+  while (1) {
+    uint32_t wait = work_promote_due(wq);
+
+    work_item_t *work = work_pop(wq);
+    if (work) {
+      work->function(work, work->arg);
+      continue;
+    }
+
+    // A submit after the pop above has posted, so this returns at once
+    sem_wait(wq->wake, wait);
+  }
+}
+
+static bool work_enqueue(work_queue_t *wq, work_item_t *work, uint32_t ticks) {
+  if (!wq || !work) return false;
+
+  KERNEL_CRITICAL_BEGIN();
+  if (work->queue) {
+    wq->coalesced++;
+    KERNEL_CRITICAL_END();
+    return false;
+  }
+
+  work->queue = wq;
+  if (ticks == 0) {
+    list_insert_tail(&wq->pending, &work->link);
+  } else {
+    work->due = tick_now + ticks;
+    work_insert_delayed(wq, work);
+  }
+  KERNEL_CRITICAL_END();
+
+  // Already posted and not yet taken is fine: one wake covers both
+  sem_post(wq->wake);
+  return true;
+}
+
+// ============================== PUBLIC API ===================================
+
+bool work_queue_init(work_queue_t *wq, const char *name,
+                     task_priority_t priority, uint16_t stack_size) {
+  if (!wq) return false;
+
+  list_init(&wq->pending);
+  list_init(&wq->delayed);
+  wq->runs = 0;
+  wq->coalesced = 0;
+
+  wq->wake = sem_create(0, 1, name);
+  if (!wq->wake) return false;
+
+  wq->worker = task_create(work_queue_worker, name, stack_size, wq, priority);
+  if (!wq->worker) {
+    sem_delete(wq->wake);
+    return false;
+  }
+  return true;
+}
+
+void work_init(work_item_t *work, work_function_t function, void *arg) {
+  if (!work) return;
+
+  list_init(&work->link);
+  work->function = function;
+  work->arg = arg;
+  work->due = 0;
+  work->queue = NULL;
+}
+
+bool work_submit(work_queue_t *wq, work_item_t *work) {
+  return work_enqueue(wq, work, 0);
+}
+
+bool work_submit_delayed(work_queue_t *wq, work_item_t *work, uint32_t ticks) {
+  return work_enqueue(wq, work, ticks);
+}
+
+bool work_cancel(work_item_t *work) {
+  if (!work) return false;
+
+  KERNEL_CRITICAL_BEGIN();
+  bool queued = work->queue != NULL;
+  list_remove(&work->link);
+  work->queue = NULL;
+  KERNEL_CRITICAL_END();
+  return queued;
+}
+
+bool work_is_queued(const work_item_t *work) {
+  if (!work) return false;
+
+  KERNEL_CRITICAL_BEGIN();
+  bool queued = work->queue != NULL;
+  KERNEL_CRITICAL_END();
+  return queued;
+}
@@ -0,0 +1,24 @@
+// crt_init.c - C runtime setup called from Reset_Handler (startup.s)
+//
+// Runs before .data/.bss exist, so it only touches the linker symbols.
+
+#include <stdint.h>
+
+extern uint32_t _sidata; // .data load address (flash)
+extern uint32_t _sdata;  // .data start (RAM)
+extern uint32_t _edata;
+extern uint32_t _sbss;
+extern uint32_t _ebss;
+
+void copy_data_init(void) {
+  const uint32_t *src = &_sidata;
+  for (uint32_t *dst = &_sdata; dst < &_edata;) {
+    *dst++ = *src++;
+  }
+}
+
+void zero_bss_init(void) {
+  for (uint32_t *dst = &_sbss; dst < &_ebss;) {
+    *dst++ = 0;
+  }
+}
@@ -26,17 +26,27 @@ vector_table:
     .word SysTick_Handler            // SysTick handler (CRITICAL for RTOS!)
     
     // External interrupts (add as needed)
-    .word Default_Handler            // IRQ 0
-    .word Default_Handler            // IRQ 1
+    .word IRQ0_Handler               // IRQ 0
+    .word IRQ1_Handler               // IRQ 1
     // ... add more as needed for your specific MCU
 
 .text
 .global Reset_Handler
+.type Reset_Handler, %function     // Vector entries need the Thumb bit set
 Reset_Handler:
     // Due to ARM Thumb instruction encoding...
     ldr r0, =_estack                 // Load into low register first
     mov sp, r0                       // Then move to stack pointer
     
+    // Enable CP10/CP11 (FPU) access. Write-ignored on parts without an FPU,
+    // and must happen before any compiler-generated FP instruction.
+    ldr r0, =0xE000ED88              // CPACR
+    ldr r1, [r0]
+    orr r1, r1, #0x00F00000
+    str r1, [r0]
+    dsb
+    isb
+
     // Copy data section from flash to RAM
     bl copy_data_init
     
@@ -67,6 +77,21 @@ Reset_Handler:
 .weak SysTick_Handler
 .weak Default_Handler
 
+// IRQ handlers default to Default_Handler until the application defines one
+.weak IRQ0_Handler
+.thumb_set IRQ0_Handler, Default_Handler
+.weak IRQ1_Handler
+.thumb_set IRQ1_Handler, Default_Handler
+
+.type NMI_Handler, %function
+.type HardFault_Handler, %function
+.type MemManage_Handler, %function
+.type BusFault_Handler, %function
+.type UsageFault_Handler, %function
+.type SVC_Handler, %function
+.type DebugMon_Handler, %function
+.type Default_Handler, %function
+
 NMI_Handler:
 HardFault_Handler:
 MemManage_Handler:
@@ -82,6 +107,8 @@ Default_Handler:
 .global SysTick_Handler              // Timer tick handler
 
 // Placeholder implementations (remove when you implement them)
+.type PendSV_Handler, %function
+.type SysTick_Handler, %function
 PendSV_Handler:
     bx lr                            // Just return for now
 
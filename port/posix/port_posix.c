@@ -0,0 +1,319 @@
+// port_posix.c - Linux/POSIX host port
+//
+// Runs the unmodified kernel inside one host process (build with
+// PORT_POSIX=1):
+//
+//   - Every task is a ucontext on its own host stack. The pool stack from
+//     task_create() is still allocated and painted but never run on: libc
+//     and signal frames need far more than an embedded stack.
+//   - SysTick is an ITIMER_REAL interval timer. Its SIGALRM handler does
+//     what SysTick_Handler in context_switch.S does.
+//   - PendSV is SIGUSR1. trigger_context_switch() raises it. If the signals
+//     are blocked (a critical section, or inside the tick handler) it stays
+//     pending and is taken when they are unblocked, like a pended
+//     exception. The handler swaps contexts.
+//   - Critical sections and __disable_irq() block SIGALRM, SIGUSR1 and
+//     SIGUSR2 (the simulated peripheral IRQ). Each handler runs with all
+//     three blocked, so handlers never nest.
+//
+// All signals go to the one thread, so the process must stay
+// single-threaded. Tasks can be switched out in the middle of a libc call.
+// Keep stdout unbuffered and avoid malloc() from more than one task.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // Register names for the profiler's PC in <ucontext.h>
+#endif
+
+#include "config.h"
+
+#if PORT_POSIX
+
+#include "critical.h"
+#include "port.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "task.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#ifndef PORT_POSIX_STACK_SIZE
+#define PORT_POSIX_STACK_SIZE (64 * 1024) // Host stack per task
+#endif
+
+#define PORT_SIG_TICK SIGALRM
+#define PORT_SIG_SWITCH SIGUSR1
+#define PORT_SIG_IRQ SIGUSR2
+
+// What port_current_exception() reports, matching the Cortex-M numbers
+#define PORT_EXC_PENDSV 14
+#define PORT_EXC_SYSTICK 15
+#define PORT_EXC_IRQ0 16
+
+typedef struct port_context {
+  task_handle_t task; // Owner, NULL while free
+  task_function_t function;
+  void *param;
+  ucontext_t context;
+  uint8_t stack[PORT_POSIX_STACK_SIZE] __attribute__((aligned(16)));
+} port_context_t;
+
+// One per TCB, so lookups are a short linear scan
+static port_context_t port_contexts[MAX_TASKS];
+
+static volatile sig_atomic_t port_exception; // 0 while a task runs
+static volatile sig_atomic_t port_started;
+static void (*volatile port_irq_handler)(void);
+static uintptr_t port_tick_pc; // Interrupted PC, for the profiler
+
+// ============================== HELPER FUNCTIONS =============================
+
+// The signals that stand in for kernel-aware interrupts
+static void port_irq_signals(sigset_t *set) {
+  sigemptyset(set);
+  sigaddset(set, PORT_SIG_TICK);
+  sigaddset(set, PORT_SIG_SWITCH);
+  sigaddset(set, PORT_SIG_IRQ);
+}
+
+static port_context_t *port_context_of(task_handle_t task) {
+  for (size_t i = 0; i < MAX_TASKS; i++) {
+    if (port_contexts[i].task == task) {
+      return &port_contexts[i];
+    }
+  }
+  return NULL;
+}
+
+// First code every task runs. PendSV set current_task before switching.
+static void port_task_entry(void) {
+  port_context_t *ctx = port_context_of(current_task);
+
+  // Entered from a handler that never returns on this context, with the
+  // handler's mask still in place
+  port_exception = 0;
+  port_enable_interrupts();
+
+  ctx->function(ctx->param);
+
+  // A task that returns faults on target (LR = 0); fail loudly here too
+  abort();
+}
+
+// The host stand-in for the PC in an exception frame; 0 where unknown
+static uintptr_t port_interrupted_pc(const void *uc) {
+#if defined(__x86_64__)
+  return (uintptr_t)((const ucontext_t *)uc)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+  return (uintptr_t)((const ucontext_t *)uc)->uc_mcontext.pc;
+#else
+  (void)uc;
+  return 0;
+#endif
+}
+
+static void port_signal_handler(int sig, siginfo_t *info, void *uc) {
+  int saved_errno = errno;
+  sig_atomic_t interrupted = port_exception;
+  (void)info;
+
+  if (sig == PORT_SIG_TICK) {
+    port_tick_pc = port_interrupted_pc(uc);
+    port_exception = PORT_EXC_SYSTICK;
+    SysTick_Handler();
+  } else if (sig == PORT_SIG_SWITCH) {
+    port_exception = PORT_EXC_PENDSV;
+    PendSV_Handler();
+  } else {
+    port_exception = PORT_EXC_IRQ0;
+    void (*handler)(void) = port_irq_handler;
+    if (handler) {
+      handler();
+    }
+  }
+
+  // After a switch this runs when the task is switched back in
+  port_exception = interrupted;
+  errno = saved_errno;
+}
+
+static void port_install_handlers(void) {
+  struct sigaction sa = {0};
+  sa.sa_sigaction = port_signal_handler;
+  sa.sa_flags = SA_RESTART | SA_SIGINFO;
+  port_irq_signals(&sa.sa_mask);
+
+  sigaction(PORT_SIG_TICK, &sa, NULL);
+  sigaction(PORT_SIG_SWITCH, &sa, NULL);
+  sigaction(PORT_SIG_IRQ, &sa, NULL);
+}
+
+// ============================== PORT INTERFACE ===============================
+
+uint32_t kernel_critical_enter(void) {
+  sigset_t irqs, old;
+  port_irq_signals(&irqs);
+  sigprocmask(SIG_BLOCK, &irqs, &old);
+  return sigismember(&old, PORT_SIG_TICK) ? 1u : 0u;
+}
+
+void kernel_critical_exit(uint32_t was_masked) {
+  if (!was_masked) {
+    sigset_t irqs;
+    port_irq_signals(&irqs);
+    sigprocmask(SIG_UNBLOCK, &irqs, NULL);
+  }
+}
+
+void port_disable_interrupts(void) {
+  sigset_t irqs;
+  port_irq_signals(&irqs);
+  sigprocmask(SIG_BLOCK, &irqs, NULL);
+}
+
+void port_enable_interrupts(void) {
+  sigset_t irqs;
+  port_irq_signals(&irqs);
+  sigprocmask(SIG_UNBLOCK, &irqs, NULL);
+}
+
+// Like WFI with PRIMASK set: sleeps until a signal is pending. Unlike WFI
+// the handler runs inside sigsuspend(), before the caller unmasks.
+void port_wait_for_interrupt(void) {
+  sigset_t waiting;
+  sigprocmask(SIG_SETMASK, NULL, &waiting);
+  sigdelset(&waiting, PORT_SIG_TICK);
+  sigdelset(&waiting, PORT_SIG_SWITCH);
+  sigdelset(&waiting, PORT_SIG_IRQ);
+  sigsuspend(&waiting);
+}
+
+uint32_t port_current_exception(void) { return (uint32_t)port_exception; }
+
+void port_task_init(task_handle_t task, task_function_t function,
+                    void *param) {
+  port_context_t *ctx = port_context_of(task); // Re-initialised task
+  if (!ctx) {
+    ctx = port_context_of(NULL);
+  }
+  if (!ctx) {
+    // More tasks than TCBs: cannot happen
+    while (1) {
+    }
+  }
+
+  ctx->task = task;
+  ctx->function = function;
+  ctx->param = param;
+
+  getcontext(&ctx->context);
+  ctx->context.uc_stack.ss_sp = ctx->stack;
+  ctx->context.uc_stack.ss_size = sizeof(ctx->stack);
+  ctx->context.uc_link = NULL;
+  // Start masked: swapcontext() installs the new mask before it restores
+  // the registers, and a signal in between would run on the old stack
+  // with current_task already pointing here. port_task_entry() unmasks.
+  port_irq_signals(&ctx->context.uc_sigmask);
+  makecontext(&ctx->context, port_task_entry, 0);
+}
+
+void port_task_free(task_handle_t task) {
+  port_context_t *ctx = port_context_of(task);
+  if (ctx) {
+    ctx->task = NULL;
+  }
+}
+
+void systick_init(uint32_t ticks_per_second) {
+  // Blocked until the first task's context unmasks them, as PRIMASK is
+  // clear only once start_first_task() runs on target. Later calls only
+  // change the rate.
+  if (!port_started) {
+    port_disable_interrupts();
+    port_install_handlers();
+  }
+
+  // tv_usec must stay below 10^6, so a 1 Hz tick is a whole second
+  uint32_t period_us = 1000000u / ticks_per_second;
+  struct itimerval period = {0};
+  period.it_interval.tv_sec = (time_t)(period_us / 1000000u);
+  period.it_interval.tv_usec = (suseconds_t)(period_us % 1000000u);
+  period.it_value = period.it_interval;
+
+  // Without a tick nothing would ever time out; fail loudly instead
+  if (setitimer(ITIMER_REAL, &period, NULL) != 0) {
+    abort();
+  }
+}
+
+void start_first_task(uint32_t *first_task_sp) {
+  (void)first_task_sp;
+
+  port_started = 1;
+  setcontext(&port_context_of(current_task)->context);
+
+  // Only reached if setcontext() fails
+  abort();
+}
+
+void trigger_context_switch(void) {
+  // A PendSV pended before the scheduler runs has nothing to switch from
+  if (port_started) {
+    raise(PORT_SIG_SWITCH);
+  }
+}
+
+void port_posix_set_irq_handler(void (*handler)(void)) {
+  port_irq_handler = handler;
+}
+
+void port_posix_trigger_irq(void) { raise(PORT_SIG_IRQ); }
+
+// ================================= HANDLERS ==================================
+
+void SysTick_Handler(void) {
+#if PROFILE_ENABLED
+  // Handlers never nest here, so a task (or main) was interrupted
+  if (port_tick_pc) {
+    profile_sample(port_tick_pc, current_task);
+  }
+#endif
+  if (!scheduler_tick()) return;
+
+  task_handle_t next = scheduler_get_next_task();
+  if (next != current_task) {
+    next_task = next;
+    trigger_context_switch(); // Taken once this handler returns
+  }
+}
+
+void PendSV_Handler(void) {
+  task_handle_t from = current_task;
+  task_handle_t to = next_task;
+
+  if (!to || to == from) {
+    return;
+  }
+
+#if KERNEL_SWITCH_HOOK_ENABLED
+  scheduler_switch_hook(from, to);
+#endif
+
+  current_task = to;
+
+  port_context_t *from_ctx = port_context_of(from);
+  port_context_t *to_ctx = port_context_of(to);
+
+  if (from_ctx) {
+    // Returns when from is switched back in
+    swapcontext(&from_ctx->context, &to_ctx->context);
+  } else {
+    // The outgoing task was deleted; nothing to save
+    setcontext(&to_ctx->context);
+  }
+}
+
+#endif // PORT_POSIX
@@ -0,0 +1,634 @@
+// sim.c - Discrete-event scheduler simulator (see sim.h)
+//
+// The port layer of a PORT_SIM build. Tasks are ucontexts on host stacks,
+// as on the POSIX port, but nothing is asynchronous: SysTick and the
+// scheduled interrupts are events on a virtual cycle clock, and they are
+// delivered only at the points where a Cortex-M would take them:
+//
+//   - while a task computes (SIM_OP_COMPUTE), which can be preempted;
+//   - when interrupts are unmasked again (critical section exit,
+//     __enable_irq() after the idle task's WFI);
+//   - right after a task is switched in.
+//
+// PendSV is a flag taken at the same points. WFI moves the clock straight
+// to the next event, so idle time costs nothing to simulate. There is one
+// host thread and no host time source, so runs are bit-for-bit repeatable.
+
+#include "config.h"
+
+#if PORT_SIM
+
+#include "sim.h"
+
+#include "critical.h"
+#include "mutex.h"
+#include "port.h"
+#include "queue.h"
+#include "runtime_stats.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#if !LATENCY_STATS_ENABLED || !RUNTIME_STATS_ENABLED
+#error "The simulator reports from LATENCY_STATS and RUNTIME_STATS"
+#endif
+
+#ifndef SIM_STACK_SIZE
+#define SIM_STACK_SIZE (64 * 1024) // Host stack per task
+#endif
+
+#define SIM_QUEUE_FOREVER 0x7FFFFFFFu // Queues have no "forever" constant
+#define SIM_PARK_TICKS 0x7FFFFFFFu
+
+// What port_current_exception() reports, matching the Cortex-M numbers
+#define SIM_EXC_PENDSV 14
+#define SIM_EXC_SYSTICK 15
+#define SIM_EXC_IRQ0 16
+
+typedef enum {
+  SIM_EVENT_TICK,
+  SIM_EVENT_IRQ,
+  SIM_EVENT_END,
+} sim_event_t;
+
+typedef struct sim_context {
+  task_handle_t task; // Owner, NULL while free
+  task_function_t function;
+  void *param;
+  ucontext_t context;
+  uint8_t stack[SIM_STACK_SIZE] __attribute__((aligned(16)));
+} sim_context_t;
+
+typedef struct sim_task_state {
+  const sim_task_t *def;
+  task_handle_t handle;
+  sim_task_result_t *result;
+  uint32_t last_release_tick; // SIM_OP_DELAY_UNTIL base
+} sim_task_state_t;
+
+static sim_context_t sim_contexts[MAX_TASKS];
+static sim_task_state_t sim_tasks[SIM_MAX_TASKS];
+
+static semaphore_handle_t sim_semaphores[MAX_SEMAPHORES];
+static queue_handle_t sim_queues[MAX_QUEUES];
+static mutex_handle_t sim_mutexes[MAX_MUTEXES];
+
+static const sim_scenario_t *sim_scenario;
+static sim_result_t *sim_result;
+
+static uint64_t sim_time;
+static uint64_t sim_tick_cycles;
+static uint64_t sim_next_tick;
+static uint64_t sim_irq_next[SIM_MAX_IRQS]; // UINT64_MAX once done
+
+static uint32_t sim_exception; // 0 while a task runs
+static bool sim_masked;
+static bool sim_switch_pending;
+static bool sim_started;
+
+static ucontext_t sim_main_context; // sim_run()'s caller
+static ucontext_t sim_boot_context; // Runs kernel_start()
+static uint8_t sim_boot_stack[SIM_STACK_SIZE] __attribute__((aligned(16)));
+
+static void sim_service(void);
+
+// ============================== HELPER FUNCTIONS =============================
+
+static sim_context_t *sim_context_of(task_handle_t task) {
+  for (size_t i = 0; i < MAX_TASKS; i++) {
+    if (sim_contexts[i].task == task) {
+      return &sim_contexts[i];
+    }
+  }
+  return NULL;
+}
+
+// Earliest pending event. Ties go to the tick, then to the lowest IRQ.
+static sim_event_t sim_next_event(uint64_t *when, size_t *irq) {
+  sim_event_t event = SIM_EVENT_TICK;
+  *when = sim_next_tick;
+
+  for (size_t i = 0; i < sim_scenario->irq_count; i++) {
+    if (sim_irq_next[i] < *when) {
+      *when = sim_irq_next[i];
+      *irq = i;
+      event = SIM_EVENT_IRQ;
+    }
+  }
+
+  if (*when >= sim_scenario->duration) {
+    *when = sim_scenario->duration;
+    event = SIM_EVENT_END;
+  }
+  return event;
+}
+
+static uint64_t sim_next_event_time(void) {
+  uint64_t when;
+  size_t irq;
+  sim_next_event(&when, &irq);
+  return when;
+}
+
+// Reads the kernel's own accounting, so test_sim checks runtime_stats.c
+static void sim_collect(void) {
+  task_runtime_stats_t stats;
+
+  // Also charges the running task up to the end of the run
+  task_get_runtime_stats(kernel_get_idle_task(), &stats);
+  sim_result->cycles = sim_time;
+  sim_result->task_count = sim_scenario->task_count;
+  sim_result->isr_cycles = kernel_get_isr_cycles();
+  sim_result->idle_cycles = stats.runtime_cycles;
+  sim_result->cpu_load = kernel_get_cpu_load();
+
+  for (size_t i = 0; i < sim_scenario->task_count; i++) {
+    task_handle_t task = sim_tasks[i].handle;
+    sim_task_result_t *res = sim_tasks[i].result;
+
+    if (res->jobs == 0) {
+      res->response_min = 0;
+    }
+    task_get_runtime_stats(task, &stats);
+    res->run_count = stats.run_count;
+    res->runtime_cycles = stats.runtime_cycles;
+    res->wakeup_max_cycles = task->latency.wakeup.max_cycles;
+    for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+      res->blocked_cycles += task->latency.blocked[r].total_cycles;
+    }
+  }
+}
+
+// End of the run: back to sim_run(), abandoning every task context
+static void sim_finish(void) {
+  sim_time = sim_scenario->duration;
+  sim_started = false;
+  sim_collect();
+  setcontext(&sim_main_context);
+  abort();
+}
+
+static void sim_deliver(sim_event_t event, size_t irq) {
+  if (event == SIM_EVENT_END) {
+    sim_finish();
+  }
+
+  if (event == SIM_EVENT_TICK) {
+    sim_next_tick += sim_tick_cycles;
+    sim_result->ticks++;
+
+    sim_exception = SIM_EXC_SYSTICK;
+    SysTick_Handler();
+    sim_exception = 0;
+    return;
+  }
+
+  const sim_irq_t *def = &sim_scenario->irqs[irq];
+  sim_irq_next[irq] = def->period ? sim_irq_next[irq] + def->period
+                                  : UINT64_MAX;
+  sim_result->irqs++;
+
+  sim_exception = SIM_EXC_IRQ0 + (uint32_t)irq;
+  kernel_isr_enter();
+  sim_time += def->cycles;
+
+  if (def->action.type == SIM_OP_SEM_POST) {
+    sem_post(sim_semaphores[def->action.object]);
+  } else {
+    queue_send(sim_queues[def->action.object], &def->action.arg, 0);
+  }
+
+  kernel_isr_exit();
+  sim_exception = 0;
+}
+
+static void sim_pendsv(void) {
+  sim_switch_pending = false;
+
+  task_handle_t from = current_task;
+  task_handle_t to = next_task;
+  if (!to || to == from) {
+    return;
+  }
+
+  sim_exception = SIM_EXC_PENDSV;
+  sim_masked = true;
+
+  // The save half of the switch belongs to the outgoing task
+  sim_time += sim_scenario->switch_cycles;
+
+#if KERNEL_SWITCH_HOOK_ENABLED
+  scheduler_switch_hook(from, to);
+#endif
+
+  current_task = to;
+  sim_result->context_switches++;
+
+  sim_context_t *from_ctx = sim_context_of(from);
+  sim_context_t *to_ctx = sim_context_of(to);
+
+  if (from_ctx) {
+    swapcontext(&from_ctx->context, &to_ctx->context);
+  } else {
+    setcontext(&to_ctx->context); // The outgoing task was deleted
+  }
+
+  // `from` is running again
+  sim_masked = false;
+  sim_exception = 0;
+}
+
+// Takes a pended switch and every event that is due, as the core would once
+// nothing masks them. Each task has at most one frame in here.
+static void sim_service(void) {
+  while (sim_started && sim_exception == 0 && !sim_masked) {
+    if (sim_switch_pending) {
+      sim_pendsv();
+      continue;
+    }
+
+    uint64_t when;
+    size_t irq = 0;
+    sim_event_t event = sim_next_event(&when, &irq);
+    if (when > sim_time) {
+      break;
+    }
+    sim_deliver(event, irq);
+  }
+}
+
+// CPU work that events can interrupt. A preempted task picks up the rest of
+// its work when it is switched back in.
+static void sim_compute(uint64_t cycles) {
+  while (cycles > 0) {
+    sim_service();
+
+    uint64_t next = sim_next_event_time();
+    if (next - sim_time >= cycles) {
+      sim_time += cycles;
+      cycles = 0;
+    } else {
+      cycles -= next - sim_time;
+      sim_time = next;
+    }
+  }
+  sim_service();
+}
+
+// Ops that wait for the event a job responds to. Mutex locks and full
+// queues are contention inside the job and count towards its response.
+static bool sim_op_releases(sim_op_type_t type) {
+  return type == SIM_OP_DELAY || type == SIM_OP_DELAY_UNTIL ||
+         type == SIM_OP_SEM_WAIT || type == SIM_OP_QUEUE_RECEIVE;
+}
+
+static uint32_t sim_wakeups(task_handle_t task) {
+  uint32_t count = 0;
+  for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+    count += task->latency.blocked[r].count;
+  }
+  return count;
+}
+
+static void sim_delay_until(sim_task_state_t *st, uint32_t period) {
+  uint32_t release = st->last_release_tick + period;
+  st->last_release_tick = release;
+
+  if (time_lte(release, tick_now)) {
+    // The previous job overran its period; start this one late
+    st->result->deadline_misses++;
+    return;
+  }
+  task_delay(release - tick_now);
+}
+
+static void sim_execute(sim_task_state_t *st, const sim_op_t *op) {
+  uint32_t item = op->arg;
+  uint32_t queue_timeout =
+      op->arg == SIM_WAIT_FOREVER ? SIM_QUEUE_FOREVER : op->arg;
+
+  switch (op->type) {
+  case SIM_OP_COMPUTE:
+    sim_compute(op->arg);
+    break;
+  case SIM_OP_DELAY:
+    task_delay(op->arg);
+    break;
+  case SIM_OP_DELAY_UNTIL:
+    sim_delay_until(st, op->arg);
+    break;
+  case SIM_OP_YIELD:
+    task_yield();
+    break;
+  case SIM_OP_SEM_WAIT:
+    sem_wait(sim_semaphores[op->object], op->arg);
+    break;
+  case SIM_OP_SEM_POST:
+    sem_post(sim_semaphores[op->object]);
+    break;
+  case SIM_OP_QUEUE_SEND:
+    queue_send(sim_queues[op->object], &item, queue_timeout);
+    break;
+  case SIM_OP_QUEUE_RECEIVE:
+    queue_receive(sim_queues[op->object], &item, queue_timeout);
+    break;
+  case SIM_OP_MUTEX_LOCK:
+    mutex_lock(sim_mutexes[op->object], op->arg);
+    break;
+  case SIM_OP_MUTEX_UNLOCK:
+    mutex_unlock(sim_mutexes[op->object]);
+    break;
+  }
+}
+
+static void sim_task_body(void *param) {
+  sim_task_state_t *st = param;
+  const sim_task_t *def = st->def;
+  sim_task_result_t *res = st->result;
+
+  while (def->jobs == 0 || res->jobs < def->jobs) {
+    uint64_t release = sim_time;
+    bool leading = true;
+
+    for (size_t i = 0; i < def->op_count; i++) {
+      const sim_op_t *op = &def->ops[i];
+      uint32_t wakeups = sim_wakeups(st->handle);
+
+      sim_execute(st, op);
+
+      if (leading && sim_op_releases(op->type)) {
+        // Released when made ready, not when it got the CPU
+        uint32_t waited = sim_wakeups(st->handle) != wakeups
+                              ? port_cycle_count() - st->handle->ready_since
+                              : 0;
+        release = sim_time - waited;
+      } else {
+        leading = false;
+      }
+    }
+
+    uint64_t response = sim_time - release;
+    if (response < res->response_min) res->response_min = response;
+    if (response > res->response_max) res->response_max = response;
+    res->response_total += response;
+    res->jobs++;
+  }
+
+  while (1) {
+    task_delay(SIM_PARK_TICKS);
+  }
+}
+
+static bool sim_op_valid(const sim_scenario_t *s, const sim_op_t *op) {
+  switch (op->type) {
+  case SIM_OP_SEM_WAIT:
+  case SIM_OP_SEM_POST:
+    return op->object < s->semaphore_count;
+  case SIM_OP_QUEUE_SEND:
+  case SIM_OP_QUEUE_RECEIVE:
+    return op->object < s->queue_count;
+  case SIM_OP_MUTEX_LOCK:
+  case SIM_OP_MUTEX_UNLOCK:
+    return op->object < s->mutex_count;
+  default:
+    return true;
+  }
+}
+
+static bool sim_scenario_valid(const sim_scenario_t *s) {
+  if (s->task_count > SIM_MAX_TASKS || s->irq_count > SIM_MAX_IRQS ||
+      s->semaphore_count > MAX_SEMAPHORES || s->queue_count > MAX_QUEUES ||
+      s->mutex_count > MAX_MUTEXES || s->duration == 0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < s->task_count; i++) {
+    const sim_task_t *t = &s->tasks[i];
+    if (!t->ops || t->op_count == 0 || t->priority >= MAX_PRIORITY) {
+      return false;
+    }
+    for (size_t j = 0; j < t->op_count; j++) {
+      if (!sim_op_valid(s, &t->ops[j])) {
+        return false;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < s->irq_count; i++) {
+    const sim_op_t *action = &s->irqs[i].action;
+    if ((action->type != SIM_OP_SEM_POST &&
+         action->type != SIM_OP_QUEUE_SEND) ||
+        !sim_op_valid(s, action)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void sim_boot(void) {
+  kernel_start();
+  abort(); // Never returns
+}
+
+// ============================== PORT INTERFACE ===============================
+
+uint32_t port_cycle_count(void) { return (uint32_t)sim_time; }
+
+uint64_t port_time_cycles(void) { return sim_time; }
+
+uint32_t kernel_critical_enter(void) {
+  uint32_t was_masked = sim_masked;
+  sim_masked = true;
+  return was_masked;
+}
+
+void kernel_critical_exit(uint32_t was_masked) {
+  if (!was_masked) {
+    sim_masked = false;
+    sim_service();
+  }
+}
+
+void port_disable_interrupts(void) { sim_masked = true; }
+
+void port_enable_interrupts(void) {
+  sim_masked = false;
+  sim_service();
+}
+
+// The idle task sleeps masked; the event is taken once it unmasks
+void port_wait_for_interrupt(void) {
+  uint64_t next = sim_next_event_time();
+  if (next > sim_time) {
+    sim_time = next;
+  }
+}
+
+uint32_t port_current_exception(void) { return sim_exception; }
+
+static void sim_task_entry(void) {
+  sim_context_t *ctx = sim_context_of(current_task);
+
+  // Entered from PendSV (or start_first_task), which never returns here
+  sim_exception = 0;
+  sim_masked = false;
+  sim_service();
+
+  ctx->function(ctx->param);
+
+  // A task that returns faults on target (LR = 0)
+  abort();
+}
+
+void port_task_init(task_handle_t task, task_function_t function,
+                    void *param) {
+  sim_context_t *ctx = sim_context_of(task); // Re-initialised task
+  if (!ctx) {
+    ctx = sim_context_of(NULL);
+  }
+  if (!ctx) {
+    // More tasks than TCBs: cannot happen
+    while (1) {
+    }
+  }
+
+  ctx->task = task;
+  ctx->function = function;
+  ctx->param = param;
+
+  getcontext(&ctx->context);
+  ctx->context.uc_stack.ss_sp = ctx->stack;
+  ctx->context.uc_stack.ss_size = sizeof(ctx->stack);
+  ctx->context.uc_link = NULL;
+  makecontext(&ctx->context, sim_task_entry, 0);
+}
+
+void port_task_free(task_handle_t task) {
+  sim_context_t *ctx = sim_context_of(task);
+  if (ctx) {
+    ctx->task = NULL;
+  }
+}
+
+void systick_init(uint32_t ticks_per_second) {
+  sim_tick_cycles = PORT_CYCLE_COUNTER_HZ / ticks_per_second;
+  sim_next_tick = sim_time + sim_tick_cycles;
+}
+
+void start_first_task(uint32_t *first_task_sp) {
+  (void)first_task_sp;
+
+  sim_started = true;
+  sim_result->context_switches++;
+  setcontext(&sim_context_of(current_task)->context);
+  abort();
+}
+
+void trigger_context_switch(void) {
+  if (!sim_started) {
+    return;
+  }
+  sim_switch_pending = true;
+  sim_service();
+}
+
+// ================================= HANDLERS ==================================
+
+void SysTick_Handler(void) {
+  if (!scheduler_tick()) return;
+
+  task_handle_t next = scheduler_get_next_task();
+  if (next != current_task) {
+    next_task = next;
+    trigger_context_switch(); // Taken once this handler returns
+  }
+}
+
+void PendSV_Handler(void) { sim_pendsv(); }
+
+// ================================ PUBLIC API =================================
+
+bool sim_run(const sim_scenario_t *scenario, sim_result_t *result) {
+  static bool ran;
+
+  if (ran || !scenario || !result || !sim_scenario_valid(scenario)) {
+    return false;
+  }
+  ran = true;
+
+  sim_scenario = scenario;
+  sim_result = result;
+  memset(result, 0, sizeof(*result));
+
+  kernel_init();
+
+  for (size_t i = 0; i < scenario->semaphore_count; i++) {
+    sim_semaphores[i] = sem_create(0, SIM_SEM_MAX, "sim");
+    if (!sim_semaphores[i]) return false;
+  }
+  for (size_t i = 0; i < scenario->queue_count; i++) {
+    sim_queues[i] = queue_create(SIM_QUEUE_LENGTH, sizeof(uint32_t));
+    if (!sim_queues[i]) return false;
+  }
+  for (size_t i = 0; i < scenario->mutex_count; i++) {
+    sim_mutexes[i] = mutex_create("sim");
+    if (!sim_mutexes[i]) return false;
+  }
+
+  for (size_t i = 0; i < scenario->task_count; i++) {
+    sim_task_state_t *st = &sim_tasks[i];
+    st->def = &scenario->tasks[i];
+    st->result = &result->tasks[i];
+    st->result->name = st->def->name;
+    st->result->response_min = UINT64_MAX;
+
+    st->handle = task_create(sim_task_body, st->def->name, 0, st,
+                             st->def->priority);
+    if (!st->handle) return false;
+  }
+
+  for (size_t i = 0; i < scenario->irq_count; i++) {
+    sim_irq_next[i] = scenario->irqs[i].start;
+  }
+
+  getcontext(&sim_boot_context);
+  sim_boot_context.uc_stack.ss_sp = sim_boot_stack;
+  sim_boot_context.uc_stack.ss_size = sizeof(sim_boot_stack);
+  sim_boot_context.uc_link = NULL;
+  makecontext(&sim_boot_context, sim_boot, 0);
+
+  // Comes back through sim_finish()
+  swapcontext(&sim_main_context, &sim_boot_context);
+  return true;
+}
+
+uint64_t sim_now(void) { return sim_time; }
+
+void sim_print_result(const sim_result_t *result) {
+  for (size_t i = 0; i < result->task_count; i++) {
+    const sim_task_result_t *t = &result->tasks[i];
+    uint64_t avg = t->jobs ? t->response_total / t->jobs : 0;
+
+    printf("sim,%s,%lu,%llu,%llu,%llu,%lu,%lu,%llu,%llu,%lu\n", t->name,
+           (unsigned long)t->jobs, (unsigned long long)t->response_min,
+           (unsigned long long)avg, (unsigned long long)t->response_max,
+           (unsigned long)t->deadline_misses, (unsigned long)t->run_count,
+           (unsigned long long)t->runtime_cycles,
+           (unsigned long long)t->blocked_cycles,
+           (unsigned long)t->wakeup_max_cycles);
+  }
+
+  printf("sim_total,%llu,%lu,%lu,%lu,%llu,%llu,%lu\n",
+         (unsigned long long)result->cycles, (unsigned long)result->ticks,
+         (unsigned long)result->irqs, (unsigned long)result->context_switches,
+         (unsigned long long)result->idle_cycles,
+         (unsigned long long)result->isr_cycles,
+         (unsigned long)result->cpu_load);
+}
+
+#endif // PORT_SIM
@@ -0,0 +1,147 @@
+// sim.h - Discrete-event scheduler simulator
+//
+// Runs the real kernel (scheduler.c, queue.c, semaphore.c, mutex.c) against
+// a virtual cycle clock. Task bodies are scripts of sim_op_t steps and
+// interrupts come from a schedule. Nothing depends on host speed or host
+// timers, so a scenario gives the same numbers on every run and on every
+// machine. Build with PORT_SIM=1 and link port/sim/sim.c as the port.
+//
+// Time only moves in SIM_OP_COMPUTE steps, in interrupt handlers, on
+// context switches and while the idle task sleeps. Kernel calls themselves
+// take no virtual time.
+
+#ifndef SIM_H
+#define SIM_H
+
+#include "kernel.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_MAX_TASKS (MAX_TASKS - 1) // One TCB is the idle task's
+#define SIM_MAX_IRQS 8
+
+#ifndef SIM_QUEUE_LENGTH
+#define SIM_QUEUE_LENGTH 8 // uint32_t items per queue, power of two
+#endif
+
+#ifndef SIM_SEM_MAX
+#define SIM_SEM_MAX 255 // Counting semaphores start at 0
+#endif
+
+#define SIM_WAIT_FOREVER 0xFFFFFFFFu // Timeout for the blocking ops
+
+typedef enum {
+  SIM_OP_COMPUTE,       // arg: cycles of CPU work
+  SIM_OP_DELAY,         // arg: ticks
+  SIM_OP_DELAY_UNTIL,   // arg: period in ticks, from the last release
+  SIM_OP_YIELD,         //
+  SIM_OP_SEM_WAIT,      // object: semaphore, arg: timeout in ticks
+  SIM_OP_SEM_POST,      // object: semaphore
+  SIM_OP_QUEUE_SEND,    // object: queue, arg: timeout in ticks
+  SIM_OP_QUEUE_RECEIVE, // object: queue, arg: timeout in ticks
+  SIM_OP_MUTEX_LOCK,    // object: mutex, arg: timeout in ticks
+  SIM_OP_MUTEX_UNLOCK,  // object: mutex
+} sim_op_type_t;
+
+typedef struct sim_op {
+  sim_op_type_t type;
+  uint8_t object; // Index into the scenario's semaphores/queues/mutexes
+  uint32_t arg;
+} sim_op_t;
+
+#define SIM_COMPUTE(cycles) {SIM_OP_COMPUTE, 0, (cycles)}
+#define SIM_DELAY(ticks) {SIM_OP_DELAY, 0, (ticks)}
+#define SIM_DELAY_UNTIL(period) {SIM_OP_DELAY_UNTIL, 0, (period)}
+#define SIM_YIELD() {SIM_OP_YIELD, 0, 0}
+#define SIM_SEM_WAIT(sem, timeout) {SIM_OP_SEM_WAIT, (sem), (timeout)}
+#define SIM_SEM_POST(sem) {SIM_OP_SEM_POST, (sem), 0}
+#define SIM_QUEUE_SEND(q, timeout) {SIM_OP_QUEUE_SEND, (q), (timeout)}
+#define SIM_QUEUE_RECEIVE(q, timeout) {SIM_OP_QUEUE_RECEIVE, (q), (timeout)}
+#define SIM_MUTEX_LOCK(m, timeout) {SIM_OP_MUTEX_LOCK, (m), (timeout)}
+#define SIM_MUTEX_UNLOCK(m) {SIM_OP_MUTEX_UNLOCK, (m), 0}
+
+// A task runs its script over and over. Each pass is one job. A job is
+// released when the delays, semaphore waits and queue receives at the head
+// of the script are satisfied (at the start of the pass if it has none)
+// and completes at the end of the pass. Response time is completion minus
+// release, so mutex and full-queue blocking inside the job counts.
+typedef struct sim_task {
+  const char *name;
+  task_priority_t priority;
+  const sim_op_t *ops;
+  size_t op_count;
+  uint32_t jobs; // Passes to run before parking, 0 = no limit
+} sim_task_t;
+
+// An interrupt asserted at `start` and then every `period` cycles (0 =
+// once). The handler runs for `cycles` and then performs `action`, which
+// must be SIM_OP_SEM_POST or SIM_OP_QUEUE_SEND (never blocks).
+typedef struct sim_irq {
+  uint64_t start;
+  uint64_t period;
+  uint32_t cycles;
+  sim_op_t action;
+} sim_irq_t;
+
+typedef struct sim_scenario {
+  const sim_task_t *tasks;
+  size_t task_count;
+  const sim_irq_t *irqs;
+  size_t irq_count;
+  size_t semaphore_count;
+  size_t queue_count;
+  size_t mutex_count;
+  uint32_t switch_cycles; // Charged to every context switch
+  uint64_t duration;      // Cycles to simulate
+} sim_scenario_t;
+
+typedef struct sim_task_result {
+  const char *name;
+  uint32_t jobs;              // Completed passes
+  uint32_t deadline_misses;   // DELAY_UNTIL found its release already past
+  uint64_t response_min;      // Cycles, release -> end of pass
+  uint64_t response_max;      //
+  uint64_t response_total;    // Divide by jobs for the mean
+  uint32_t run_count;         // Times switched in
+  uint64_t runtime_cycles;    // CPU time, interrupts excluded
+  uint64_t blocked_cycles;    // Time spent blocked, all wake reasons
+  uint32_t wakeup_max_cycles; // Worst made-ready -> running latency
+} sim_task_result_t;
+
+typedef struct sim_result {
+  uint64_t cycles; // Simulated time
+  uint32_t ticks;
+  uint32_t irqs;             // Interrupt handlers run
+  uint32_t context_switches; // Including the first task
+  uint64_t idle_cycles;
+  uint64_t isr_cycles;
+  uint32_t cpu_load; // kernel_get_cpu_load() at the end, permille
+  size_t task_count;
+  sim_task_result_t tasks[SIM_MAX_TASKS];
+} sim_result_t;
+
+// Boots the kernel on the scenario and runs it for scenario->duration
+// cycles. The kernel cannot be re-initialised, so this works once per
+// process; fork() for parameter sweeps. Returns false on a bad scenario or
+// a second call.
+bool sim_run(const sim_scenario_t *scenario, sim_result_t *result);
+
+// Current virtual time in cycles, for code running inside the simulation
+uint64_t sim_now(void);
+
+// One CSV line per task, all times in cycles:
+//   sim,<name>,<jobs>,<resp_min>,<resp_avg>,<resp_max>,<misses>,
+//       <run_count>,<runtime>,<blocked>,<wakeup_max>
+// then sim_total,<cycles>,<ticks>,<irqs>,<switches>,<idle>,<isr>,<load>
+void sim_print_result(const sim_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_H
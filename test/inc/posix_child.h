@@ -0,0 +1,29 @@
+#ifndef POSIX_CHILD_H
+#define POSIX_CHILD_H
+
+// Runs the real kernel on the POSIX port in a forked child. kernel_start()
+// never returns, so a task in the child ends the run with _exit(): 0 for
+// pass, anything else for the check that failed.
+
+#include <stdbool.h>
+
+// A run that has not exited by then is killed and counts as a hang
+#ifndef POSIX_CHILD_TIMEOUT_MS
+#define POSIX_CHILD_TIMEOUT_MS 5000
+#endif
+
+// Exit status of a child whose kernel_start() returned
+#define POSIX_CHILD_NEVER_RETURNED 99
+
+//=============================================================================
+// POSIX CHILD HELPERS
+//=============================================================================
+
+// Forks, calls scenario() and then kernel_start() in the child, and waits.
+// Returns the child's exit status, or -1 if it crashed or hung.
+int posix_child_run(void (*scenario)(void));
+
+// Ends the child with code unless condition holds
+void posix_child_check(bool condition, int code);
+
+#endif // POSIX_CHILD_H
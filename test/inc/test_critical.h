@@ -0,0 +1,15 @@
+#ifndef TEST_CRITICAL_H
+#define TEST_CRITICAL_H
+
+//=============================================================================
+// CRITICAL SECTION PROFILER TEST DECLARATIONS
+//=============================================================================
+
+void test_critical_profile_should_start_empty(void);
+void test_critical_profile_should_record_section_length(void);
+void test_critical_profile_should_group_by_call_site(void);
+void test_critical_profile_should_sort_longest_first(void);
+void test_critical_profile_should_time_only_outermost_section(void);
+void test_critical_profile_reset_should_clear_table(void);
+
+#endif // TEST_CRITICAL_H
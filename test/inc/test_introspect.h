@@ -0,0 +1,16 @@
+#ifndef TEST_INTROSPECT_H
+#define TEST_INTROSPECT_H
+
+//=============================================================================
+// KERNEL INTROSPECTION TEST DECLARATIONS
+//=============================================================================
+
+void test_introspect_should_reject_null_arguments(void);
+void test_introspect_should_walk_every_task(void);
+void test_introspect_should_report_queue_fill(void);
+void test_introspect_should_report_semaphore_and_mutex(void);
+void test_introspect_should_skip_deleted_objects(void);
+void test_introspect_should_classify_objects(void);
+void test_introspect_should_report_blocked_waiter(void);
+
+#endif // TEST_INTROSPECT_H
@@ -0,0 +1,22 @@
+#ifndef TEST_KLOG_H
+#define TEST_KLOG_H
+
+//=============================================================================
+// DEFERRED LOG TEST DECLARATIONS
+//=============================================================================
+
+// Ring tests
+void test_klog_init_should_fill_header(void);
+void test_klog_should_store_format_id_and_args(void);
+void test_klog_should_drop_when_full(void);
+void test_klog_should_reuse_drained_words_across_laps(void);
+void test_klog_drain_should_stop_at_incomplete_record(void);
+void test_klog_should_survive_interrupting_producers(void);
+
+// Formatting tests
+void test_klog_format_should_render_integer_conversions(void);
+void test_klog_format_should_unpack_strings(void);
+void test_klog_format_should_truncate_to_buffer(void);
+void test_pool_print_stats_should_log_table(void);
+
+#endif // TEST_KLOG_H
@@ -0,0 +1,16 @@
+#ifndef TEST_LATENCY_H
+#define TEST_LATENCY_H
+
+//=============================================================================
+// WAKEUP LATENCY TEST DECLARATIONS
+//=============================================================================
+
+void test_latency_stats_should_start_empty(void);
+void test_latency_stats_should_record_wakeup_latency(void);
+void test_latency_stats_should_count_only_real_wakeups(void);
+void test_latency_stats_should_split_blocked_time_by_reason(void);
+void test_latency_histogram_percentile_should_bound_samples(void);
+void test_latency_stats_reset_should_clear(void);
+void test_latency_stats_should_handle_null(void);
+
+#endif // TEST_LATENCY_H
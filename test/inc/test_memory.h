@@ -33,6 +33,7 @@ void test_task_pool_alloc_stack_should_select_appropriate_size(void);
 void test_pool_alloc_should_handle_invalid_pool_type(void);
 void test_pool_free_should_handle_invalid_pool_type(void);
 void test_pool_get_stats_should_handle_invalid_pool_type(void);
+void test_pool_should_be_empty_when_compiled_out(void);
 
 // Stress tests
 void test_pool_should_handle_allocation_deallocation_cycles(void);
@@ -41,6 +42,14 @@ void test_pool_should_maintain_consistency_across_multiple_types(void);
 // Integration tests
 void test_task_stack_allocation_integration(void);
 
+// Guard word tests
+void test_pool_free_should_reject_interior_pointer(void);
+void test_pool_free_should_detect_overrun_into_guard(void);
+void test_pool_free_should_detect_underrun_into_guard(void);
+void test_pool_integrity_scan_should_pass_on_clean_pools(void);
+void test_pool_integrity_scan_should_detect_corruption(void);
+void test_pool_integrity_scan_should_detect_write_after_free(void);
+
 // Module setup/teardown
 void memory_test_setup(void);
 void memory_test_teardown(void);
@@ -25,6 +25,7 @@ void test_mutex_lock_should_timeout_when_unavailable(void);
 void test_mutex_lock_should_timeout_when_deadline_exceeded(void);
 void test_mutex_lock_should_handle_mutex_deletion_while_waiting(void);
 void test_mutex_lock_should_handle_infinite_timeout(void);
+void test_mutex_lock_forever_should_block_until_unlocked(void);
 
 // Ownership tests
 void test_mutex_get_owner_should_return_current_owner(void);
@@ -34,6 +35,7 @@ void test_mutex_is_locked_should_reflect_lock_state(void);
 // Priority inheritance tests
 void test_mutex_should_apply_priority_inheritance(void);
 void test_mutex_should_restore_priority_on_unlock(void);
+void test_mutex_unlock_should_requeue_owner_at_base_priority(void);
 void test_mutex_should_restore_priority_on_delete(void);
 
 // Waiting tasks tests
@@ -56,6 +58,6 @@ void test_mutex_unlock_without_lock_should_fail(void);
 // Module setup/teardown and test runner
 void mutex_test_setup(void);
 void mutex_test_teardown(void);
-void run_mutex_tests(void);
+int run_mutex_tests(void);
 
 #endif // TEST_MUTEX_H
@@ -0,0 +1,19 @@
+#ifndef TEST_PORT_POSIX_H
+#define TEST_PORT_POSIX_H
+
+//=============================================================================
+// POSIX HOST PORT TEST DECLARATIONS
+//=============================================================================
+
+void test_posix_port_should_run_highest_priority_first(void);
+void test_posix_port_should_wake_delayed_task_on_time(void);
+void test_posix_port_should_program_one_hertz_tick(void);
+void test_posix_port_should_time_slice_equal_priorities(void);
+void test_posix_port_should_defer_tick_in_critical_section(void);
+void test_posix_port_should_ping_pong_semaphores(void);
+void test_posix_port_should_time_out_semaphore_wait(void);
+void test_posix_port_should_pass_queue_items_in_order(void);
+void test_posix_port_should_inherit_and_restore_mutex_priority(void);
+void test_posix_port_should_wake_task_from_interrupt(void);
+
+#endif // TEST_PORT_POSIX_H
@@ -0,0 +1,16 @@
+#ifndef TEST_PROFILE_H
+#define TEST_PROFILE_H
+
+//=============================================================================
+// PC-SAMPLING PROFILER TEST DECLARATIONS
+//=============================================================================
+
+void test_profile_should_describe_layout_in_header(void);
+void test_profile_should_count_repeated_samples_once(void);
+void test_profile_should_key_samples_by_task(void);
+void test_profile_should_record_task_names(void);
+void test_profile_should_drop_when_probes_run_out(void);
+void test_profile_should_clear_on_reset(void);
+void test_profile_should_sample_running_task_on_tick(void);
+
+#endif // TEST_PROFILE_H
@@ -0,0 +1,13 @@
+#ifndef TEST_REPLAY_H
+#define TEST_REPLAY_H
+
+//=============================================================================
+// RECORD/REPLAY TEST DECLARATIONS
+//=============================================================================
+
+void test_replay_should_reproduce_recorded_run(void);
+void test_replay_should_report_divergence_after_change(void);
+void test_replay_should_reject_trace_for_missing_objects(void);
+void test_replay_should_stop_recording_when_buffer_fills(void);
+
+#endif // TEST_REPLAY_H
@@ -0,0 +1,15 @@
+#ifndef TEST_SCHEDULER_H
+#define TEST_SCHEDULER_H
+
+//=============================================================================
+// SCHEDULER TEST DECLARATIONS
+//=============================================================================
+
+void test_scheduler_should_wake_delay_on_its_nth_tick(void);
+void test_scheduler_should_wake_on_tick_zero(void);
+void test_scheduler_should_wake_delay_armed_before_the_wrap(void);
+void test_scheduler_should_requeue_running_task_on_priority_change(void);
+void test_scheduler_should_not_rotate_on_pick(void);
+void test_scheduler_should_rotate_equal_priorities_on_tick(void);
+
+#endif // TEST_SCHEDULER_H
@@ -26,8 +26,10 @@ void test_counting_semaphore_basic_operations(void);
 void test_sem_wait_should_succeed_when_tokens_available(void);
 void test_sem_wait_should_timeout_when_no_tokens(void);
 void test_sem_wait_should_return_timeout_when_deadline_exceeded(void);
+void test_sem_wait_forever_should_block_until_posted(void);
 void test_sem_wait_should_handle_semaphore_deletion(void);
 void test_sem_post_should_increment_count(void);
+void test_sem_post_should_hand_unit_to_waiter(void);
 void test_sem_post_should_prevent_overflow(void);
 
 // Error handling tests
@@ -0,0 +1,19 @@
+#ifndef TEST_SIM_H
+#define TEST_SIM_H
+
+//=============================================================================
+// DISCRETE-EVENT SIMULATOR TEST DECLARATIONS
+//=============================================================================
+
+void test_sim_should_release_periodic_task_on_every_tick(void);
+void test_sim_should_charge_switch_cost_to_preempting_task(void);
+void test_sim_should_count_overrun_as_deadline_miss(void);
+void test_sim_should_run_task_woken_from_idle_at_once(void);
+void test_sim_should_not_preempt_busy_task_until_next_tick(void);
+void test_sim_should_bound_inversion_with_priority_inheritance(void);
+void test_sim_should_account_runtime_per_task(void);
+void test_sim_should_report_load_over_sliding_window(void);
+void test_sim_should_repeat_runs_bit_for_bit(void);
+void test_sim_should_reject_unknown_objects(void);
+
+#endif // TEST_SIM_H
@@ -0,0 +1,16 @@
+#ifndef TEST_SWTIMER_H
+#define TEST_SWTIMER_H
+
+//=============================================================================
+// SOFTWARE TIMER TEST DECLARATIONS
+//=============================================================================
+
+void test_swtimer_should_reject_bad_arguments(void);
+void test_swtimer_should_fire_one_shot_once(void);
+void test_swtimer_should_fire_periodic_without_drift(void);
+void test_swtimer_should_fire_beyond_one_turn_of_the_wheel(void);
+void test_swtimer_should_stop_start_and_reset(void);
+void test_swtimer_should_run_callbacks_in_timer_task(void);
+void test_swtimer_should_drop_queued_commands_of_deleted_timer(void);
+
+#endif // TEST_SWTIMER_H
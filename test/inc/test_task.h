@@ -24,6 +24,7 @@ void test_task_delete_should_allow_reallocation(void);
 
 // Task state management tests
 void test_task_set_state_should_update_state(void);
+void test_task_set_state_should_dequeue_blocked_task(void);
 void test_task_set_state_should_handle_null_task(void);
 void test_task_get_state_should_return_current_state(void);
 void test_task_get_state_should_return_deleted_for_null_task(void);
@@ -33,10 +34,15 @@ void test_task_init_stack_should_setup_cortex_m4_stack(void);
 void test_task_init_stack_should_set_function_address(void);
 void test_task_init_stack_should_set_parameter_in_r0(void);
 void test_task_init_stack_should_set_psr_thumb_bit(void);
+void test_task_init_stack_should_set_initial_exc_return(void);
 void test_task_stack_check_should_detect_valid_stack(void);
 void test_task_stack_check_should_handle_null_task(void);
 void test_task_stack_used_bytes_should_calculate_correctly(void);
 void test_task_stack_used_bytes_should_handle_null_task(void);
+void test_task_stack_high_water_should_cover_initial_frame(void);
+void test_task_stack_high_water_should_track_deepest_word(void);
+void test_task_stack_high_water_should_handle_null_task(void);
+void test_task_stack_sweep_should_record_min_headroom(void);
 
 // Task properties tests
 void test_task_should_store_name_correctly(void);
@@ -0,0 +1,16 @@
+#ifndef TEST_TELEMETRY_H
+#define TEST_TELEMETRY_H
+
+//=============================================================================
+// TELEMETRY SNAPSHOT TEST DECLARATIONS
+//=============================================================================
+
+void test_telemetry_should_reject_bad_buffers(void);
+void test_telemetry_should_fill_header(void);
+void test_telemetry_should_report_every_pool(void);
+void test_telemetry_should_report_tasks(void);
+void test_telemetry_should_report_queue_semaphore_and_mutex(void);
+void test_telemetry_should_keep_entries_whole_when_truncated(void);
+void test_telemetry_should_report_runtime_while_running(void);
+
+#endif // TEST_TELEMETRY_H
@@ -0,0 +1,20 @@
+#ifndef TEST_TIME_H
+#define TEST_TIME_H
+
+//=============================================================================
+// TIME BASE AND CLOCK TEST DECLARATIONS
+//=============================================================================
+
+void test_time_should_convert_durations_to_ticks_rounding_up(void);
+void test_time_should_convert_ticks_and_cycles_to_time(void);
+void test_time_should_clamp_deadlines_to_timeouts(void);
+void test_time_should_extend_tick_count_across_wrap(void);
+void test_time_should_keep_cycle_time_monotonic(void);
+void test_time_should_block_until_absolute_deadline(void);
+void test_time_should_convert_at_any_tick_rate(void);
+void test_time_should_follow_runtime_tick_rate(void);
+void test_time_should_saturate_long_durations(void);
+void test_time_should_rescale_armed_timeouts_on_clock_change(void);
+void test_time_should_convert_latency_after_clock_change(void);
+
+#endif // TEST_TIME_H
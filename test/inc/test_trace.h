@@ -0,0 +1,24 @@
+#ifndef TEST_TRACE_H
+#define TEST_TRACE_H
+
+//=============================================================================
+// TRACE RECORDER TEST DECLARATIONS
+//=============================================================================
+
+// Recorder tests
+void test_trace_init_should_fill_header(void);
+void test_trace_should_ignore_events_when_stopped(void);
+void test_trace_record_should_store_fields(void);
+void test_trace_should_wrap_and_keep_counting(void);
+void test_trace_clear_should_reset_ring(void);
+void test_trace_sink_should_see_each_record(void);
+void test_trace_stream_should_write_header_and_records(void);
+void test_trace_stream_should_write_through_from_signal_handler(void);
+
+// Kernel hook tests
+void test_trace_start_should_emit_task_names(void);
+void test_trace_should_name_tasks_created_while_running(void);
+void test_trace_should_record_task_create_and_block(void);
+void test_trace_should_record_pool_alloc_and_free(void);
+
+#endif // TEST_TRACE_H
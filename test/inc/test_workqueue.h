@@ -0,0 +1,15 @@
+#ifndef TEST_WORKQUEUE_H
+#define TEST_WORKQUEUE_H
+
+//=============================================================================
+// WORK QUEUE TEST DECLARATIONS
+//=============================================================================
+
+void test_workqueue_should_reject_null_arguments(void);
+void test_workqueue_should_coalesce_resubmits(void);
+void test_workqueue_should_cancel_queued_work(void);
+void test_workqueue_should_run_interrupt_work_in_worker(void);
+void test_workqueue_should_run_delayed_work_when_due(void);
+void test_workqueue_should_run_higher_priority_queue_first(void);
+
+#endif // TEST_WORKQUEUE_H
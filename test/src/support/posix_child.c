@@ -0,0 +1,37 @@
+#include "posix_child.h"
+#include "kernel.h"
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int posix_child_run(void (*scenario)(void)) {
+  fflush(stdout);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    setvbuf(stdout, NULL, _IONBF, 0);
+    scenario();
+    kernel_start();
+    _exit(POSIX_CHILD_NEVER_RETURNED);
+  }
+
+  for (int waited = 0; waited < POSIX_CHILD_TIMEOUT_MS; waited += 10) {
+    int status;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+      return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+    usleep(10 * 1000);
+  }
+
+  // Hung: deadlock or lost wakeup
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  return -1;
+}
+
+void posix_child_check(bool condition, int code) {
+  if (!condition) {
+    _exit(code);
+  }
+}
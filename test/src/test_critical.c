@@ -0,0 +1,114 @@
+#include "critical.h"
+#include "port.h"
+#include "test_critical.h"
+#include "unity.h"
+#include <stdint.h>
+#include <string.h>
+
+// Busy-wait so a section has a known minimum length
+static void spin_cycles(uint32_t cycles) {
+  uint32_t start = port_cycle_count();
+  while (port_cycle_count() - start < cycles) {
+  }
+}
+
+// Each helper is its own call site
+__attribute__((noinline)) static void short_section(void) {
+  KERNEL_CRITICAL_BEGIN();
+  spin_cycles(1000);
+  KERNEL_CRITICAL_END();
+}
+
+__attribute__((noinline)) static void long_section(void) {
+  KERNEL_CRITICAL_BEGIN();
+  spin_cycles(200000);
+  KERNEL_CRITICAL_END();
+}
+
+__attribute__((noinline)) static void nested_section(void) {
+  KERNEL_CRITICAL_BEGIN();
+  short_section();
+  spin_cycles(50000);
+  KERNEL_CRITICAL_END();
+}
+
+void setUp(void) { critical_profile_reset(); }
+
+void tearDown(void) {}
+
+//=============================================================================
+// CRITICAL SECTION PROFILER TESTS
+//=============================================================================
+
+void test_critical_profile_should_start_empty(void) {
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  TEST_ASSERT_EQUAL(0, critical_profile_get(top, CRITICAL_PROFILE_SLOTS));
+  TEST_ASSERT_EQUAL(0, critical_profile_worst_cycles());
+}
+
+void test_critical_profile_should_record_section_length(void) {
+  long_section();
+
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  TEST_ASSERT_EQUAL(1, critical_profile_get(top, CRITICAL_PROFILE_SLOTS));
+  TEST_ASSERT_NOT_EQUAL(0, top[0].site);
+  TEST_ASSERT_GREATER_OR_EQUAL(200000, top[0].max_cycles);
+  TEST_ASSERT_EQUAL(1, top[0].count);
+  TEST_ASSERT_EQUAL(top[0].max_cycles, critical_profile_worst_cycles());
+}
+
+void test_critical_profile_should_group_by_call_site(void) {
+  for (int i = 0; i < 5; i++) {
+    short_section();
+  }
+
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  TEST_ASSERT_EQUAL(1, critical_profile_get(top, CRITICAL_PROFILE_SLOTS));
+  TEST_ASSERT_EQUAL(5, top[0].count);
+  TEST_ASSERT_GREATER_OR_EQUAL(5 * 1000, top[0].total_cycles);
+}
+
+void test_critical_profile_should_sort_longest_first(void) {
+  short_section();
+  long_section();
+
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  TEST_ASSERT_EQUAL(2, critical_profile_get(top, CRITICAL_PROFILE_SLOTS));
+  TEST_ASSERT_GREATER_THAN(top[1].max_cycles, top[0].max_cycles);
+  TEST_ASSERT_NOT_EQUAL(top[0].site, top[1].site);
+
+  // A short output buffer gets only the worst sites
+  critical_profile_entry_t worst;
+  TEST_ASSERT_EQUAL(1, critical_profile_get(&worst, 1));
+  TEST_ASSERT_EQUAL(top[0].site, worst.site);
+}
+
+void test_critical_profile_should_time_only_outermost_section(void) {
+  nested_section();
+
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  TEST_ASSERT_EQUAL(1, critical_profile_get(top, CRITICAL_PROFILE_SLOTS));
+  // Covers the inner section and the spin after it
+  TEST_ASSERT_GREATER_OR_EQUAL(51000, top[0].max_cycles);
+}
+
+void test_critical_profile_reset_should_clear_table(void) {
+  long_section();
+  critical_profile_reset();
+
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  TEST_ASSERT_EQUAL(0, critical_profile_get(top, CRITICAL_PROFILE_SLOTS));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_critical_profile_should_start_empty);
+  RUN_TEST(test_critical_profile_should_record_section_length);
+  RUN_TEST(test_critical_profile_should_group_by_call_site);
+  RUN_TEST(test_critical_profile_should_sort_longest_first);
+  RUN_TEST(test_critical_profile_should_time_only_outermost_section);
+  RUN_TEST(test_critical_profile_reset_should_clear_table);
+
+  return UNITY_END();
+}
@@ -0,0 +1,233 @@
+#include "introspect.h"
+#include "kernel.h"
+#include "memory.h"
+#include "posix_child.h"
+#include "test_introspect.h"
+#include "unity.h"
+#include <string.h>
+#include <unistd.h>
+
+// Walks run over a kernel that is initialised but not started, except for
+// the blocked-waiter test, which runs the kernel in a forked child
+// (posix_child.h).
+
+static task_handle_t worker;
+static queue_handle_t queue;
+static semaphore_handle_t sem;
+static mutex_handle_t mutex;
+
+static void dummy_task(void *param) {
+  (void)param;
+  while (1) {
+  }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_introspect_should_reject_null_arguments(void) {
+  size_t cursor = 0;
+  task_info_t task;
+  queue_info_t q;
+  sem_info_t s;
+  mutex_info_t m;
+
+  TEST_ASSERT_FALSE(introspect_task_next(NULL, &task));
+  TEST_ASSERT_FALSE(introspect_task_next(&cursor, NULL));
+  TEST_ASSERT_FALSE(introspect_queue_next(&cursor, NULL));
+  TEST_ASSERT_FALSE(introspect_sem_next(&cursor, NULL));
+  TEST_ASSERT_FALSE(introspect_mutex_next(&cursor, NULL));
+  TEST_ASSERT_FALSE(introspect_queue_next(NULL, &q));
+  TEST_ASSERT_FALSE(introspect_sem_next(NULL, &s));
+  TEST_ASSERT_FALSE(introspect_mutex_next(NULL, &m));
+}
+
+void test_introspect_should_walk_every_task(void) {
+  size_t cursor = 0;
+  size_t count = 0;
+  bool saw_worker = false;
+  bool saw_idle = false;
+  task_info_t info;
+
+  while (introspect_task_next(&cursor, &info)) {
+    TEST_ASSERT_EQUAL(info.slot + 1, cursor);
+    TEST_ASSERT_EQUAL(pool_index_of(POOL_TCB, info.handle), info.slot);
+    TEST_ASSERT_TRUE(info.stack_used > 0);
+    TEST_ASSERT_TRUE(info.stack_used <= info.stack_size);
+    TEST_ASSERT_NULL(info.waiting_on);
+    TEST_ASSERT_EQUAL(KERNEL_OBJECT_NONE, info.waiting_on_type);
+
+    if (info.handle == worker) {
+      saw_worker = true;
+      TEST_ASSERT_EQUAL_STRING("worker", info.name);
+      TEST_ASSERT_EQUAL(TASK_READY, info.state);
+      TEST_ASSERT_EQUAL(3, info.base_priority);
+      TEST_ASSERT_EQUAL(3, info.effective_priority);
+      TEST_ASSERT_EQUAL(worker->stack_size, info.stack_size);
+      TEST_ASSERT_EQUAL(worker->stack_min_headroom, info.stack_headroom);
+    } else if (info.handle == kernel_get_idle_task()) {
+      saw_idle = true;
+      TEST_ASSERT_EQUAL(MAX_PRIORITY, info.base_priority);
+    }
+    count++;
+  }
+
+  TEST_ASSERT_TRUE(saw_worker);
+  TEST_ASSERT_TRUE(saw_idle);
+  TEST_ASSERT_EQUAL(pool_get_stats(POOL_TCB).used_objects, count);
+
+  // An exhausted cursor stays exhausted
+  TEST_ASSERT_FALSE(introspect_task_next(&cursor, &info));
+}
+
+void test_introspect_should_report_queue_fill(void) {
+  uint32_t item = 7;
+  queue_send_immediate(queue, &item);
+  queue_send_immediate(queue, &item);
+  queue_send_immediate(queue, &item);
+
+  size_t cursor = 0;
+  queue_info_t info;
+  TEST_ASSERT_TRUE(introspect_queue_next(&cursor, &info));
+  TEST_ASSERT_EQUAL_PTR(queue, info.handle);
+  TEST_ASSERT_EQUAL(pool_index_of(POOL_QCB, queue), info.slot);
+  TEST_ASSERT_EQUAL(3, info.messages);
+  TEST_ASSERT_EQUAL(4, info.capacity);
+  TEST_ASSERT_EQUAL(sizeof(uint32_t), info.item_size);
+  TEST_ASSERT_EQUAL(0, info.waiting_senders);
+  TEST_ASSERT_EQUAL(0, info.waiting_receivers);
+  TEST_ASSERT_FALSE(introspect_queue_next(&cursor, &info));
+
+  while (queue_receive_immediate(queue, &item) == QUEUE_SUCCESS) {
+  }
+}
+
+void test_introspect_should_report_semaphore_and_mutex(void) {
+  size_t cursor = 0;
+  sem_info_t s;
+  TEST_ASSERT_TRUE(introspect_sem_next(&cursor, &s));
+  TEST_ASSERT_EQUAL_PTR(sem, s.handle);
+  TEST_ASSERT_EQUAL_STRING("rx_done", s.name);
+  TEST_ASSERT_EQUAL(1, s.count);
+  TEST_ASSERT_EQUAL(5, s.max_count);
+  TEST_ASSERT_EQUAL(0, s.waiting_tasks);
+
+  cursor = 0;
+  mutex_info_t m;
+  TEST_ASSERT_TRUE(introspect_mutex_next(&cursor, &m));
+  TEST_ASSERT_EQUAL_PTR(mutex, m.handle);
+  TEST_ASSERT_EQUAL_STRING("bus", m.name);
+  TEST_ASSERT_NULL(m.owner);
+  TEST_ASSERT_EQUAL(-1, m.owner_slot);
+
+  mutex->owner = worker;
+  cursor = 0;
+  TEST_ASSERT_TRUE(introspect_mutex_next(&cursor, &m));
+  TEST_ASSERT_EQUAL_PTR(worker, m.owner);
+  TEST_ASSERT_EQUAL(pool_index_of(POOL_TCB, worker), m.owner_slot);
+  mutex->owner = NULL;
+}
+
+void test_introspect_should_skip_deleted_objects(void) {
+  semaphore_handle_t extra = sem_create(0, 1, "extra");
+  TEST_ASSERT_NOT_NULL(extra);
+
+  size_t cursor = 0;
+  size_t count = 0;
+  sem_info_t info;
+  while (introspect_sem_next(&cursor, &info)) {
+    count++;
+  }
+  TEST_ASSERT_EQUAL(2, count);
+
+  sem_delete(extra);
+  cursor = 0;
+  count = 0;
+  while (introspect_sem_next(&cursor, &info)) {
+    TEST_ASSERT_NOT_EQUAL(extra, info.handle);
+    count++;
+  }
+  TEST_ASSERT_EQUAL(1, count);
+}
+
+void test_introspect_should_classify_objects(void) {
+  int local;
+
+  TEST_ASSERT_EQUAL(KERNEL_OBJECT_NONE, introspect_object_type(NULL));
+  TEST_ASSERT_EQUAL(KERNEL_OBJECT_QUEUE, introspect_object_type(queue));
+  TEST_ASSERT_EQUAL(KERNEL_OBJECT_SEMAPHORE, introspect_object_type(sem));
+  TEST_ASSERT_EQUAL(KERNEL_OBJECT_MUTEX, introspect_object_type(mutex));
+  TEST_ASSERT_EQUAL(KERNEL_OBJECT_UNKNOWN, introspect_object_type(&local));
+}
+
+static semaphore_handle_t gate;
+static task_handle_t waiter;
+
+static void waiter_task(void *param) {
+  (void)param;
+  sem_wait(gate, 1000);
+  _exit(10); // The checker should have exited first
+}
+
+static void checker_task(void *param) {
+  (void)param;
+  size_t cursor = 0;
+  task_info_t info;
+  bool found = false;
+
+  while (introspect_task_next(&cursor, &info)) {
+    if (info.handle == task_get_current()) {
+      posix_child_check(info.state == TASK_RUNNING, 1);
+    }
+    if (info.handle != waiter) continue;
+    found = true;
+    posix_child_check(info.state == TASK_BLOCKED, 2);
+    posix_child_check(info.waiting_on == gate, 3);
+    posix_child_check(info.waiting_on_type == KERNEL_OBJECT_SEMAPHORE, 4);
+    posix_child_check(info.wake_tick != 0, 5);
+  }
+  posix_child_check(found, 6);
+
+  sem_info_t s;
+  cursor = 0;
+  do {
+    posix_child_check(introspect_sem_next(&cursor, &s), 7);
+  } while (s.handle != gate);
+  posix_child_check(s.waiting_tasks == 1, 8);
+  _exit(0);
+}
+
+static void waiter_scenario(void) {
+  gate = sem_create(0, 1, "gate");
+  waiter = task_create(waiter_task, "waiter", 0, NULL, 1);
+  task_create(checker_task, "checker", 0, NULL, 2);
+}
+
+void test_introspect_should_report_blocked_waiter(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(waiter_scenario));
+}
+
+int main(void) {
+  kernel_init();
+  worker = task_create(dummy_task, "worker", 0, NULL, 3);
+  queue = queue_create(4, sizeof(uint32_t));
+  sem = sem_create(1, 5, "rx_done");
+  mutex = mutex_create("bus");
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_introspect_should_reject_null_arguments);
+  RUN_TEST(test_introspect_should_walk_every_task);
+  RUN_TEST(test_introspect_should_report_queue_fill);
+  RUN_TEST(test_introspect_should_report_semaphore_and_mutex);
+  RUN_TEST(test_introspect_should_skip_deleted_objects);
+  RUN_TEST(test_introspect_should_classify_objects);
+  RUN_TEST(test_introspect_should_report_blocked_waiter);
+
+  return UNITY_END();
+}
@@ -0,0 +1,269 @@
+#include "klog.h"
+#include "memory.h"
+#include "test_klog.h"
+#include "unity.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+
+// Sink capture
+#define CAPTURE_RECORDS 64
+
+static klog_record_t captured[CAPTURE_RECORDS];
+static size_t captured_count;
+static char text[2048];
+
+static void capture_sink(const klog_record_t *record) {
+  if (captured_count < CAPTURE_RECORDS) {
+    captured[captured_count] = *record;
+  }
+  captured_count++;
+}
+
+static void text_sink(const klog_record_t *record) {
+  size_t len = strlen(text);
+  klog_format(record, text + len, sizeof(text) - len);
+}
+
+// Helper: format of a single record written now
+static const char *format_one(const klog_record_t *record) {
+  static char line[128];
+  klog_format(record, line, sizeof(line));
+  return line;
+}
+
+void setUp(void) {
+  klog_init();
+  captured_count = 0;
+  text[0] = '\0';
+}
+
+void tearDown(void) {}
+
+//=============================================================================
+// RING TESTS
+//=============================================================================
+
+void test_klog_init_should_fill_header(void) {
+  TEST_ASSERT_EQUAL_HEX32(KLOG_MAGIC, klog_ram.header.magic);
+  TEST_ASSERT_EQUAL(KLOG_VERSION, klog_ram.header.version);
+  TEST_ASSERT_EQUAL(sizeof(klog_header_t), klog_ram.header.header_size);
+  TEST_ASSERT_EQUAL(KLOG_BUFFER_WORDS, klog_ram.header.capacity);
+  TEST_ASSERT_EQUAL(0, klog_ram.header.head);
+  TEST_ASSERT_EQUAL(0, klog_ram.header.tail);
+  TEST_ASSERT_EQUAL(0, klog_dropped());
+}
+
+void test_klog_should_store_format_id_and_args(void) {
+  KLOG("first %u\n", 7);
+  KLOG("second %u %u\n", 0xDEADBEEF, 42);
+  KLOG("third\n");
+
+  TEST_ASSERT_EQUAL(3 * KLOG_RECORD_WORDS + 3, klog_ram.header.head);
+  TEST_ASSERT_EQUAL(3, klog_drain(capture_sink, 8));
+  TEST_ASSERT_EQUAL(klog_ram.header.head, klog_ram.header.tail);
+
+  TEST_ASSERT_EQUAL(1, captured[0].count);
+  TEST_ASSERT_EQUAL_HEX32(7, captured[0].args[0]);
+  TEST_ASSERT_EQUAL(2, captured[1].count);
+  TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, captured[1].args[0]);
+  TEST_ASSERT_EQUAL_HEX32(42, captured[1].args[1]);
+  TEST_ASSERT_EQUAL(0, captured[2].count);
+
+  // The id is where the format sits in the section
+  TEST_ASSERT_EQUAL_STRING("first %u\n", __start_klog_fmt + captured[0].format);
+  TEST_ASSERT_EQUAL_STRING("third\n", __start_klog_fmt + captured[2].format);
+  TEST_ASSERT_TRUE(captured[2].timestamp - captured[0].timestamp < 1000000000u);
+}
+
+void test_klog_should_drop_when_full(void) {
+  uint32_t words = KLOG_RECORD_WORDS + 1;
+  uint32_t fits = KLOG_BUFFER_WORDS / words;
+
+  for (uint32_t i = 0; i < fits + 5; i++) {
+    KLOG("%u\n", i);
+  }
+
+  TEST_ASSERT_EQUAL(5, klog_dropped());
+  TEST_ASSERT_EQUAL(fits * words, klog_ram.header.head);
+
+  // The oldest records survive, the newest were dropped
+  TEST_ASSERT_EQUAL(fits, klog_drain(capture_sink, (size_t)-1));
+  TEST_ASSERT_EQUAL(0, captured[0].args[0]);
+  TEST_ASSERT_EQUAL(CAPTURE_RECORDS - 1, captured[CAPTURE_RECORDS - 1].args[0]);
+
+  KLOG("%u\n", 99u);
+  TEST_ASSERT_EQUAL(1, klog_drain(capture_sink, 1));
+  TEST_ASSERT_EQUAL(5, klog_dropped());
+}
+
+void test_klog_should_reuse_drained_words_across_laps(void) {
+  // 7-word records do not divide the ring, so they straddle its end
+  for (uint32_t i = 0; i < 3 * KLOG_BUFFER_WORDS; i++) {
+    KLOG("%u %u %u %u\n", i, ~i, i * 3, i ^ 0x5A5A5A5A);
+    captured_count = 0;
+    TEST_ASSERT_EQUAL(1, klog_drain(capture_sink, 4));
+    TEST_ASSERT_EQUAL(4, captured[0].count);
+    TEST_ASSERT_EQUAL(i, captured[0].args[0]);
+    TEST_ASSERT_EQUAL(~i, captured[0].args[1]);
+    TEST_ASSERT_EQUAL(i * 3, captured[0].args[2]);
+    TEST_ASSERT_EQUAL(i ^ 0x5A5A5A5A, captured[0].args[3]);
+  }
+  TEST_ASSERT_EQUAL(0, klog_dropped());
+  TEST_ASSERT_EQUAL(0, klog_drain(capture_sink, 4));
+}
+
+void test_klog_drain_should_stop_at_incomplete_record(void) {
+  KLOG("done %u\n", 1);
+
+  // A producer interrupted between claiming its words and tagging them
+  uint32_t pending = klog_ram.header.head;
+  klog_ram.header.head += KLOG_RECORD_WORDS;
+
+  KLOG("after %u\n", 2);
+
+  TEST_ASSERT_EQUAL(1, klog_drain(capture_sink, 8));
+  TEST_ASSERT_EQUAL(1, captured[0].args[0]);
+  TEST_ASSERT_EQUAL(0, klog_drain(capture_sink, 8));
+
+  // Once it completes, both come out in claim order
+  klog_ram.words[(pending + 1) % KLOG_BUFFER_WORDS] = 0;
+  klog_ram.words[pending % KLOG_BUFFER_WORDS] = ~pending;
+  TEST_ASSERT_EQUAL(2, klog_drain(capture_sink, 8));
+  TEST_ASSERT_EQUAL(0, captured[1].count);
+  TEST_ASSERT_EQUAL(2, captured[2].args[0]);
+}
+
+// The timer signal stands in for an interrupt landing anywhere in a
+// producer, including between its claim and its tag
+static volatile uint32_t isr_written;
+
+static void isr_logger(int sig) {
+  (void)sig;
+  uint32_t n = isr_written++;
+  KLOG("isr %u %u %u\n", 0x15500000u | n, n, ~n);
+}
+
+static uint32_t task_written;
+static uint32_t bad_records;
+static uint32_t isr_seen;
+static uint32_t task_seen;
+
+static void check_sink(const klog_record_t *record) {
+  const uint32_t *a = record->args;
+  if (record->count == 3 && (a[0] & 0xFFF00000u) == 0x15500000u) {
+    bad_records += a[1] != (a[0] & 0xFFFFF) || a[2] != ~a[1];
+    isr_seen++;
+  } else if (record->count == 2) {
+    bad_records += a[1] != a[0] * 7;
+    task_seen++;
+  } else {
+    bad_records++;
+  }
+}
+
+void test_klog_should_survive_interrupting_producers(void) {
+  struct sigaction sa = {0};
+  sa.sa_handler = isr_logger;
+  sigaction(SIGALRM, &sa, NULL);
+
+  isr_written = task_written = bad_records = isr_seen = task_seen = 0;
+  struct itimerval every = {{0, 20}, {0, 20}};
+  setitimer(ITIMER_REAL, &every, NULL);
+
+  for (uint32_t i = 0; i < 200000; i++) {
+    KLOG("task %u %u\n", i, i * 7);
+    task_written++;
+    if (i % 16 == 0) {
+      klog_drain(check_sink, (size_t)-1);
+    }
+  }
+
+  struct itimerval stop = {{0, 0}, {0, 0}};
+  setitimer(ITIMER_REAL, &stop, NULL);
+  signal(SIGALRM, SIG_DFL);
+  klog_drain(check_sink, (size_t)-1);
+
+  TEST_ASSERT_EQUAL(0, bad_records);
+  TEST_ASSERT_TRUE(isr_written > 0);
+  TEST_ASSERT_EQUAL(task_written + isr_written,
+                    task_seen + isr_seen + klog_dropped());
+  TEST_ASSERT_EQUAL(klog_ram.header.head, klog_ram.header.tail);
+}
+
+//=============================================================================
+// FORMATTING TESTS
+//=============================================================================
+
+void test_klog_format_should_render_integer_conversions(void) {
+  KLOG("%d|%5u|%-4x|%08X|%c|%o|100%%\n", -12, 34, 0xab, 0xBEEF, 'k', 8);
+  klog_drain(capture_sink, 1);
+
+  TEST_ASSERT_EQUAL_STRING("-12|   34|ab  |0000BEEF|k|10|100%\n",
+                           format_one(&captured[0]));
+}
+
+void test_klog_format_should_unpack_strings(void) {
+  const char *name = "Stack Default";
+  KLOG("[%-16s] [%.3s] %u\n", KLOG_STR(name), KLOG_STR("abcdef"), 5);
+  KLOG("[%s] [%s]\n", KLOG_STR(""), KLOG_STR("exactly16chars!!and more"));
+  klog_drain(capture_sink, 2);
+
+  TEST_ASSERT_EQUAL(2 * KLOG_STR_ARGS + 1, captured[0].count);
+  TEST_ASSERT_EQUAL_STRING("[Stack Default   ] [abc] 5\n",
+                           format_one(&captured[0]));
+  TEST_ASSERT_EQUAL_STRING("[] [exactly16chars!!]\n", format_one(&captured[1]));
+}
+
+void test_klog_format_should_truncate_to_buffer(void) {
+  char small[8];
+  KLOG("value=%u and more\n", 123456);
+  klog_drain(capture_sink, 1);
+
+  size_t len = klog_format(&captured[0], small, sizeof(small));
+  TEST_ASSERT_EQUAL(strlen("value=123456 and more\n"), len);
+  TEST_ASSERT_EQUAL_STRING("value=1", small);
+}
+
+void test_pool_print_stats_should_log_table(void) {
+  memory_pools_init();
+  void *tcb = pool_alloc(POOL_TCB);
+
+  pool_print_stats();
+  TEST_ASSERT_EQUAL(0, klog_dropped());
+  klog_drain(text_sink, (size_t)-1);
+  pool_free(POOL_TCB, tcb);
+
+  char row[96];
+  pool_stats_t stats = pool_get_stats(POOL_TCB);
+  uint32_t permille = (uint32_t)(1000 / stats.total_objects);
+  snprintf(row, sizeof(row), "TCB              | %5u | %4u | %4u | %4u | %8u.%u%% |",
+           (unsigned)stats.total_objects, 1u,
+           (unsigned)stats.total_objects - 1, 1u, permille / 10, permille % 10);
+
+  TEST_ASSERT_NOT_NULL(strstr(text, "=== Memory Pool Statistics ===\n"));
+  TEST_ASSERT_NOT_NULL(strstr(text, row));
+  TEST_ASSERT_NOT_NULL(strstr(text, "\nStack Default    |"));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  // Ring tests
+  RUN_TEST(test_klog_init_should_fill_header);
+  RUN_TEST(test_klog_should_store_format_id_and_args);
+  RUN_TEST(test_klog_should_drop_when_full);
+  RUN_TEST(test_klog_should_reuse_drained_words_across_laps);
+  RUN_TEST(test_klog_drain_should_stop_at_incomplete_record);
+  RUN_TEST(test_klog_should_survive_interrupting_producers);
+
+  // Formatting tests
+  RUN_TEST(test_klog_format_should_render_integer_conversions);
+  RUN_TEST(test_klog_format_should_unpack_strings);
+  RUN_TEST(test_klog_format_should_truncate_to_buffer);
+  RUN_TEST(test_pool_print_stats_should_log_table);
+
+  return UNITY_END();
+}
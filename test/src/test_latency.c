@@ -0,0 +1,155 @@
+#include "latency_stats.h"
+#include "memory.h"
+#include "port.h"
+#include "task.h"
+#include "test_latency.h"
+#include "unity.h"
+#include <stdint.h>
+#include <string.h>
+
+// Mock scheduler functions for testing
+void scheduler_remove_task(task_handle_t task) { (void)task; }
+
+static task_handle_t task;
+
+void dummy_latency_task(void *param) {
+  (void)param;
+  while (1) {
+  }
+}
+
+static void spin_cycles(uint32_t cycles) {
+  uint32_t start = port_cycle_count();
+  while (port_cycle_count() - start < cycles) {
+  }
+}
+
+// Block, wake with reason, then switch in after about run_delay cycles
+static void wake_cycle(wake_reason_t reason, uint32_t run_delay) {
+  task_set_state(task, TASK_BLOCKED);
+  task->wake_reason = reason;
+  latency_stats_ready(task);
+  task->state = TASK_READY; // What scheduler_add_task does next
+  spin_cycles(run_delay);
+  latency_stats_switch(task);
+}
+
+void setUp(void) {
+  memory_pools_init();
+  task = task_create_internal(dummy_latency_task, "Lat", 256, NULL, 3);
+}
+
+void tearDown(void) {
+  if (task) {
+    task_delete_internal(task);
+    task = NULL;
+  }
+}
+
+//=============================================================================
+// WAKEUP LATENCY TESTS
+//=============================================================================
+
+void test_latency_stats_should_start_empty(void) {
+  task_latency_stats_t stats;
+  TEST_ASSERT_TRUE(task_get_latency_stats(task, &stats));
+  TEST_ASSERT_EQUAL(0, stats.wakeup.count);
+  TEST_ASSERT_EQUAL(0, stats.wakeup.max_cycles);
+  for (int r = 0; r < WAKE_REASON_COUNT; r++) {
+    TEST_ASSERT_EQUAL(0, stats.blocked[r].count);
+  }
+}
+
+void test_latency_stats_should_record_wakeup_latency(void) {
+  wake_cycle(WAKE_REASON_DATA_AVAILABLE, 5000);
+
+  task_latency_stats_t stats;
+  task_get_latency_stats(task, &stats);
+  TEST_ASSERT_EQUAL(1, stats.wakeup.count);
+  TEST_ASSERT_GREATER_OR_EQUAL(5000, stats.wakeup.max_cycles);
+
+  // Exactly one bucket holds the sample: the one containing max_cycles
+  uint32_t b = 31 - __builtin_clz(stats.wakeup.max_cycles);
+  if (b >= LATENCY_HIST_BUCKETS) b = LATENCY_HIST_BUCKETS - 1;
+  TEST_ASSERT_EQUAL(1, stats.wakeup.buckets[b]);
+}
+
+void test_latency_stats_should_count_only_real_wakeups(void) {
+  // Preempted tasks are switched in again without being made ready
+  latency_stats_switch(task);
+  latency_stats_ready(task); // Not blocked: ignored
+
+  wake_cycle(WAKE_REASON_TIMEOUT, 0);
+  latency_stats_switch(task); // Second switch-in of the same wakeup
+
+  task_latency_stats_t stats;
+  task_get_latency_stats(task, &stats);
+  TEST_ASSERT_EQUAL(1, stats.wakeup.count);
+}
+
+void test_latency_stats_should_split_blocked_time_by_reason(void) {
+  wake_cycle(WAKE_REASON_DATA_AVAILABLE, 0);
+  wake_cycle(WAKE_REASON_TIMEOUT, 0);
+  wake_cycle(WAKE_REASON_TIMEOUT, 0);
+
+  task_set_state(task, TASK_BLOCKED);
+  spin_cycles(20000);
+  task->wake_reason = WAKE_REASON_SIGNAL;
+  latency_stats_ready(task);
+
+  task_latency_stats_t stats;
+  task_get_latency_stats(task, &stats);
+  TEST_ASSERT_EQUAL(1, stats.blocked[WAKE_REASON_DATA_AVAILABLE].count);
+  TEST_ASSERT_EQUAL(2, stats.blocked[WAKE_REASON_TIMEOUT].count);
+  TEST_ASSERT_EQUAL(1, stats.blocked[WAKE_REASON_SIGNAL].count);
+  TEST_ASSERT_GREATER_OR_EQUAL(20000, stats.blocked[WAKE_REASON_SIGNAL].max_cycles);
+  TEST_ASSERT_GREATER_OR_EQUAL(stats.blocked[WAKE_REASON_SIGNAL].max_cycles,
+                               stats.blocked[WAKE_REASON_SIGNAL].total_cycles);
+}
+
+void test_latency_histogram_percentile_should_bound_samples(void) {
+  latency_histogram_t hist;
+  memset(&hist, 0, sizeof(hist));
+  TEST_ASSERT_EQUAL(0, latency_histogram_percentile(&hist, 500));
+
+  hist.buckets[3] = 90;  // [8, 16) cycles
+  hist.buckets[10] = 10; // [1024, 2048) cycles
+  hist.count = 100;
+  hist.max_cycles = 1500;
+
+  TEST_ASSERT_EQUAL(15, latency_histogram_percentile(&hist, 500));
+  TEST_ASSERT_EQUAL(15, latency_histogram_percentile(&hist, 900));
+  TEST_ASSERT_EQUAL(2047, latency_histogram_percentile(&hist, 990));
+}
+
+void test_latency_stats_reset_should_clear(void) {
+  wake_cycle(WAKE_REASON_TIMEOUT, 0);
+  task_reset_latency_stats(task);
+
+  task_latency_stats_t stats;
+  task_get_latency_stats(task, &stats);
+  TEST_ASSERT_EQUAL(0, stats.wakeup.count);
+  TEST_ASSERT_EQUAL(0, stats.blocked[WAKE_REASON_TIMEOUT].count);
+}
+
+void test_latency_stats_should_handle_null(void) {
+  task_latency_stats_t stats;
+  TEST_ASSERT_FALSE(task_get_latency_stats(NULL, &stats));
+  TEST_ASSERT_FALSE(task_get_latency_stats(task, NULL));
+  latency_stats_switch(NULL);
+  task_reset_latency_stats(NULL);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_latency_stats_should_start_empty);
+  RUN_TEST(test_latency_stats_should_record_wakeup_latency);
+  RUN_TEST(test_latency_stats_should_count_only_real_wakeups);
+  RUN_TEST(test_latency_stats_should_split_blocked_time_by_reason);
+  RUN_TEST(test_latency_histogram_percentile_should_bound_samples);
+  RUN_TEST(test_latency_stats_reset_should_clear);
+  RUN_TEST(test_latency_stats_should_handle_null);
+
+  return UNITY_END();
+}
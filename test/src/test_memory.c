@@ -42,6 +42,9 @@ static void track_allocation(void *ptr) {
 void test_memory_pools_init_should_initialize_all_pools(void) {
     // Verify all pools have expected initial state
     for (pool_type_t type = 0; type < POOL_COUNT; type++) {
+#if !SWTIMER_ENABLED
+        if (type == POOL_TMCB) continue; // Compiled out, see below
+#endif
         pool_stats_t stats = pool_get_stats(type);
         TEST_ASSERT_GREATER_THAN(0, stats.total_objects);
         TEST_ASSERT_EQUAL(stats.total_objects, stats.free_objects);
@@ -286,6 +289,18 @@ void test_pool_get_stats_should_handle_invalid_pool_type(void) {
     TEST_ASSERT_EQUAL(0, stats.peak_usage);
 }
 
+void test_pool_should_be_empty_when_compiled_out(void) {
+#if !SWTIMER_ENABLED
+    uint32_t object;
+
+    TEST_ASSERT_EQUAL(0, pool_get_stats(POOL_TMCB).total_objects);
+    TEST_ASSERT_NULL(pool_alloc(POOL_TMCB));
+    TEST_ASSERT_FALSE(pool_free(POOL_TMCB, &object));
+    TEST_ASSERT_NULL(pool_object_at(POOL_TMCB, 0));
+    TEST_ASSERT_EQUAL(-1, pool_index_of(POOL_TMCB, &object));
+#endif
+}
+
 //=============================================================================
 // STRESS TESTS
 //=============================================================================
@@ -358,6 +373,144 @@ void test_task_stack_allocation_integration(void) {
     TEST_ASSERT_TRUE(task_pool_free_stack(stack));
 }
 
+//=============================================================================
+// GUARD WORD TESTS
+//=============================================================================
+
+static pool_type_t reported_pool;
+static void *reported_object;
+static int report_count;
+
+static void record_corruption(pool_type_t pool_type, void *object) {
+    reported_pool = pool_type;
+    reported_object = object;
+    report_count++;
+}
+
+static void reset_corruption_reports(void) {
+    reported_pool = POOL_COUNT;
+    reported_object = NULL;
+    report_count = 0;
+    pool_set_corruption_handler(record_corruption);
+}
+
+// Enough steps to visit every slot of every pool at least once
+static bool scan_all_pools(void) {
+    bool clean = true;
+    size_t slots = 0;
+    for (pool_type_t type = 0; type < POOL_COUNT; type++) {
+        size_t objects = pool_get_stats(type).total_objects;
+        slots += objects ? objects : 1; // A compiled-out pool takes one slot
+    }
+    for (size_t i = 0; i < slots / POOL_SCAN_SLOTS_PER_STEP + 1; i++) {
+        clean = pool_integrity_scan_step() && clean;
+    }
+    return clean;
+}
+
+void test_pool_free_should_reject_interior_pointer(void) {
+    uint8_t *ptr = (uint8_t *)pool_alloc(POOL_BUFFER_SMALL);
+    TEST_ASSERT_NOT_NULL(ptr);
+
+    TEST_ASSERT_FALSE(pool_free(POOL_BUFFER_SMALL, ptr + 4));
+    TEST_ASSERT_TRUE(pool_free(POOL_BUFFER_SMALL, ptr));
+}
+
+void test_pool_free_should_detect_overrun_into_guard(void) {
+#if POOL_GUARD_ENABLED
+    reset_corruption_reports();
+    uint8_t *buffer = (uint8_t *)pool_alloc(POOL_BUFFER_SMALL);
+    TEST_ASSERT_NOT_NULL(buffer);
+
+    // One word past the end of the buffer
+    memset(buffer, 0x11, SMALL_BUFFER_SIZE + sizeof(uint32_t));
+
+    TEST_ASSERT_TRUE(pool_free(POOL_BUFFER_SMALL, buffer));
+    TEST_ASSERT_EQUAL(1, report_count);
+    TEST_ASSERT_EQUAL(POOL_BUFFER_SMALL, reported_pool);
+    TEST_ASSERT_EQUAL_PTR(buffer, reported_object);
+    TEST_ASSERT_EQUAL(1, pool_get_stats(POOL_BUFFER_SMALL).corruptions);
+
+    // Guard is re-armed, so the same damage is not reported again
+    TEST_ASSERT_TRUE(scan_all_pools());
+    TEST_ASSERT_EQUAL(1, report_count);
+    pool_set_corruption_handler(NULL);
+#endif
+}
+
+void test_pool_free_should_detect_underrun_into_guard(void) {
+#if POOL_GUARD_ENABLED
+    reset_corruption_reports();
+    uint32_t *stack = (uint32_t *)pool_alloc(POOL_STACK_SMALL);
+    TEST_ASSERT_NOT_NULL(stack);
+
+    // Stack overflow writes just below the stack base
+    stack[-1] = 0;
+
+    TEST_ASSERT_TRUE(pool_free(POOL_STACK_SMALL, stack));
+    TEST_ASSERT_EQUAL(1, report_count);
+    TEST_ASSERT_EQUAL_PTR(stack, reported_object);
+    pool_set_corruption_handler(NULL);
+#endif
+}
+
+void test_pool_integrity_scan_should_pass_on_clean_pools(void) {
+    reset_corruption_reports();
+    void *tcb = pool_alloc(POOL_TCB);
+    TEST_ASSERT_NOT_NULL(tcb);
+    track_allocation(tcb);
+
+    TEST_ASSERT_TRUE(scan_all_pools());
+    TEST_ASSERT_EQUAL(0, report_count);
+    pool_set_corruption_handler(NULL);
+}
+
+void test_pool_integrity_scan_should_detect_corruption(void) {
+#if POOL_GUARD_ENABLED
+    reset_corruption_reports();
+    uint8_t *qcb = (uint8_t *)pool_alloc(POOL_QCB);
+    TEST_ASSERT_NOT_NULL(qcb);
+    track_allocation(qcb);
+
+    // Scribble over the word past the object without freeing it
+    memset(qcb + sizeof(queue_control_block), 0, sizeof(uint32_t));
+
+    TEST_ASSERT_FALSE(scan_all_pools());
+    TEST_ASSERT_EQUAL(1, report_count);
+    TEST_ASSERT_EQUAL(POOL_QCB, reported_pool);
+    TEST_ASSERT_EQUAL_PTR(qcb, reported_object);
+    pool_set_corruption_handler(NULL);
+#endif
+}
+
+void test_pool_integrity_scan_should_detect_write_after_free(void) {
+#if POOL_GUARD_ENABLED && POOL_POISON_ENABLED
+    reset_corruption_reports();
+    uint8_t *scb = (uint8_t *)pool_alloc(POOL_SCB);
+    TEST_ASSERT_NOT_NULL(scb);
+
+    TEST_ASSERT_TRUE(pool_free(POOL_SCB, scb));
+    for (size_t i = 0; i < sizeof(semaphore_control_block); i++) {
+        TEST_ASSERT_EQUAL_HEX8(POOL_POISON_BYTE, scb[i]);
+    }
+    TEST_ASSERT_EQUAL(0, report_count);
+
+    // A stale pointer writes the first word, which the scan checks
+    *(uint32_t *)scb = 0;
+
+    TEST_ASSERT_FALSE(scan_all_pools());
+    TEST_ASSERT_EQUAL(1, report_count);
+    TEST_ASSERT_EQUAL(POOL_SCB, reported_pool);
+    TEST_ASSERT_EQUAL_PTR(scb, reported_object);
+    TEST_ASSERT_EQUAL(1, pool_get_stats(POOL_SCB).corruptions);
+
+    // Poison is restored, so the same write is not reported again
+    TEST_ASSERT_TRUE(scan_all_pools());
+    TEST_ASSERT_EQUAL(1, report_count);
+    pool_set_corruption_handler(NULL);
+#endif
+}
+
 //=============================================================================
 // TEST RUNNER
 //=============================================================================
@@ -393,6 +546,7 @@ int main(void) {
     RUN_TEST(test_pool_alloc_should_handle_invalid_pool_type);
     RUN_TEST(test_pool_free_should_handle_invalid_pool_type);
     RUN_TEST(test_pool_get_stats_should_handle_invalid_pool_type);
+    RUN_TEST(test_pool_should_be_empty_when_compiled_out);
 
     // Stress tests
     RUN_TEST(test_pool_should_handle_allocation_deallocation_cycles);
@@ -401,5 +555,13 @@ int main(void) {
     // Integration tests
     RUN_TEST(test_task_stack_allocation_integration);
 
+    // Guard word tests
+    RUN_TEST(test_pool_free_should_reject_interior_pointer);
+    RUN_TEST(test_pool_free_should_detect_overrun_into_guard);
+    RUN_TEST(test_pool_free_should_detect_underrun_into_guard);
+    RUN_TEST(test_pool_integrity_scan_should_pass_on_clean_pools);
+    RUN_TEST(test_pool_integrity_scan_should_detect_corruption);
+    RUN_TEST(test_pool_integrity_scan_should_detect_write_after_free);
+
     return UNITY_END();
 }
@@ -20,6 +20,16 @@ task_handle_t current_task = NULL;
 static task_control_block mock_task_owner;
 static task_control_block mock_task_waiter;
 
+// Counted so tests can tell whether a lock blocked and armed a timeout
+static int yield_calls;
+static int timeout_calls;
+
+// Stands in for the tasks that would run while the caller is blocked
+static void (*yield_hook)(void);
+
+// Last task handed to scheduler_restore_priority(), which requeues it
+static task_handle_t restored_task;
+
 // Mock scheduler functions
 void scheduler_cancel_timeout(task_handle_t task) {
   (void)task; // Mock implementation - do nothing
@@ -35,20 +45,27 @@ void scheduler_remove_task(task_handle_t task) {
 
 void scheduler_set_timeout(task_handle_t task, uint32_t wake_tick) {
   (void)task;
-  (void)wake_tick; // Mock implementation - do nothing
+  (void)wake_tick;
+  timeout_calls++;
 }
 
 void scheduler_yield(void) {
-  // Mock implementation - do nothing (in real system, this would context switch)
+  // In a real system this would context switch
+  yield_calls++;
+  if (yield_hook) {
+    yield_hook();
+  }
 }
 
+// Like the real one, boosting never lowers a priority
 void scheduler_boost_priority(task_handle_t task, task_priority_t new_priority) {
-  if (task) {
+  if (task && new_priority < task->effective_priority) {
     task->effective_priority = new_priority;
   }
 }
 
 void scheduler_restore_priority(task_handle_t task) {
+  restored_task = task;
   if (task) {
     task->effective_priority = task->base_priority;
   }
@@ -68,6 +85,10 @@ void mutex_test_setup(void) {
   test_mutex = NULL;
   tick_now = 0;
   current_task = NULL;
+  yield_calls = 0;
+  timeout_calls = 0;
+  yield_hook = NULL;
+  restored_task = NULL;
   
   // Initialize mock tasks
   memset(&mock_task_owner, 0, sizeof(mock_task_owner));
@@ -306,6 +327,35 @@ void test_mutex_lock_should_handle_infinite_timeout(void) {
   TEST_ASSERT_TRUE(mutex_is_locked(test_mutex));
 }
 
+// The owner unlocks on the first yield and any later one times the wait
+// out, so a waiter that misses the unlock fails instead of blocking for ever
+static void unlock_on_first_yield(void) {
+  if (yield_calls == 1) {
+    task_handle_t waiter = current_task;
+    current_task = &mock_task_owner;
+    TEST_ASSERT_EQUAL(MUTEX_OK, mutex_unlock(test_mutex));
+    current_task = waiter;
+  } else {
+    current_task->wake_reason = WAKE_REASON_TIMEOUT;
+  }
+}
+
+void test_mutex_lock_forever_should_block_until_unlocked(void) {
+  test_mutex = mutex_create("TestMutex");
+  current_task = &mock_task_owner;
+  TEST_ASSERT_EQUAL(MUTEX_OK, mutex_lock(test_mutex, MUTEX_NO_WAIT));
+
+  current_task = &mock_task_waiter;
+  yield_hook = unlock_on_first_yield;
+
+  // The forever deadline is start - 1, which must not read as expired
+  tick_now = 100;
+  TEST_ASSERT_EQUAL(MUTEX_OK, mutex_lock(test_mutex, MUTEX_WAIT_FOREVER));
+  TEST_ASSERT_EQUAL_PTR(&mock_task_waiter, mutex_get_owner(test_mutex));
+  TEST_ASSERT_EQUAL(1, yield_calls);
+  TEST_ASSERT_EQUAL(0, timeout_calls);
+}
+
 //=============================================================================
 // OWNERSHIP TESTS
 //=============================================================================
@@ -395,6 +445,25 @@ void test_mutex_should_restore_priority_on_unlock(void) {
   TEST_ASSERT_EQUAL(3, mock_task_owner.effective_priority);
 }
 
+void test_mutex_unlock_should_requeue_owner_at_base_priority(void) {
+  test_mutex = mutex_create("TestMutex");
+  current_task = &mock_task_owner;
+  TEST_ASSERT_EQUAL(MUTEX_OK, mutex_lock(test_mutex, MUTEX_NO_WAIT));
+
+  // The higher priority waiter blocks, boosting the owner, and times out
+  current_task = &mock_task_waiter;
+  current_task->wake_reason = WAKE_REASON_TIMEOUT;
+  TEST_ASSERT_EQUAL(MUTEX_ERROR_TIMEOUT, mutex_lock(test_mutex, 10));
+  TEST_ASSERT_EQUAL(1, mock_task_owner.effective_priority);
+
+  // Boosting back to the saved priority would be a no-op: only a restore
+  // lowers it and moves the owner back to its own ready queue
+  current_task = &mock_task_owner;
+  TEST_ASSERT_EQUAL(MUTEX_OK, mutex_unlock(test_mutex));
+  TEST_ASSERT_EQUAL_PTR(&mock_task_owner, restored_task);
+  TEST_ASSERT_EQUAL(3, mock_task_owner.effective_priority);
+}
+
 void test_mutex_should_restore_priority_on_delete(void) {
   test_mutex = mutex_create("TestMutex");
   current_task = &mock_task_owner;
@@ -571,7 +640,7 @@ void test_mutex_unlock_without_lock_should_fail(void) {
 // TEST RUNNER
 //=============================================================================
 
-void run_mutex_tests(void) {
+int run_mutex_tests(void) {
   UNITY_BEGIN();
 
   // Mutex creation/deletion tests
@@ -594,6 +663,7 @@ void run_mutex_tests(void) {
   RUN_TEST(test_mutex_lock_should_timeout_when_deadline_exceeded);
   RUN_TEST(test_mutex_lock_should_handle_mutex_deletion_while_waiting);
   RUN_TEST(test_mutex_lock_should_handle_infinite_timeout);
+  RUN_TEST(test_mutex_lock_forever_should_block_until_unlocked);
 
   // Ownership tests
   RUN_TEST(test_mutex_get_owner_should_return_current_owner);
@@ -603,6 +673,7 @@ void run_mutex_tests(void) {
   // Priority inheritance tests
   RUN_TEST(test_mutex_should_apply_priority_inheritance);
   RUN_TEST(test_mutex_should_restore_priority_on_unlock);
+  RUN_TEST(test_mutex_unlock_should_requeue_owner_at_base_priority);
   RUN_TEST(test_mutex_should_restore_priority_on_delete);
 
   // Waiting tasks tests
@@ -622,10 +693,7 @@ void run_mutex_tests(void) {
   RUN_TEST(test_mutex_recursive_lock_should_fail);
   RUN_TEST(test_mutex_unlock_without_lock_should_fail);
 
-  UNITY_END();
+  return UNITY_END();
 }
 
-int main(void) {
-  run_mutex_tests();
-  return 0;
-}
+int main(void) { return run_mutex_tests(); }
@@ -0,0 +1,326 @@
+#include "critical.h"
+#include "kernel.h"
+#include "mutex.h"
+#include "port.h"
+#include "posix_child.h"
+#include "queue.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "task.h"
+#include "test_port_posix.h"
+#include "unity.h"
+#include <sys/time.h>
+#include <unistd.h>
+
+// These tests run the real scheduler on the POSIX port, each scenario in a
+// forked child (posix_child.h) of a kernel initialised once in main().
+
+static volatile int step;
+static volatile uint32_t counter[2];
+static semaphore_handle_t sem[2];
+static mutex_handle_t mutex;
+static queue_handle_t queue;
+
+void setUp(void) {
+  step = 0;
+  counter[0] = counter[1] = 0;
+}
+
+void tearDown(void) {}
+
+//=============================================================================
+// SCHEDULING
+//=============================================================================
+
+static void order_high_task(void *param) {
+  (void)param;
+  posix_child_check(step == 0, 1); // Runs before the lower priority task
+  step = 1;
+  task_delay(5);
+
+  // Back as soon as the delay expires, preempting the busy low task
+  posix_child_check(step == 2, 2);
+  _exit(0);
+}
+
+static void order_low_task(void *param) {
+  (void)param;
+  posix_child_check(step == 1, 3);
+  step = 2;
+  while (1) {
+  }
+}
+
+static void order_scenario(void) {
+  task_create(order_low_task, "low", 0, NULL, 3);
+  task_create(order_high_task, "high", 0, NULL, 1);
+}
+
+void test_posix_port_should_run_highest_priority_first(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(order_scenario));
+}
+
+static void delay_task(void *param) {
+  (void)param;
+  uint32_t start = tick_now;
+  task_delay(10);
+  uint32_t elapsed = tick_now - start;
+  posix_child_check(elapsed >= 10, 1);
+  posix_child_check(elapsed <= 12, 2);
+  _exit(0);
+}
+
+static void delay_scenario(void) {
+  task_create(delay_task, "delay", 0, NULL, 1);
+}
+
+void test_posix_port_should_wake_delayed_task_on_time(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(delay_scenario));
+}
+
+static void slow_tick_task(void *param) {
+  (void)param;
+  struct itimerval period;
+
+  // One second is past the range of tv_usec on its own
+  posix_child_check(kernel_set_clock(PORT_CORE_CLOCK_HZ, 1), 1);
+  posix_child_check(getitimer(ITIMER_REAL, &period) == 0, 2);
+  posix_child_check(period.it_interval.tv_sec == 1, 3);
+  posix_child_check(period.it_interval.tv_usec == 0, 4);
+  _exit(0);
+}
+
+static void slow_tick_scenario(void) {
+  task_create(slow_tick_task, "slow", 0, NULL, 1);
+}
+
+void test_posix_port_should_program_one_hertz_tick(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(slow_tick_scenario));
+}
+
+static void spin_task(void *param) {
+  volatile uint32_t *count = param;
+  while (1) {
+    (*count)++;
+  }
+}
+
+static void slice_monitor_task(void *param) {
+  (void)param;
+  task_delay(50);
+
+  // Neither spinner yields; only the tick can have rotated them
+  posix_child_check(counter[0] > 0, 1);
+  posix_child_check(counter[1] > 0, 2);
+  _exit(0);
+}
+
+static void slice_scenario(void) {
+  task_create(spin_task, "spin0", 0, (void *)&counter[0], 2);
+  task_create(spin_task, "spin1", 0, (void *)&counter[1], 2);
+  task_create(slice_monitor_task, "monitor", 0, NULL, 1);
+}
+
+void test_posix_port_should_time_slice_equal_priorities(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(slice_scenario));
+}
+
+static void critical_task(void *param) {
+  (void)param;
+  task_delay(1); // Start on a tick boundary
+
+  KERNEL_CRITICAL_BEGIN();
+  uint32_t masked_tick = tick_now;
+  usleep(5 * 1000);
+  posix_child_check(tick_now == masked_tick, 1);
+  KERNEL_CRITICAL_END();
+
+  // The pending tick is taken on unmask
+  posix_child_check(tick_now != masked_tick, 2);
+  _exit(0);
+}
+
+static void critical_scenario(void) {
+  task_create(critical_task, "critical", 0, NULL, 1);
+}
+
+void test_posix_port_should_defer_tick_in_critical_section(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(critical_scenario));
+}
+
+//=============================================================================
+// BLOCKING
+//=============================================================================
+
+#define PING_PONG_ROUNDS 1000
+
+static void ping_task(void *param) {
+  (void)param;
+  for (int i = 0; i < PING_PONG_ROUNDS; i++) {
+    posix_child_check(sem_post(sem[0]) == SEM_OK, 1);
+    posix_child_check(sem_wait(sem[1], SEM_WAIT_FOREVER) == SEM_OK, 2);
+  }
+  posix_child_check(counter[0] == PING_PONG_ROUNDS, 3);
+  _exit(0);
+}
+
+static void pong_task(void *param) {
+  (void)param;
+  while (1) {
+    sem_wait(sem[0], SEM_WAIT_FOREVER);
+    counter[0]++;
+    sem_post(sem[1]);
+  }
+}
+
+static void ping_pong_scenario(void) {
+  sem[0] = sem_create(0, 1, "ping");
+  sem[1] = sem_create(0, 1, "pong");
+  task_create(ping_task, "ping", 0, NULL, 1);
+  task_create(pong_task, "pong", 0, NULL, 2);
+}
+
+void test_posix_port_should_ping_pong_semaphores(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(ping_pong_scenario));
+}
+
+static void timeout_task(void *param) {
+  (void)param;
+  task_delay(1);
+
+  uint32_t start = tick_now;
+  posix_child_check(sem_wait(sem[0], 20) == SEM_ERROR_TIMEOUT, 1);
+  posix_child_check(tick_now - start >= 20, 2);
+  _exit(0);
+}
+
+static void timeout_scenario(void) {
+  sem[0] = sem_create(0, 1, "never");
+  task_create(timeout_task, "timeout", 0, NULL, 1);
+}
+
+void test_posix_port_should_time_out_semaphore_wait(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(timeout_scenario));
+}
+
+#define QUEUE_ITEMS 100
+#define QUEUE_WAIT 0x7FFFFFFFu
+
+static void producer_task(void *param) {
+  (void)param;
+  for (uint32_t i = 0; i < QUEUE_ITEMS; i++) {
+    // Blocks whenever the consumer falls four items behind
+    posix_child_check(queue_send(queue, &i, QUEUE_WAIT) == QUEUE_SUCCESS, 1);
+  }
+  while (1) {
+    task_delay(100);
+  }
+}
+
+static void consumer_task(void *param) {
+  (void)param;
+  for (uint32_t i = 0; i < QUEUE_ITEMS; i++) {
+    uint32_t item;
+    posix_child_check(
+        queue_receive(queue, &item, QUEUE_WAIT) == QUEUE_SUCCESS, 2);
+    posix_child_check(item == i, 3);
+  }
+  _exit(0);
+}
+
+static void queue_scenario(void) {
+  queue = queue_create(4, sizeof(uint32_t));
+  task_create(producer_task, "producer", 0, NULL, 1);
+  task_create(consumer_task, "consumer", 0, NULL, 2);
+}
+
+void test_posix_port_should_pass_queue_items_in_order(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(queue_scenario));
+}
+
+static void pi_low_task(void *param) {
+  (void)param;
+  posix_child_check(mutex_lock(mutex, MUTEX_WAIT_FOREVER) == MUTEX_OK, 1);
+
+  // Hold the mutex until the high priority task blocks on it
+  while (!mutex_has_waiting_tasks(mutex)) {
+  }
+  posix_child_check(task_get_current()->effective_priority == 1, 2);
+
+  posix_child_check(mutex_unlock(mutex) == MUTEX_OK, 3);
+  posix_child_check(task_get_current()->effective_priority == 3, 4);
+  step = 1;
+
+  while (1) {
+    task_delay(100);
+  }
+}
+
+static void pi_high_task(void *param) {
+  (void)param;
+  task_delay(2); // Let the low task take the mutex first
+
+  posix_child_check(mutex_lock(mutex, MUTEX_WAIT_FOREVER) == MUTEX_OK, 5);
+  posix_child_check(step == 1, 6);
+  _exit(0);
+}
+
+static void pi_scenario(void) {
+  mutex = mutex_create("pi");
+  task_create(pi_low_task, "low", 0, NULL, 3);
+  task_create(pi_high_task, "high", 0, NULL, 1);
+}
+
+void test_posix_port_should_inherit_and_restore_mutex_priority(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(pi_scenario));
+}
+
+//=============================================================================
+// INTERRUPTS
+//=============================================================================
+
+static void irq_handler(void) {
+  kernel_isr_enter();
+  step = (int)port_current_exception();
+  sem_post(sem[0]);
+  kernel_isr_exit();
+}
+
+static void irq_task(void *param) {
+  (void)param;
+  posix_child_check(port_current_exception() == 0, 1);
+
+  port_posix_trigger_irq();
+  posix_child_check(sem_wait(sem[0], 10) == SEM_OK, 2);
+  posix_child_check(step == 16, 3); // Reported as IRQ 0
+  _exit(0);
+}
+
+static void irq_scenario(void) {
+  sem[0] = sem_create(0, 1, "irq");
+  port_posix_set_irq_handler(irq_handler);
+  task_create(irq_task, "irq", 0, NULL, 1);
+}
+
+void test_posix_port_should_wake_task_from_interrupt(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(irq_scenario));
+}
+
+int main(void) {
+  kernel_init();
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_posix_port_should_run_highest_priority_first);
+  RUN_TEST(test_posix_port_should_wake_delayed_task_on_time);
+  RUN_TEST(test_posix_port_should_program_one_hertz_tick);
+  RUN_TEST(test_posix_port_should_time_slice_equal_priorities);
+  RUN_TEST(test_posix_port_should_defer_tick_in_critical_section);
+  RUN_TEST(test_posix_port_should_ping_pong_semaphores);
+  RUN_TEST(test_posix_port_should_time_out_semaphore_wait);
+  RUN_TEST(test_posix_port_should_pass_queue_items_in_order);
+  RUN_TEST(test_posix_port_should_inherit_and_restore_mutex_priority);
+  RUN_TEST(test_posix_port_should_wake_task_from_interrupt);
+
+  return UNITY_END();
+}
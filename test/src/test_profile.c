@@ -0,0 +1,166 @@
+#include "kernel.h"
+#include "memory.h"
+#include "posix_child.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "test_profile.h"
+#include "unity.h"
+#include <string.h>
+#include <unistd.h>
+
+// Samples are fed in by hand on a kernel that is initialised but not
+// started, except for the tick test, which runs the kernel in a forked
+// child (posix_child.h) so the POSIX port samples a spinning task.
+
+#define SPIN_TICKS 50
+
+static task_handle_t worker;
+static task_handle_t other;
+
+static void dummy_task(void *param) {
+  (void)param;
+  while (1) {
+  }
+}
+
+// Helper: the entry for pc and slot, or NULL
+static const profile_entry_t *find_entry(uintptr_t pc, uint32_t slot) {
+  for (size_t i = 0; i < PROFILE_HASH_SLOTS; i++) {
+    const profile_entry_t *e = &profile_ram.entries[i];
+    if (e->count && e->pc == pc && e->task == slot) return e;
+  }
+  return NULL;
+}
+
+static uint32_t total_counted(void) {
+  uint32_t total = 0;
+  for (size_t i = 0; i < PROFILE_HASH_SLOTS; i++) {
+    total += profile_ram.entries[i].count;
+  }
+  return total;
+}
+
+void setUp(void) { profile_reset(); }
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_profile_should_describe_layout_in_header(void) {
+  TEST_ASSERT_EQUAL_HEX32(PROFILE_MAGIC, profile_ram.header.magic);
+  TEST_ASSERT_EQUAL(PROFILE_VERSION, profile_ram.header.version);
+  TEST_ASSERT_EQUAL(sizeof(profile_header_t), profile_ram.header.header_size);
+  TEST_ASSERT_EQUAL(20, sizeof(profile_header_t));
+  TEST_ASSERT_EQUAL(PROFILE_HASH_SLOTS, profile_ram.header.slots);
+  TEST_ASSERT_EQUAL(sizeof(uintptr_t), profile_ram.header.pc_bytes);
+  TEST_ASSERT_EQUAL(MAX_TASKS, profile_ram.header.task_slots);
+  TEST_ASSERT_EQUAL(0, profile_ram.header.samples);
+}
+
+void test_profile_should_count_repeated_samples_once(void) {
+  for (int i = 0; i < 5; i++) {
+    profile_sample(0x1000, worker);
+  }
+  profile_sample(0x1004, worker);
+
+  uint32_t slot = pool_index_of(POOL_TCB, worker);
+  TEST_ASSERT_EQUAL(5, find_entry(0x1000, slot)->count);
+  TEST_ASSERT_EQUAL(1, find_entry(0x1004, slot)->count);
+  TEST_ASSERT_EQUAL(6, profile_ram.header.samples);
+  TEST_ASSERT_EQUAL(6, total_counted());
+}
+
+void test_profile_should_key_samples_by_task(void) {
+  profile_sample(0x2000, worker);
+  profile_sample(0x2000, other);
+  profile_sample(0x2000, other);
+  profile_sample(0x2000, NULL);
+
+  TEST_ASSERT_EQUAL(1, find_entry(0x2000, pool_index_of(POOL_TCB, worker))->count);
+  TEST_ASSERT_EQUAL(2, find_entry(0x2000, pool_index_of(POOL_TCB, other))->count);
+  TEST_ASSERT_EQUAL(1, find_entry(0x2000, PROFILE_NO_TASK)->count);
+}
+
+void test_profile_should_record_task_names(void) {
+  profile_sample(0x3000, worker);
+  profile_sample(0x3000, other);
+
+  TEST_ASSERT_EQUAL_STRING("worker",
+                           profile_ram.names[pool_index_of(POOL_TCB, worker)]);
+  TEST_ASSERT_EQUAL_STRING("other",
+                           profile_ram.names[pool_index_of(POOL_TCB, other)]);
+}
+
+void test_profile_should_drop_when_probes_run_out(void) {
+  uint32_t samples = 4 * PROFILE_HASH_SLOTS;
+  for (uint32_t i = 0; i < samples; i++) {
+    profile_sample(0x8000 + 2 * i, worker);
+  }
+
+  TEST_ASSERT_EQUAL(samples, profile_ram.header.samples);
+  TEST_ASSERT_TRUE(profile_ram.header.dropped > 0);
+  TEST_ASSERT_EQUAL(samples, total_counted() + profile_ram.header.dropped);
+}
+
+void test_profile_should_clear_on_reset(void) {
+  profile_sample(0x4000, worker);
+  profile_reset();
+
+  TEST_ASSERT_EQUAL(0, profile_ram.header.samples);
+  TEST_ASSERT_EQUAL(0, profile_ram.header.dropped);
+  TEST_ASSERT_EQUAL(0, total_counted());
+  TEST_ASSERT_EQUAL_STRING("", profile_ram.names[pool_index_of(POOL_TCB, worker)]);
+  TEST_ASSERT_EQUAL(PROFILE_MAGIC, profile_ram.header.magic);
+}
+
+static void spin_task(void *param) {
+  (void)param;
+  while (tick_now < SPIN_TICKS) {
+  }
+
+  // Nearly every tick landed in the loop above
+  uint32_t slot = pool_index_of(POOL_TCB, task_get_current());
+  uint32_t mine = 0;
+  const profile_entry_t *hottest = NULL;
+  for (size_t i = 0; i < PROFILE_HASH_SLOTS; i++) {
+    const profile_entry_t *e = &profile_ram.entries[i];
+    if (!e->count || e->task != slot) continue;
+    mine += e->count;
+    if (!hottest || e->count > hottest->count) hottest = e;
+  }
+
+  posix_child_check(strcmp(profile_ram.names[slot], "spin") == 0, 1);
+  posix_child_check(mine >= SPIN_TICKS / 2, 2);
+  posix_child_check(profile_ram.header.samples >= mine, 3);
+  uintptr_t offset = hottest->pc - (uintptr_t)spin_task;
+  posix_child_check(offset <= 256, 4);
+  _exit(0);
+}
+
+static void spin_scenario(void) {
+  task_create(spin_task, "spin", 0, NULL, 1);
+}
+
+void test_profile_should_sample_running_task_on_tick(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(spin_scenario));
+}
+
+int main(void) {
+  kernel_init();
+  worker = task_create(dummy_task, "worker", 0, NULL, 3);
+  other = task_create(dummy_task, "other", 0, NULL, 4);
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_profile_should_describe_layout_in_header);
+  RUN_TEST(test_profile_should_count_repeated_samples_once);
+  RUN_TEST(test_profile_should_key_samples_by_task);
+  RUN_TEST(test_profile_should_record_task_names);
+  RUN_TEST(test_profile_should_drop_when_probes_run_out);
+  RUN_TEST(test_profile_should_clear_on_reset);
+  RUN_TEST(test_profile_should_sample_running_task_on_tick);
+
+  return UNITY_END();
+}
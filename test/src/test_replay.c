@@ -0,0 +1,257 @@
+#include "critical.h"
+#include "kernel.h"
+#include "port.h"
+#include "posix_child.h"
+#include "queue.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "test_replay.h"
+#include "unity.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Record runs on the POSIX port take their interrupts and ticks from host
+// timing, so no two recordings are alike. Replays of one recording must
+// all see exactly what it saw. Each run is a forked child (kernel_start()
+// never returns) that leaves its trace and log in shared memory.
+
+#define LOG_LENGTH 64
+
+typedef enum { RUN_RECORD, RUN_REPLAY } run_mode_t;
+
+typedef struct log_entry {
+  uint32_t tick;
+  uint32_t result; // sem_wait() result
+  uint32_t value;  // Item received with it, 0 if none
+} log_entry_t;
+
+typedef struct run_result {
+  log_entry_t log[LOG_LENGTH];
+  replay_status_t status;
+  bool play_accepted;
+} run_result_t;
+
+typedef struct shared {
+  replay_buffer_t trace;
+  run_result_t record;
+  run_result_t replay;
+} shared_t;
+
+static shared_t *shared;
+static run_result_t *result; // This child's half of shared
+static run_mode_t mode;
+static task_priority_t ticker_priority;
+static int worker_jobs;
+
+static semaphore_handle_t irq_sem;
+static queue_handle_t irq_queue;
+
+static void spin(uint32_t loops) {
+  for (volatile uint32_t i = 0; i < loops; i++) {
+  }
+}
+
+//=============================================================================
+// SCENARIO
+//=============================================================================
+
+// The item is the live cycle count: it only repeats if it is replayed
+static void irq_handler(void) {
+  kernel_isr_enter();
+  uint32_t value = port_cycle_count() | 1;
+  sem_post(irq_sem);
+  queue_send(irq_queue, &value, 0);
+  kernel_isr_exit();
+}
+
+static void worker_task(void *param) {
+  (void)param;
+
+  for (int i = 0; i < worker_jobs; i++) {
+    log_entry_t scratch;
+    log_entry_t *entry = i < LOG_LENGTH ? &result->log[i] : &scratch;
+    entry->result = sem_wait(irq_sem, 3);
+
+    // A bare read could race a tick that replay places only to the next
+    // section boundary
+    KERNEL_CRITICAL_BEGIN();
+    entry->tick = tick_now;
+    KERNEL_CRITICAL_END();
+
+    if (queue_receive(irq_queue, &entry->value, 0) != QUEUE_SUCCESS) {
+      entry->value = 0;
+    }
+  }
+
+  if (mode == RUN_RECORD) {
+    replay_record_stop();
+    memcpy(&shared->trace, &replay_ram, sizeof(replay_ram));
+  }
+  replay_get_status(&result->status);
+  _exit(0);
+}
+
+// Raises the interrupt whenever the host clock says so
+static void trigger_task(void *param) {
+  (void)param;
+
+  for (uint32_t i = 0;; i++) {
+    spin(20000);
+    if ((port_cycle_count() >> 10) & 1) {
+      port_posix_trigger_irq();
+    }
+    if (i % 4 == 0) {
+      task_delay(1 + i % 3);
+    } else {
+      task_yield();
+    }
+  }
+}
+
+// Never calls the kernel while spinning; only ticks move it on
+static void spinner_task(void *param) {
+  (void)param;
+
+  while (1) {
+    spin(300000);
+    task_delay(2);
+  }
+}
+
+static void ticker_task(void *param) {
+  (void)param;
+
+  while (1) {
+    task_delay(1);
+    spin(5000);
+  }
+}
+
+static void scenario(void) {
+  kernel_init();
+  irq_sem = sem_create(0, 4, "irq");
+  irq_queue = queue_create(8, sizeof(uint32_t));
+  port_posix_set_irq_handler(irq_handler);
+
+  task_create(worker_task, "worker", 0, NULL, 1);
+  task_create(ticker_task, "ticker", 0, NULL, ticker_priority);
+  task_create(trigger_task, "trigger", 0, NULL, 3);
+  task_create(spinner_task, "spin0", 0, NULL, 4);
+  task_create(spinner_task, "spin1", 0, NULL, 4);
+
+  if (mode == RUN_RECORD) {
+    replay_record_start();
+  } else {
+    result->play_accepted = replay_play(&shared->trace, sizeof(shared->trace));
+    if (!result->play_accepted) {
+      _exit(0);
+    }
+  }
+}
+
+static int run_kernel(run_mode_t run_mode) {
+  mode = run_mode;
+  result = run_mode == RUN_RECORD ? &shared->record : &shared->replay;
+  return posix_child_run(scenario);
+}
+
+void setUp(void) {
+  memset(shared, 0, sizeof(*shared));
+  ticker_priority = 2;
+  worker_jobs = LOG_LENGTH;
+}
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_replay_should_reproduce_recorded_run(void) {
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_RECORD));
+  TEST_ASSERT_EQUAL(REPLAY_OFF, shared->record.status.state);
+  TEST_ASSERT_EQUAL_UINT32(0, shared->trace.header.truncated);
+  TEST_ASSERT_TRUE(shared->trace.header.records > LOG_LENGTH);
+
+  for (int run = 0; run < 3; run++) {
+    memset(&shared->replay, 0, sizeof(shared->replay));
+    TEST_ASSERT_EQUAL(0, run_kernel(RUN_REPLAY));
+
+    TEST_ASSERT_TRUE(shared->replay.play_accepted);
+    TEST_ASSERT_NOT_EQUAL(REPLAY_DIVERGED, shared->replay.status.state);
+    TEST_ASSERT_EQUAL_MEMORY(shared->record.log, shared->replay.log,
+                             sizeof(shared->record.log));
+    TEST_ASSERT_EQUAL_UINT32(shared->trace.header.digest,
+                             shared->replay.status.digest);
+  }
+}
+
+void test_replay_should_report_divergence_after_change(void) {
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_RECORD));
+
+  // The ticker now outranks the worker: same inputs, other decisions
+  ticker_priority = 0;
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_REPLAY));
+
+  TEST_ASSERT_TRUE(shared->replay.play_accepted);
+  TEST_ASSERT_EQUAL(REPLAY_DIVERGED, shared->replay.status.state);
+  TEST_ASSERT_TRUE(shared->replay.status.diverged_at <
+                   shared->trace.header.records);
+}
+
+void test_replay_should_reject_trace_for_missing_objects(void) {
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_RECORD));
+
+  // Point the first recorded send at a queue slot that does not exist
+  uint8_t *data = shared->trace.data;
+  uint32_t pos = 0;
+  bool patched = false;
+  while (!patched && pos < shared->trace.header.bytes) {
+    uint8_t type = data[pos++];
+    while (data[pos++] & 0x80) { // Section delta
+    }
+    while (data[pos++] & 0x80) { // Cycle offset
+    }
+    pos += 2; // Digest
+    if (type == REPLAY_RECORD_SEM_POST) {
+      pos += 1;
+    } else if (type == REPLAY_RECORD_QUEUE_SEND) {
+      data[pos] = MAX_QUEUES - 1;
+      patched = true;
+    }
+  }
+  TEST_ASSERT_TRUE(patched);
+
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_REPLAY));
+  TEST_ASSERT_FALSE(shared->replay.play_accepted);
+}
+
+void test_replay_should_stop_recording_when_buffer_fills(void) {
+  worker_jobs = 40 * LOG_LENGTH;
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_RECORD));
+  TEST_ASSERT_EQUAL_UINT32(1, shared->trace.header.truncated);
+  TEST_ASSERT_TRUE(shared->trace.header.bytes <= REPLAY_BUFFER_BYTES);
+
+  // What was kept still replays up to where it ends
+  TEST_ASSERT_EQUAL(0, run_kernel(RUN_REPLAY));
+  TEST_ASSERT_TRUE(shared->replay.play_accepted);
+  TEST_ASSERT_EQUAL(REPLAY_DONE, shared->replay.status.state);
+  TEST_ASSERT_EQUAL_UINT32(shared->trace.header.records,
+                           shared->replay.status.delivered);
+}
+
+int main(void) {
+  shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_replay_should_reproduce_recorded_run);
+  RUN_TEST(test_replay_should_report_divergence_after_change);
+  RUN_TEST(test_replay_should_reject_trace_for_missing_objects);
+  RUN_TEST(test_replay_should_stop_recording_when_buffer_fills);
+
+  return UNITY_END();
+}
@@ -0,0 +1,196 @@
+#include "kernel.h"
+#include "scheduler.h"
+#include "task.h"
+#include "test_scheduler.h"
+#include "unity.h"
+#include <stdint.h>
+
+// The ready queues and delay lists are driven directly on a kernel that is
+// initialised but not started: current_task is set by hand and ticks are
+// scheduler_tick() calls. Nothing switches, so every step is exact.
+
+#define MAX_TEST_TASKS 4
+
+static task_handle_t tasks[MAX_TEST_TASKS];
+static int task_count;
+
+static void spin_task(void *param) {
+  (void)param;
+  while (1) {
+  }
+}
+
+// Helper: a ready task, deleted again in tearDown
+static task_handle_t make_task(const char *name, task_priority_t priority) {
+  task_handle_t task = task_create(spin_task, name, 0, NULL, priority);
+  TEST_ASSERT_NOT_NULL(task);
+  tasks[task_count++] = task;
+  return task;
+}
+
+// Helper: what task_delay() does when called from the given task
+static void delay_task(task_handle_t task, uint32_t ticks) {
+  current_task = task;
+  scheduler_delay_current_task(ticks);
+  current_task = NULL;
+}
+
+// Helper: runs n ticks
+static void run_ticks(uint32_t n) {
+  while (n--) {
+    scheduler_tick();
+  }
+}
+
+void setUp(void) {
+  task_count = 0;
+  current_task = NULL;
+  tick_now = 0;
+}
+
+void tearDown(void) {
+  current_task = NULL;
+  while (task_count > 0) {
+    task_delete_internal(tasks[--task_count]);
+  }
+}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_scheduler_should_wake_delay_on_its_nth_tick(void) {
+  task_handle_t task = make_task("delay", 1);
+
+  // task_delay(1) sleeps until the next tick, not the one after
+  tick_now = 100;
+  delay_task(task, 1);
+  TEST_ASSERT_EQUAL(101, task->wake_tick);
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(TASK_READY, task->state);
+  TEST_ASSERT_EQUAL(WAKE_REASON_TIMEOUT, task->wake_reason);
+
+  delay_task(task, 3);
+  run_ticks(2);
+  TEST_ASSERT_EQUAL(TASK_BLOCKED, task->state);
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(TASK_READY, task->state);
+}
+
+void test_scheduler_should_wake_on_tick_zero(void) {
+  task_handle_t task = make_task("zero", 1);
+
+  // Due exactly on the tick that wraps the counter
+  tick_now = UINT32_MAX - 1;
+  delay_task(task, 2);
+  TEST_ASSERT_EQUAL_HEX32(0, task->wake_tick);
+
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(TASK_BLOCKED, task->state);
+  run_ticks(1);
+  TEST_ASSERT_EQUAL_HEX32(0, tick_now);
+  TEST_ASSERT_EQUAL(TASK_READY, task->state);
+  TEST_ASSERT_EQUAL(WAKE_REASON_TIMEOUT, task->wake_reason);
+}
+
+void test_scheduler_should_wake_delay_armed_before_the_wrap(void) {
+  task_handle_t task = make_task("wrap", 1);
+  task_handle_t parked = make_task("parked", 1);
+
+  // Due at 0x10, after the wrap: on the current list, not the overflow one
+  tick_now = UINT32_MAX - 0xf;
+  delay_task(task, 0x20);
+  // More than half the counter away, so it waits on the overflow list
+  delay_task(parked, 0x80000008u);
+  TEST_ASSERT_EQUAL_HEX32(0x10, task->wake_tick);
+  TEST_ASSERT_EQUAL_HEX32(0x7ffffff8u, parked->wake_tick);
+
+  // Swapping the lists on the wrap would park the first one for an epoch
+  run_ticks(0x1f);
+  TEST_ASSERT_EQUAL(TASK_BLOCKED, task->state);
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(TASK_READY, task->state);
+  TEST_ASSERT_EQUAL(WAKE_REASON_TIMEOUT, task->wake_reason);
+  TEST_ASSERT_EQUAL(TASK_BLOCKED, parked->state);
+
+  // The overflow list joined the current one on the wrap; skip ahead
+  // rather than run two billion ticks
+  tick_now = 0x7ffffff7u;
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(TASK_READY, parked->state);
+}
+
+void test_scheduler_should_requeue_running_task_on_priority_change(void) {
+  task_handle_t holder = make_task("holder", 3);
+  task_handle_t middle = make_task("middle", 2);
+
+  // A running task stays at the head of its ready queue
+  current_task = holder;
+  holder->state = TASK_RUNNING;
+  TEST_ASSERT_EQUAL_PTR(middle, scheduler_get_next_task());
+
+  // Boosted by a mutex waiter, it must move queues, not just relabel
+  scheduler_boost_priority(holder, 1);
+  TEST_ASSERT_EQUAL(1, holder->effective_priority);
+  TEST_ASSERT_EQUAL_PTR(holder, scheduler_get_next_task());
+
+  // Restored on unlock, it goes back behind the middle priority task
+  scheduler_restore_priority(holder);
+  TEST_ASSERT_EQUAL(3, holder->effective_priority);
+  TEST_ASSERT_EQUAL_PTR(middle, scheduler_get_next_task());
+  TEST_ASSERT_EQUAL(2, scheduler_get_highest_priority());
+}
+
+void test_scheduler_should_not_rotate_on_pick(void) {
+  task_handle_t first = make_task("first", 2);
+  task_handle_t second = make_task("second", 2);
+
+  TEST_ASSERT_EQUAL_PTR(first, scheduler_get_next_task());
+  TEST_ASSERT_EQUAL_PTR(first, scheduler_get_next_task());
+
+  // Preempted by a more urgent task, it gets the CPU back first when that
+  // one blocks, ahead of its equal-priority peer
+  current_task = first;
+  first->state = TASK_RUNNING;
+  task_handle_t urgent = make_task("urgent", 1);
+  TEST_ASSERT_EQUAL_PTR(urgent, scheduler_get_next_task());
+  task_set_state(urgent, TASK_BLOCKED);
+  TEST_ASSERT_EQUAL_PTR(first, scheduler_get_next_task());
+  (void)second;
+}
+
+void test_scheduler_should_rotate_equal_priorities_on_tick(void) {
+  task_handle_t first = make_task("first", 2);
+  task_handle_t second = make_task("second", 2);
+
+  current_task = first;
+  first->state = TASK_RUNNING;
+  run_ticks(1);
+
+#if SCHEDULER_TIME_SLICING
+  // The running task's slice is up: it goes behind its peer
+  TEST_ASSERT_EQUAL_PTR(second, scheduler_get_next_task());
+  current_task = second;
+  run_ticks(1);
+  TEST_ASSERT_EQUAL_PTR(first, scheduler_get_next_task());
+#else
+  // Cooperative: only a yield or a block gives up the CPU
+  TEST_ASSERT_EQUAL_PTR(first, scheduler_get_next_task());
+  (void)second;
+#endif
+}
+
+int main(void) {
+  kernel_init();
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_scheduler_should_wake_delay_on_its_nth_tick);
+  RUN_TEST(test_scheduler_should_wake_on_tick_zero);
+  RUN_TEST(test_scheduler_should_wake_delay_armed_before_the_wrap);
+  RUN_TEST(test_scheduler_should_requeue_running_task_on_priority_change);
+  RUN_TEST(test_scheduler_should_not_rotate_on_pick);
+  RUN_TEST(test_scheduler_should_rotate_equal_priorities_on_tick);
+
+  return UNITY_END();
+}
@@ -19,6 +19,13 @@ task_handle_t current_task = NULL;
 // Mock task structure for testing blocking behavior
 static task_control_block mock_task;
 
+// Counted so tests can tell whether a wait blocked and armed a timeout
+static int yield_calls;
+static int timeout_calls;
+
+// Stands in for the tasks that would run while the caller is blocked
+static void (*yield_hook)(void);
+
 // Mock scheduler functions
 void scheduler_cancel_timeout(task_handle_t task) {
   (void)task; // Mock implementation - do nothing
@@ -34,11 +41,16 @@ void scheduler_remove_task(task_handle_t task) {
 
 void scheduler_set_timeout(task_handle_t task, uint32_t wake_tick) {
   (void)task;
-  (void)wake_tick; // Mock implementation - do nothing
+  (void)wake_tick;
+  timeout_calls++;
 }
 
 void scheduler_yield(void) {
-  // Mock implementation - do nothing (in real system, this would context switch)
+  // In a real system this would context switch
+  yield_calls++;
+  if (yield_hook) {
+    yield_hook();
+  }
 }
 
 //=============================================================================
@@ -55,6 +67,9 @@ void setUp(void) {
   test_sem = NULL;
   tick_now = 0;
   current_task = NULL;
+  yield_calls = 0;
+  timeout_calls = 0;
+  yield_hook = NULL;
   
   // Initialize mock task
   memset(&mock_task, 0, sizeof(mock_task));
@@ -257,6 +272,29 @@ void test_sem_wait_should_return_timeout_when_deadline_exceeded(void) {
   TEST_ASSERT_EQUAL(SEM_ERROR_TIMEOUT, sem_wait(test_sem, 10));
 }
 
+// Posts on the first yield and times the wait out on any later one, so a
+// waiter that misses the post fails instead of blocking for ever
+static void post_on_first_yield(void) {
+  if (yield_calls == 1) {
+    TEST_ASSERT_TRUE(sem_has_waiting_tasks(test_sem));
+    sem_post(test_sem);
+  } else {
+    current_task->wake_reason = WAKE_REASON_TIMEOUT;
+  }
+}
+
+void test_sem_wait_forever_should_block_until_posted(void) {
+  test_sem = sem_create(0, 1, "TestSem");
+  current_task = &mock_task;
+  yield_hook = post_on_first_yield;
+
+  // The forever deadline is start - 1, which must not read as expired
+  tick_now = 100;
+  TEST_ASSERT_EQUAL(SEM_OK, sem_wait(test_sem, SEM_WAIT_FOREVER));
+  TEST_ASSERT_EQUAL(1, yield_calls);
+  TEST_ASSERT_EQUAL(0, timeout_calls);
+}
+
 void test_sem_wait_should_handle_semaphore_deletion(void) {
   test_sem = sem_create(0, 1, "TestSem");
   
@@ -278,6 +316,20 @@ void test_sem_post_should_increment_count(void) {
   TEST_ASSERT_EQUAL(2, sem_get_count(test_sem));
 }
 
+void test_sem_post_should_hand_unit_to_waiter(void) {
+  test_sem = sem_create(0, 1, "TestSem");
+  current_task = &mock_task;
+  yield_hook = post_on_first_yield;
+
+  // The waiter wakes owning the unit; count never sees it, so neither a
+  // retry by the waiter nor another task can lose or steal it
+  TEST_ASSERT_EQUAL(SEM_OK, sem_wait(test_sem, 10));
+  TEST_ASSERT_EQUAL(1, yield_calls);
+  TEST_ASSERT_EQUAL(WAKE_REASON_DATA_AVAILABLE, mock_task.wake_reason);
+  TEST_ASSERT_EQUAL(0, sem_get_count(test_sem));
+  TEST_ASSERT_FALSE(sem_has_waiting_tasks(test_sem));
+}
+
 void test_sem_post_should_prevent_overflow(void) {
   test_sem = sem_create(2, 2, "TestSem");
   
@@ -465,8 +517,10 @@ int main(void) {
   RUN_TEST(test_sem_wait_should_succeed_when_tokens_available);
   RUN_TEST(test_sem_wait_should_timeout_when_no_tokens);
   RUN_TEST(test_sem_wait_should_return_timeout_when_deadline_exceeded);
+  RUN_TEST(test_sem_wait_forever_should_block_until_posted);
   RUN_TEST(test_sem_wait_should_handle_semaphore_deletion);
   RUN_TEST(test_sem_post_should_increment_count);
+  RUN_TEST(test_sem_post_should_hand_unit_to_waiter);
   RUN_TEST(test_sem_post_should_prevent_overflow);
 
   // Error handling tests
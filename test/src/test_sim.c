@@ -0,0 +1,323 @@
+#include "port.h"
+#include "sim.h"
+#include "test_sim.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The simulator boots the kernel once per process, so every scenario runs
+// in a forked child that hands its result back through shared memory.
+// Expected values are exact: the simulation has no host-time input.
+
+#define TICK (PORT_CYCLE_COUNTER_HZ / KERNEL_TICK_HZ)
+#define OPS(ops) ops, sizeof(ops) / sizeof(ops[0])
+
+static sim_result_t *shared_result;
+
+static bool run_sim(const sim_scenario_t *scenario, sim_result_t *result) {
+  fflush(stdout);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    _exit(sim_run(scenario, shared_result) ? 0 : 1);
+  }
+
+  int status;
+  waitpid(pid, &status, 0);
+  *result = *shared_result;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void setUp(void) { memset(shared_result, 0, sizeof(*shared_result)); }
+
+void tearDown(void) {}
+
+//=============================================================================
+// TIMING
+//=============================================================================
+
+void test_sim_should_release_periodic_task_on_every_tick(void) {
+  static const sim_op_t ops[] = {SIM_DELAY_UNTIL(1), SIM_COMPUTE(1000)};
+  static const sim_task_t tasks[] = {{"periodic", 1, OPS(ops), 0}};
+  const sim_scenario_t scenario = {
+      .tasks = tasks, .task_count = 1, .duration = 10 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  // Ticks 1-9; the tenth falls on the end of the run
+  TEST_ASSERT_EQUAL_UINT32(9, result.ticks);
+  TEST_ASSERT_EQUAL_UINT32(9, result.tasks[0].jobs);
+  TEST_ASSERT_EQUAL_UINT64(1000, result.tasks[0].response_min);
+  TEST_ASSERT_EQUAL_UINT64(1000, result.tasks[0].response_max);
+  TEST_ASSERT_EQUAL_UINT32(0, result.tasks[0].deadline_misses);
+  TEST_ASSERT_EQUAL_UINT64(10 * TICK, result.cycles);
+}
+
+void test_sim_should_charge_switch_cost_to_preempting_task(void) {
+  static const sim_op_t high_ops[] = {SIM_DELAY_UNTIL(2), SIM_COMPUTE(100)};
+  static const sim_op_t low_ops[] = {SIM_COMPUTE(100 * TICK)};
+  static const sim_task_t tasks[] = {
+      {"high", 1, OPS(high_ops), 0},
+      {"low", 3, OPS(low_ops), 0},
+  };
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 2,
+                                   .switch_cycles = 50,
+                                   .duration = 10 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  // Released on ticks 2, 4, 6 and 8, each one switch away from running
+  TEST_ASSERT_EQUAL_UINT32(4, result.tasks[0].jobs);
+  TEST_ASSERT_EQUAL_UINT64(150, result.tasks[0].response_min);
+  TEST_ASSERT_EQUAL_UINT64(150, result.tasks[0].response_max);
+  TEST_ASSERT_EQUAL_UINT32(50, result.tasks[0].wakeup_max_cycles);
+  TEST_ASSERT_EQUAL_UINT32(0, result.tasks[1].jobs);
+}
+
+void test_sim_should_count_overrun_as_deadline_miss(void) {
+  static const sim_op_t ops[] = {SIM_DELAY_UNTIL(1), SIM_COMPUTE(TICK + 1)};
+  static const sim_task_t tasks[] = {{"overrun", 1, OPS(ops), 3}};
+  const sim_scenario_t scenario = {
+      .tasks = tasks, .task_count = 1, .duration = 10 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  TEST_ASSERT_EQUAL_UINT32(3, result.tasks[0].jobs);
+  TEST_ASSERT_EQUAL_UINT32(2, result.tasks[0].deadline_misses);
+}
+
+//=============================================================================
+// INTERRUPTS
+//=============================================================================
+
+static const sim_op_t irq_handler_ops[] = {
+    SIM_SEM_WAIT(0, SIM_WAIT_FOREVER),
+    SIM_COMPUTE(200),
+};
+
+void test_sim_should_run_task_woken_from_idle_at_once(void) {
+  static const sim_task_t tasks[] = {{"handler", 1, OPS(irq_handler_ops), 0}};
+  static const sim_irq_t irqs[] = {
+      {TICK + TICK / 2, 0, 100, {SIM_OP_SEM_POST, 0, 0}},
+  };
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 1,
+                                   .irqs = irqs,
+                                   .irq_count = 1,
+                                   .semaphore_count = 1,
+                                   .duration = 3 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  TEST_ASSERT_EQUAL_UINT32(1, result.irqs);
+  TEST_ASSERT_EQUAL_UINT64(100, result.isr_cycles);
+  TEST_ASSERT_EQUAL_UINT32(1, result.tasks[0].jobs);
+  TEST_ASSERT_EQUAL_UINT64(200, result.tasks[0].response_max);
+}
+
+void test_sim_should_not_preempt_busy_task_until_next_tick(void) {
+  static const sim_op_t busy_ops[] = {SIM_COMPUTE(100 * TICK)};
+  static const sim_task_t tasks[] = {
+      {"handler", 1, OPS(irq_handler_ops), 0},
+      {"busy", 3, OPS(busy_ops), 0},
+  };
+  static const sim_irq_t irqs[] = {
+      {TICK + TICK / 2, 0, 100, {SIM_OP_SEM_POST, 0, 0}},
+  };
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 2,
+                                   .irqs = irqs,
+                                   .irq_count = 1,
+                                   .semaphore_count = 1,
+                                   .duration = 3 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  // A post from an ISR only readies the task; the tick at 2 ms switches
+  TEST_ASSERT_EQUAL_UINT32(1, result.tasks[0].jobs);
+  TEST_ASSERT_EQUAL_UINT64(TICK / 2 - 100 + 200,
+                           result.tasks[0].response_max);
+}
+
+//=============================================================================
+// BLOCKING
+//=============================================================================
+
+void test_sim_should_bound_inversion_with_priority_inheritance(void) {
+  static const sim_op_t high_ops[] = {
+      SIM_DELAY(1),
+      SIM_MUTEX_LOCK(0, SIM_WAIT_FOREVER),
+      SIM_COMPUTE(100),
+      SIM_MUTEX_UNLOCK(0),
+  };
+  static const sim_op_t mid_ops[] = {SIM_DELAY(1), SIM_COMPUTE(5 * TICK)};
+  static const sim_op_t low_ops[] = {
+      SIM_MUTEX_LOCK(0, SIM_WAIT_FOREVER),
+      SIM_COMPUTE(3 * TICK),
+      SIM_MUTEX_UNLOCK(0),
+      SIM_DELAY(100),
+  };
+  static const sim_task_t tasks[] = {
+      {"high", 1, OPS(high_ops), 1},
+      {"mid", 3, OPS(mid_ops), 1},
+      {"low", 4, OPS(low_ops), 1},
+  };
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 3,
+                                   .mutex_count = 1,
+                                   .duration = 20 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  // Waits out the rest of low's section (ticks 1-3), never mid's work
+  TEST_ASSERT_EQUAL_UINT32(1, result.tasks[0].jobs);
+  TEST_ASSERT_EQUAL_UINT64(2 * TICK + 100, result.tasks[0].response_max);
+}
+
+//=============================================================================
+// RUNTIME ACCOUNTING
+//=============================================================================
+
+void test_sim_should_account_runtime_per_task(void) {
+  static const sim_op_t quarter_ops[] = {SIM_DELAY_UNTIL(1),
+                                         SIM_COMPUTE(TICK / 4)};
+  static const sim_op_t half_ops[] = {SIM_DELAY_UNTIL(1),
+                                      SIM_COMPUTE(TICK / 2)};
+  static const sim_task_t tasks[] = {
+      {"quarter", 1, OPS(quarter_ops), 0},
+      {"half", 2, OPS(half_ops), 0},
+  };
+  // Lands in the middle of quarter's work on every tick
+  static const sim_irq_t irqs[] = {
+      {TICK + TICK / 8, TICK, 100, {SIM_OP_SEM_POST, 0, 0}},
+  };
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 2,
+                                   .irqs = irqs,
+                                   .irq_count = 1,
+                                   .semaphore_count = 1,
+                                   .duration = 10 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+
+  // Released on ticks 1-9, after one run at boot up to the first delay.
+  // Interrupt time is nobody's run time, so the tasks get exactly their
+  // compute and idle loses the interrupts'.
+  uint64_t idle = TICK + 9 * (TICK / 4 - 100);
+  TEST_ASSERT_EQUAL_UINT32(9, result.irqs);
+  TEST_ASSERT_EQUAL_UINT64(900, result.isr_cycles);
+  TEST_ASSERT_EQUAL_UINT32(10, result.tasks[0].run_count);
+  TEST_ASSERT_EQUAL_UINT64(9 * (TICK / 4), result.tasks[0].runtime_cycles);
+  TEST_ASSERT_EQUAL_UINT32(10, result.tasks[1].run_count);
+  TEST_ASSERT_EQUAL_UINT64(9 * (TICK / 2), result.tasks[1].runtime_cycles);
+  TEST_ASSERT_EQUAL_UINT64(idle, result.idle_cycles);
+
+  // The whole run fits in the first load slot
+  TEST_ASSERT_EQUAL_UINT32((10 * TICK - idle) * 1000 / (10 * TICK),
+                           result.cpu_load);
+}
+
+void test_sim_should_report_load_over_sliding_window(void) {
+  static const sim_op_t ops[] = {SIM_DELAY_UNTIL(1), SIM_COMPUTE(TICK / 2)};
+  static const sim_task_t tasks[] = {{"busy", 1, OPS(ops), 1000}};
+  const sim_scenario_t scenario = {
+      .tasks = tasks, .task_count = 1, .duration = 1500 * TICK};
+  sim_result_t result;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &result));
+  TEST_ASSERT_EQUAL_UINT32(1000, result.tasks[0].jobs);
+
+  // Busy at half load on ticks 1-1000, then idle. The window is the last
+  // RUNTIME_LOAD_SLOTS slots, ticks 500-1500, which hold jobs 500-1000;
+  // the load since boot would be a third.
+  TEST_ASSERT_EQUAL_UINT32(RUNTIME_LOAD_SLOTS * RUNTIME_LOAD_SLOT_TICKS,
+                           1000);
+  TEST_ASSERT_EQUAL_UINT32(501 * (uint64_t)(TICK / 2) * 1000 / (1000 * TICK),
+                           result.cpu_load);
+}
+
+void test_sim_should_repeat_runs_bit_for_bit(void) {
+  static const sim_op_t producer_ops[] = {
+      SIM_DELAY_UNTIL(1),
+      SIM_COMPUTE(TICK / 3),
+      SIM_QUEUE_SEND(0, SIM_WAIT_FOREVER),
+      SIM_MUTEX_LOCK(0, SIM_WAIT_FOREVER),
+      SIM_COMPUTE(700),
+      SIM_MUTEX_UNLOCK(0),
+  };
+  static const sim_op_t consumer_ops[] = {
+      SIM_QUEUE_RECEIVE(0, SIM_WAIT_FOREVER),
+      SIM_MUTEX_LOCK(0, SIM_WAIT_FOREVER),
+      SIM_COMPUTE(TICK / 2),
+      SIM_MUTEX_UNLOCK(0),
+  };
+  static const sim_op_t spin_ops[] = {SIM_COMPUTE(TICK / 7), SIM_YIELD()};
+  static const sim_task_t tasks[] = {
+      {"producer", 1, OPS(producer_ops), 0},
+      {"consumer", 2, OPS(consumer_ops), 0},
+      {"spin_a", 3, OPS(spin_ops), 0},
+      {"spin_b", 3, OPS(spin_ops), 0},
+  };
+  static const sim_irq_t irqs[] = {
+      {1234, 98765, 321, {SIM_OP_QUEUE_SEND, 0, 7}},
+  };
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 4,
+                                   .irqs = irqs,
+                                   .irq_count = 1,
+                                   .queue_count = 1,
+                                   .mutex_count = 1,
+                                   .switch_cycles = 90,
+                                   .duration = 500 * TICK};
+  sim_result_t first, second;
+
+  TEST_ASSERT_TRUE(run_sim(&scenario, &first));
+  TEST_ASSERT_TRUE(run_sim(&scenario, &second));
+
+  TEST_ASSERT_TRUE(first.tasks[1].jobs > 0);
+  TEST_ASSERT_EQUAL_MEMORY(&first, &second, sizeof(first));
+}
+
+void test_sim_should_reject_unknown_objects(void) {
+  static const sim_op_t ops[] = {SIM_SEM_WAIT(1, SIM_WAIT_FOREVER)};
+  static const sim_task_t tasks[] = {{"bad", 1, OPS(ops), 0}};
+  const sim_scenario_t scenario = {.tasks = tasks,
+                                   .task_count = 1,
+                                   .semaphore_count = 1,
+                                   .duration = TICK};
+  sim_result_t result;
+
+  // Rejected before the kernel boots, so no fork is needed
+  TEST_ASSERT_FALSE(sim_run(&scenario, &result));
+}
+
+int main(void) {
+  shared_result = mmap(NULL, sizeof(*shared_result), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_sim_should_release_periodic_task_on_every_tick);
+  RUN_TEST(test_sim_should_charge_switch_cost_to_preempting_task);
+  RUN_TEST(test_sim_should_count_overrun_as_deadline_miss);
+  RUN_TEST(test_sim_should_run_task_woken_from_idle_at_once);
+  RUN_TEST(test_sim_should_not_preempt_busy_task_until_next_tick);
+  RUN_TEST(test_sim_should_bound_inversion_with_priority_inheritance);
+  RUN_TEST(test_sim_should_account_runtime_per_task);
+  RUN_TEST(test_sim_should_report_load_over_sliding_window);
+  RUN_TEST(test_sim_should_repeat_runs_bit_for_bit);
+  RUN_TEST(test_sim_should_reject_unknown_objects);
+
+  return UNITY_END();
+}
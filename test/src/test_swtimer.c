@@ -0,0 +1,262 @@
+#include "kernel.h"
+#include "memory.h"
+#include "posix_child.h"
+#include "scheduler.h"
+#include "swtimer.h"
+#include "test_swtimer.h"
+#include "unity.h"
+#include <unistd.h>
+
+// Tick-context timers are driven by calling scheduler_tick() on a kernel
+// that is initialised but not started. The timer task test runs the
+// kernel in a forked child (posix_child.h).
+
+static uint32_t fires;
+static uint32_t fire_ticks[8];
+
+static void record_fire(swtimer_handle_t timer, void *arg) {
+  (void)timer;
+  (void)arg;
+  if (fires < sizeof(fire_ticks) / sizeof(fire_ticks[0])) {
+    fire_ticks[fires] = tick_now;
+  }
+  fires++;
+}
+
+// Helper: runs n ticks
+static void run_ticks(uint32_t n) {
+  while (n--) {
+    scheduler_tick();
+  }
+}
+
+void setUp(void) { fires = 0; }
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_swtimer_should_reject_bad_arguments(void) {
+  TEST_ASSERT_NULL(swtimer_create("zero", 0, SWTIMER_ONE_SHOT, record_fire,
+                                  NULL));
+  TEST_ASSERT_NULL(swtimer_create("none", 5, SWTIMER_ONE_SHOT, NULL, NULL));
+  TEST_ASSERT_EQUAL(SWTIMER_ERROR_NULL, swtimer_start(NULL));
+  TEST_ASSERT_EQUAL(SWTIMER_ERROR_NULL, swtimer_stop_from_isr(NULL));
+  TEST_ASSERT_FALSE(swtimer_is_active(NULL));
+
+  swtimer_handle_t timers[MAX_SWTIMERS];
+  for (int i = 0; i < MAX_SWTIMERS; i++) {
+    timers[i] = swtimer_create("t", 5, SWTIMER_ONE_SHOT, record_fire, NULL);
+    TEST_ASSERT_NOT_NULL(timers[i]);
+  }
+  TEST_ASSERT_NULL(swtimer_create("t", 5, SWTIMER_ONE_SHOT, record_fire, NULL));
+  TEST_ASSERT_EQUAL(SWTIMER_ERROR_PERIOD, swtimer_set_period(timers[0], 0));
+
+  for (int i = 0; i < MAX_SWTIMERS; i++) {
+    swtimer_delete(timers[i]);
+  }
+  TEST_ASSERT_EQUAL(0, pool_get_stats(POOL_TMCB).used_objects);
+}
+
+void test_swtimer_should_fire_one_shot_once(void) {
+  swtimer_handle_t timer = swtimer_create(
+      "once", 5, SWTIMER_ONE_SHOT | SWTIMER_IN_TICK, record_fire, NULL);
+  TEST_ASSERT_FALSE(swtimer_is_active(timer));
+
+  uint32_t start = tick_now;
+  swtimer_start(timer);
+  TEST_ASSERT_TRUE(swtimer_is_active(timer));
+
+  run_ticks(4);
+  TEST_ASSERT_EQUAL(0, fires);
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(1, fires);
+  TEST_ASSERT_EQUAL(start + 5, fire_ticks[0]);
+  TEST_ASSERT_FALSE(swtimer_is_active(timer));
+
+  run_ticks(SWTIMER_WHEEL_SLOTS * 2);
+  TEST_ASSERT_EQUAL(1, fires);
+
+  swtimer_delete(timer);
+}
+
+void test_swtimer_should_fire_periodic_without_drift(void) {
+  swtimer_handle_t timer = swtimer_create(
+      "tick3", 3, SWTIMER_PERIODIC | SWTIMER_IN_TICK, record_fire, NULL);
+
+  uint32_t start = tick_now;
+  swtimer_start(timer);
+  run_ticks(3 * 5 + 2);
+
+  TEST_ASSERT_EQUAL(5, fires);
+  for (uint32_t i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL(start + 3 * (i + 1), fire_ticks[i]);
+  }
+  TEST_ASSERT_TRUE(swtimer_is_active(timer));
+
+  swtimer_stop(timer);
+  run_ticks(10);
+  TEST_ASSERT_EQUAL(5, fires);
+
+  swtimer_delete(timer);
+}
+
+void test_swtimer_should_fire_beyond_one_turn_of_the_wheel(void) {
+  uint32_t period = SWTIMER_WHEEL_SLOTS * 3 + 7;
+  swtimer_handle_t timer = swtimer_create(
+      "long", period, SWTIMER_ONE_SHOT | SWTIMER_IN_TICK, record_fire, NULL);
+  // Shares its slot with the long one but is due a turn earlier
+  swtimer_handle_t short_timer =
+      swtimer_create("short", period - SWTIMER_WHEEL_SLOTS,
+                     SWTIMER_ONE_SHOT | SWTIMER_IN_TICK, record_fire, NULL);
+
+  uint32_t start = tick_now;
+  swtimer_start(timer);
+  swtimer_start(short_timer);
+  run_ticks(period);
+
+  TEST_ASSERT_EQUAL(2, fires);
+  TEST_ASSERT_EQUAL(start + period - SWTIMER_WHEEL_SLOTS, fire_ticks[0]);
+  TEST_ASSERT_EQUAL(start + period, fire_ticks[1]);
+
+  swtimer_delete(timer);
+  swtimer_delete(short_timer);
+}
+
+void test_swtimer_should_stop_start_and_reset(void) {
+  swtimer_handle_t timer = swtimer_create(
+      "ctl", 10, SWTIMER_ONE_SHOT | SWTIMER_IN_TICK, record_fire, NULL);
+
+  // Stopped before expiry: never fires
+  swtimer_start(timer);
+  run_ticks(5);
+  swtimer_stop(timer);
+  run_ticks(10);
+  TEST_ASSERT_EQUAL(0, fires);
+
+  // Start leaves a running timer alone, reset restarts the count
+  uint32_t start = tick_now;
+  swtimer_start(timer);
+  run_ticks(5);
+  swtimer_start(timer);
+  run_ticks(5);
+  TEST_ASSERT_EQUAL(1, fires);
+  TEST_ASSERT_EQUAL(start + 10, fire_ticks[0]);
+
+  start = tick_now;
+  swtimer_start(timer);
+  run_ticks(5);
+  swtimer_reset(timer);
+  run_ticks(9);
+  TEST_ASSERT_EQUAL(1, fires);
+  run_ticks(1);
+  TEST_ASSERT_EQUAL(2, fires);
+  TEST_ASSERT_EQUAL(start + 15, fire_ticks[1]);
+
+  // A new period applies from the next start
+  swtimer_set_period(timer, 2);
+  swtimer_start(timer);
+  run_ticks(2);
+  TEST_ASSERT_EQUAL(3, fires);
+
+  swtimer_delete(timer);
+}
+
+static volatile uint32_t task_fires;
+static volatile uint32_t kicked_fires;
+static volatile bool wrong_context;
+
+static void count_in_task(swtimer_handle_t timer, void *arg) {
+  (void)timer;
+  (void)arg;
+  if (task_get_current() != swtimer_get_task()) wrong_context = true;
+  task_fires++;
+}
+
+static void count_kicked(swtimer_handle_t timer, void *arg) {
+  (void)timer;
+  (void)arg;
+  kicked_fires++;
+}
+
+// Runs in the tick interrupt, so it has to go through the command queue
+static void kick_from_tick(swtimer_handle_t timer, void *arg) {
+  (void)timer;
+  swtimer_start_from_isr(arg);
+}
+
+static void checker_task(void *param) {
+  (void)param;
+  swtimer_handle_t periodic =
+      swtimer_create("periodic", 10, SWTIMER_PERIODIC, count_in_task, NULL);
+  swtimer_handle_t kicked =
+      swtimer_create("kicked", 5, SWTIMER_ONE_SHOT, count_kicked, NULL);
+  swtimer_handle_t kicker =
+      swtimer_create("kicker", 20, SWTIMER_ONE_SHOT | SWTIMER_IN_TICK,
+                     kick_from_tick, kicked);
+
+  swtimer_start(periodic);
+  swtimer_start(kicker);
+  task_delay(105);
+
+  posix_child_check(task_fires == 10, 1);
+  posix_child_check(!wrong_context, 2);
+  posix_child_check(kicked_fires == 1, 3); // Started at tick 20, fired at 25
+  posix_child_check(!swtimer_is_active(kicked), 4);
+  posix_child_check(swtimer_is_active(periodic), 5);
+  _exit(0);
+}
+
+static void checker_scenario(void) {
+  // Below the timer task, so callbacks run as soon as they are due
+  task_create(checker_task, "checker", 0, NULL, SWTIMER_TASK_PRIORITY + 1);
+}
+
+void test_swtimer_should_run_callbacks_in_timer_task(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(checker_scenario));
+}
+
+static void delete_task(void *param) {
+  (void)param;
+  uint32_t used = pool_get_stats(POOL_TMCB).used_objects;
+  swtimer_handle_t timer =
+      swtimer_create("doomed", 5, SWTIMER_ONE_SHOT, count_kicked, NULL);
+
+  // Above the timer task, so both commands are still queued at the delete
+  posix_child_check(swtimer_start_from_isr(timer) == SWTIMER_OK, 1);
+  posix_child_check(swtimer_reset_from_isr(timer) == SWTIMER_OK, 2);
+  swtimer_delete(timer);
+  posix_child_check(pool_get_stats(POOL_TMCB).used_objects == used + 1, 3);
+
+  // The timer task drops both commands, then frees the block
+  task_delay(20);
+  posix_child_check(pool_get_stats(POOL_TMCB).used_objects == used, 4);
+  posix_child_check(kicked_fires == 0, 5);
+  _exit(0);
+}
+
+static void delete_scenario(void) {
+  task_create(delete_task, "delete", 0, NULL, SWTIMER_TASK_PRIORITY - 1);
+}
+
+void test_swtimer_should_drop_queued_commands_of_deleted_timer(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(delete_scenario));
+}
+
+int main(void) {
+  kernel_init();
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_swtimer_should_reject_bad_arguments);
+  RUN_TEST(test_swtimer_should_fire_one_shot_once);
+  RUN_TEST(test_swtimer_should_fire_periodic_without_drift);
+  RUN_TEST(test_swtimer_should_fire_beyond_one_turn_of_the_wheel);
+  RUN_TEST(test_swtimer_should_stop_start_and_reset);
+  RUN_TEST(test_swtimer_should_run_callbacks_in_timer_task);
+  RUN_TEST(test_swtimer_should_drop_queued_commands_of_deleted_timer);
+
+  return UNITY_END();
+}
@@ -6,8 +6,14 @@
 #include <string.h>
 
 // Mock scheduler functions for testing
+static task_handle_t removed_task;
+
 void scheduler_remove_task(task_handle_t task) {
-  (void)task; // Mock implementation - do nothing
+  // Takes it off whatever list stands in for its ready queue
+  removed_task = task;
+  if (task && !list_is_empty(&task->ready_link)) {
+    list_remove(&task->ready_link);
+  }
 }
 
 // Test fixture - global variables
@@ -26,6 +32,7 @@ void setUp(void) {
     // Initialize memory pools before each test
     memory_pools_init();
     test_task = NULL; 
+    removed_task = NULL;
 }
 
 void tearDown(void) {
@@ -246,6 +253,24 @@ void test_task_set_state_should_update_state(void) {
   TEST_ASSERT_EQUAL(TASK_SUSPENDED, test_task->state);
 }
 
+void test_task_set_state_should_dequeue_blocked_task(void) {
+  static list_head_t ready_queue; // Outlives the test, for tearDown
+  list_init(&ready_queue);
+  test_task =
+      task_create_internal(dummy_task_function, "TestTask", 512, NULL, 3);
+  list_insert_tail(&ready_queue, &test_task->ready_link);
+
+  // Running tasks stay queued
+  task_set_state(test_task, TASK_RUNNING);
+  TEST_ASSERT_NULL(removed_task);
+  TEST_ASSERT_FALSE(list_is_empty(&ready_queue));
+
+  // A blocked one left queued would keep being picked
+  task_set_state(test_task, TASK_BLOCKED);
+  TEST_ASSERT_EQUAL_PTR(test_task, removed_task);
+  TEST_ASSERT_TRUE(list_is_empty(&ready_queue));
+}
+
 void test_task_set_state_should_handle_null_task(void) {
   // Should not crash
   task_set_state(NULL, TASK_RUNNING);
@@ -327,6 +352,14 @@ void test_task_init_stack_should_set_psr_thumb_bit(void) {
   TEST_ASSERT_EQUAL_HEX32(0x01000000, *psr_location);
 }
 
+void test_task_init_stack_should_set_initial_exc_return(void) {
+  test_task =
+      task_create_internal(dummy_task_function, "TestTask", 512, NULL, 3);
+
+  // Tasks start without an FP frame: Thread mode, PSP, basic frame
+  TEST_ASSERT_EQUAL_HEX32(TASK_INITIAL_EXC_RETURN, test_task->exc_return);
+}
+
 void test_task_stack_check_should_detect_valid_stack(void) {
   test_task =
       task_create_internal(dummy_task_function, "TestTask", 512, NULL, 3);
@@ -356,6 +389,44 @@ void test_task_stack_used_bytes_should_handle_null_task(void) {
   TEST_ASSERT_EQUAL(0, task_stack_used_bytes(NULL));
 }
 
+void test_task_stack_high_water_should_cover_initial_frame(void) {
+  test_task =
+      task_create_internal(dummy_task_function, "TestTask", 512, NULL, 3);
+
+  // Only the initial 16-word frame has been written so far
+  TEST_ASSERT_EQUAL(64, task_stack_high_water(test_task));
+  TEST_ASSERT_EQUAL(512 - 64, test_task->stack_min_headroom);
+}
+
+void test_task_stack_high_water_should_track_deepest_word(void) {
+  test_task =
+      task_create_internal(dummy_task_function, "TestTask", 512, NULL, 3);
+
+  // Simulate a deep call chain that has since returned
+  test_task->stack_base[32] = 0;
+
+  TEST_ASSERT_EQUAL(512 - 32 * sizeof(uint32_t),
+                    task_stack_high_water(test_task));
+}
+
+void test_task_stack_high_water_should_handle_null_task(void) {
+  TEST_ASSERT_EQUAL(0, task_stack_high_water(NULL));
+}
+
+void test_task_stack_sweep_should_record_min_headroom(void) {
+  test_task =
+      task_create_internal(dummy_task_function, "TestTask", 512, NULL, 3);
+
+  test_task->stack_base[100] = 0;
+  task_stack_sweep();
+  TEST_ASSERT_EQUAL(100 * sizeof(uint32_t), test_task->stack_min_headroom);
+
+  // Headroom only ever shrinks, even if the stack is repainted
+  test_task->stack_base[100] = STACK_PAINT_PATTERN;
+  task_stack_sweep();
+  TEST_ASSERT_EQUAL(100 * sizeof(uint32_t), test_task->stack_min_headroom);
+}
+
 //=============================================================================
 // TASK PROPERTIES TESTS
 //=============================================================================
@@ -538,6 +609,7 @@ int main(void) {
 
   // Task state management tests
   RUN_TEST(test_task_set_state_should_update_state);
+  RUN_TEST(test_task_set_state_should_dequeue_blocked_task);
   RUN_TEST(test_task_set_state_should_handle_null_task);
   RUN_TEST(test_task_get_state_should_return_current_state);
   RUN_TEST(test_task_get_state_should_return_deleted_for_null_task);
@@ -547,10 +619,15 @@ int main(void) {
   RUN_TEST(test_task_init_stack_should_set_function_address);
   RUN_TEST(test_task_init_stack_should_set_parameter_in_r0);
   RUN_TEST(test_task_init_stack_should_set_psr_thumb_bit);
+  RUN_TEST(test_task_init_stack_should_set_initial_exc_return);
   RUN_TEST(test_task_stack_check_should_detect_valid_stack);
   RUN_TEST(test_task_stack_check_should_handle_null_task);
   RUN_TEST(test_task_stack_used_bytes_should_calculate_correctly);
   RUN_TEST(test_task_stack_used_bytes_should_handle_null_task);
+  RUN_TEST(test_task_stack_high_water_should_cover_initial_frame);
+  RUN_TEST(test_task_stack_high_water_should_track_deepest_word);
+  RUN_TEST(test_task_stack_high_water_should_handle_null_task);
+  RUN_TEST(test_task_stack_sweep_should_record_min_headroom);
 
   // Task properties tests
   RUN_TEST(test_task_should_store_name_correctly);
@@ -0,0 +1,256 @@
+#include "kernel.h"
+#include "memory.h"
+#include "mutex.h"
+#include "posix_child.h"
+#include "queue.h"
+#include "semaphore.h"
+#include "telemetry.h"
+#include "test_telemetry.h"
+#include "unity.h"
+#include <string.h>
+#include <unistd.h>
+
+// Snapshots are taken of a kernel that is initialised but not started,
+// except for the runtime test, which runs the kernel in a forked child
+// (posix_child.h).
+
+static uint8_t frame[1024];
+static size_t frame_length;
+
+static task_handle_t worker;
+static queue_handle_t queue;
+static semaphore_handle_t sem;
+static mutex_handle_t mutex;
+
+static uint32_t u16_at(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+static uint32_t u32_at(const uint8_t *p) {
+  return u16_at(p) | u16_at(p + 2) << 16;
+}
+
+static uint64_t u64_at(const uint8_t *p) {
+  return u32_at(p) | (uint64_t)u32_at(p + 4) << 32;
+}
+
+// Helper: value of the n-th entry of a type, or NULL; sets its length
+static const uint8_t *find_entry(uint8_t type, int n, size_t *length) {
+  size_t pos = TELEMETRY_HEADER_SIZE;
+  while (pos + 2 <= frame_length) {
+    if (frame[pos] == type && n-- == 0) {
+      *length = frame[pos + 1];
+      return &frame[pos + 2];
+    }
+    pos += 2 + frame[pos + 1];
+  }
+  return NULL;
+}
+
+// Helper: the entry of a type whose first byte (slot) matches
+static const uint8_t *find_slot(uint8_t type, int slot, size_t *length) {
+  const uint8_t *value;
+  for (int n = 0; (value = find_entry(type, n, length)); n++) {
+    if (value[0] == slot) return value;
+  }
+  return NULL;
+}
+
+static void dummy_task(void *param) {
+  (void)param;
+  while (1) {
+  }
+}
+
+void setUp(void) {
+  memset(frame, 0, sizeof(frame));
+  frame_length = 0;
+}
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_telemetry_should_reject_bad_buffers(void) {
+  TEST_ASSERT_EQUAL(TELEMETRY_ERROR_NULL,
+                    telemetry_snapshot(NULL, sizeof(frame), &frame_length));
+  TEST_ASSERT_EQUAL(TELEMETRY_ERROR_NULL,
+                    telemetry_snapshot(frame, sizeof(frame), NULL));
+  TEST_ASSERT_EQUAL(TELEMETRY_ERROR_TOO_SMALL,
+                    telemetry_snapshot(frame, TELEMETRY_HEADER_SIZE - 1,
+                                       &frame_length));
+}
+
+void test_telemetry_should_fill_header(void) {
+  TEST_ASSERT_EQUAL(TELEMETRY_OK,
+                    telemetry_snapshot(frame, sizeof(frame), &frame_length));
+  uint32_t first_sequence = u32_at(&frame[8]);
+
+  TEST_ASSERT_EQUAL_HEX32(TELEMETRY_MAGIC, u32_at(&frame[0]));
+  TEST_ASSERT_EQUAL(TELEMETRY_VERSION, frame[4]);
+  TEST_ASSERT_EQUAL(0, frame[5]);
+  TEST_ASSERT_EQUAL(frame_length, u16_at(&frame[6]));
+  TEST_ASSERT_TRUE(u32_at(&frame[16]) >= u32_at(&frame[12]));
+
+  TEST_ASSERT_EQUAL(TELEMETRY_OK,
+                    telemetry_snapshot(frame, sizeof(frame), &frame_length));
+  TEST_ASSERT_EQUAL(first_sequence + 1, u32_at(&frame[8]));
+
+  // Entries tile the frame exactly
+  size_t pos = TELEMETRY_HEADER_SIZE;
+  while (pos < frame_length) {
+    pos += 2 + frame[pos + 1];
+  }
+  TEST_ASSERT_EQUAL(frame_length, pos);
+}
+
+void test_telemetry_should_report_every_pool(void) {
+  telemetry_snapshot(frame, sizeof(frame), &frame_length);
+
+  for (int i = 0; i < POOL_COUNT; i++) {
+    size_t length;
+    const uint8_t *pool = find_slot(TELEMETRY_ENTRY_POOL, i, &length);
+    pool_stats_t stats = pool_get_stats((pool_type_t)i);
+
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL(9, length);
+    TEST_ASSERT_EQUAL(stats.total_objects, u16_at(pool + 1));
+    TEST_ASSERT_EQUAL(stats.used_objects, u16_at(pool + 3));
+    TEST_ASSERT_EQUAL(stats.peak_usage, u16_at(pool + 5));
+    TEST_ASSERT_EQUAL(stats.corruptions, u16_at(pool + 7));
+  }
+}
+
+void test_telemetry_should_report_tasks(void) {
+  telemetry_snapshot(frame, sizeof(frame), &frame_length);
+
+  size_t length;
+  const uint8_t *kernel = find_entry(TELEMETRY_ENTRY_KERNEL, 0, &length);
+  TEST_ASSERT_NOT_NULL(kernel);
+  TEST_ASSERT_EQUAL(15, length);
+  TEST_ASSERT_EQUAL(2, kernel[14]); // Idle and worker
+
+  int slot = pool_index_of(POOL_TCB, worker);
+  const uint8_t *task = find_slot(TELEMETRY_ENTRY_TASK, slot, &length);
+  TEST_ASSERT_NOT_NULL(task);
+  TEST_ASSERT_EQUAL(20 + strlen("worker"), length);
+  TEST_ASSERT_EQUAL(TASK_READY, task[1]);
+  TEST_ASSERT_EQUAL(3, task[2]);
+  TEST_ASSERT_EQUAL(3, task[3]);
+  TEST_ASSERT_EQUAL(worker->stack_size, u16_at(task + 4));
+  TEST_ASSERT_EQUAL(worker->stack_min_headroom, u16_at(task + 6));
+  TEST_ASSERT_TRUE(u16_at(task + 6) > 0);
+  TEST_ASSERT_EQUAL_MEMORY("worker", task + 20, strlen("worker"));
+
+  const uint8_t *idle = find_slot(TELEMETRY_ENTRY_TASK,
+                                  pool_index_of(POOL_TCB, kernel_get_idle_task()),
+                                  &length);
+  TEST_ASSERT_NOT_NULL(idle);
+  TEST_ASSERT_EQUAL(MAX_PRIORITY, idle[2]);
+}
+
+void test_telemetry_should_report_queue_semaphore_and_mutex(void) {
+  uint32_t item = 7;
+  queue_send_immediate(queue, &item);
+  queue_send_immediate(queue, &item);
+  mutex->owner = worker;
+
+  telemetry_snapshot(frame, sizeof(frame), &frame_length);
+
+  size_t length;
+  const uint8_t *q =
+      find_slot(TELEMETRY_ENTRY_QUEUE, pool_index_of(POOL_QCB, queue), &length);
+  TEST_ASSERT_NOT_NULL(q);
+  TEST_ASSERT_EQUAL(8, length);
+  TEST_ASSERT_EQUAL(2, u16_at(q + 1));
+  TEST_ASSERT_EQUAL(4, u16_at(q + 3));
+  TEST_ASSERT_EQUAL(sizeof(uint32_t), u16_at(q + 5));
+  TEST_ASSERT_EQUAL(0, q[7]);
+
+  const uint8_t *s =
+      find_slot(TELEMETRY_ENTRY_SEM, pool_index_of(POOL_SCB, sem), &length);
+  TEST_ASSERT_NOT_NULL(s);
+  TEST_ASSERT_EQUAL(10 + strlen("rx_done"), length);
+  TEST_ASSERT_EQUAL(1, u32_at(s + 1));
+  TEST_ASSERT_EQUAL(5, u32_at(s + 5));
+  TEST_ASSERT_EQUAL_MEMORY("rx_done", s + 10, strlen("rx_done"));
+
+  const uint8_t *m =
+      find_slot(TELEMETRY_ENTRY_MUTEX, pool_index_of(POOL_MCB, mutex), &length);
+  TEST_ASSERT_NOT_NULL(m);
+  TEST_ASSERT_EQUAL(pool_index_of(POOL_TCB, worker), m[1]);
+  TEST_ASSERT_EQUAL_MEMORY("bus", m + 3, strlen("bus"));
+
+  mutex->owner = NULL;
+  telemetry_snapshot(frame, sizeof(frame), &frame_length);
+  m = find_slot(TELEMETRY_ENTRY_MUTEX, pool_index_of(POOL_MCB, mutex), &length);
+  TEST_ASSERT_EQUAL(TELEMETRY_NO_TASK, m[1]);
+
+  queue_receive_immediate(queue, &item);
+  queue_receive_immediate(queue, &item);
+}
+
+void test_telemetry_should_keep_entries_whole_when_truncated(void) {
+  size_t full;
+  telemetry_snapshot(frame, sizeof(frame), &full);
+
+  for (size_t size = TELEMETRY_HEADER_SIZE; size < full; size += 7) {
+    memset(frame, 0xEE, sizeof(frame));
+    TEST_ASSERT_EQUAL(TELEMETRY_OK,
+                      telemetry_snapshot(frame, size, &frame_length));
+    TEST_ASSERT_TRUE(frame_length <= size);
+    TEST_ASSERT_EQUAL(TELEMETRY_FLAG_TRUNCATED, frame[5]);
+    TEST_ASSERT_EQUAL(frame_length, u16_at(&frame[6]));
+    TEST_ASSERT_EQUAL_HEX8(0xEE, frame[size]);
+
+    size_t pos = TELEMETRY_HEADER_SIZE;
+    while (pos < frame_length) {
+      pos += 2 + frame[pos + 1];
+    }
+    TEST_ASSERT_EQUAL(frame_length, pos);
+  }
+}
+
+static void snapshot_task(void *param) {
+  (void)param;
+  task_delay(5);
+
+  telemetry_snapshot(frame, sizeof(frame), &frame_length);
+  size_t length;
+  const uint8_t *self = find_slot(
+      TELEMETRY_ENTRY_TASK, pool_index_of(POOL_TCB, task_get_current()), &length);
+  posix_child_check(self != NULL, 1);
+  posix_child_check(self[1] == TASK_RUNNING, 2);
+  posix_child_check(u32_at(self + 8) != 0, 3);   // Run count
+  posix_child_check(u64_at(self + 12) != 0, 4);  // Runtime cycles
+  posix_child_check(u32_at(&frame[16]) >= 5, 5); // Tick at end
+  _exit(0);
+}
+
+static void snapshot_scenario(void) {
+  task_create(snapshot_task, "snap", 0, NULL, 1);
+}
+
+void test_telemetry_should_report_runtime_while_running(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(snapshot_scenario));
+}
+
+int main(void) {
+  kernel_init();
+  worker = task_create(dummy_task, "worker", 0, NULL, 3);
+  queue = queue_create(4, sizeof(uint32_t));
+  sem = sem_create(1, 5, "rx_done");
+  mutex = mutex_create("bus");
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_telemetry_should_reject_bad_buffers);
+  RUN_TEST(test_telemetry_should_fill_header);
+  RUN_TEST(test_telemetry_should_report_every_pool);
+  RUN_TEST(test_telemetry_should_report_tasks);
+  RUN_TEST(test_telemetry_should_report_queue_semaphore_and_mutex);
+  RUN_TEST(test_telemetry_should_keep_entries_whole_when_truncated);
+  RUN_TEST(test_telemetry_should_report_runtime_while_running);
+
+  return UNITY_END();
+}
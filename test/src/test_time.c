@@ -0,0 +1,282 @@
+#include "kernel.h"
+#include "klog.h"
+#include "latency_stats.h"
+#include "port.h"
+#include "posix_child.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "test_time.h"
+#include "time_utils.h"
+#include "trace.h"
+#include "unity.h"
+#include <unistd.h>
+
+// The conversions assume the default KERNEL_TICK_HZ of 1000. The deadline
+// and clock change tests run the kernel in a forked child (posix_child.h).
+
+#define DEADLINE_TICKS 5
+#define RESCALE_TIMEOUT_MS 200
+#define RESCALE_TICK_HZ 100
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_time_should_convert_durations_to_ticks_rounding_up(void) {
+  TEST_ASSERT_EQUAL(1000, KERNEL_TICK_HZ);
+
+  TEST_ASSERT_EQUAL(0, time_ms_to_ticks(0));
+  TEST_ASSERT_EQUAL(5, time_ms_to_ticks(5));
+  TEST_ASSERT_EQUAL(0xFFFFFFFEu, time_ms_to_ticks(0xFFFFFFFEu));
+
+  TEST_ASSERT_EQUAL(0, time_us_to_ticks(0));
+  TEST_ASSERT_EQUAL(1, time_us_to_ticks(1));
+  TEST_ASSERT_EQUAL(1, time_us_to_ticks(1000));
+  TEST_ASSERT_EQUAL(2, time_us_to_ticks(1001));
+}
+
+void test_time_should_convert_ticks_and_cycles_to_time(void) {
+  TEST_ASSERT_EQUAL_UINT64(1500, time_ticks_to_ms(1500));
+  TEST_ASSERT_EQUAL_UINT64(1500000, time_ticks_to_us(1500));
+  TEST_ASSERT_EQUAL_UINT64(0x100000000ull * 1000,
+                           time_ticks_to_us(0x100000000ull));
+
+  TEST_ASSERT_EQUAL_UINT64(1, time_cycles_to_us(168, 168000000u));
+  TEST_ASSERT_EQUAL_UINT64(0, time_cycles_to_us(167, 168000000u));
+
+  // A year of 168 MHz cycles overflows cycles * 10^6 in 64 bits
+  uint64_t year_s = 365ull * 24 * 3600;
+  TEST_ASSERT_EQUAL_UINT64(year_s * 1000000u,
+                           time_cycles_to_us(year_s * 168000000u, 168000000u));
+}
+
+void test_time_should_clamp_deadlines_to_timeouts(void) {
+  TEST_ASSERT_EQUAL(0, ticks_until64(100, 100));
+  TEST_ASSERT_EQUAL(0, ticks_until64(99, 100));
+  TEST_ASSERT_EQUAL(7, ticks_until64(0x100000003ull, 0xFFFFFFFCull));
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFEu, ticks_until64(UINT64_MAX, 0));
+  TEST_ASSERT_NOT_EQUAL(SEM_WAIT_FOREVER, ticks_until64(0xFFFFFFFFull, 0));
+}
+
+void test_time_should_extend_tick_count_across_wrap(void) {
+  scheduler_init();
+  TEST_ASSERT_EQUAL_UINT64(0, kernel_get_ticks64());
+
+  tick_now = 0xFFFFFFFEu;
+  scheduler_tick();
+  TEST_ASSERT_EQUAL_UINT64(0xFFFFFFFFull, kernel_get_ticks64());
+  scheduler_tick();
+  TEST_ASSERT_EQUAL_UINT64(0x100000000ull, kernel_get_ticks64());
+  scheduler_tick();
+  TEST_ASSERT_EQUAL_UINT64(0x100000001ull, kernel_get_ticks64());
+  TEST_ASSERT_EQUAL(10, kernel_ticks_until(0x10000000Bull));
+
+  scheduler_init();
+}
+
+void test_time_should_keep_cycle_time_monotonic(void) {
+  uint64_t last = kernel_get_time_cycles();
+  uint64_t start_us = kernel_get_time_us();
+
+  for (int i = 0; i < 10000; i++) {
+    uint64_t now = kernel_get_time_cycles();
+    TEST_ASSERT_TRUE(now >= last);
+    last = now;
+  }
+  usleep(2000);
+  TEST_ASSERT_TRUE(kernel_get_time_us() - start_us >= 2000);
+}
+
+void test_time_should_convert_at_any_tick_rate(void) {
+  TEST_ASSERT_EQUAL(5, TIME_MS_TO_TICKS(5));
+  TEST_ASSERT_EQUAL(1, TIME_MS_TO_TICKS_AT(5, 100));
+  TEST_ASSERT_EQUAL(2, TIME_MS_TO_TICKS_AT(11, 100));
+  TEST_ASSERT_EQUAL(1, TIME_US_TO_TICKS_AT(1, 32768));
+  TEST_ASSERT_EQUAL_UINT64(1500, TIME_TICKS_TO_MS_AT(150, 100));
+  TEST_ASSERT_EQUAL_UINT64(30, TIME_TICKS_TO_US_AT(1, 32768));
+
+  // Constant expressions, e.g. for static timeouts
+  static const uint32_t period = TIME_MS_TO_TICKS(250);
+  TEST_ASSERT_EQUAL(250, period);
+}
+
+void test_time_should_follow_runtime_tick_rate(void) {
+  scheduler_init();
+  TEST_ASSERT_EQUAL(KERNEL_TICK_HZ, kernel_get_tick_hz());
+  TEST_ASSERT_EQUAL(PORT_CORE_CLOCK_HZ, kernel_get_core_clock_hz());
+
+  TEST_ASSERT_FALSE(kernel_set_clock(PORT_CORE_CLOCK_HZ, 0));
+  TEST_ASSERT_EQUAL(KERNEL_TICK_HZ, kernel_get_tick_hz());
+
+  TEST_ASSERT_TRUE(kernel_set_clock(84000000u, 250));
+  TEST_ASSERT_EQUAL(250, kernel_get_tick_hz());
+  TEST_ASSERT_EQUAL(84000000u, kernel_get_core_clock_hz());
+  TEST_ASSERT_EQUAL(2, time_ms_to_ticks(5));
+  TEST_ASSERT_EQUAL(1, time_us_to_ticks(4000));
+  TEST_ASSERT_EQUAL_UINT64(4000, time_ticks_to_ms(1000));
+
+  TEST_ASSERT_TRUE(kernel_set_clock(PORT_CORE_CLOCK_HZ, KERNEL_TICK_HZ));
+  TEST_ASSERT_EQUAL(5, time_ms_to_ticks(5));
+}
+
+void test_time_should_saturate_long_durations(void) {
+  // 500000 s at 10 kHz is 5 * 10^9 ticks, past the 32-bit range
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFEu,
+                          TIME_MS_TO_TICKS_AT(500000000u, 10000));
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFEu,
+                          TIME_US_TO_TICKS_AT(0xFFFFFFFFu, 2000000));
+  TEST_ASSERT_EQUAL(0xFFFFFFFEu, time_ms_to_ticks(0xFFFFFFFFu));
+
+  scheduler_init();
+  TEST_ASSERT_TRUE(kernel_set_clock(PORT_CORE_CLOCK_HZ, 10000));
+  TEST_ASSERT_EQUAL(5000000, time_ms_to_ticks(500000));
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFEu, time_ms_to_ticks(500000000u));
+  TEST_ASSERT_NOT_EQUAL(SEM_WAIT_FOREVER, time_ms_to_ticks(0xFFFFFFFFu));
+  TEST_ASSERT_EQUAL(42949673, time_us_to_ticks(0xFFFFFFFFu));
+
+  TEST_ASSERT_TRUE(kernel_set_clock(PORT_CORE_CLOCK_HZ, KERNEL_TICK_HZ));
+}
+
+static void deadline_task(void *param) {
+  (void)param;
+  semaphore_handle_t never = sem_create(0, 1, "never");
+  uint64_t deadline = kernel_get_ticks64() + DEADLINE_TICKS;
+  uint64_t start_us = kernel_get_time_us();
+
+  posix_child_check(
+      sem_wait(never, kernel_ticks_until(deadline)) == SEM_ERROR_TIMEOUT, 1);
+  posix_child_check(kernel_get_ticks64() >= deadline, 2);
+  posix_child_check(
+      kernel_get_time_us() - start_us >= (DEADLINE_TICKS - 1) * 1000u, 3);
+
+  // A deadline that has passed polls once
+  posix_child_check(
+      sem_wait(never, kernel_ticks_until(deadline)) == SEM_ERROR_TIMEOUT, 4);
+  _exit(0);
+}
+
+static void deadline_scenario(void) {
+  kernel_init();
+  task_create(deadline_task, "deadline", 0, NULL, 1);
+}
+
+void test_time_should_block_until_absolute_deadline(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(deadline_scenario));
+}
+
+static void rescaled_task(void *param) {
+  semaphore_handle_t never = param;
+  uint64_t start_ticks = kernel_get_ticks64();
+  uint64_t start_us = kernel_get_time_us();
+
+  // The clock changes while this waits
+  sem_result_t waited = sem_wait(never, time_ms_to_ticks(RESCALE_TIMEOUT_MS));
+  posix_child_check(waited == SEM_ERROR_TIMEOUT, 1);
+  posix_child_check(kernel_get_tick_hz() == RESCALE_TICK_HZ, 2);
+  // Still RESCALE_TIMEOUT_MS, now counted in fewer, longer ticks
+  uint64_t elapsed_us = kernel_get_time_us() - start_us;
+  posix_child_check(elapsed_us >= (RESCALE_TIMEOUT_MS - 10) * 1000u, 3);
+  posix_child_check(elapsed_us <= 2 * RESCALE_TIMEOUT_MS * 1000u, 4);
+  uint64_t ticks = kernel_get_ticks64() - start_ticks;
+  uint64_t expected = RESCALE_TIMEOUT_MS * RESCALE_TICK_HZ / 1000u;
+  posix_child_check(ticks <= expected + 2, 5);
+  _exit(0);
+}
+
+static void clock_task(void *param) {
+  (void)param;
+  posix_child_check(kernel_set_clock(PORT_CORE_CLOCK_HZ, RESCALE_TICK_HZ), 6);
+  while (1) {
+    task_delay(RESCALE_TICK_HZ);
+  }
+}
+
+static void rescale_scenario(void) {
+  kernel_init();
+  semaphore_handle_t never = sem_create(0, 1, "never");
+  task_create(rescaled_task, "rescaled", 0, never, 1);
+  task_create(clock_task, "clock", 0, NULL, 2);
+}
+
+void test_time_should_rescale_armed_timeouts_on_clock_change(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(rescale_scenario));
+}
+
+#define LATENCY_DELAY_TICKS 20
+
+// Last trace record of the given event, NULL if there is none
+static const trace_record_t *last_record(uint16_t event) {
+  uint32_t head = trace_ram.header.head;
+  uint32_t oldest = head > TRACE_BUFFER_RECORDS ? head - TRACE_BUFFER_RECORDS
+                                                : 0;
+  for (uint32_t i = head; i-- > oldest;) {
+    const trace_record_t *r = &trace_ram.records[i % TRACE_BUFFER_RECORDS];
+    if (r->event == event) return r;
+  }
+  return NULL;
+}
+
+static void latency_task(void *param) {
+  (void)param;
+  task_handle_t self = task_get_current();
+
+  trace_start();
+  posix_child_check(kernel_set_clock(PORT_CORE_CLOCK_HZ / 2, KERNEL_TICK_HZ),
+                    1);
+
+  // The change is in the streams, and their headers carry the new rate
+  const trace_record_t *change = last_record(TRACE_EVENT_CLOCK_CHANGE);
+  posix_child_check(change != NULL, 2);
+  posix_child_check(change->arg == port_cycle_counter_hz(), 3);
+  posix_child_check(trace_ram.header.timestamp_hz == port_cycle_counter_hz(),
+                    4);
+  posix_child_check(klog_ram.header.timestamp_hz == port_cycle_counter_hz(),
+                    5);
+
+  // A latency measured after the change converts back to the time it took
+  task_reset_latency_stats(self);
+  uint64_t start_us = kernel_get_time_us();
+  task_delay(LATENCY_DELAY_TICKS);
+  uint64_t elapsed_us = kernel_get_time_us() - start_us;
+
+  task_latency_stats_t stats;
+  posix_child_check(task_get_latency_stats(self, &stats), 6);
+  const blocked_time_t *delay = &stats.blocked[WAKE_REASON_TIMEOUT];
+  posix_child_check(delay->count == 1, 7);
+  uint64_t blocked_us = delay->total_cycles * 1000000u /
+                        port_cycle_counter_hz();
+  posix_child_check(blocked_us <= elapsed_us, 8);
+  posix_child_check(blocked_us + 1000 >= elapsed_us, 9);
+  _exit(0);
+}
+
+static void latency_scenario(void) {
+  kernel_init();
+  task_create(latency_task, "latency", 0, NULL, 1);
+}
+
+void test_time_should_convert_latency_after_clock_change(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(latency_scenario));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_time_should_convert_durations_to_ticks_rounding_up);
+  RUN_TEST(test_time_should_convert_ticks_and_cycles_to_time);
+  RUN_TEST(test_time_should_clamp_deadlines_to_timeouts);
+  RUN_TEST(test_time_should_extend_tick_count_across_wrap);
+  RUN_TEST(test_time_should_keep_cycle_time_monotonic);
+  RUN_TEST(test_time_should_block_until_absolute_deadline);
+  RUN_TEST(test_time_should_convert_at_any_tick_rate);
+  RUN_TEST(test_time_should_follow_runtime_tick_rate);
+  RUN_TEST(test_time_should_saturate_long_durations);
+  RUN_TEST(test_time_should_rescale_armed_timeouts_on_clock_change);
+  RUN_TEST(test_time_should_convert_latency_after_clock_change);
+
+  return UNITY_END();
+}
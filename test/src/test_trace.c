@@ -0,0 +1,291 @@
+#include "memory.h"
+#include "task.h"
+#include "test_trace.h"
+#include "trace.h"
+#include "unity.h"
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Mock scheduler functions for testing
+void scheduler_remove_task(task_handle_t task) { (void)task; }
+
+// Sink capture
+static trace_record_t sink_records[8];
+static size_t sink_count;
+
+static void capture_sink(const trace_record_t *record) {
+  if (sink_count < sizeof(sink_records) / sizeof(sink_records[0])) {
+    sink_records[sink_count] = *record;
+  }
+  sink_count++;
+}
+
+void dummy_trace_task(void *param) {
+  (void)param;
+  while (1) {
+  }
+}
+
+void setUp(void) {
+  trace_init();
+  memory_pools_init();
+  sink_count = 0;
+}
+
+void tearDown(void) {
+  trace_stop();
+  trace_stream_close();
+}
+
+// Helper: the n-th record ever written (no wrap)
+static trace_record_t *record_at(uint32_t n) {
+  return &trace_ram.records[n % TRACE_BUFFER_RECORDS];
+}
+
+// Helper: index of the first record with the given event, or -1
+static int find_event(uint16_t event) {
+  uint32_t count = trace_ram.header.head < TRACE_BUFFER_RECORDS
+                       ? trace_ram.header.head
+                       : TRACE_BUFFER_RECORDS;
+  for (uint32_t i = 0; i < count; i++) {
+    if (record_at(i)->event == event) return (int)i;
+  }
+  return -1;
+}
+
+//=============================================================================
+// RECORDER TESTS
+//=============================================================================
+
+void test_trace_init_should_fill_header(void) {
+  TEST_ASSERT_EQUAL_HEX32(TRACE_MAGIC, trace_ram.header.magic);
+  TEST_ASSERT_EQUAL(TRACE_VERSION, trace_ram.header.version);
+  TEST_ASSERT_EQUAL(sizeof(trace_record_t), trace_ram.header.record_size);
+  TEST_ASSERT_EQUAL(16, trace_ram.header.record_size);
+  TEST_ASSERT_EQUAL(TRACE_BUFFER_RECORDS, trace_ram.header.capacity);
+  TEST_ASSERT_EQUAL(0, trace_ram.header.head);
+  TEST_ASSERT_EQUAL(0, trace_ram.header.enabled);
+}
+
+void test_trace_should_ignore_events_when_stopped(void) {
+  trace_record(TRACE_EVENT_USER, 1, 2);
+  TEST_ASSERT_EQUAL(0, trace_ram.header.head);
+
+  trace_start();
+  trace_stop();
+  uint32_t head = trace_ram.header.head;
+  trace_record(TRACE_EVENT_USER, 1, 2);
+  TEST_ASSERT_EQUAL(head, trace_ram.header.head);
+}
+
+void test_trace_record_should_store_fields(void) {
+  trace_start();
+  uint32_t head = trace_ram.header.head;
+
+  trace_record(TRACE_EVENT_USER + 3, 0x1234, 0xABCD);
+
+  TEST_ASSERT_EQUAL(head + 1, trace_ram.header.head);
+  trace_record_t *rec = record_at(head);
+  TEST_ASSERT_EQUAL(TRACE_EVENT_USER + 3, rec->event);
+  TEST_ASSERT_EQUAL((uint16_t)head, rec->sequence);
+  TEST_ASSERT_EQUAL_HEX32(0x1234, rec->object);
+  TEST_ASSERT_EQUAL_HEX32(0xABCD, rec->arg);
+}
+
+void test_trace_should_wrap_and_keep_counting(void) {
+  trace_start();
+  for (uint32_t i = 0; i < TRACE_BUFFER_RECORDS + 3; i++) {
+    trace_record(TRACE_EVENT_USER, i, i);
+  }
+
+  TEST_ASSERT_EQUAL(TRACE_BUFFER_RECORDS + 3, trace_ram.header.head);
+  // Oldest slots were overwritten by the newest records
+  TEST_ASSERT_EQUAL(TRACE_BUFFER_RECORDS, trace_ram.records[0].arg);
+  TEST_ASSERT_EQUAL(TRACE_BUFFER_RECORDS + 2, trace_ram.records[2].arg);
+  TEST_ASSERT_EQUAL(3, trace_ram.records[3].arg);
+}
+
+void test_trace_clear_should_reset_ring(void) {
+  trace_start();
+  trace_record(TRACE_EVENT_USER, 1, 1);
+  trace_clear();
+
+  TEST_ASSERT_EQUAL(0, trace_ram.header.head);
+  TEST_ASSERT_EQUAL(TRACE_EVENT_NONE, trace_ram.records[0].event);
+}
+
+void test_trace_sink_should_see_each_record(void) {
+  trace_set_sink(capture_sink);
+  trace_start();
+  trace_record(TRACE_EVENT_USER, 7, 8);
+  trace_record(TRACE_EVENT_USER + 1, 9, 10);
+
+  TEST_ASSERT_EQUAL(2, sink_count);
+  TEST_ASSERT_EQUAL(TRACE_EVENT_USER + 1, sink_records[1].event);
+  TEST_ASSERT_EQUAL(9, sink_records[1].object);
+  TEST_ASSERT_EQUAL(10, sink_records[1].arg);
+}
+
+void test_trace_stream_should_write_header_and_records(void) {
+  const char *path = "test_trace_stream.bin";
+  TEST_ASSERT_TRUE(trace_stream_open(path));
+  trace_start();
+  trace_record(TRACE_EVENT_USER, 0x11, 0x22);
+  trace_stop();
+  trace_stream_close();
+
+  FILE *f = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(f);
+  trace_header_t header;
+  trace_record_t rec;
+  TEST_ASSERT_EQUAL(1, fread(&header, sizeof(header), 1, f));
+  TEST_ASSERT_EQUAL(1, fread(&rec, sizeof(rec), 1, f));
+  TEST_ASSERT_EQUAL(0, fread(&rec, sizeof(rec), 1, f));
+  fclose(f);
+  remove(path);
+
+  TEST_ASSERT_EQUAL_HEX32(TRACE_MAGIC, header.magic);
+  TEST_ASSERT_EQUAL(0, header.capacity);
+  TEST_ASSERT_EQUAL(TRACE_EVENT_USER, rec.event);
+  TEST_ASSERT_EQUAL_HEX32(0x22, rec.arg);
+}
+
+// Records the way a host-port interrupt does, from a signal handler
+static void record_in_handler(int sig) {
+  (void)sig;
+  trace_record(TRACE_EVENT_ISR_ENTER, 0, 1);
+}
+
+void test_trace_stream_should_write_through_from_signal_handler(void) {
+  const char *path = "test_trace_handler.bin";
+  TEST_ASSERT_TRUE(trace_stream_open(path));
+  trace_start();
+
+  struct sigaction action = {0};
+  struct sigaction previous;
+  action.sa_handler = record_in_handler;
+  sigaction(SIGUSR1, &action, &previous);
+  trace_record(TRACE_EVENT_USER, 0x11, 0);
+  raise(SIGUSR1);
+  sigaction(SIGUSR1, &previous, NULL);
+
+  // Nothing is buffered in the process: both records are in the file
+  // before the stream is closed
+  FILE *f = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(f);
+  trace_header_t header;
+  trace_record_t recs[2];
+  TEST_ASSERT_EQUAL(1, fread(&header, sizeof(header), 1, f));
+  TEST_ASSERT_EQUAL(2, fread(recs, sizeof(recs[0]), 2, f));
+  fclose(f);
+  trace_stream_close();
+  remove(path);
+
+  TEST_ASSERT_EQUAL(TRACE_EVENT_USER, recs[0].event);
+  TEST_ASSERT_EQUAL(TRACE_EVENT_ISR_ENTER, recs[1].event);
+  TEST_ASSERT_EQUAL((uint16_t)(recs[0].sequence + 1), recs[1].sequence);
+}
+
+//=============================================================================
+// KERNEL HOOK TESTS
+//=============================================================================
+
+void test_trace_should_name_tasks_created_while_running(void) {
+  trace_start();
+  task_handle_t task =
+      task_create_internal(dummy_trace_task, "Late", 256, NULL, 2);
+  TEST_ASSERT_NOT_NULL(task);
+
+  int first = find_event(TRACE_EVENT_TASK_NAME);
+  TEST_ASSERT_GREATER_THAN(find_event(TRACE_EVENT_TASK_CREATE), first);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)task, record_at(first)->object);
+  TEST_ASSERT_EQUAL_MEMORY("Late", &record_at(first)->arg, 4);
+
+  task_delete_internal(task);
+}
+
+void test_trace_start_should_emit_task_names(void) {
+  task_handle_t task =
+      task_create_internal(dummy_trace_task, "Sensor", 256, NULL, 2);
+  TEST_ASSERT_NOT_NULL(task);
+
+  trace_start();
+
+  int first = find_event(TRACE_EVENT_TASK_NAME);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, first);
+
+  char name[sizeof(task->name)];
+  for (size_t i = 0; i < sizeof(name) / 4; i++) {
+    trace_record_t *rec = record_at((uint32_t)first + i);
+    TEST_ASSERT_EQUAL(TRACE_EVENT_TASK_NAME, rec->event);
+    TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)task, rec->object);
+    memcpy(&name[i * 4], &rec->arg, 4);
+  }
+  TEST_ASSERT_EQUAL_STRING("Sensor", name);
+
+  task_delete_internal(task);
+}
+
+void test_trace_should_record_task_create_and_block(void) {
+  trace_start();
+  task_handle_t task =
+      task_create_internal(dummy_trace_task, "Worker", 256, NULL, 4);
+  TEST_ASSERT_NOT_NULL(task);
+
+  int create = find_event(TRACE_EVENT_TASK_CREATE);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, create);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)task, record_at(create)->object);
+  TEST_ASSERT_EQUAL(4, record_at(create)->arg);
+
+  static int wait_object;
+  task->waiting_on = &wait_object;
+  task_set_state(task, TASK_BLOCKED);
+
+  int block = find_event(TRACE_EVENT_TASK_BLOCK);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, block);
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)&wait_object,
+                          record_at(block)->arg);
+
+  task_delete_internal(task);
+}
+
+void test_trace_should_record_pool_alloc_and_free(void) {
+  trace_start();
+  void *ptr = pool_alloc(POOL_QCB);
+  TEST_ASSERT_NOT_NULL(ptr);
+  pool_free(POOL_QCB, ptr);
+
+  int alloc = find_event(TRACE_EVENT_POOL_ALLOC);
+  int freed = find_event(TRACE_EVENT_POOL_FREE);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, alloc);
+  TEST_ASSERT_GREATER_THAN(alloc, freed);
+
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)(uintptr_t)ptr, record_at(alloc)->object);
+  TEST_ASSERT_EQUAL(POOL_QCB, record_at(alloc)->arg & 0xFFFF);
+  TEST_ASSERT_EQUAL(1, record_at(alloc)->arg >> 16);
+  TEST_ASSERT_EQUAL(0, record_at(freed)->arg >> 16);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+
+  // Recorder tests
+  RUN_TEST(test_trace_init_should_fill_header);
+  RUN_TEST(test_trace_should_ignore_events_when_stopped);
+  RUN_TEST(test_trace_record_should_store_fields);
+  RUN_TEST(test_trace_should_wrap_and_keep_counting);
+  RUN_TEST(test_trace_clear_should_reset_ring);
+  RUN_TEST(test_trace_sink_should_see_each_record);
+  RUN_TEST(test_trace_stream_should_write_header_and_records);
+  RUN_TEST(test_trace_stream_should_write_through_from_signal_handler);
+
+  // Kernel hook tests
+  RUN_TEST(test_trace_start_should_emit_task_names);
+  RUN_TEST(test_trace_should_name_tasks_created_while_running);
+  RUN_TEST(test_trace_should_record_task_create_and_block);
+  RUN_TEST(test_trace_should_record_pool_alloc_and_free);
+
+  return UNITY_END();
+}
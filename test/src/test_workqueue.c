@@ -0,0 +1,282 @@
+#include "critical.h"
+#include "kernel.h"
+#include "port.h"
+#include "posix_child.h"
+#include "scheduler.h"
+#include "test_workqueue.h"
+#include "unity.h"
+#include "workqueue.h"
+#include <unistd.h>
+
+// Submit bookkeeping is checked on a kernel that is initialised but not
+// started. Scenarios that run work go through a forked child
+// (posix_child.h).
+
+static work_queue_t queue;
+static work_queue_t high_queue;
+
+static volatile int runs;
+static volatile uint32_t run_ticks[4];
+static volatile bool wrong_worker;
+
+static void count_work(work_item_t *work, void *arg) {
+  (void)work;
+  if (arg && task_get_current() != ((work_queue_t *)arg)->worker) {
+    wrong_worker = true;
+  }
+  if (runs < 4) run_ticks[runs] = tick_now;
+  runs++;
+}
+
+void setUp(void) {
+  runs = 0;
+  wrong_worker = false;
+}
+
+void tearDown(void) {}
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+void test_workqueue_should_reject_null_arguments(void) {
+  work_item_t work = WORK_ITEM_INIT(work, count_work, NULL);
+
+  TEST_ASSERT_FALSE(work_queue_init(NULL, "none", 2, 0));
+  TEST_ASSERT_FALSE(work_submit(NULL, &work));
+  TEST_ASSERT_FALSE(work_submit(&queue, NULL));
+  TEST_ASSERT_FALSE(work_submit_delayed(NULL, &work, 5));
+  TEST_ASSERT_FALSE(work_cancel(NULL));
+  TEST_ASSERT_FALSE(work_is_queued(NULL));
+  TEST_ASSERT_FALSE(work_is_queued(&work));
+}
+
+void test_workqueue_should_coalesce_resubmits(void) {
+  work_item_t work;
+  work_init(&work, count_work, NULL);
+  uint32_t coalesced = queue.coalesced;
+
+  TEST_ASSERT_TRUE(work_submit(&queue, &work));
+  TEST_ASSERT_TRUE(work_is_queued(&work));
+  TEST_ASSERT_FALSE(work_submit(&queue, &work));
+  TEST_ASSERT_FALSE(work_submit_delayed(&queue, &work, 10));
+  TEST_ASSERT_EQUAL(coalesced + 2, queue.coalesced);
+  TEST_ASSERT_EQUAL(0, runs);
+
+  work_cancel(&work);
+
+  // Waiting for its delay counts as queued too
+  TEST_ASSERT_TRUE(work_submit_delayed(&queue, &work, 10));
+  TEST_ASSERT_FALSE(work_submit(&queue, &work));
+  work_cancel(&work);
+}
+
+void test_workqueue_should_cancel_queued_work(void) {
+  work_item_t first, second;
+  work_init(&first, count_work, NULL);
+  work_init(&second, count_work, NULL);
+
+  work_submit(&queue, &first);
+  work_submit_delayed(&queue, &second, 3);
+
+  TEST_ASSERT_TRUE(work_cancel(&first));
+  TEST_ASSERT_FALSE(work_is_queued(&first));
+  TEST_ASSERT_FALSE(work_cancel(&first));
+  TEST_ASSERT_TRUE(work_cancel(&second));
+  TEST_ASSERT_TRUE(list_is_empty(&queue.pending));
+  TEST_ASSERT_TRUE(list_is_empty(&queue.delayed));
+
+  // Idle again, so it can go back in
+  TEST_ASSERT_TRUE(work_submit(&queue, &first));
+  work_cancel(&first);
+}
+
+static work_item_t irq_work;
+
+static void submit_from_irq(void) {
+  kernel_isr_enter();
+  work_submit(&queue, &irq_work);
+  kernel_isr_exit();
+}
+
+static void irq_task(void *param) {
+  (void)param;
+  uint32_t coalesced = queue.coalesced;
+
+  // The worker is lower priority, so nothing runs until this task sleeps
+  port_posix_trigger_irq();
+  port_posix_trigger_irq();
+  port_posix_trigger_irq();
+  posix_child_check(runs == 0, 1);
+  posix_child_check(queue.coalesced == coalesced + 2, 2);
+
+  task_delay(2);
+  posix_child_check(runs == 1, 3);
+  posix_child_check(!wrong_worker, 4);
+  posix_child_check(!work_is_queued(&irq_work), 5);
+  _exit(0);
+}
+
+static void irq_scenario(void) {
+  work_init(&irq_work, count_work, &queue);
+  port_posix_set_irq_handler(submit_from_irq);
+  task_create(irq_task, "irq", 0, NULL, 1);
+}
+
+void test_workqueue_should_run_interrupt_work_in_worker(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(irq_scenario));
+}
+
+static work_item_t delayed_work;
+
+// Resubmits itself once, from inside its own run
+static void delayed_function(work_item_t *work, void *arg) {
+  count_work(work, arg);
+  if (runs == 1) {
+    posix_child_check(work_submit_delayed(&queue, work, 5), 10);
+  }
+}
+
+static void delayed_task(void *param) {
+  (void)param;
+  uint32_t start = tick_now;
+
+  posix_child_check(work_submit_delayed(&queue, &delayed_work, 20), 1);
+  task_delay(10);
+  posix_child_check(runs == 0, 2);
+
+  task_delay(30);
+  posix_child_check(runs == 2, 3);
+  uint32_t first = run_ticks[0] - start;
+  uint32_t second = run_ticks[1] - run_ticks[0];
+  posix_child_check(first >= 20 && first <= 21, 4);
+  posix_child_check(second >= 5 && second <= 6, 5);
+  posix_child_check(!wrong_worker, 6);
+  _exit(0);
+}
+
+static void delayed_scenario(void) {
+  work_init(&delayed_work, delayed_function, &queue);
+  task_create(delayed_task, "delayed", 0, NULL, 1);
+}
+
+void test_workqueue_should_run_delayed_work_when_due(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(delayed_scenario));
+}
+
+static work_item_t low_work, high_work;
+
+// Records its position instead of the tick
+static void order_function(work_item_t *work, void *arg) {
+  (void)arg;
+  run_ticks[runs++] = (work == &high_work) ? 0 : 1;
+}
+
+static void priority_task(void *param) {
+  (void)param;
+
+  posix_child_check(work_queue_init(&high_queue, "high_wq", 1, 0), 1);
+  work_submit(&queue, &low_work);
+  work_submit(&high_queue, &high_work);
+  task_delay(5);
+
+  posix_child_check(runs == 2, 2);
+  posix_child_check(run_ticks[0] == 0, 3); // high_work
+  posix_child_check(run_ticks[1] == 1, 4); // low_work
+  _exit(0);
+}
+
+static void priority_scenario(void) {
+  work_init(&low_work, order_function, NULL);
+  work_init(&high_work, order_function, NULL);
+  task_create(priority_task, "prio", 0, NULL, 0);
+}
+
+void test_workqueue_should_run_higher_priority_queue_first(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(priority_scenario));
+}
+
+#define MANY_DELAYED 2048
+#define NEAR_DELAYED 32
+
+static work_item_t many_work[MANY_DELAYED];
+
+// Masked time of all critical sections since the last reset, in cycles
+static uint64_t masked_cycles(void) {
+  critical_profile_entry_t top[CRITICAL_PROFILE_SLOTS];
+  size_t count = critical_profile_get(top, CRITICAL_PROFILE_SLOTS);
+  uint64_t total = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    total += top[i].total_cycles;
+  }
+  return total;
+}
+
+// Runs NEAR_DELAYED items due one per tick, with far_items more parked
+// behind them, and returns the masked time it took
+static uint64_t run_near_items(int far_items) {
+  int base = runs;
+
+  for (int i = 0; i < NEAR_DELAYED + far_items; i++) {
+    uint32_t ticks = i < NEAR_DELAYED ? (uint32_t)i + 1 : 100000;
+    posix_child_check(work_submit_delayed(&queue, &many_work[i], ticks), 1);
+  }
+
+  critical_profile_reset();
+  task_delay(NEAR_DELAYED + 2);
+  posix_child_check(runs == base + NEAR_DELAYED, 2);
+  uint64_t cycles = masked_cycles();
+
+  for (int i = 0; i < NEAR_DELAYED + far_items; i++) {
+    work_cancel(&many_work[i]);
+  }
+  return cycles;
+}
+
+static void many_task(void *param) {
+  (void)param;
+
+  // Walking the parked items on every wake would multiply the masked time;
+  // taking due items off the head costs the same with or without them.
+  // Best of three, since the host may preempt a masked section.
+  uint64_t alone = UINT64_MAX, parked = UINT64_MAX;
+  for (int round = 0; round < 3; round++) {
+    uint64_t cycles = run_near_items(0);
+    if (cycles < alone) alone = cycles;
+    cycles = run_near_items(MANY_DELAYED - NEAR_DELAYED);
+    if (cycles < parked) parked = cycles;
+  }
+  posix_child_check(parked < 2 * alone, 3);
+  _exit(0);
+}
+
+static void many_scenario(void) {
+  for (int i = 0; i < MANY_DELAYED; i++) {
+    work_init(&many_work[i], count_work, NULL);
+  }
+  task_create(many_task, "many", 0, NULL, 1);
+}
+
+void test_workqueue_should_not_mask_interrupts_per_delayed_item(void) {
+  TEST_ASSERT_EQUAL(0, posix_child_run(many_scenario));
+}
+
+int main(void) {
+  kernel_init();
+  if (!work_queue_init(&queue, "wq", 2, 0)) {
+    return 1;
+  }
+
+  UNITY_BEGIN();
+
+  RUN_TEST(test_workqueue_should_reject_null_arguments);
+  RUN_TEST(test_workqueue_should_coalesce_resubmits);
+  RUN_TEST(test_workqueue_should_cancel_queued_work);
+  RUN_TEST(test_workqueue_should_run_interrupt_work_in_worker);
+  RUN_TEST(test_workqueue_should_run_delayed_work_when_due);
+  RUN_TEST(test_workqueue_should_run_higher_priority_queue_first);
+  RUN_TEST(test_workqueue_should_not_mask_interrupts_per_delayed_item);
+
+  return UNITY_END();
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Compare two kbench result files.
+
+    $ tools/bench_compare.py old.csv new.csv [--threshold 5]
+
+Reads the `kbench,...` lines of each file (other output is ignored) and
+prints the change in average and minimum cycles per benchmark. Exits with
+status 1 if any average got slower by more than the threshold percentage,
+so it can gate CI.
+"""
+
+import argparse
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.strip().split(",")
+            if len(fields) != 7 or fields[0] != "kbench":
+                continue
+            _, name, param, iters, mn, avg, mx = fields
+            results[(name, param)] = (int(iters), int(mn), int(avg), int(mx))
+    return results
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else float("inf")
+    return (new - old) * 100.0 / old
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="allowed slowdown of the average, in percent")
+    args = parser.parse_args()
+
+    old, new = load(args.old), load(args.new)
+    regressions = 0
+
+    print("%-26s %-18s %9s %9s %8s %9s" %
+          ("benchmark", "param", "old avg", "new avg", "change", "new min"))
+    for key in sorted(set(old) | set(new)):
+        if key not in old or key not in new:
+            print("%-26s %-18s %s" % (key[0], key[1],
+                                      "only in " + ("new" if key in new else "old")))
+            continue
+        o, n = old[key], new[key]
+        pct = change(o[2], n[2])
+        flag = ""
+        if pct > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-26s %-18s %9d %9d %+7.1f%% %9d%s" %
+              (key[0], key[1], o[2], n[2], pct, n[1], flag))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""Format a Morph-RT deferred log (KLOG) on the host.
+
+The target logs format ids and raw arguments; the format strings live in
+the klog_fmt section of the ELF, which is not loaded on the target. Pull
+them out once into a dictionary, or read them from the ELF each time:
+
+    $ tools/klog_decode.py --elf app.elf --extract klog.json
+    (gdb) dump binary memory klog.bin &klog_ram \
+              (char *)&klog_ram + sizeof(klog_ram)
+    $ tools/klog_decode.py --dict klog.json klog.bin
+    $ tools/klog_decode.py --elf app.elf --timestamps klog.bin
+
+Input is either a RAM dump of klog_ram (header + ring; the records not yet
+drained are decoded) or a stream: a header with capacity 0, then records
+as they sit in the ring minus the tag word (format | count << 16,
+timestamp, arguments).
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+KLOG_MAGIC = 0x474C524D
+HEADER = struct.Struct("<IHHIIIII")  # klog_header_t
+RECORD_WORDS = 3                     # tag, format | count << 16, timestamp
+STR_ARGS = 4
+CLOCK_FORMAT = "clock: cycle counter "  # Logged by kernel_set_clock()
+
+CONVERSION_RE = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)([diouxXcs%])")
+
+
+def elf_section(path, name):
+    """Contents of one section, for 32- and 64-bit little-endian ELF."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[5] != 1:
+        sys.exit("klog_decode: %s is not a little-endian ELF file" % path)
+
+    if data[4] == 1:  # ELFCLASS32
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+        section = struct.Struct("<IIIIIIIIII")
+    else:
+        shoff, = struct.unpack_from("<Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3A)
+        section = struct.Struct("<IIQQQQIIQQ")
+
+    headers = [section.unpack_from(data, shoff + i * shentsize)
+               for i in range(shnum)]
+    strtab = headers[shstrndx]
+    names = data[strtab[4]:strtab[4] + strtab[5]]
+    for sh in headers:
+        end = names.index(b"\0", sh[0])
+        if names[sh[0]:end].decode() == name:
+            return data[sh[4]:sh[4] + sh[5]]
+    sys.exit("klog_decode: %s has no %s section (no KLOG() calls?)"
+             % (path, name))
+
+
+def dictionary_from_elf(path):
+    """Format id (offset in klog_fmt) -> format string."""
+    blob = elf_section(path, "klog_fmt")
+    formats, start = {}, 0
+    while start < len(blob):
+        end = blob.index(b"\0", start)
+        formats[start] = blob[start:end].decode("utf-8", "replace")
+        start = end + 1
+    return formats
+
+
+def format_record(fmt, args):
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else 0
+
+    def convert(m):
+        flags, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if conv == "s":
+            raw = b"".join(struct.pack("<I", take()) for _ in range(STR_ARGS))
+            value = raw.split(b"\0")[0].decode("latin-1")
+        elif conv in "di":
+            value = struct.unpack("<i", struct.pack("<I", take()))[0]
+        elif conv == "c":
+            value = chr(take() & 0xFF)
+        else:
+            value = take()
+        return ("%" + flags + conv) % value
+
+    return CONVERSION_RE.sub(convert, fmt)
+
+
+def load_records(path):
+    """(timestamp_hz, dropped, [(format, timestamp, args)], incomplete)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        sys.exit("klog_decode: %s is too short for a header" % path)
+    (magic, _version, header_size, capacity, head, tail, hz,
+     dropped) = HEADER.unpack_from(data)
+    if magic != KLOG_MAGIC:
+        sys.exit("klog_decode: %s: bad magic 0x%08x" % (path, magic))
+
+    body = data[header_size:]
+    words = struct.unpack("<%dI" % (len(body) // 4), body[:len(body) // 4 * 4])
+    records, incomplete = [], False
+
+    if capacity == 0:  # Stream: no tags, no wrap
+        pos = 0
+        while pos + 2 <= len(words):
+            info, timestamp = words[pos], words[pos + 1]
+            count = info >> 16
+            records.append((info & 0xFFFF, timestamp,
+                            words[pos + 2:pos + 2 + count]))
+            pos += 2 + count
+        return hz, dropped, records, incomplete
+
+    if len(words) < capacity:
+        sys.exit("klog_decode: %s holds %d of %d ring words"
+                 % (path, len(words), capacity))
+    pos = tail
+    while pos != head:
+        if words[pos % capacity] != ~pos & 0xFFFFFFFF:
+            incomplete = True  # A producer was interrupted mid-record
+            break
+        info = words[(pos + 1) % capacity]
+        count = info >> 16
+        args = [words[(pos + RECORD_WORDS + i) % capacity]
+                for i in range(count)]
+        records.append((info & 0xFFFF, words[(pos + 2) % capacity], args))
+        pos = (pos + RECORD_WORDS + count) & 0xFFFFFFFF
+    return hz, dropped, records, incomplete
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", help="klog_ram dump or stream")
+    parser.add_argument("--elf", help="image to read the formats from")
+    parser.add_argument("--dict", help="dictionary written by --extract")
+    parser.add_argument("--extract", metavar="JSON",
+                        help="write the formats of --elf to a dictionary")
+    parser.add_argument("--timestamps", action="store_true",
+                        help="prefix each record with its time in seconds")
+    args = parser.parse_args()
+
+    if args.elf:
+        formats = dictionary_from_elf(args.elf)
+    elif args.dict:
+        with open(args.dict) as f:
+            formats = {int(k): v for k, v in json.load(f).items()}
+    else:
+        parser.error("one of --elf or --dict is required")
+
+    if args.extract:
+        with open(args.extract, "w") as f:
+            json.dump({str(k): v for k, v in sorted(formats.items())}, f,
+                      indent=1)
+        if not args.log:
+            return 0
+    if not args.log:
+        parser.error("no log to decode")
+
+    hz, dropped, records, incomplete = load_records(args.log)
+
+    # kernel_set_clock() logs the old and new counter rate; timestamps after
+    # that record count at the new one. The first such record left in the
+    # log tells the rate before it, the header the rate after the last.
+    clock_ids = {k for k, v in formats.items() if v.startswith(CLOCK_FORMAT)}
+    hz = next((a[0] for f, _, a in records if f in clock_ids and a), hz) or 1
+    base_s = base_ts = 0
+
+    for fmt_id, timestamp, record_args in records:
+        fmt = formats.get(fmt_id)
+        if fmt is None:
+            text = "<unknown format %d: %s>\n" % (
+                fmt_id, " ".join("0x%x" % a for a in record_args))
+        else:
+            text = format_record(fmt, record_args)
+        seconds = base_s + (timestamp - base_ts) / hz
+        if fmt_id in clock_ids and len(record_args) > 1 and record_args[1]:
+            base_s, base_ts, hz = seconds, timestamp, record_args[1]
+        if args.timestamps:
+            text = "[%12.6f] %s" % (seconds, text)
+        sys.stdout.write(text)
+
+    if incomplete:
+        print("# log ends at a record that was still being written",
+              file=sys.stderr)
+    if dropped:
+        print("# %d records dropped (ring full)" % dropped, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Symbolize a Morph-RT PC-sampling profile into per-task hot functions.
+
+Dump profile_ram from the target and read it against the image it ran:
+
+    (gdb) dump binary memory prof.bin &profile_ram \\
+              (char *)&profile_ram + sizeof(profile_ram)
+    $ tools/profile_report.py --elf app.elf prof.bin
+    $ tools/profile_report.py --elf app.elf --folded prof.bin | flamegraph.pl
+
+The default report lists, per task, the functions its samples fell in.
+--folded prints "task;function count" lines, the input format of
+flamegraph.pl and speedscope; the samples are leaf PCs only, so each
+flame is two levels deep. The layout is documented in kernel/inc/profile.h.
+"""
+
+import argparse
+import bisect
+import collections
+import struct
+import sys
+
+PROFILE_MAGIC = 0x4650524D
+HEADER = struct.Struct("<IHHHBBII")  # profile_header_t
+NO_TASK = 0xFF
+NAME_BYTES = 16
+
+
+def elf_functions(path):
+    """Sorted (start, end, name) of the function symbols of an ELF file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[5] != 1:
+        sys.exit("profile_report: %s is not a little-endian ELF file" % path)
+
+    if data[4] == 1:  # ELFCLASS32
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        section = struct.Struct("<IIIIIIIIII")
+        symbol = struct.Struct("<IIIBBH")  # name, value, size, info
+
+        def unpack_symbol(raw):
+            name, value, size, info, _, _ = raw
+            return name, value, size, info
+    else:
+        shoff, = struct.unpack_from("<Q", data, 0x28)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x3A)
+        section = struct.Struct("<IIQQQQIIQQ")
+        symbol = struct.Struct("<IBBHQQ")
+
+        def unpack_symbol(raw):
+            name, info, _, _, value, size = raw
+            return name, value, size, info
+
+    headers = [section.unpack_from(data, shoff + i * shentsize)
+               for i in range(shnum)]
+    functions = []
+    for sh in headers:
+        if sh[1] != 2:  # SHT_SYMTAB
+            continue
+        strtab = headers[sh[6]]
+        names = data[strtab[4]:strtab[4] + strtab[5]]
+        for offset in range(sh[4], sh[4] + sh[5], symbol.size):
+            name, value, size, info = unpack_symbol(
+                symbol.unpack_from(data, offset))
+            if info & 0xF != 2 or not value:  # STT_FUNC
+                continue
+            end = names.index(b"\0", name)
+            start = value & ~1  # Thumb bit
+            functions.append((start, start + max(size, 1),
+                              names[name:end].decode("utf-8", "replace")))
+    if not functions:
+        sys.exit("profile_report: %s has no symbol table (stripped?)" % path)
+    return sorted(functions)
+
+
+def load_profile(path):
+    """(header dict, task names by slot, [(pc, task slot, count)])."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        sys.exit("profile_report: %s is too short" % path)
+    magic, version, header_size, slots, pc_bytes, task_slots, samples, \
+        dropped = HEADER.unpack_from(data)
+    if magic != PROFILE_MAGIC:
+        sys.exit("profile_report: bad magic 0x%08x" % magic)
+    if pc_bytes not in (4, 8):
+        sys.exit("profile_report: unsupported PC size %d" % pc_bytes)
+
+    def align(n):
+        return (n + pc_bytes - 1) // pc_bytes * pc_bytes
+
+    names = {}
+    for slot in range(task_slots):
+        raw = data[header_size + slot * NAME_BYTES:
+                   header_size + (slot + 1) * NAME_BYTES]
+        names[slot] = raw.split(b"\0")[0].decode("utf-8", "replace")
+
+    entry = struct.Struct("<" + ("I" if pc_bytes == 4 else "Q") + "IB")
+    stride = align(entry.size)
+    base = align(header_size + task_slots * NAME_BYTES)
+    if len(data) < base + slots * stride:
+        sys.exit("profile_report: %s is truncated" % path)
+
+    samples_list = []
+    for i in range(slots):
+        pc, count, task = entry.unpack_from(data, base + i * stride)
+        if count:
+            samples_list.append((pc, task, count))
+    header = {"version": version, "samples": samples, "dropped": dropped}
+    return header, names, samples_list
+
+
+def task_name(names, slot):
+    if slot == NO_TASK:
+        return "(interrupts)"
+    return names.get(slot) or "#%d" % slot
+
+
+def symbolize(functions, pc):
+    starts = [f[0] for f in functions]
+    i = bisect.bisect_right(starts, pc) - 1
+    if i >= 0 and pc < functions[i][1]:
+        return functions[i][2]
+    return "0x%x" % pc
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("profile", help="profile_ram dump")
+    parser.add_argument("--elf", required=True, help="image that was sampled")
+    parser.add_argument("--folded", action="store_true",
+                        help="print folded stacks for a flame graph")
+    parser.add_argument("--top", type=int, default=10,
+                        help="functions listed per task (default 10)")
+    args = parser.parse_args()
+
+    functions = elf_functions(args.elf)
+    header, names, samples = load_profile(args.profile)
+
+    # task -> function -> samples
+    by_task = collections.defaultdict(collections.Counter)
+    for pc, task, count in samples:
+        by_task[task_name(names, task)][symbolize(functions, pc)] += count
+
+    if args.folded:
+        for task in sorted(by_task):
+            for function, count in sorted(by_task[task].items()):
+                print("%s;%s %d" % (task, function, count))
+        return 0
+
+    total = header["samples"] or 1
+    print("%d samples, %d dropped (%.1f%%)" % (
+        header["samples"], header["dropped"],
+        100.0 * header["dropped"] / total))
+    ranked = sorted(by_task.items(), key=lambda t: -sum(t[1].values()))
+    for task, counter in ranked:
+        task_total = sum(counter.values())
+        print("\n%s: %d samples (%.1f%%)" % (task, task_total,
+                                              100.0 * task_total / total))
+        for function, count in counter.most_common(args.top):
+            print("  %6.1f%%  %7d  %s" % (100.0 * count / total, count,
+                                          function))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""Worst-case stack per task from GCC's frame and call-graph output.
+
+Build with -fstack-usage -fcallgraph-info=su (GCC 10 or later; the bench
+images do, see the <image>_stack targets in bench/CMakeLists.txt), then:
+
+    $ tools/stack_report.py --objects build/bench/CMakeFiles/kbench.dir \
+          --sources bench/kbench.c kernel/src/kernel.c
+
+Tasks are the task_create()/task_create_internal() calls in the sources
+whose entry is a function name and whose size is a literal or a config.h
+preset. For each one, the deepest call chain from the entry is summed
+from the per-function frames (.su) along the call graph (.ci). The frame
+a switched-out task keeps is added: the exception frame the CPU stacks on
+the PSP, R4-R11 as laid out by task_init_stack(), and with --fpu the
+extended frame and S16-S31. The total is checked against the stack class
+the requested size rounds up to, less the MPU guard.
+
+Recursion, unbounded dynamic frames (alloca, VLAs), calls through
+pointers and calls into code built without the flags (libc) cannot be
+bounded from this output. They are listed under the task, and its total
+is marked with '+' as a lower bound; --indirect and --assume fill them
+in. Exits with status 1 if any task does not fit, so it can gate CI.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# What a switched-out task keeps on its stack besides its call chain
+HW_FRAME = 32      # R0-R3, R12, LR, PC, xPSR
+HW_FPU_FRAME = 72  # S0-S15, FPSCR, reserved (extended frame)
+SW_FRAME = 32      # R4-R11
+SW_FPU_FRAME = 64  # S16-S31, only for tasks that used the FPU
+ALIGN_PAD = 4      # Exception entry may realign the PSP to 8 bytes
+
+CLASSES = ("SMALL", "DEFAULT", "LARGE")
+INDIRECT = "__indirect_call"
+
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+DEFINE_RE = re.compile(r"^\s*#define\s+(\w+)\s+(\d+)u?\b", re.M)
+CREATE_RE = re.compile(r"\btask_create(?:_internal)?\s*\(\s*(\w+)\s*,"
+                       r"\s*([^,]+?)\s*,\s*([^,]+?)\s*,")
+COMMENT_RE = re.compile(r"//[^\n]*|/\*.*?\*/", re.S)
+
+
+class CallGraph:
+    def __init__(self, assume, indirect):
+        self.frames = {}     # (unit, name) -> (bytes, qualifier)
+        self.calls = {}      # (unit, name) -> callee names
+        self.defined = {}    # name -> [(unit, name)]
+        self.assume = assume
+        self.indirect = indirect
+        self.memo = {}
+
+    def load(self, objects):
+        for root, _, files in os.walk(objects):
+            for ci in (f for f in files if f.endswith(".ci")):
+                unit = os.path.join(root, ci[:-3])
+                self.load_unit(unit)
+        if not self.frames:
+            sys.exit("stack_report: no .su/.ci files under %s "
+                     "(built with -fstack-usage -fcallgraph-info=su?)"
+                     % objects)
+
+    def load_unit(self, unit):
+        # file:line:col:function <tab> bytes <tab> static|dynamic[,bounded]
+        if os.path.exists(unit + ".su"):
+            with open(unit + ".su") as f:
+                for line in f:
+                    fields = line.rstrip("\n").split("\t")
+                    if len(fields) != 3:
+                        continue
+                    key = (unit, fields[0].split(":")[-1])
+                    self.frames[key] = (int(fields[1]), fields[2])
+                    self.defined.setdefault(key[1], []).append(key)
+
+        with open(unit + ".ci") as f:
+            for line in f:
+                edge = EDGE_RE.search(line)
+                if edge:
+                    # Static functions are titled "file:function"
+                    caller = (unit, edge.group(1).split(":")[-1])
+                    callee = edge.group(2).split(":")[-1]
+                    self.calls.setdefault(caller, set()).add(callee)
+
+    def resolve(self, unit, name):
+        """Definitions a call from unit can reach: its own static first."""
+        if (unit, name) in self.frames:
+            return [(unit, name)]
+        return self.defined.get(name, [])
+
+    def worst(self, key, active=()):
+        """(bytes, chain, issues) for the deepest chain from key."""
+        if key in self.memo:
+            return self.memo[key]
+
+        frame, qualifier = self.frames[key]
+        issues = set()
+        if qualifier == "dynamic":
+            issues.add(("unbounded frame", key[1]))
+
+        deepest, chain = 0, []
+        active = set(active) | {key}
+        for callee in sorted(self.calls.get(key, ())):
+            targets = [callee]
+            if callee == INDIRECT:
+                targets = self.indirect.get(key[1], [])
+                if not targets:
+                    issues.add(("call through pointer", key[1]))
+
+            for target in targets:
+                if target in self.assume:
+                    depth, sub, sub_issues = self.assume[target], [target], ()
+                    if depth > deepest:
+                        deepest, chain = depth, sub
+                    continue
+
+                defs = self.resolve(key[0], target)
+                if not defs:
+                    issues.add(("not analysed", target))
+                for d in defs:
+                    if d in active:
+                        issues.add(("recursion", target))
+                        continue
+                    depth, sub, sub_issues = self.worst(d, active)
+                    issues |= sub_issues
+                    if depth > deepest:
+                        deepest, chain = depth, sub
+
+        result = (frame + deepest, [key[1]] + chain, frozenset(issues))
+        self.memo[key] = result
+        return result
+
+
+def load_config(path):
+    with open(path) as f:
+        text = f.read()
+    return {m.group(1): int(m.group(2)) for m in DEFINE_RE.finditer(text)}
+
+
+def find_tasks(sources, config, entries):
+    """(name, entry, requested bytes or None) per task_create() call."""
+    tasks = []
+    for path in sources:
+        with open(path) as f:
+            text = COMMENT_RE.sub("", f.read())
+        for m in CREATE_RE.finditer(text):
+            entry, name, size = m.groups()
+            name = name[1:-1] if name.startswith('"') else name
+            size = config.get(size, int(size) if size.isdigit() else None)
+            entry = entries.get(name, entry)
+            tasks.append((name, entry, size, os.path.basename(path)))
+    return tasks
+
+
+def stack_class(size, config):
+    """The pool class task_create() rounds a request up to."""
+    for cls in CLASSES[:-1]:
+        if size <= config[cls + "_STACK_SIZE"]:
+            return cls
+    return CLASSES[-1]
+
+
+def usable(cls, config, mpu_guard):
+    size = config[cls + "_STACK_SIZE"]
+    return size - (2 * config["MPU_STACK_GUARD_SIZE"] if mpu_guard else 0)
+
+
+def pairs(values):
+    result = {}
+    for value in values:
+        key, _, rhs = value.partition("=")
+        if not rhs:
+            sys.exit("stack_report: expected NAME=VALUE, got %r" % value)
+        result[key] = rhs
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--objects", required=True,
+                        help="directory holding the .su and .ci files")
+    parser.add_argument("--sources", nargs="+", required=True,
+                        help="sources to search for task_create() calls")
+    parser.add_argument("--config", default=os.path.join(
+        os.path.dirname(__file__), "..", "kernel", "inc", "config.h"))
+    parser.add_argument("--fpu", action="store_true",
+                        help="tasks may use the FPU (hard-float build)")
+    parser.add_argument("--no-mpu-guard", action="store_true",
+                        help="built with MPU_STACK_GUARD_ENABLED=0")
+    parser.add_argument("--margin", type=int, default=10,
+                        help="headroom in percent a smaller class must "
+                             "leave before a task is called oversized")
+    parser.add_argument("--task", action="append", default=[],
+                        metavar="NAME=FUNCTION",
+                        help="entry of a task created through a pointer")
+    parser.add_argument("--indirect", action="append", default=[],
+                        metavar="CALLER=F1,F2",
+                        help="functions a caller reaches through pointers")
+    parser.add_argument("--assume", action="append", default=[],
+                        metavar="FUNCTION=BYTES",
+                        help="stack of a function built without the flags")
+    args = parser.parse_args()
+
+    config = load_config(args.config)
+    graph = CallGraph({k: int(v) for k, v in pairs(args.assume).items()},
+                      {k: v.split(",") for k, v in pairs(args.indirect).items()})
+    graph.load(args.objects)
+
+    switch = HW_FRAME + SW_FRAME + ALIGN_PAD
+    if args.fpu:
+        switch += HW_FPU_FRAME + SW_FPU_FRAME
+
+    print("%-16s %-24s %-8s %6s %6s %6s %7s  %s" %
+          ("task", "entry", "class", "usable", "chain", "switch", "total",
+           "verdict"))
+
+    too_small = 0
+    for name, entry, size, source in find_tasks(args.sources, config,
+                                                pairs(args.task)):
+        defs = graph.defined.get(entry)
+        if not defs:
+            if size is not None:
+                print("%-16s %-24s (%s: entry is not a function, use --task)"
+                      % (name, entry, source))
+            continue  # A wrapper passing its own parameters on
+        if size is None:
+            print("%-16s %-24s (%s: stack size is not a constant)"
+                  % (name, entry, source))
+            continue
+
+        depth, chain, issues = max(graph.worst(d) for d in defs)
+        total = depth + switch
+        cls = stack_class(size, config)
+        room = usable(cls, config, not args.no_mpu_guard)
+
+        verdict = "ok"
+        if total > room:
+            verdict = "TOO SMALL by %d" % (total - room)
+            too_small += 1
+        else:
+            for smaller in CLASSES[:CLASSES.index(cls)]:
+                if total * (100 + args.margin) <= \
+                        usable(smaller, config, not args.no_mpu_guard) * 100:
+                    verdict = "oversized, %s fits" % smaller
+                    break
+
+        print("%-16s %-24s %-8s %6d %6d %6d %6d%s  %s" %
+              (name, entry, cls, room, depth, switch, total,
+               "+" if issues else " ", verdict))
+        print("    " + " > ".join(chain))
+        for kind, what in sorted(issues):
+            print("    lower bound: %s: %s" % (kind, what))
+
+    return 1 if too_small else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
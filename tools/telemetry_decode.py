@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Decode Morph-RT telemetry frames written by telemetry_snapshot().
+
+A file may hold one frame or several back to back, as collected from the
+link:
+
+    $ tools/telemetry_decode.py frames.bin
+    $ tools/telemetry_decode.py --json frames.bin > frames.json
+
+The frame layout is documented in kernel/inc/telemetry.h. Entry types this
+decoder does not know are skipped by their length.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TELEMETRY_MAGIC = 0x4D54524D
+HEADER = struct.Struct("<IBBHIII")
+FLAG_TRUNCATED = 0x01
+NO_TASK = 0xFF
+
+POOLS = ["TCB", "Stack Small", "Stack Default", "Stack Large", "QCB",
+         "Buffer Small", "Buffer Medium", "Buffer Large", "SCB", "MCB",
+         "TMCB"]
+STATES = ["READY", "RUNNING", "BLOCKED", "SUSPENDED", "DELETED"]
+
+# type -> (list in the frame, struct of the fixed part, field names)
+ENTRIES = {
+    1: ("kernel", struct.Struct("<HQIB"),
+        ("cpu_load_permille", "isr_cycles", "timestamp_hz", "task_count")),
+    2: ("pools", struct.Struct("<BHHHH"),
+        ("pool", "total", "used", "peak", "corruptions")),
+    3: ("tasks", struct.Struct("<BBBBHHIQ"),
+        ("slot", "state", "base_priority", "effective_priority",
+         "stack_size", "stack_headroom", "run_count", "runtime_cycles")),
+    4: ("queues", struct.Struct("<BHHHB"),
+        ("slot", "messages", "capacity", "item_size", "flags")),
+    5: ("semaphores", struct.Struct("<BIIB"),
+        ("slot", "count", "max_count", "waiters")),
+    6: ("mutexes", struct.Struct("<BBB"), ("slot", "owner", "waiters")),
+}
+NAMED = (3, 5, 6)  # A name runs from the fixed part to the end
+
+
+def decode_frame(data, offset):
+    """(frame dict, offset of the next frame)."""
+    if len(data) - offset < HEADER.size:
+        raise ValueError("truncated header at offset %d" % offset)
+    magic, version, flags, length, sequence, tick_start, tick_end = \
+        HEADER.unpack_from(data, offset)
+    if magic != TELEMETRY_MAGIC:
+        raise ValueError("bad magic 0x%08x at offset %d" % (magic, offset))
+    if length < HEADER.size or offset + length > len(data):
+        raise ValueError("bad frame length %d at offset %d" % (length, offset))
+
+    frame = {"version": version, "sequence": sequence,
+             "tick_start": tick_start, "tick_end": tick_end,
+             "truncated": bool(flags & FLAG_TRUNCATED)}
+    for name, _, _ in ENTRIES.values():
+        frame[name] = []
+
+    pos, end = offset + HEADER.size, offset + length
+    while pos + 2 <= end:
+        kind, size = data[pos], data[pos + 1]
+        value = data[pos + 2:pos + 2 + size]
+        pos += 2 + size
+        if kind not in ENTRIES:
+            continue
+        name, layout, fields = ENTRIES[kind]
+        if size < layout.size:
+            raise ValueError("short entry of type %d (%d bytes)" % (kind, size))
+        entry = dict(zip(fields, layout.unpack_from(value)))
+        if kind in NAMED:
+            entry["name"] = value[layout.size:].decode("utf-8", "replace")
+        frame[name].append(entry)
+    return frame, end
+
+
+def print_frame(frame):
+    kernel = frame["kernel"][0] if frame["kernel"] else {}
+    hz = kernel.get("timestamp_hz") or 1
+    tasks = {t["slot"]: t for t in frame["tasks"]}
+
+    print("=== Snapshot %d (ticks %d-%d)%s ===" % (
+        frame["sequence"], frame["tick_start"], frame["tick_end"],
+        ", TRUNCATED" if frame["truncated"] else ""))
+    if kernel:
+        print("CPU load %.1f%%, ISR time %.6f s, %d tasks" % (
+            kernel["cpu_load_permille"] / 10.0, kernel["isr_cycles"] / hz,
+            kernel["task_count"]))
+
+    print("\nPool             | Total | Used | Peak | Corrupt")
+    for p in frame["pools"]:
+        name = POOLS[p["pool"]] if p["pool"] < len(POOLS) else str(p["pool"])
+        print("%-16s | %5d | %4d | %4d | %7d" % (
+            name, p["total"], p["used"], p["peak"], p["corruptions"]))
+
+    print("\nTask             | State     | Prio | Stack | Headroom |"
+          "    Runs | Runtime s")
+    for t in frame["tasks"]:
+        state = STATES[t["state"]] if t["state"] < len(STATES) else "?"
+        prio = str(t["base_priority"])
+        if t["effective_priority"] != t["base_priority"]:
+            prio += ">%d" % t["effective_priority"]
+        print("%-16s | %-9s | %4s | %5d | %8d | %7d | %9.6f" % (
+            t["name"], state, prio, t["stack_size"], t["stack_headroom"],
+            t["run_count"], t["runtime_cycles"] / hz))
+
+    if frame["queues"]:
+        print("\nQueue | Messages | Blocked")
+        for q in frame["queues"]:
+            blocked = ",".join(w for bit, w in ((1, "send"), (2, "recv"))
+                               if q["flags"] & bit) or "-"
+            print("%5d | %4d/%-3d | %s" % (q["slot"], q["messages"],
+                                           q["capacity"], blocked))
+
+    if frame["semaphores"]:
+        print("\nSemaphore        | Count | Waiters")
+        for s in frame["semaphores"]:
+            print("%-16s | %2d/%-2d | %7d" % (s["name"], s["count"],
+                                              s["max_count"], s["waiters"]))
+
+    if frame["mutexes"]:
+        print("\nMutex            | Owner            | Waiters")
+        for m in frame["mutexes"]:
+            owner = "-"
+            if m["owner"] != NO_TASK:
+                owner = tasks.get(m["owner"], {}).get("name",
+                                                      "#%d" % m["owner"])
+            print("%-16s | %-16s | %7d" % (m["name"], owner, m["waiters"]))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("frames", help="file holding one or more frames")
+    parser.add_argument("--json", action="store_true",
+                        help="print the frames as a JSON list")
+    args = parser.parse_args()
+
+    with open(args.frames, "rb") as f:
+        data = f.read()
+
+    frames, offset = [], 0
+    try:
+        while offset < len(data):
+            frame, offset = decode_frame(data, offset)
+            frames.append(frame)
+    except ValueError as err:
+        print("telemetry_decode: %s" % err, file=sys.stderr)
+        if not frames:
+            return 1
+
+    if args.json:
+        json.dump(frames, sys.stdout, indent=1)
+        print()
+    else:
+        for frame in frames:
+            print_frame(frame)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
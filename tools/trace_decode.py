@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""Decode a Morph-RT kernel trace into a readable timeline.
+
+Input is either a RAM dump of the trace_ram symbol (header + ring) or a
+stream written by a trace sink (header with capacity 0, then records).
+
+    (gdb) dump binary memory trace.bin &trace_ram \
+              (char *)&trace_ram + sizeof(trace_ram)
+    $ tools/trace_decode.py trace.bin
+    $ tools/trace_decode.py --csv trace.bin > trace.csv
+
+The loader (load_trace) is shared with the other trace tools.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+TRACE_MAGIC = 0x5454524D
+HEADER = struct.Struct("<IHHIIII")  # trace_header_t
+RECORD = struct.Struct("<IHHII")    # trace_record_t
+
+EVENTS = {
+    0: "NONE",
+    1: "TASK_SWITCH",
+    2: "TASK_READY",
+    3: "TASK_BLOCK",
+    4: "TASK_CREATE",
+    5: "TASK_DELETE",
+    6: "TASK_NAME",
+    16: "QUEUE_SEND",
+    17: "QUEUE_RECEIVE",
+    18: "QUEUE_SEND_BLOCK",
+    19: "QUEUE_RECEIVE_BLOCK",
+    24: "SEM_POST",
+    25: "SEM_TAKE",
+    26: "SEM_BLOCK",
+    32: "MUTEX_LOCK",
+    33: "MUTEX_UNLOCK",
+    34: "MUTEX_BLOCK",
+    35: "MUTEX_PI_BOOST",
+    36: "MUTEX_PI_RESTORE",
+    40: "POOL_ALLOC",
+    41: "POOL_FREE",
+    48: "ISR_ENTER",
+    49: "ISR_EXIT",
+    56: "CLOCK_CHANGE",
+}
+EVENT_CLOCK_CHANGE = 56
+TRACE_EVENT_USER = 64
+
+POOLS = ["TCB", "STACK_S", "STACK_D", "STACK_L", "QCB",
+         "BUF_S", "BUF_M", "BUF_L", "SCB", "MCB", "TMCB"]
+
+
+class Trace:
+    def __init__(self, header, records, names, lost):
+        self.version = header[1]
+        self.timestamp_hz = header[5] or 1
+        self.records = records  # (time_s, event, sequence, object, arg)
+        self.names = names      # object -> task name
+        self.lost = lost
+
+    def event_name(self, event):
+        if event >= TRACE_EVENT_USER:
+            return "USER+%d" % (event - TRACE_EVENT_USER)
+        return EVENTS.get(event, "EVENT_%d" % event)
+
+    def task_name(self, handle):
+        if handle == 0:
+            return "-"
+        return self.names.get(handle, "0x%08x" % handle)
+
+
+def _ordered(raw, capacity, head):
+    """Slots in write order: oldest surviving record first."""
+    if capacity == 0:
+        return raw
+    if head <= capacity:
+        return raw[:head]
+    start = head % capacity
+    return raw[start:] + raw[:start]
+
+
+def load_trace(data):
+    if len(data) < HEADER.size:
+        raise ValueError("file too short for a trace header")
+    header = HEADER.unpack_from(data, 0)
+    magic, version, record_size, capacity, head = header[:5]
+    if magic != TRACE_MAGIC:
+        raise ValueError("bad magic 0x%08x" % magic)
+    if record_size != RECORD.size:
+        raise ValueError("unsupported record size %d" % record_size)
+
+    body = data[HEADER.size:]
+    raw = [RECORD.unpack_from(body, off)
+           for off in range(0, len(body) - RECORD.size + 1, RECORD.size)]
+    if capacity:
+        raw = raw[:capacity]
+
+    names, name_parts = {}, {}
+    ordered, records, lost = [], [], 0
+    prev_ts = prev_seq = None
+    epoch = 0
+
+    for ts, event, seq, obj, arg in _ordered(raw, capacity, head):
+        if prev_seq is not None and seq != (prev_seq + 1) & 0xFFFF:
+            lost += (seq - prev_seq - 1) & 0xFFFF
+        prev_seq = seq
+
+        # Timestamps are a free-running 32-bit counter
+        if prev_ts is not None and ts < prev_ts:
+            epoch += 1 << 32
+        prev_ts = ts
+
+        if event == 6:  # TASK_NAME: four records of four bytes each
+            parts = name_parts.get(obj, b"") + struct.pack("<I", arg)
+            if len(parts) < 16:
+                name_parts[obj] = parts
+            else:
+                names[obj] = parts.split(b"\0", 1)[0].decode("ascii", "replace")
+                name_parts.pop(obj, None)
+            continue
+
+        ordered.append((epoch + ts, event, seq, obj, arg))
+
+    # The counter changes rate at each CLOCK_CHANGE; the first one left in
+    # the buffer tells the rate before it, the header the rate after the last
+    hz = next((obj for _, event, _, obj, _ in ordered
+               if event == EVENT_CLOCK_CHANGE), header[5]) or 1
+    base_s = base_ts = 0
+    for ts, event, seq, obj, arg in ordered:
+        time_s = base_s + (ts - base_ts) / hz
+        records.append((time_s, event, seq, obj, arg))
+        if event == EVENT_CLOCK_CHANGE and arg:
+            base_s, base_ts, hz = time_s, ts, arg
+
+    if capacity and head > capacity:
+        lost += head - capacity
+
+    return Trace(header, records, names, lost)
+
+
+def describe(trace, event, obj, arg):
+    """Human-readable subject and detail columns for one record."""
+    name = trace.event_name(event)
+    if name == "TASK_SWITCH":
+        return trace.task_name(obj), "from %s" % trace.task_name(arg)
+    if name in ("TASK_READY", "TASK_CREATE"):
+        return trace.task_name(obj), "prio %d" % arg
+    if name == "TASK_BLOCK":
+        return trace.task_name(obj), ("on 0x%08x" % arg) if arg else "delay"
+    if name == "TASK_DELETE":
+        return trace.task_name(obj), ""
+    if name in ("MUTEX_PI_BOOST", "MUTEX_PI_RESTORE"):
+        return trace.task_name(obj), "prio %d" % arg
+    if name in ("MUTEX_LOCK", "MUTEX_BLOCK"):
+        return "0x%08x" % obj, "owner %s" % trace.task_name(arg)
+    if name.startswith("POOL_"):
+        pool = arg & 0xFFFF
+        label = POOLS[pool] if pool < len(POOLS) else str(pool)
+        return "0x%08x" % obj, "%s used %d" % (label, arg >> 16)
+    if name.startswith("ISR_"):
+        return "irq", "exception %d" % arg
+    if name == "CLOCK_CHANGE":
+        return "clock", "%d -> %d Hz" % (obj, arg)
+    return "0x%08x" % obj, str(arg)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("trace", help="RAM dump or stream file")
+    parser.add_argument("--csv", action="store_true", help="emit CSV")
+    args = parser.parse_args()
+
+    with open(args.trace, "rb") as f:
+        trace = load_trace(f.read())
+
+    if not trace.records:
+        print("empty trace", file=sys.stderr)
+        return 0
+
+    t0 = trace.records[0][0]
+    rows = []
+    for ts, event, seq, obj, arg in trace.records:
+        subject, detail = describe(trace, event, obj, arg)
+        rows.append(((ts - t0) * 1e6, trace.event_name(event), subject, detail))
+
+    if args.csv:
+        out = csv.writer(sys.stdout)
+        out.writerow(["time_us", "event", "subject", "detail"])
+        for t, ev, subj, detail in rows:
+            out.writerow(["%.3f" % t, ev, subj, detail])
+    else:
+        for t, ev, subj, detail in rows:
+            print("%12.3f us  %-19s %-16s %s" % (t, ev, subj, detail))
+        if trace.lost:
+            print("(%d records lost to wrap or overrun)" % trace.lost)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
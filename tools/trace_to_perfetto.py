@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Convert a Morph-RT kernel trace to Chrome Trace Event JSON.
+
+The output loads in ui.perfetto.dev and chrome://tracing. Each task gets a
+track with Running, Ready and Blocked slices. Queue messages are drawn as
+flow arrows from sender to receiver. Pool usage shows up as counter tracks,
+and interrupts get a track of their own.
+
+    $ tools/trace_to_perfetto.py trace.bin -o trace.json
+
+Input is anything tools/trace_decode.py accepts: a trace_ram dump from
+target or QEMU, or a stream written by trace_stream_open() on the host.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from trace_decode import POOLS, load_trace  # noqa: E402
+
+PID = 1
+ISR_TID = 0
+
+EV_SWITCH, EV_READY, EV_BLOCK, EV_CREATE, EV_DELETE = 1, 2, 3, 4, 5
+EV_QUEUE_SEND, EV_QUEUE_RECEIVE = 16, 17
+EV_POOL_ALLOC, EV_POOL_FREE = 40, 41
+EV_ISR_ENTER, EV_ISR_EXIT = 48, 49
+
+
+class TaskTrack:
+    def __init__(self, tid):
+        self.tid = tid
+        self.state = None
+        self.since = 0.0
+        self.block_pending = False
+
+
+class Converter:
+    def __init__(self, trace):
+        self.trace = trace
+        self.events = []
+        self.tasks = {}
+        self.running = None
+        self.isr_depth = 0
+        self.queues = {}   # queue -> [(ts, tid)] messages in flight
+        self.next_flow = 1
+
+    def track(self, handle):
+        task = self.tasks.get(handle)
+        if task is None:
+            task = self.tasks[handle] = TaskTrack(len(self.tasks) + 1)
+        return task
+
+    def enter(self, handle, state, ts):
+        """Close the task's current slice and open a new one."""
+        task = self.track(handle)
+        if task.state is not None and ts > task.since:
+            self.events.append({
+                "name": task.state, "cat": "sched", "ph": "X", "pid": PID,
+                "tid": task.tid, "ts": task.since,
+                "dur": round(ts - task.since, 3),
+            })
+        task.state = state
+        task.since = ts
+
+    def producer_tid(self):
+        if self.isr_depth > 0 or self.running is None:
+            return ISR_TID
+        return self.track(self.running).tid
+
+    def flow(self, name, start, end):
+        flow_id = self.next_flow
+        self.next_flow += 1
+        common = {"name": name, "cat": "queue", "pid": PID, "id": flow_id}
+        self.events.append(dict(common, ph="s", ts=start[0], tid=start[1]))
+        self.events.append(dict(common, ph="f", bp="e", ts=end[0], tid=end[1]))
+
+    def convert(self):
+        trace = self.trace
+        if not trace.records:
+            return []
+        t0 = trace.records[0][0]
+        ts = 0.0
+
+        for time_s, event, _seq, obj, arg in trace.records:
+            ts = round((time_s - t0) * 1e6, 3)
+
+            if event == EV_SWITCH:
+                if arg:
+                    prev = self.track(arg)
+                    state = "Blocked" if prev.block_pending else "Ready"
+                    if prev.state == "Running":
+                        self.enter(arg, state, ts)
+                    prev.block_pending = False
+                self.enter(obj, "Running", ts)
+                self.running = obj
+            elif event == EV_READY:
+                task = self.track(obj)
+                if task.state == "Running":
+                    task.block_pending = False
+                else:
+                    self.enter(obj, "Ready", ts)
+            elif event == EV_BLOCK:
+                task = self.track(obj)
+                if task.state == "Running":
+                    task.block_pending = True
+                else:
+                    self.enter(obj, "Blocked", ts)
+            elif event == EV_CREATE:
+                self.track(obj)
+            elif event == EV_DELETE:
+                self.enter(obj, None, ts)
+            elif event == EV_QUEUE_SEND:
+                self.queues.setdefault(obj, []).append(
+                    (ts, self.producer_tid()))
+            elif event == EV_QUEUE_RECEIVE:
+                pending = self.queues.get(obj)
+                if pending:
+                    self.flow("queue 0x%08x" % obj, pending.pop(0),
+                              (ts, self.producer_tid()))
+            elif event in (EV_POOL_ALLOC, EV_POOL_FREE):
+                pool = arg & 0xFFFF
+                label = POOLS[pool] if pool < len(POOLS) else str(pool)
+                self.events.append({
+                    "name": "pool " + label, "ph": "C", "pid": PID, "ts": ts,
+                    "args": {"used": arg >> 16},
+                })
+            elif event == EV_ISR_ENTER:
+                self.isr_depth += 1
+                self.events.append({
+                    "name": "exception %d" % arg, "cat": "irq", "ph": "B",
+                    "pid": PID, "tid": ISR_TID, "ts": ts,
+                })
+            elif event == EV_ISR_EXIT and self.isr_depth > 0:
+                self.isr_depth -= 1
+                self.events.append({
+                    "ph": "E", "pid": PID, "tid": ISR_TID, "ts": ts,
+                })
+            else:
+                self.events.append({
+                    "name": trace.event_name(event), "cat": "kernel",
+                    "ph": "i", "s": "t", "pid": PID,
+                    "tid": self.producer_tid(), "ts": ts,
+                    "args": {"object": "0x%08x" % obj, "arg": arg},
+                })
+
+        # Close whatever is still open at the end of the capture
+        for handle, task in self.tasks.items():
+            if task.state is not None:
+                self.enter(handle, None, ts)
+
+        return self.metadata() + self.events
+
+    def metadata(self):
+        meta = [
+            {"name": "process_name", "ph": "M", "pid": PID,
+             "args": {"name": "Morph-RT"}},
+            {"name": "thread_name", "ph": "M", "pid": PID, "tid": ISR_TID,
+             "args": {"name": "Interrupts"}},
+        ]
+        for handle, task in self.tasks.items():
+            meta.append({"name": "thread_name", "ph": "M", "pid": PID,
+                         "tid": task.tid,
+                         "args": {"name": self.trace.task_name(handle)}})
+        return meta
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("trace", help="RAM dump or stream file")
+    parser.add_argument("-o", "--output", help="JSON file (default stdout)")
+    args = parser.parse_args()
+
+    with open(args.trace, "rb") as f:
+        trace = load_trace(f.read())
+
+    doc = {"traceEvents": Converter(trace).convert(),
+           "displayTimeUnit": "ns"}
+    if trace.lost:
+        doc["metadata"] = {"lost_records": trace.lost}
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(doc, f)
+    else:
+        json.dump(doc, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())